@@ -3,29 +3,73 @@
 
 #include "APILayer.h"
 
-#include <directxtk/SimpleMath.h>
 #include <openxr/openxr.h>
 
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "Clock.h"
+#include "ConfigWatcher.h"
 #include "DebugPrint.h"
 #include "Environment.h"
+#include "EyeGazeSource.h"
+#include "FusionSource.h"
 #include "HandTrackingSource.h"
+#include "HotspotIndex.h"
+#include "InputPipeline.h"
+#include "InputPipelineStages.h"
+#include "InputSampler.h"
 #include "OpenXRNext.h"
 #include "PointCtrlSource.h"
+#include "SmoothingStage.h"
+#include "TelemetryWriter.h"
+#include "Utf8.h"
 #include "VirtualControllerSink.h"
 #include "VirtualTouchScreenSink.h"
 #include "openxr.h"
 
-using namespace DirectX::SimpleMath;
-
 namespace HandTrackedCockpitClicking {
 
-APILayer::APILayer(XrInstance instance, const std::shared_ptr<OpenXRNext>& next)
-  : mOpenXR(next), mInstance(instance) {
+namespace {
+
+// Loading and indexing a large file is slow, so this is done once per config
+// change, not once per session
+std::shared_ptr<const HotspotIndex> LoadHotspots(
+  const Config::Snapshot& config) {
+  if (config.HotspotFile.empty()) {
+    return nullptr;
+  }
+  auto hotspots = HotspotIndex::Load(Utf8::ToWide(config.HotspotFile));
+  if (!hotspots) {
+    return nullptr;
+  }
+  return std::make_shared<const HotspotIndex>(std::move(*hotspots));
+}
+
+}// namespace
+
+APILayer::APILayer(
+  XrInstance instance,
+  const std::shared_ptr<OpenXRNext>& next,
+  const Environment::InstanceInfo& environment)
+  : mOpenXR(next), mInstance(instance), mEnvironment(environment) {
   DebugPrint("{}()", __FUNCTION__);
+
+  // The globals are only loaded once, so from here on, they're only used as
+  // the starting point
+  mConfig = std::make_shared<const Config::Snapshot>(Config::Current());
+
+  // Per-instance, as games usually suggest bindings before creating a session
+  if (
+    mEnvironment.Have_XR_EXT_eye_gaze_interaction
+    && mConfig->PointerSource == PointerSource::EyeGaze) {
+    mEyeGaze = std::make_unique<EyeGazeSource>(mOpenXR, instance);
+  }
+  mHotspots = LoadHotspots(*mConfig);
+
+  mConfigWatcher = std::make_unique<ConfigWatcher>(
+    [this](auto config) { this->OnConfigChanged(std::move(config)); });
 }
 
 // Report to higher layers and apps that OpenXR Hand Tracking is unavailable;
@@ -60,23 +104,50 @@ XrResult APILayer::xrBeginSession(
   if (XR_FAILED(result)) [[unlikely]] {
     return result;
   }
+  const auto s = mSessions.Find(session);
+  if (!s) [[unlikely]] {
+    return result;
+  }
 
   switch (beginInfo->primaryViewConfigurationType) {
     case XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO:
     case XR_VIEW_CONFIGURATION_TYPE_PRIMARY_QUAD_VARJO:
-      this->mPrimaryViewConfigurationType
+      s->mPrimaryViewConfigurationType
         = beginInfo->primaryViewConfigurationType;
   };
 
   return result;
 }
 
+APILayer::Session::Session(
+  const std::shared_ptr<OpenXRNext>& openXR,
+  XrSession session)
+  : mOpenXR(openXR), mSession(session) {
+}
+
+APILayer::Session::~Session() {
+  mInputSampler.reset();
+  mTelemetry.reset();
+  mPrepared.reset();
+  mInputPipeline.reset();
+  mFusion.reset();
+  mHandTracking.reset();
+  mVirtualController.reset();
+  mVirtualTouchScreen.reset();
+  if (mViewSpace) {
+    mOpenXR->xrDestroySpace(mViewSpace);
+  }
+  if (mLocalSpace) {
+    mOpenXR->xrDestroySpace(mLocalSpace);
+  }
+}
+
 XrResult APILayer::xrCreateSession(
   XrInstance instance,
   const XrSessionCreateInfo* createInfo,
   XrSession* session) {
   static uint32_t sCount = 0;
-  DebugPrint("{}(): #{}", __FUNCTION__, sCount);
+  DebugPrint("{}(): #{}", __FUNCTION__, sCount++);
 
   const auto nextResult
     = mOpenXR->xrCreateSession(instance, createInfo, session);
@@ -84,9 +155,45 @@ XrResult APILayer::xrCreateSession(
     DebugPrint("Failed to create OpenXR session: {}", nextResult);
     return nextResult;
   }
-  if (!Environment::Have_XR_KHR_win32_convert_performance_counter_time) {
+
+  auto s = std::make_unique<Session>(mOpenXR, *session);
+  this->InitializeSession(*s);
+
+  std::unique_lock lock(mConfigMutex);
+  if (!mSessions.Insert(*session, s.get())) {
+    DebugPrint(
+      "Too many sessions; not handling session {:#016x}",
+      reinterpret_cast<uintptr_t>(*session));
+    if (mEyeGazeSession == *session) {
+      mEyeGaze->DestroySession();
+      mEyeGazeSession = {};
+    }
     return nextResult;
   }
+  // The config changed while we were initializing, before the ConfigWatcher
+  // could see this session
+  const auto generation = mConfigGeneration.load();
+  if (s->mInitialized && s->mConfigGeneration != generation) {
+    s->mPrepared
+      = this->BuildInputPipeline(*s, mConfig, mHotspots, generation);
+  }
+  s.release();
+  return nextResult;
+}
+
+void APILayer::InitializeSession(Session& s) {
+  if (!mEnvironment.Have_XR_KHR_win32_convert_performance_counter_time) {
+    return;
+  }
+  const auto session = s.mSession;
+  std::shared_ptr<const HotspotIndex> hotspots;
+  {
+    std::unique_lock lock(mConfigMutex);
+    s.mConfig = mConfig;
+    s.mConfigGeneration = mConfigGeneration;
+    hotspots = mHotspots;
+  }
+  const auto& config = *s.mConfig;
 
   XrReferenceSpaceCreateInfo referenceSpace {
     .type = XR_TYPE_REFERENCE_SPACE_CREATE_INFO,
@@ -96,82 +203,331 @@ XrResult APILayer::xrCreateSession(
   };
 
   if (!mOpenXR->check_xrCreateReferenceSpace(
-        *session, &referenceSpace, &mViewSpace)) {
+        session, &referenceSpace, &s.mViewSpace)) {
     DebugPrint("Failed to create view space");
-    return nextResult;
+    return;
   }
   referenceSpace.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
   if (!mOpenXR->check_xrCreateReferenceSpace(
-        *session, &referenceSpace, &mLocalSpace)) {
+        session, &referenceSpace, &s.mLocalSpace)) {
     DebugPrint("Failed to create world space");
-    return nextResult;
+    return;
   }
 
+  s.mClock = std::make_shared<OpenXRClock>(mOpenXR.get(), mInstance);
+
+  if (mEyeGaze && !mEyeGazeSession) {
+    mEyeGaze->CreateSession(session, s.mViewSpace);
+    mEyeGazeSession = session;
+    s.mUsesEyeGaze = true;
+  }
+
+  const auto pinchesWithEyeGaze
+    = (config.PointerSource == PointerSource::EyeGaze)
+    && (config.PinchToClick || config.PinchToScroll);
   if (
-    Environment::Have_XR_EXT_hand_tracking
-    && (Config::PointerSource == PointerSource::OpenXRHandTracking)) {
-    mHandTracking = std::make_unique<HandTrackingSource>(
-      mOpenXR, instance, *session, mViewSpace, mLocalSpace);
+    mEnvironment.Have_XR_EXT_hand_tracking
+    && (config.PointerSource == PointerSource::OpenXRHandTracking
+        || config.PointerSource == PointerSource::Fusion
+        || pinchesWithEyeGaze)) {
+    s.mHandTracking = std::make_unique<HandTrackingSource>(
+      mOpenXR,
+      mInstance,
+      mEnvironment,
+      session,
+      s.mViewSpace,
+      s.mLocalSpace,
+      s.mConfig);
+  }
+  s.mPointCtrl = std::make_unique<PointCtrlSource>(s.mConfig, nullptr);
+  if (s.mHandTracking && config.PointerSource == PointerSource::Fusion) {
+    s.mFusion = std::make_unique<FusionSource>(
+      s.mHandTracking.get(), s.mPointCtrl.get(), s.mConfig);
   }
-  mPointCtrl = std::make_unique<PointCtrlSource>();
+
+  this->StartInputSampler(s);
 
   if (
-    VirtualControllerSink::IsActionSink()
-    || VirtualControllerSink::IsPointerSink()) {
-    mVirtualController = std::make_unique<VirtualControllerSink>(
-      mOpenXR, instance, *session, mViewSpace);
+    VirtualControllerSink::IsActionSink(config)
+    || VirtualControllerSink::IsPointerSink(config)) {
+    s.mVirtualController = std::make_unique<VirtualControllerSink>(
+      mOpenXR, mInstance, session, s.mViewSpace, s.mConfig);
   }
 
-  DebugPrint("Fully initialized.");
-  return nextResult;
+  this->SwapInputPipeline(
+    s, this->BuildInputPipeline(s, s.mConfig, hotspots, s.mConfigGeneration));
+  this->UpdateTelemetryWriter(s);
+  s.mInitialized = true;
+
+  DebugPrint(
+    "Fully initialized session {:#016x}.",
+    reinterpret_cast<uintptr_t>(session));
 }
 
-XrResult APILayer::xrDestroySession(XrSession session) {
-  if (mViewSpace) {
-    mOpenXR->xrDestroySpace(mViewSpace);
-    mViewSpace = {};
+void APILayer::StartInputSampler(Session& s) {
+  if (!s.mConfig->InputSampleRateHz) {
+    return;
   }
-  if (mLocalSpace) {
-    mOpenXR->xrDestroySpace(mLocalSpace);
-    mLocalSpace = {};
+  std::vector<InputSource*> sources {s.mPointCtrl.get()};
+  if (s.mHandTracking) {
+    sources.push_back(s.mHandTracking.get());
+  }
+  s.mInputSampler = std::make_unique<InputSampler>(
+    s.mClock, s.mConfig->InputSampleRateHz, std::move(sources));
+}
+
+void APILayer::OnConfigChanged(
+  std::shared_ptr<const Config::Snapshot> config) {
+  DebugPrint("Config changed");
+  // Before taking the lock, as this can be slow
+  auto hotspots = LoadHotspots(*config);
+
+  std::unique_lock lock(mConfigMutex);
+  // Sessions that are still using the previous snapshot keep it alive
+  mConfig = std::move(config);
+  mHotspots = std::move(hotspots);
+
+  const auto generation = mConfigGeneration.load() + 1;
+  mSessions.ForEach([&](XrSession, Session* s) {
+    if (s->mInitialized) {
+      s->mPrepared
+        = this->BuildInputPipeline(*s, mConfig, mHotspots, generation);
+    }
+  });
+  // Only once the pipelines are ready, so that the frame thread never waits
+  // for them
+  mConfigGeneration.store(generation, std::memory_order_release);
+}
+
+void APILayer::ApplyConfig(Session& s) {
+  // Called every frame, so only take the lock if there's something to take
+  if (s.mConfigGeneration == mConfigGeneration.load()) {
+    return;
+  }
+  std::unique_ptr<PreparedPipeline> prepared;
+  {
+    // If the ConfigWatcher is busy preparing an even newer config, take that
+    // on a later frame instead of waiting
+    std::unique_lock lock(mConfigMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;
+    }
+    prepared = std::move(s.mPrepared);
+  }
+  if (!prepared) {
+    return;
+  }
+  DebugPrint(
+    "Applying changed config to session {:#016x}",
+    reinterpret_cast<uintptr_t>(s.mSession));
+
+  const auto previousSampleRate = s.mConfig->InputSampleRateHz;
+  s.mConfig = prepared->mConfig;
+  s.mConfigGeneration = prepared->mConfigGeneration;
+
+  // The sampler thread doesn't read the sources' config, so it can keep
+  // running while they take the new one
+  if (s.mHandTracking) {
+    s.mHandTracking->ReloadConfig(s.mConfig);
+  }
+  s.mPointCtrl->ReloadConfig(s.mConfig);
+  if (s.mFusion) {
+    s.mFusion->ReloadConfig(s.mConfig);
+  }
+  if (s.mVirtualTouchScreen) {
+    s.mVirtualTouchScreen->ReloadConfig(s.mConfig);
+  }
+
+  // The sources and sinks are kept, so that device connections and held
+  // buttons survive; changing which ones are used needs a restart
+  this->SwapInputPipeline(s, std::move(prepared));
+  if (s.mConfig->InputSampleRateHz != previousSampleRate) {
+    s.mInputSampler.reset();
+    this->StartInputSampler(s);
+  }
+  this->UpdateTelemetryWriter(s);
+}
+
+void APILayer::UpdateTelemetryWriter(Session& s) {
+  if (!s.mConfig->EnableTelemetry) {
+    s.mTelemetry.reset();
+    return;
+  }
+  if (!s.mTelemetry) {
+    s.mTelemetry = std::make_unique<TelemetryWriter>();
+  }
+}
+
+std::unique_ptr<APILayer::PreparedPipeline> APILayer::BuildInputPipeline(
+  Session& s,
+  const std::shared_ptr<const Config::Snapshot>& configPtr,
+  const std::shared_ptr<const HotspotIndex>& hotspots,
+  uint64_t configGeneration) const {
+  auto ret = std::make_unique<PreparedPipeline>();
+  ret->mConfig = configPtr;
+  ret->mConfigGeneration = configGeneration;
+  ret->mPipeline = std::make_unique<InputPipeline>();
+  const auto& pipeline = ret->mPipeline;
+  const auto& config = *configPtr;
+
+  const auto pointerMode
+    = (config.PointerSink == PointerSink::VirtualTouchScreen)
+    ? PointerMode::Direction
+    : PointerMode::Pose;
+
+  if (s.mFusion) {
+    pipeline->AddStage(
+      std::make_unique<FusionStage>(s.mFusion.get(), pointerMode));
+  } else {
+    if (s.mHandTracking) {
+      pipeline->AddStage(std::make_unique<HandTrackingStage>(
+        s.mHandTracking.get(), pointerMode, config));
+    }
+    if (s.mPointCtrl) {
+      pipeline->AddStage(std::make_unique<PointCtrlStage>(
+        s.mPointCtrl.get(), pointerMode, config));
+    }
+  }
+  if (s.mUsesEyeGaze) {
+    // After the other sources, as it needs to know which hand is clicking
+    pipeline->AddStage(
+      std::make_unique<EyeGazeStage>(mEyeGaze.get(), pointerMode));
+  }
+  ret->mSourceStageCount = pipeline->GetStageCount();
+  if (s.mHandTracking) {
+    pipeline->AddStage(
+      std::make_unique<KeepAliveStage>(s.mHandTracking.get()));
+  }
+
+  if (config.SmoothingFactor <= 0.99f) {
+    pipeline->AddStage(std::make_unique<SmoothingStage>(
+      SmoothingStage::Parameters::FromConfig(config)));
+  }
+  if (hotspots) {
+    pipeline->AddStage(
+      std::make_unique<HotspotStage>(hotspots, config.HotspotSnapAngle));
+  }
+
+  ret->mHaveVirtualTouchScreen = VirtualTouchScreenSink::IsActionSink(config)
+    || VirtualTouchScreenSink::IsPointerSink(config);
+  if (ret->mHaveVirtualTouchScreen) {
+    pipeline->AddStage(std::make_unique<VirtualTouchScreenStage>(
+      configPtr,
+      mOpenXR,
+      s.mSession,
+      s.mViewSpace,
+      &s.mPrimaryViewConfigurationType,
+      &s.mVirtualTouchScreen));
+  }
+  if (s.mVirtualController) {
+    pipeline->AddStage(std::make_unique<VirtualControllerStage>(
+      s.mVirtualController.get(), config.ProjectionDistance));
+  }
+  return ret;
+}
+
+void APILayer::SwapInputPipeline(
+  Session& s,
+  std::unique_ptr<PreparedPipeline> prepared) {
+  s.mInputPipeline = std::move(prepared->mPipeline);
+  s.mSourceStageCount = prepared->mSourceStageCount;
+  if (!prepared->mHaveVirtualTouchScreen) {
+    // Releases any held buttons
+    s.mVirtualTouchScreen.reset();
+  }
+}
+
+XrResult APILayer::xrDestroySession(XrSession session) {
+  Session* s {nullptr};
+  {
+    // The ConfigWatcher's thread might be building a pipeline for it
+    std::unique_lock lock(mConfigMutex);
+    s = mSessions.Erase(session);
+  }
+  if (s) {
+    mActionSpaces.EraseIf([s](Session* it) { return it == s; });
+    if (mEyeGazeSession == session) {
+      mEyeGaze->DestroySession();
+      mEyeGazeSession = {};
+    }
+    delete s;
   }
-  mHandTracking.reset();
-  mVirtualController.reset();
   return mOpenXR->xrDestroySession(session);
 }
 
 APILayer::~APILayer() {
-  if (mViewSpace) {
-    mOpenXR->xrDestroySpace(mViewSpace);
+  // Waits for any callback to finish, so nothing else uses the sessions
+  mConfigWatcher.reset();
+
+  std::vector<Session*> sessions;
+  mSessions.ForEach(
+    [&sessions](XrSession, Session* s) { sessions.push_back(s); });
+  for (const auto s: sessions) {
+    mSessions.Erase(s->mSession);
+    delete s;
   }
-  if (mLocalSpace) {
-    mOpenXR->xrDestroySpace(mLocalSpace);
+  if (mEyeGaze) {
+    mEyeGaze->DestroySession();
   }
 }
 
+bool APILayer::HaveVirtualController() const {
+  bool ret = false;
+  mSessions.ForEach([&ret](XrSession, Session* s) {
+    ret = ret || static_cast<bool>(s->mVirtualController);
+  });
+  return ret;
+}
+
 XrResult APILayer::xrSuggestInteractionProfileBindings(
   XrInstance instance,
   const XrInteractionProfileSuggestedBinding* suggestedBindings) {
-  if (mVirtualController) {
+  const auto haveVirtualController = this->HaveVirtualController();
+  if (haveVirtualController) {
     for (uint32_t i = 0; i < suggestedBindings->countSuggestedBindings; ++i) {
       const auto& [action, binding] = suggestedBindings->suggestedBindings[i];
       if (mAttachedActions.contains(action)) {
         return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
       }
     }
-    return mVirtualController->xrSuggestInteractionProfileBindings(
+  }
+  if (
+    mEyeGaze
+    && suggestedBindings->interactionProfile
+      == mEyeGaze->GetInteractionProfile()) {
+    return mEyeGaze->xrSuggestInteractionProfileBindings(
       instance, suggestedBindings);
   }
-  return mOpenXR->xrSuggestInteractionProfileBindings(
-    instance, suggestedBindings);
+  if (!haveVirtualController) {
+    return mOpenXR->xrSuggestInteractionProfileBindings(
+      instance, suggestedBindings);
+  }
+
+  // Bindings are per-instance, but each session's virtual controller needs
+  // to see them. Passing through the same suggestion more than once is
+  // harmless, as it replaces the previous one for that profile.
+  XrResult result {XR_SUCCESS};
+  mSessions.ForEach([&](XrSession, Session* s) {
+    if (!s->mVirtualController) {
+      return;
+    }
+    const auto it = s->mVirtualController->xrSuggestInteractionProfileBindings(
+      instance, suggestedBindings);
+    if (XR_FAILED(it)) {
+      result = it;
+    }
+  });
+  return result;
 }
 
 XrResult APILayer::xrGetActionStateBoolean(
   XrSession session,
   const XrActionStateGetInfo* getInfo,
   XrActionStateBoolean* state) {
-  if (mVirtualController) {
-    return mVirtualController->xrGetActionStateBoolean(session, getInfo, state);
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrGetActionStateBoolean(
+      session, getInfo, state);
   }
   return mOpenXR->xrGetActionStateBoolean(session, getInfo, state);
 }
@@ -180,8 +536,10 @@ XrResult APILayer::xrGetActionStateFloat(
   XrSession session,
   const XrActionStateGetInfo* getInfo,
   XrActionStateFloat* state) {
-  if (mVirtualController) {
-    return mVirtualController->xrGetActionStateFloat(session, getInfo, state);
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrGetActionStateFloat(
+      session, getInfo, state);
   }
   return mOpenXR->xrGetActionStateFloat(session, getInfo, state);
 }
@@ -190,8 +548,10 @@ XrResult APILayer::xrGetActionStatePose(
   XrSession session,
   const XrActionStateGetInfo* getInfo,
   XrActionStatePose* state) {
-  if (mVirtualController) {
-    return mVirtualController->xrGetActionStatePose(session, getInfo, state);
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrGetActionStatePose(
+      session, getInfo, state);
   }
   return mOpenXR->xrGetActionStatePose(session, getInfo, state);
 }
@@ -201,16 +561,49 @@ XrResult APILayer::xrLocateSpace(
   XrSpace baseSpace,
   XrTime time,
   XrSpaceLocation* location) {
-  if (mVirtualController) {
-    return mVirtualController->xrLocateSpace(space, baseSpace, time, location);
+  const auto s = mActionSpaces.Find(space);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrLocateSpace(
+      space, baseSpace, time, location);
   }
   return mOpenXR->xrLocateSpace(space, baseSpace, time, location);
 }
 
+XrResult APILayer::xrLocateSpaces(
+  XrSession session,
+  const XrSpacesLocateInfo* locateInfo,
+  XrSpaceLocations* spaceLocations) {
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrLocateSpaces(
+      session, locateInfo, spaceLocations);
+  }
+  return mOpenXR->xrLocateSpaces(session, locateInfo, spaceLocations);
+}
+
+XrResult APILayer::xrLocateSpacesKHR(
+  XrSession session,
+  const XrSpacesLocateInfoKHR* locateInfo,
+  XrSpaceLocationsKHR* spaceLocations) {
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrLocateSpacesKHR(
+      session, locateInfo, spaceLocations);
+  }
+  return mOpenXR->xrLocateSpacesKHR(session, locateInfo, spaceLocations);
+}
+
+XrResult APILayer::xrDestroySpace(XrSpace space) {
+  mActionSpaces.Erase(space);
+  return mOpenXR->xrDestroySpace(space);
+}
+
 XrResult APILayer::xrAttachSessionActionSets(
   XrSession session,
   const XrSessionActionSetsAttachInfo* attachInfo) {
-  const auto result = mOpenXR->xrAttachSessionActionSets(session, attachInfo);
+  const auto result = (mEyeGaze && session == mEyeGazeSession)
+    ? mEyeGaze->xrAttachSessionActionSets(session, attachInfo)
+    : mOpenXR->xrAttachSessionActionSets(session, attachInfo);
   if (XR_FAILED(result)) {
     return result;
   }
@@ -228,8 +621,12 @@ XrResult APILayer::xrAttachSessionActionSets(
 XrResult APILayer::xrSyncActions(
   XrSession session,
   const XrActionsSyncInfo* syncInfo) {
-  if (mVirtualController) {
-    return mVirtualController->xrSyncActions(session, syncInfo);
+  if (mEyeGaze && session == mEyeGazeSession) {
+    syncInfo = mEyeGaze->WithActiveActionSet(syncInfo);
+  }
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrSyncActions(session, syncInfo);
   }
   return mOpenXR->xrSyncActions(session, syncInfo);
 }
@@ -237,8 +634,15 @@ XrResult APILayer::xrSyncActions(
 XrResult APILayer::xrPollEvent(
   XrInstance instance,
   XrEventDataBuffer* eventData) {
-  if (mVirtualController) {
-    return mVirtualController->xrPollEvent(instance, eventData);
+  bool havePendingEvent = false;
+  mSessions.ForEach([&](XrSession, Session* s) {
+    if (havePendingEvent || !s->mVirtualController) {
+      return;
+    }
+    havePendingEvent = s->mVirtualController->PollEvent(eventData);
+  });
+  if (havePendingEvent) {
+    return XR_SUCCESS;
   }
   return mOpenXR->xrPollEvent(instance, eventData);
 }
@@ -247,8 +651,9 @@ XrResult APILayer::xrGetCurrentInteractionProfile(
   XrSession session,
   XrPath topLevelUserPath,
   XrInteractionProfileState* interactionProfile) {
-  if (mVirtualController) {
-    return mVirtualController->xrGetCurrentInteractionProfile(
+  const auto s = mSessions.Find(session);
+  if (s && s->mVirtualController) {
+    return s->mVirtualController->xrGetCurrentInteractionProfile(
       session, topLevelUserPath, interactionProfile);
   }
   return mOpenXR->xrGetCurrentInteractionProfile(
@@ -259,13 +664,19 @@ XrResult APILayer::xrCreateAction(
   XrActionSet actionSet,
   const XrActionCreateInfo* createInfo,
   XrAction* action) {
-  const auto result = mVirtualController
-    ? mVirtualController->xrCreateAction(actionSet, createInfo, action)
-    : mOpenXR->xrCreateAction(actionSet, createInfo, action);
+  const auto result = mOpenXR->xrCreateAction(actionSet, createInfo, action);
   if (XR_FAILED(result)) {
     return result;
   }
 
+  // Actions are per-instance, so every session's virtual controller needs to
+  // know about them
+  mSessions.ForEach([=](XrSession, Session* s) {
+    if (s->mVirtualController) {
+      s->mVirtualController->AddActionBindings(createInfo, *action);
+    }
+  });
+
   if (mActionSetActions.contains(actionSet)) {
     mActionSetActions.at(actionSet).emplace(*action);
   } else {
@@ -279,10 +690,16 @@ XrResult APILayer::xrCreateActionSpace(
   XrSession session,
   const XrActionSpaceCreateInfo* createInfo,
   XrSpace* space) {
-  if (mVirtualController) {
-    return mVirtualController->xrCreateActionSpace(session, createInfo, space);
+  const auto s = mSessions.Find(session);
+  const auto result = (s && s->mVirtualController)
+    ? s->mVirtualController->xrCreateActionSpace(session, createInfo, space)
+    : mOpenXR->xrCreateActionSpace(session, createInfo, space);
+  if (XR_SUCCEEDED(result) && s) {
+    if (!mActionSpaces.Insert(*space, s)) {
+      DebugPrint("Too many action spaces; not tracking new space");
+    }
   }
-  return mOpenXR->xrCreateActionSpace(session, createInfo, space);
+  return result;
 }
 
 XrResult APILayer::xrCreateHandTrackerEXT(
@@ -301,223 +718,29 @@ XrResult APILayer::xrWaitFrame(
     return nextResult;
   }
 
-  FrameInfo frameInfo(
-    mOpenXR.get(),
-    mInstance,
-    mLocalSpace,
-    mViewSpace,
-    state->predictedDisplayTime);
-
-  if (
-    (!mVirtualTouchScreen)
-    && (VirtualTouchScreenSink::IsActionSink() || VirtualTouchScreenSink::IsPointerSink())
-    && mPrimaryViewConfigurationType.has_value()) {
-    mVirtualTouchScreen = std::make_unique<VirtualTouchScreenSink>(
-      mOpenXR,
-      session,
-      mPrimaryViewConfigurationType.value(),
-      state->predictedDisplayTime,
-      mViewSpace);
+  const auto s = mSessions.Find(session);
+  if (!(s && s->mInputPipeline)) {
+    return XR_SUCCESS;
   }
 
-  InputState leftHand {XR_HAND_LEFT_EXT};
-  InputState rightHand {XR_HAND_RIGHT_EXT};
-  const auto pointerMode
-    = (Config::PointerSink == PointerSink::VirtualTouchScreen)
-    ? PointerMode::Direction
-    : PointerMode::Pose;
-
-  if (mHandTracking) {
-    const auto [l, r] = mHandTracking->Update(
-      (Config::PointerSource == PointerSource::OpenXRHandTracking)
-        ? pointerMode
-        : PointerMode::None,
-      frameInfo);
-    if (Config::PointerSource == PointerSource::OpenXRHandTracking) {
-      leftHand.mPose = l.mPose;
-      leftHand.mDirection = l.mDirection;
-      rightHand.mPose = r.mPose;
-      rightHand.mDirection = r.mDirection;
-    }
-    if (Config::PinchToClick) {
-      leftHand.mActions.mPrimary = l.mActions.mPrimary;
-      leftHand.mActions.mSecondary = l.mActions.mSecondary;
-      rightHand.mActions.mPrimary = r.mActions.mPrimary;
-      rightHand.mActions.mSecondary = r.mActions.mSecondary;
-    }
-    if (Config::PinchToScroll) {
-      leftHand.mActions.mValueChange = l.mActions.mValueChange;
-      rightHand.mActions.mValueChange = r.mActions.mValueChange;
-    }
-  }
-
-  if (mPointCtrl) {
-    const auto [l, r] = mPointCtrl->Update(pointerMode, frameInfo);
-    if (Config::PointerSource == PointerSource::PointCtrl) {
-      leftHand.mPose = l.mPose;
-      leftHand.mDirection = l.mDirection;
-      rightHand.mPose = r.mPose;
-      rightHand.mDirection = r.mDirection;
-    }
-    if (Config::PointCtrlFCUMapping != PointCtrlFCUMapping::Disabled) {
-      leftHand.mActions.mPrimary
-        = leftHand.mActions.mPrimary || l.mActions.mPrimary;
-      leftHand.mActions.mSecondary
-        = leftHand.mActions.mSecondary || l.mActions.mSecondary;
-      if (l.mActions.mValueChange != ActionState::ValueChange::None) {
-        leftHand.mActions.mValueChange = l.mActions.mValueChange;
-      }
+  this->ApplyConfig(*s);
 
-      rightHand.mActions.mPrimary
-        = rightHand.mActions.mPrimary || r.mActions.mPrimary;
-      rightHand.mActions.mSecondary
-        = rightHand.mActions.mSecondary || r.mActions.mSecondary;
-      if (r.mActions.mValueChange != ActionState::ValueChange::None) {
-        rightHand.mActions.mValueChange = r.mActions.mValueChange;
-      }
-    }
-  }
-
-  if (mHandTracking) {
-    if (leftHand.mActions.Any()) {
-      mHandTracking->KeepAlive(XR_HAND_LEFT_EXT, frameInfo);
-    }
-    if (rightHand.mActions.Any()) {
-      mHandTracking->KeepAlive(XR_HAND_RIGHT_EXT, frameInfo);
-    }
-  }
-
-  const InputSnapshot leftSnapshot {frameInfo, leftHand};
-  const InputSnapshot rightSnapshot {frameInfo, rightHand};
-
-  leftHand = this->SmoothHand(leftSnapshot, mPreviousFrameLeftHand);
-  rightHand = this->SmoothHand(rightSnapshot, mPreviousFrameRightHand);
-
-  if (mVirtualTouchScreen) {
-    mVirtualTouchScreen->Update(leftHand, rightHand);
-  }
-
-  if (mVirtualController) {
-    if (!leftHand.mPose) {
-      leftHand.mPose = ProjectDirection(frameInfo, leftHand);
-    }
-    if (!rightHand.mPose) {
-      rightHand.mPose = ProjectDirection(frameInfo, rightHand);
-    }
-    mVirtualController->Update(frameInfo, leftHand, rightHand);
+  const FrameInfo frameInfo(
+    mOpenXR.get(),
+    *s->mClock,
+    s->mLocalSpace,
+    s->mViewSpace,
+    state->predictedDisplayTime);
+  s->mInputPipeline->Run(frameInfo);
+  if (s->mTelemetry) {
+    s->mTelemetry->Write(
+      frameInfo,
+      *s->mInputPipeline,
+      s->mSourceStageCount,
+      s->mHandTracking.get());
   }
 
-  mPreviousFrameLeftHand = leftSnapshot;
-  mPreviousFrameRightHand = rightSnapshot;
-
   return XR_SUCCESS;
 }
 
-std::optional<XrPosef> APILayer::ProjectDirection(
-  const FrameInfo& frameInfo,
-  const InputState& hand) const {
-  if (hand.mPose) {
-    return hand.mPose;
-  }
-
-  if (!hand.mDirection) {
-    return {};
-  }
-
-  const auto rx = hand.mDirection->x;
-  const auto ry = hand.mDirection->y;
-
-  const auto pointDirection
-    = Quaternion::CreateFromAxisAngle(Vector3::UnitX, rx)
-    * Quaternion::CreateFromAxisAngle(Vector3::UnitY, -ry);
-
-  const auto p = Vector3::Transform(
-    {0.0f, 0.0f, -Config::ProjectionDistance}, pointDirection);
-  const auto o = pointDirection;
-
-  const XrPosef viewPose {
-    .orientation = {o.x, o.y, o.z, o.w},
-    .position = {p.x, p.y, p.z},
-  };
-
-  const auto worldPose = viewPose * frameInfo.mViewInLocal;
-  return worldPose;
-}
-
-InputState APILayer::SmoothHand(
-  const InputSnapshot& currentFrame,
-  const std::optional<InputSnapshot>& maybePreviousFrame) const {
-  const auto& currentInput = currentFrame.mInputState;
-  if (currentInput.mPointerMode == PointerMode::None) {
-    return currentInput;
-  }
-
-  if (Config::SmoothingFactor > 0.99f) {
-    return currentInput;
-  }
-
-  if (!maybePreviousFrame) {
-    return currentInput;
-  }
-  const auto& previousFrame = *maybePreviousFrame;
-  const auto& previousInput = previousFrame.mInputState;
-
-  if (currentInput.mPointerMode != previousInput.mPointerMode) {
-    return currentInput;
-  }
-
-  switch (currentInput.mPointerMode) {
-    case PointerMode::None:
-      // TODO (C++23): std::unreachable()
-      __assume(false);
-    case PointerMode::Direction: {
-      if (!(currentInput.mDirection && previousInput.mDirection)) {
-        return currentInput;
-      }
-
-      const auto currentPose
-        = this->ProjectDirection(currentFrame.mFrameInfo, currentInput);
-      const auto previousPose
-        = this->ProjectDirection(previousFrame.mFrameInfo, previousInput);
-      if (!(currentPose && previousPose)) {
-        return currentInput;
-      }
-
-      const auto p = (this->SmoothPose(*currentPose, *previousPose)
-                      * currentFrame.mFrameInfo.mLocalInView)
-                       .position;
-      const auto rx = std::atan2f(p.y, -p.z);
-      const auto ry = std::atan2f(p.x, -p.z);
-      auto ret = currentInput;
-      ret.mDirection = {rx, ry};
-      return ret;
-    }
-    case PointerMode::Pose: {
-      if (!(currentInput.mPose && previousInput.mPose)) {
-        return currentInput;
-      }
-
-      auto ret = currentInput;
-      ret.mPose = this->SmoothPose(*currentInput.mPose, *previousInput.mPose);
-      return ret;
-    }
-    default:
-      __assume(false);
-  }
-}
-
-XrPosef APILayer::SmoothPose(
-  const XrPosef& currentPose,
-  const XrPosef& previousPose) const {
-  const auto ao = XrQuatToSM(previousPose.orientation);
-  const auto bo = XrQuatToSM(currentPose.orientation);
-  const auto ap = XrVecToSM(previousPose.position);
-  const auto bp = XrVecToSM(currentPose.position);
-
-  return {
-    SMQuatToXr(Quaternion::Slerp(ao, bo, Config::SmoothingFactor)),
-    SMVecToXr(Vector3::Lerp(ap, bp, Config::SmoothingFactor)),
-  };
-}
-
 }// namespace HandTrackedCockpitClicking
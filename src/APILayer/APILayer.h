@@ -4,17 +4,30 @@
 
 #include <openxr/openxr.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_set>
 
+#include "Config.h"
+#include "Environment.h"
 #include "FrameInfo.h"
+#include "HandleMap.h"
 #include "InputState.h"
 
 namespace HandTrackedCockpitClicking {
 
+class Clock;
+class ConfigWatcher;
+class EyeGazeSource;
+class FusionSource;
 class HandTrackingSource;
+class HotspotIndex;
+class InputPipeline;
+class InputSampler;
 class OpenXRNext;
 class PointCtrlSource;
+class TelemetryWriter;
 class VirtualControllerSink;
 class VirtualTouchScreenSink;
 struct FrameInfo;
@@ -22,7 +35,10 @@ struct FrameInfo;
 class APILayer final {
  public:
   APILayer() = delete;
-  APILayer(XrInstance, const std::shared_ptr<OpenXRNext>&);
+  APILayer(
+    XrInstance,
+    const std::shared_ptr<OpenXRNext>&,
+    const Environment::InstanceInfo&);
   virtual ~APILayer();
 
 XrResult xrGetSystemProperties(
@@ -91,6 +107,17 @@ XrResult xrGetSystemProperties(
     XrTime time,
     XrSpaceLocation* location);
 
+  XrResult xrLocateSpaces(
+    XrSession session,
+    const XrSpacesLocateInfo* locateInfo,
+    XrSpaceLocations* spaceLocations);
+  XrResult xrLocateSpacesKHR(
+    XrSession session,
+    const XrSpacesLocateInfoKHR* locateInfo,
+    XrSpaceLocationsKHR* spaceLocations);
+
+  XrResult xrDestroySpace(XrSpace space);
+
   XrResult xrAttachSessionActionSets(
     XrSession,
     const XrSessionActionSetsAttachInfo*);
@@ -99,38 +126,106 @@ XrResult xrGetSystemProperties(
   XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData);
 
  private:
-  std::optional<XrPosef> ProjectDirection(
-    const FrameInfo& frameInfo,
-    const InputState& hand) const;
+  // Everything that ApplyConfig() needs to switch a session to a new config;
+  // built off the frame thread, so that the frame thread only swaps it in
+  struct PreparedPipeline {
+    std::shared_ptr<const Config::Snapshot> mConfig;
+    uint64_t mConfigGeneration {};
+    std::unique_ptr<InputPipeline> mPipeline;
+    std::size_t mSourceStageCount {};
+    bool mHaveVirtualTouchScreen {false};
+  };
 
-  struct InputSnapshot {
-    FrameInfo mFrameInfo {};
-    InputState mInputState {};
+  // Everything tied to an XrSession; an instance can have several
+  struct Session {
+    Session(const std::shared_ptr<OpenXRNext>&, XrSession);
+    ~Session();
+
+    std::shared_ptr<OpenXRNext> mOpenXR;
+    XrSession mSession {};
+    XrSpace mViewSpace {};
+    XrSpace mLocalSpace {};
+    std::shared_ptr<const Clock> mClock;
+
+    std::optional<XrViewConfigurationType> mPrimaryViewConfigurationType;
+
+    std::unique_ptr<HandTrackingSource> mHandTracking;
+    std::unique_ptr<PointCtrlSource> mPointCtrl;
+    // Wraps mHandTracking and mPointCtrl, so must be after them
+    std::unique_ptr<FusionSource> mFusion;
+    std::unique_ptr<VirtualControllerSink> mVirtualController;
+    // Created by VirtualTouchScreenStage, but kept here so that it isn't
+    // recreated - and any held buttons lost - when the pipeline is rebuilt
+    std::unique_ptr<VirtualTouchScreenSink> mVirtualTouchScreen;
+    // After the sources and sinks, so it's destroyed before them
+    std::unique_ptr<InputPipeline> mInputPipeline;
+    // For a newer config than mInputPipeline, if there is one; guarded by
+    // APILayer::mConfigMutex
+    std::unique_ptr<PreparedPipeline> mPrepared;
+    // Stages before this index are sources; used for telemetry
+    std::size_t mSourceStageCount {};
+    std::unique_ptr<TelemetryWriter> mTelemetry;
+    // After the sources, so it's stopped before they're destroyed
+    std::unique_ptr<InputSampler> mInputSampler;
+    // Read by this session's sources, stages, and sinks instead of the
+    // globals, so that other sessions can switch config at any time
+    std::shared_ptr<const Config::Snapshot> mConfig;
+    // Compared to APILayer::mConfigGeneration to see if we need to rebuild
+    uint64_t mConfigGeneration {};
+    // Set once the sources and sinks are created; they're not changed after
+    // that, so pipelines can be built for them on other threads
+    bool mInitialized {false};
+    bool mUsesEyeGaze {false};
   };
 
-  InputState SmoothHand(
-    const InputSnapshot& currentFrame,
-    const std::optional<InputSnapshot>& previousFrame) const;
-  XrPosef SmoothPose(const XrPosef& current, const XrPosef& previous) const;
+  // Sessions are rarely used concurrently, but some tools create several,
+  // one after the other, without destroying the instance
+  static constexpr std::size_t MaxSessions = 16;
+  static constexpr std::size_t MaxActionSpaces = 1024;
+
+  void InitializeSession(Session&);
+  std::unique_ptr<PreparedPipeline> BuildInputPipeline(
+    Session&,
+    const std::shared_ptr<const Config::Snapshot>&,
+    const std::shared_ptr<const HotspotIndex>&,
+    uint64_t configGeneration) const;
+  void SwapInputPipeline(Session&, std::unique_ptr<PreparedPipeline>);
+  void StartInputSampler(Session&);
+  void OnConfigChanged(std::shared_ptr<const Config::Snapshot>);
+  void ApplyConfig(Session&);
+  void UpdateTelemetryWriter(Session&);
+  bool HaveVirtualController() const;
 
   std::shared_ptr<OpenXRNext> mOpenXR;
   XrInstance mInstance {};
-  XrSpace mViewSpace {};
-  XrSpace mLocalSpace {};
-
-  std::optional<XrViewConfigurationType> mPrimaryViewConfigurationType;
+  Environment::InstanceInfo mEnvironment;
 
   std::unordered_map<XrActionSet, std::unordered_set<XrAction>>
     mActionSetActions;
   std::unordered_set<XrAction> mAttachedActions;
 
-  std::unique_ptr<HandTrackingSource> mHandTracking;
-  std::unique_ptr<PointCtrlSource> mPointCtrl;
-  std::unique_ptr<VirtualTouchScreenSink> mVirtualTouchScreen;
-  std::unique_ptr<VirtualControllerSink> mVirtualController;
-
-  std::optional<InputSnapshot> mPreviousFrameLeftHand;
-  std::optional<InputSnapshot> mPreviousFrameRightHand;
+  // Per-instance, unlike the other sources
+  std::unique_ptr<EyeGazeSource> mEyeGaze;
+  // The eye gaze source can only be used by one session at a time
+  XrSession mEyeGazeSession {};
+
+  std::unique_ptr<ConfigWatcher> mConfigWatcher;
+  // Guards mConfig, mHotspots, and each session's mPrepared; also held while
+  // adding or removing sessions, as the ConfigWatcher's thread builds
+  // pipelines for them
+  std::mutex mConfigMutex;
+  // Only incremented once every session's pipeline is prepared
+  std::atomic<uint64_t> mConfigGeneration {};
+  // The latest config; each session takes its own reference
+  std::shared_ptr<const Config::Snapshot> mConfig;
+  // Loaded from mConfig->HotspotFile; shared by every session's pipeline
+  std::shared_ptr<const HotspotIndex> mHotspots;
+
+  // Owned; looked up on every session call, so must be cheap
+  HandleMap<XrSession, Session, MaxSessions> mSessions;
+  // The session that each action space was created for, so xrLocateSpace
+  // can find the right virtual controller
+  HandleMap<XrSpace, Session, MaxActionSpaces> mActionSpaces;
 };
 
 }// namespace HandTrackedCockpitClicking
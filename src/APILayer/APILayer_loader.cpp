@@ -5,12 +5,17 @@
 #include <openxr/openxr_loader_negotiation.h>
 #include <openxr/openxr_platform.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "APILayer.h"
 #include "Config.h"
 #include "DebugPrint.h"
 #include "Environment.h"
+#include "HandleMap.h"
 #include "OpenXRNext.h"
 
 namespace Environment = HandTrackedCockpitClicking::Environment;
@@ -21,31 +26,259 @@ constexpr std::string_view OpenXRLayerName {
   "XR_APILAYER_FREDEMMOTT_HandTrackedCockpitClicking"};
 static_assert(OpenXRLayerName.size() <= XR_MAX_API_LAYER_NAME_SIZE);
 
-static std::shared_ptr<OpenXRNext> gNext;
-static APILayer* gInstance = nullptr;
+// Dispatch is by handle type, so they must be distinct types
+static_assert(XR_PTR_SIZE == 8, "OpenXR handles must be pointers");
 
+struct Instance {
+  std::shared_ptr<OpenXRNext> mNext;
+  // nullptr if we're just passing through
+  std::unique_ptr<APILayer> mLayer;
+  Environment::InstanceInfo mEnvironment;
+};
+
+struct Session {
+  Instance* mInstance {nullptr};
+};
+
+// Every intercepted call looks up its first parameter in one of these;
+// entries are added and removed when the handles are created and destroyed.
+static HandleMap<XrInstance, Instance, 16> gInstances;
+static HandleMap<XrSession, Session, 64> gSessions;
+// Spaces are tracked by session, so they can be forgotten when the session
+// is destroyed
+static HandleMap<XrSpace, Session, 4096> gSpaces;
+static HandleMap<XrActionSet, Instance, 1024> gActionSets;
+
+// Instances that didn't fit in `gInstances`. We give the app the next
+// layer's functions for these, so apart from `xrGetInstanceProcAddr` and
+// `xrDestroyInstance`, we never see any calls for them or their children.
+struct UntrackedInstance {
+  XrInstance mInstance {XR_NULL_HANDLE};
+  PFN_xrGetInstanceProcAddr mGetInstanceProcAddr {nullptr};
+};
+static std::mutex gUntrackedInstancesMutex;
+static std::vector<UntrackedInstance> gUntrackedInstances;
+
+static PFN_xrGetInstanceProcAddr FindUntrackedInstance(XrInstance instance) {
+  std::unique_lock lock(gUntrackedInstancesMutex);
+  const auto it = std::ranges::find(
+    gUntrackedInstances, instance, &UntrackedInstance::mInstance);
+  return (it == gUntrackedInstances.end()) ? nullptr
+                                           : it->mGetInstanceProcAddr;
+}
+
+// Used for calls that aren't for any instance, e.g. enumerating extensions
+static Instance* AnyInstance() {
+  Instance* ret {nullptr};
+  gInstances.ForEach([&ret](XrInstance, Instance* it) {
+    if (!ret) {
+      ret = it;
+    }
+  });
+  return ret;
+}
+
+// Used when we don't know the owner of a handle, e.g. spaces created by
+// extensions that we don't intercept, or if one of the maps is full. With
+// more than one instance, we can't tell which one it belongs to.
+static Instance* OnlyInstance() {
+  Instance* ret {nullptr};
+  std::size_t count {};
+  gInstances.ForEach([&ret, &count](XrInstance, Instance* it) {
+    ret = it;
+    ++count;
+  });
+  return (count == 1) ? ret : nullptr;
+}
+
+static Instance* FindOwner(XrInstance instance) {
+  return gInstances.Find(instance);
+}
+
+static Session* FindOwner(XrSession session) {
+  return gSessions.Find(session);
+}
+
+static Session* FindOwner(XrSpace space) {
+  return gSpaces.Find(space);
+}
+
+static Instance* FindOwner(XrActionSet actionSet) {
+  return gActionSets.Find(actionSet);
+}
+
+static Instance* GetInstance(Instance* instance) {
+  return instance;
+}
+
+static Instance* GetInstance(Session* session) {
+  return session ? session->mInstance : nullptr;
+}
+
+// Called with every argument after a successful call, so that handles
+// created by it are associated with their parent
+template <class TOwner, class T>
+static void TrackCreated(TOwner*, T) {
+}
+
+static void TrackCreated(Instance* owner, XrSession* session) {
+  if (!owner) {
+    return;
+  }
+  auto it = std::make_unique<Session>(owner);
+  if (!gSessions.Insert(*session, it.get())) {
+    DebugPrint("Too many sessions to track");
+    return;
+  }
+  it.release();
+}
+
+static void TrackCreated(Session* owner, XrSpace* space) {
+  gSpaces.Insert(*space, owner);
+}
+
+static void TrackCreated(Instance* owner, XrActionSet* actionSet) {
+  gActionSets.Insert(*actionSet, owner);
+}
+
+static void ForgetSession(Session* session) {
+  gSpaces.EraseIf([session](Session* it) { return it == session; });
+  delete session;
+}
+
+// Called with the first argument of xrDestroy* functions, before the call
+static void TrackDestroyed(XrSession session) {
+  if (const auto it = gSessions.Erase(session)) {
+    ForgetSession(it);
+  }
+}
+
+static void TrackDestroyed(XrSpace space) {
+  gSpaces.Erase(space);
+}
+
+static void TrackDestroyed(XrActionSet actionSet) {
+  gActionSets.Erase(actionSet);
+}
+
+template <auto Next>
+constexpr bool IsDestroyFunction = false;
+template <>
+constexpr bool IsDestroyFunction<&OpenXRNext::xrDestroySession> = true;
+template <>
+constexpr bool IsDestroyFunction<&OpenXRNext::xrDestroySpace> = true;
+template <>
+constexpr bool IsDestroyFunction<&OpenXRNext::xrDestroyActionSet> = true;
+
+// `Layer` is nullptr for functions we only track handles for
 template <class F, auto Next, auto Layer>
 struct XRFuncDelegator;
 
-template <class TRet, class... TArgs, auto Next, auto Layer>
-struct XRFuncDelegator<TRet (*)(TArgs...), Next, Layer> {
-  static TRet Invoke(TArgs... args) noexcept {
-    if (Config::Enabled && gInstance) {
-      return std::invoke(Layer, gInstance, args...);
+template <class TRet, class THandle, class... TArgs, auto Next, auto Layer>
+struct XRFuncDelegator<TRet (*)(THandle, TArgs...), Next, Layer> {
+  static TRet Invoke(THandle handle, TArgs... args) noexcept {
+    const auto owner = FindOwner(handle);
+    auto instance = GetInstance(owner);
+    if (!instance) [[unlikely]] {
+      instance = OnlyInstance();
+    }
+    if (!instance) [[unlikely]] {
+      return XR_ERROR_HANDLE_INVALID;
+    }
+    if constexpr (IsDestroyFunction<Next>) {
+      TrackDestroyed(handle);
+    }
+
+    const auto result = Dispatch(instance, handle, args...);
+    if (XR_SUCCEEDED(result)) {
+      (TrackCreated(owner, args), ...);
+    }
+    return result;
+  }
+
+ private:
+  static TRet Dispatch(Instance* instance, THandle handle, TArgs... args) {
+    if constexpr (!std::is_null_pointer_v<decltype(Layer)>) {
+      if (Config::Enabled && instance->mLayer) {
+        return std::invoke(Layer, instance->mLayer.get(), handle, args...);
+      }
     }
-    auto& next = gNext.get()->*Next;
-    return std::invoke(next, args...);
+    auto& next = instance->mNext.get()->*Next;
+    return std::invoke(next, handle, args...);
   }
 };
 
+static XrResult DestroyUntrackedInstance(XrInstance instance) {
+  PFN_xrGetInstanceProcAddr getInstanceProcAddr {nullptr};
+  {
+    std::unique_lock lock(gUntrackedInstancesMutex);
+    const auto it = std::ranges::find(
+      gUntrackedInstances, instance, &UntrackedInstance::mInstance);
+    if (it == gUntrackedInstances.end()) {
+      return XR_ERROR_HANDLE_INVALID;
+    }
+    getInstanceProcAddr = it->mGetInstanceProcAddr;
+    gUntrackedInstances.erase(it);
+  }
+
+  PFN_xrDestroyInstance next {nullptr};
+  const auto result = getInstanceProcAddr(
+    instance,
+    "xrDestroyInstance",
+    reinterpret_cast<PFN_xrVoidFunction*>(&next));
+  if (XR_FAILED(result)) {
+    return result;
+  }
+  return next(instance);
+}
+
 static XrResult xrDestroyInstance(XrInstance instance) {
-  delete gInstance;
-  gInstance = nullptr;
-  const auto result = gNext->xrDestroyInstance(instance);
-  gNext = nullptr;
+  const auto it = gInstances.Erase(instance);
+  if (!it) {
+    return DestroyUntrackedInstance(instance);
+  }
+  gActionSets.EraseIf([it](Instance* owner) { return owner == it; });
+  std::vector<Session*> sessions;
+  gSessions.EraseIf([it, &sessions](Session* session) {
+    if (session->mInstance != it) {
+      return false;
+    }
+    sessions.push_back(session);
+    return true;
+  });
+  for (auto session: sessions) {
+    ForgetSession(session);
+  }
+
+  it->mLayer.reset();
+  const auto result = it->mNext->xrDestroyInstance(instance);
+  delete it;
   return result;
 }
 
+static void AddInstance(
+  XrInstance instance,
+  PFN_xrGetInstanceProcAddr getInstanceProcAddr,
+  const Environment::InstanceInfo& environment,
+  bool withLayer) {
+  auto it = std::make_unique<Instance>();
+  it->mNext = std::make_shared<OpenXRNext>(instance, getInstanceProcAddr);
+  it->mEnvironment = environment;
+  if (withLayer) {
+    it->mLayer
+      = std::make_unique<APILayer>(instance, it->mNext, it->mEnvironment);
+  }
+  if (!gInstances.Insert(instance, it.get())) {
+    DebugPrint(
+      "Too many instances; passing through instance {:#016x}",
+      reinterpret_cast<uintptr_t>(instance));
+    std::unique_lock lock(gUntrackedInstancesMutex);
+    gUntrackedInstances.push_back({instance, getInstanceProcAddr});
+    return;
+  }
+  it.release();
+}
+
 static XrResult xrEnumerateInstanceExtensionProperties(
   const char* layerName,
   uint32_t propertyCapacityInput,
@@ -61,14 +294,14 @@ static XrResult xrEnumerateInstanceExtensionProperties(
 
   // As we don't implement any extensions, just delegate to the runtime or next
   // layer.
-  if (gNext) {
+  if (const auto instance = AnyInstance()) {
     // We *could* strip the hand tracking extensions here, but we're not
     // - applications wouldn't see this, as the loader just uses the manifest
     // files instead
     // - we can just make the extension functions report failure
     // - probably best to have consistent behavior for applications and API
     // layers
-    return gNext->xrEnumerateInstanceExtensionProperties(
+    return instance->mNext->xrEnumerateInstanceExtensionProperties(
       layerName, propertyCapacityInput, propertyCountOutput, properties);
   }
 
@@ -94,7 +327,7 @@ static XrResult xrEnumerateApiLayerProperties(
   // TODO: follow-up on "is the spec wrong?" in the Khronos discord - posted at
   // https://discord.com/channels/1044671358782681128/1044672025752514640/1264924075105456199
   //
-  // If so, we need to check `gNext`
+  // If so, we need to check the next layer
   *propertyCountOutput = 1;
 
   if (propertyCapacityInput == 0) {
@@ -135,6 +368,18 @@ static XrResult xrGetInstanceProcAddr(
   SPECIAL_INTERCEPTED_OPENXR_FUNCS
 #undef IT
 
+  // After the special functions, so that we still see `xrDestroyInstance`
+  const auto owner = instance ? gInstances.Find(instance) : AnyInstance();
+  if (instance && !owner) {
+    if (const auto next = FindUntrackedInstance(instance)) {
+      return next(instance, name_cstr, function);
+    }
+  }
+  // Extension functions need an instance that has the extension enabled
+  const auto appEnabled = [instance, owner](auto member) {
+    return instance && owner && owner->mEnvironment.*member;
+  };
+
 #define IT(x) \
   if (name == #x) { \
     *function = reinterpret_cast<PFN_xrVoidFunction>( \
@@ -142,7 +387,9 @@ static XrResult xrGetInstanceProcAddr(
     return XR_SUCCESS; \
   }
 #define IT_EXT(ext, fun) \
-  if (name == #fun && !Environment::App_Enabled_##ext) { \
+  if ( \
+    name == #fun \
+    && !appEnabled(&Environment::InstanceInfo::App_Enabled_##ext)) { \
     return XR_ERROR_FUNCTION_UNSUPPORTED; \
   } \
   IT(fun)
@@ -150,18 +397,29 @@ static XrResult xrGetInstanceProcAddr(
 #undef IT
 #undef IT_EXT
 
+#define IT(x) \
+  if (name == #x) { \
+    *function = reinterpret_cast<PFN_xrVoidFunction>( \
+      &XRFuncDelegator<PFN_##x, &OpenXRNext::x, nullptr>::Invoke); \
+    return XR_SUCCESS; \
+  }
+  TRACKED_OPENXR_FUNCS
+#undef IT
+
 #define IT(fun)
 #define IT_EXT(ext, fun) \
-  if (name == #fun && !Environment::App_Enabled_##ext) { \
+  if ( \
+    name == #fun \
+    && !appEnabled(&Environment::InstanceInfo::App_Enabled_##ext)) { \
     return XR_ERROR_FUNCTION_UNSUPPORTED; \
   }
   NEXT_OPENXR_FUNCS;
 #undef IT
 #undef IT_EXT
 
-  if (gNext) {
+  if (owner) {
     const auto result
-      = gNext->xrGetInstanceProcAddr(instance, name_cstr, function);
+      = owner->mNext->xrGetInstanceProcAddr(instance, name_cstr, function);
     if (result != XR_SUCCESS && Config::VerboseDebug >= 1) {
       DebugPrint(
         "xrGetInstanceProcAddr for instance {:#016x} failed: {}",
@@ -178,6 +436,32 @@ static XrResult xrGetInstanceProcAddr(
   return XR_ERROR_FUNCTION_UNSUPPORTED;
 }
 
+static bool RuntimeHasExtension(
+  PFN_xrGetInstanceProcAddr getInstanceProcAddr,
+  std::string_view extension) {
+  PFN_xrEnumerateInstanceExtensionProperties enumerate {nullptr};
+  getInstanceProcAddr(
+    XR_NULL_HANDLE,
+    "xrEnumerateInstanceExtensionProperties",
+    reinterpret_cast<PFN_xrVoidFunction*>(&enumerate));
+  if (!enumerate) {
+    return false;
+  }
+
+  uint32_t count {};
+  if (XR_FAILED(enumerate(nullptr, 0, &count, nullptr))) {
+    return false;
+  }
+  std::vector<XrExtensionProperties> properties(
+    count, {XR_TYPE_EXTENSION_PROPERTIES});
+  if (XR_FAILED(enumerate(nullptr, count, &count, properties.data()))) {
+    return false;
+  }
+  return std::ranges::any_of(properties, [extension](const auto& it) {
+    return it.extensionName == extension;
+  });
+}
+
 static XrResult xrCreateApiLayerInstance(
   const XrInstanceCreateInfo* originalInfo,
   const struct XrApiLayerCreateInfo* layerInfo,
@@ -189,25 +473,32 @@ static XrResult xrCreateApiLayerInstance(
     sCount++,
     reinterpret_cast<const uintptr_t>(originalInfo),
     reinterpret_cast<const uintptr_t>(layerInfo));
-  if (gNext) {
-    DebugPrint("Still have a gNext, wtf?!");
-    gNext = nullptr;
-  }
 
   //  TODO: check version fields etc in layerInfo
 
+  Environment::InstanceInfo environment;
   XrInstanceCreateInfo info {XR_TYPE_INSTANCE_CREATE_INFO};
   if (originalInfo) {
     info = *originalInfo;
+    const auto apiVersion = info.applicationInfo.apiVersion;
+    if (
+      XR_VERSION_MAJOR(apiVersion) > 1
+      || (XR_VERSION_MAJOR(apiVersion) == 1
+          && XR_VERSION_MINOR(apiVersion) >= 1)) {
+      environment.App_Enabled_XR_VERSION_1_1 = true;
+    }
     for (uint32_t i = 0; i < info.enabledExtensionCount; ++i) {
       const std::string_view ext {info.enabledExtensionNames[i]};
       if (ext == XR_EXT_HAND_TRACKING_EXTENSION_NAME) {
-        Environment::App_Enabled_XR_EXT_hand_tracking = true;
+        environment.App_Enabled_XR_EXT_hand_tracking = true;
       }
       if (ext == XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME) {
-        Environment::App_Enabled_XR_KHR_win32_convert_performance_counter_time
+        environment.App_Enabled_XR_KHR_win32_convert_performance_counter_time
           = true;
       }
+      if (ext == XR_KHR_LOCATE_SPACES_EXTENSION_NAME) {
+        environment.App_Enabled_XR_KHR_locate_spaces = true;
+      }
     }
   }
   XrApiLayerCreateInfo nextLayerInfo = *layerInfo;
@@ -218,8 +509,11 @@ static XrResult xrCreateApiLayerInstance(
       &info, &nextLayerInfo, instance);
     if (XR_SUCCEEDED(result)) {
       DebugPrint("Created passthru instance as disabled by config");
-      gNext = std::make_shared<OpenXRNext>(
-        *instance, layerInfo->nextInfo->nextGetInstanceProcAddr);
+      AddInstance(
+        *instance,
+        layerInfo->nextInfo->nextGetInstanceProcAddr,
+        environment,
+        false);
     }
     return result;
   }
@@ -234,6 +528,21 @@ static XrResult xrCreateApiLayerInstance(
   enabledExtensions.push_back(XR_EXT_HAND_TRACKING_EXTENSION_NAME);
   enabledExtensions.push_back(XR_FB_HAND_TRACKING_AIM_EXTENSION_NAME);
 
+  // Unlike the others, this is only used for one PointerSource, and isn't
+  // part of the fallback attempts below, so only ask for it if it's there
+  const auto wantEyeGaze = (Config::PointerSource == PointerSource::EyeGaze)
+    && RuntimeHasExtension(
+      layerInfo->nextInfo->nextGetInstanceProcAddr,
+      XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME);
+  if (
+    wantEyeGaze
+    && std::ranges::none_of(enabledExtensions, [](auto it) {
+         return std::string_view {it}
+         == XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME;
+       })) {
+    enabledExtensions.push_back(XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME);
+  }
+
   {
     auto last = std::unique(enabledExtensions.begin(), enabledExtensions.end());
     enabledExtensions.erase(last, enabledExtensions.end());
@@ -252,12 +561,15 @@ static XrResult xrCreateApiLayerInstance(
     const auto nextResult = layerInfo->nextInfo->nextCreateApiLayerInstance(
       &info, &nextLayerInfo, instance);
     if (XR_SUCCEEDED(nextResult)) {
-      Environment::Have_XR_KHR_win32_convert_performance_counter_time = true;
-      Environment::Have_XR_EXT_hand_tracking = true;
-      Environment::Have_XR_FB_hand_tracking_aim = true;
-      gNext = std::make_shared<OpenXRNext>(
-        *instance, layerInfo->nextInfo->nextGetInstanceProcAddr);
-      gInstance = new APILayer(*instance, gNext);
+      environment.Have_XR_KHR_win32_convert_performance_counter_time = true;
+      environment.Have_XR_EXT_eye_gaze_interaction = wantEyeGaze;
+      environment.Have_XR_EXT_hand_tracking = true;
+      environment.Have_XR_FB_hand_tracking_aim = true;
+      AddInstance(
+        *instance,
+        layerInfo->nextInfo->nextGetInstanceProcAddr,
+        environment,
+        true);
       DebugPrint("Initialized with all extensions");
       return nextResult;
     }
@@ -278,11 +590,14 @@ static XrResult xrCreateApiLayerInstance(
     const auto nextResult = layerInfo->nextInfo->nextCreateApiLayerInstance(
       &info, &nextLayerInfo, instance);
     if (XR_SUCCEEDED(nextResult)) {
-      Environment::Have_XR_KHR_win32_convert_performance_counter_time = true;
-      Environment::Have_XR_EXT_hand_tracking = true;
-      gNext = std::make_shared<OpenXRNext>(
-        *instance, layerInfo->nextInfo->nextGetInstanceProcAddr);
-      gInstance = new APILayer(*instance, gNext);
+      environment.Have_XR_KHR_win32_convert_performance_counter_time = true;
+      environment.Have_XR_EXT_eye_gaze_interaction = wantEyeGaze;
+      environment.Have_XR_EXT_hand_tracking = true;
+      AddInstance(
+        *instance,
+        layerInfo->nextInfo->nextGetInstanceProcAddr,
+        environment,
+        true);
       DebugPrint(
         "Initialized without {}", XR_FB_HAND_TRACKING_AIM_EXTENSION_NAME);
       return nextResult;
@@ -310,10 +625,13 @@ static XrResult xrCreateApiLayerInstance(
     const auto nextResult = layerInfo->nextInfo->nextCreateApiLayerInstance(
       &info, &nextLayerInfo, instance);
     if (XR_SUCCEEDED(nextResult)) {
-      Environment::Have_XR_KHR_win32_convert_performance_counter_time = true;
-      gNext = std::make_shared<OpenXRNext>(
-        *instance, layerInfo->nextInfo->nextGetInstanceProcAddr);
-      gInstance = new APILayer(*instance, gNext);
+      environment.Have_XR_KHR_win32_convert_performance_counter_time = true;
+      environment.Have_XR_EXT_eye_gaze_interaction = wantEyeGaze;
+      AddInstance(
+        *instance,
+        layerInfo->nextInfo->nextGetInstanceProcAddr,
+        environment,
+        true);
       DebugPrint("Initialized without {}", XR_EXT_HAND_TRACKING_EXTENSION_NAME);
       return nextResult;
     }
@@ -332,8 +650,11 @@ static XrResult xrCreateApiLayerInstance(
     originalInfo, &nextLayerInfo, instance);
   if (XR_SUCCEEDED(nextResult)) {
     DebugPrint("No-op passthrough xrCreateAPILayerInstance succeeded");
-    gNext = std::make_shared<OpenXRNext>(
-      *instance, layerInfo->nextInfo->nextGetInstanceProcAddr);
+    AddInstance(
+      *instance,
+      layerInfo->nextInfo->nextGetInstanceProcAddr,
+      environment,
+      false);
   } else {
     DebugPrint(
       "No-op passthrough xrCreateApiLayerInstance failed: {}", nextResult);
@@ -359,7 +680,12 @@ HandTrackedCockpitClicking_xrNegotiateLoaderApiLayerInterface(
     return XR_ERROR_INITIALIZATION_FAILED;
   }
 
-  HandTrackedCockpitClicking::Config::LoadForCurrentProcess();
+  // The globals are read without locks, so they must never change once
+  // anything might be using them; config changes go through per-session
+  // snapshots instead
+  static std::once_flag sLoadConfig;
+  std::call_once(
+    sLoadConfig, &HandTrackedCockpitClicking::Config::LoadForCurrentProcess);
   HandTrackedCockpitClicking::Environment::Load();
 
   // TODO: check version fields etc in loaderInfo
@@ -0,0 +1,230 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "EyeGazeSource.h"
+
+#include <directxtk/SimpleMath.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "Config.h"
+#include "openxr.h"
+
+using namespace DirectX::SimpleMath;
+
+namespace HandTrackedCockpitClicking {
+
+static constexpr auto gEyeGazeProfilePath
+  = "/interaction_profiles/ext/eye_gaze_interaction";
+static constexpr auto gGazePosePath = "/user/eyes_ext/input/gaze_ext/pose";
+
+EyeGazeSource::EyeGazeSource(
+  const std::shared_ptr<OpenXRNext>& next,
+  XrInstance instance)
+  : mOpenXR(next), mInstance(instance) {
+  if (
+    !(mOpenXR->check_xrStringToPath(
+        instance, gEyeGazeProfilePath, &mProfilePath)
+      && mOpenXR->check_xrStringToPath(
+        instance, gGazePosePath, &mGazePosePath))) {
+    DebugPrint("Failed to create eye gaze paths");
+    return;
+  }
+
+  XrActionSetCreateInfo actionSetInfo {XR_TYPE_ACTION_SET_CREATE_INFO};
+  strncpy_s(
+    actionSetInfo.actionSetName,
+    "htcc_eye_gaze",
+    XR_MAX_ACTION_SET_NAME_SIZE);
+  strncpy_s(
+    actionSetInfo.localizedActionSetName,
+    "HTCC Eye Gaze",
+    XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE);
+  if (!mOpenXR->check_xrCreateActionSet(
+        instance, &actionSetInfo, &mActionSet)) {
+    DebugPrint("Failed to create eye gaze action set");
+    return;
+  }
+
+  XrActionCreateInfo actionInfo {
+    .type = XR_TYPE_ACTION_CREATE_INFO,
+    .actionType = XR_ACTION_TYPE_POSE_INPUT,
+  };
+  strncpy_s(actionInfo.actionName, "gaze", XR_MAX_ACTION_NAME_SIZE);
+  strncpy_s(
+    actionInfo.localizedActionName, "Gaze", XR_MAX_LOCALIZED_ACTION_NAME_SIZE);
+  if (!mOpenXR->check_xrCreateAction(mActionSet, &actionInfo, &mGazeAction)) {
+    DebugPrint("Failed to create eye gaze action");
+    return;
+  }
+
+  const auto result = this->SuggestBindings();
+  if (XR_FAILED(result)) {
+    DebugPrint("Failed to suggest eye gaze bindings: {}", result);
+    return;
+  }
+
+  DebugPrint(
+    "Initialized eye gaze - dwell radius: {}; dwell milliseconds: {}",
+    Config::EyeGazeDwellRadius,
+    Config::EyeGazeDwellMilliseconds);
+}
+
+EyeGazeSource::~EyeGazeSource() {
+  this->DestroySession();
+  if (mActionSet) {
+    // Also destroys the action
+    mOpenXR->xrDestroyActionSet(mActionSet);
+  }
+}
+
+void EyeGazeSource::CreateSession(XrSession session, XrSpace viewSpace) {
+  mSession = session;
+  mViewSpace = viewSpace;
+  if (!mGazeAction) {
+    return;
+  }
+
+  XrActionSpaceCreateInfo spaceInfo {
+    .type = XR_TYPE_ACTION_SPACE_CREATE_INFO,
+    .action = mGazeAction,
+    .poseInActionSpace = XR_POSEF_IDENTITY,
+  };
+  if (!mOpenXR->check_xrCreateActionSpace(session, &spaceInfo, &mGazeSpace)) {
+    DebugPrint("Failed to create eye gaze space");
+  }
+}
+
+void EyeGazeSource::DestroySession() {
+  if (mGazeSpace) {
+    mOpenXR->xrDestroySpace(mGazeSpace);
+    mGazeSpace = {};
+  }
+  mSession = {};
+  mViewSpace = {};
+  mAttached = false;
+  mDwellFilter.Reset();
+}
+
+XrPath EyeGazeSource::GetInteractionProfile() const {
+  return mProfilePath;
+}
+
+XrResult EyeGazeSource::SuggestBindings() {
+  auto bindings = mAppBindings;
+  bindings.push_back({mGazeAction, mGazePosePath});
+
+  const XrInteractionProfileSuggestedBinding suggestion {
+    .type = XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING,
+    .interactionProfile = mProfilePath,
+    .countSuggestedBindings = static_cast<uint32_t>(bindings.size()),
+    .suggestedBindings = bindings.data(),
+  };
+  return mOpenXR->xrSuggestInteractionProfileBindings(mInstance, &suggestion);
+}
+
+XrResult EyeGazeSource::xrSuggestInteractionProfileBindings(
+  XrInstance instance,
+  const XrInteractionProfileSuggestedBinding* suggestedBindings) {
+  if (!mGazeAction) {
+    return mOpenXR->xrSuggestInteractionProfileBindings(
+      instance, suggestedBindings);
+  }
+
+  // Suggestions replace previous suggestions for the same profile, so add
+  // ours back in
+  DebugPrint("Merging game's eye gaze bindings with ours");
+  mAppBindings.assign(
+    suggestedBindings->suggestedBindings,
+    suggestedBindings->suggestedBindings
+      + suggestedBindings->countSuggestedBindings);
+  return this->SuggestBindings();
+}
+
+XrResult EyeGazeSource::xrAttachSessionActionSets(
+  XrSession session,
+  const XrSessionActionSetsAttachInfo* attachInfo) {
+  if (!(mGazeSpace && session == mSession)) {
+    return mOpenXR->xrAttachSessionActionSets(session, attachInfo);
+  }
+
+  std::vector<XrActionSet> actionSets {
+    attachInfo->actionSets,
+    attachInfo->actionSets + attachInfo->countActionSets};
+  actionSets.push_back(mActionSet);
+
+  auto info = *attachInfo;
+  info.countActionSets = static_cast<uint32_t>(actionSets.size());
+  info.actionSets = actionSets.data();
+
+  const auto result = mOpenXR->xrAttachSessionActionSets(session, &info);
+  if (XR_SUCCEEDED(result)) {
+    mAttached = true;
+    return result;
+  }
+
+  // Don't break the game if the runtime doesn't like our action set
+  DebugPrint("Failed to attach with eye gaze action set: {}", result);
+  return mOpenXR->xrAttachSessionActionSets(session, attachInfo);
+}
+
+const XrActionsSyncInfo* EyeGazeSource::WithActiveActionSet(
+  const XrActionsSyncInfo* syncInfo) {
+  if (!mAttached) {
+    return syncInfo;
+  }
+
+  mActiveActionSets.assign(
+    syncInfo->activeActionSets,
+    syncInfo->activeActionSets + syncInfo->countActiveActionSets);
+  mActiveActionSets.push_back({mActionSet, XR_NULL_PATH});
+
+  mSyncInfo = *syncInfo;
+  mSyncInfo.countActiveActionSets
+    = static_cast<uint32_t>(mActiveActionSets.size());
+  mSyncInfo.activeActionSets = mActiveActionSets.data();
+  return &mSyncInfo;
+}
+
+std::tuple<InputState, InputState> EyeGazeSource::Update(
+  PointerMode,
+  const FrameInfo& frameInfo) {
+  InputState gaze {XR_HAND_RIGHT_EXT};
+  if (!mAttached) {
+    return {{XR_HAND_LEFT_EXT}, gaze};
+  }
+
+  const XrActionStateGetInfo getInfo {
+    .type = XR_TYPE_ACTION_STATE_GET_INFO,
+    .action = mGazeAction,
+  };
+  XrActionStatePose state {XR_TYPE_ACTION_STATE_POSE};
+  if (!(mOpenXR->check_xrGetActionStatePose(mSession, &getInfo, &state)
+        && state.isActive)) {
+    // Eye tracking is unavailable, rather than just a blink
+    mDwellFilter.Reset();
+    return {{XR_HAND_LEFT_EXT}, gaze};
+  }
+
+  std::optional<XrVector2f> direction;
+  XrSpaceLocation location {XR_TYPE_SPACE_LOCATION};
+  if (
+    mOpenXR->check_xrLocateSpace(
+      mGazeSpace, mViewSpace, frameInfo.mPredictedDisplayTime, &location)
+    && (location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT)) {
+    const auto forward = Vector3::Transform(
+      Vector3::Forward, XrQuatToSM(location.pose.orientation));
+    direction = XrVector2f {
+      std::atan2f(forward.y, -forward.z),
+      std::atan2f(forward.x, -forward.z),
+    };
+    gaze.mPositionUpdatedAt = frameInfo.mNow;
+  }
+
+  gaze.mDirection = mDwellFilter.Update(
+    std::chrono::nanoseconds(frameInfo.mNow), direction);
+  return {{XR_HAND_LEFT_EXT}, gaze};
+}
+
+}// namespace HandTrackedCockpitClicking
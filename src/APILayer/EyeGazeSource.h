@@ -0,0 +1,78 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "GazeDwellFilter.h"
+#include "InputSource.h"
+#include "OpenXRNext.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Points with the user's eyes, via XR_EXT_eye_gaze_interaction.
+ *
+ * This needs its own action set; as an application can only attach action
+ * sets once per session, ours is added to the game's when it attaches its
+ * own, and is added to every `xrSyncActions()` call. If the game also uses
+ * eye gaze, its bindings are merged with ours.
+ *
+ * The action set is per-instance, as games usually suggest bindings before
+ * creating a session; the gaze space is per-session.
+ *
+ * Gaze isn't tied to a hand, so it's always reported as the right hand; the
+ * pipeline stage moves it to whichever hand is clicking.
+ */
+class EyeGazeSource final : public InputSource {
+ public:
+  EyeGazeSource(const std::shared_ptr<OpenXRNext>&, XrInstance);
+  ~EyeGazeSource();
+
+  void CreateSession(XrSession, XrSpace viewSpace);
+  void DestroySession();
+
+  std::tuple<InputState, InputState> Update(PointerMode, const FrameInfo&)
+    override;
+
+  XrPath GetInteractionProfile() const;
+  XrResult xrSuggestInteractionProfileBindings(
+    XrInstance,
+    const XrInteractionProfileSuggestedBinding*);
+  XrResult xrAttachSessionActionSets(
+    XrSession,
+    const XrSessionActionSetsAttachInfo*);
+
+  // Returns `syncInfo`, with our action set added if it's attached
+  const XrActionsSyncInfo* WithActiveActionSet(
+    const XrActionsSyncInfo* syncInfo);
+
+ private:
+  std::shared_ptr<OpenXRNext> mOpenXR;
+  XrInstance mInstance {};
+
+  XrPath mProfilePath {};
+  XrPath mGazePosePath {};
+  XrActionSet mActionSet {};
+  XrAction mGazeAction {};
+  // Bindings suggested by the game for the eye gaze profile, if any
+  std::vector<XrActionSuggestedBinding> mAppBindings;
+
+  XrSession mSession {};
+  XrSpace mViewSpace {};
+  XrSpace mGazeSpace {};
+  bool mAttached {false};
+
+  // Reused by WithActiveActionSet() to avoid allocating every frame
+  std::vector<XrActiveActionSet> mActiveActionSets;
+  XrActionsSyncInfo mSyncInfo {XR_TYPE_ACTIONS_SYNC_INFO};
+
+  GazeDwellFilter mDwellFilter {GazeDwellFilter::Parameters::FromConfig()};
+
+  XrResult SuggestBindings();
+};
+
+}// namespace HandTrackedCockpitClicking
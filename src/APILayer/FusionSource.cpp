@@ -0,0 +1,184 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "FusionSource.h"
+
+#include <directxtk/SimpleMath.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "Config.h"
+#include "DebugPrint.h"
+#include "HandTrackingSource.h"
+#include "PointCtrlSource.h"
+
+using namespace DirectX::SimpleMath;
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+FusionFilter::Source GetSource(const InputState& state) {
+  return {state.mDirection, state.mPositionUpdatedAt};
+}
+
+}// namespace
+
+FusionSource::FusionSource(
+  HandTrackingSource* handTracking,
+  PointCtrlSource* pointCtrl,
+  std::shared_ptr<const Config::Snapshot> config)
+  : mHandTracking(handTracking),
+    mPointCtrl(pointCtrl),
+    mConfig(std::move(config)) {
+  DebugPrint(
+    "FusionSource - CorrectionRate: {}; StaleMilliseconds: {}",
+    mConfig->FusionCorrectionRate,
+    mConfig->FusionStaleMilliseconds);
+  this->ReloadConfig(mConfig);
+}
+
+void FusionSource::ReloadConfig(
+  std::shared_ptr<const Config::Snapshot> config) {
+  mConfig = std::move(config);
+  const auto parameters
+    = PointCtrlDriftEstimator::Parameters::FromConfig(*mConfig);
+  DebugPrint(
+    "FusionSource - DriftCorrection: {}; DriftWindow: {}; "
+    "DriftCorrectionRate: {}",
+    mConfig->FusionDriftCorrection,
+    parameters.mWindow,
+    parameters.mCorrectionRate);
+  mDrift.SetParameters(parameters);
+}
+
+std::tuple<InputState, InputState> FusionSource::Update(
+  PointerMode pointerMode,
+  const FrameInfo& frameInfo) {
+  // PointCtrl first, so that it can be included in hand tracking captures
+  auto [pcLeft, pcRight] = mPointCtrl->Update(pointerMode, frameInfo);
+  mHandTracking->CapturePointCtrl(pcLeft, pcRight);
+  const auto [htLeft, htRight] = mHandTracking->Update(pointerMode, frameInfo);
+
+  if (mConfig->FusionDriftCorrection) {
+    this->UpdateDrift(frameInfo, {htLeft, htRight}, {pcLeft, pcRight});
+    for (auto state: {&pcLeft, &pcRight}) {
+      if (state->mDirection) {
+        state->mDirection = mDrift.Apply(*state->mDirection);
+      }
+    }
+  }
+
+  return {
+    FuseHand(pointerMode, frameInfo, htLeft, pcLeft, &mHands[0]),
+    FuseHand(pointerMode, frameInfo, htRight, pcRight, &mHands[1]),
+  };
+}
+
+void FusionSource::UpdateDrift(
+  const FrameInfo& frameInfo,
+  const std::array<InputState, 2>& handTracking,
+  const std::array<InputState, 2>& pointCtrl) {
+  // It's the same sensor whichever hand it's reported for, so only use the
+  // most confident pair each frame
+  float weight {};
+  std::size_t best {};
+  for (std::size_t i = 0; i < 2; ++i) {
+    const auto it = FusionFilter::Confidence(
+                      *mConfig, frameInfo.mNow, GetSource(handTracking[i]))
+      * FusionFilter::Confidence(
+                      *mConfig, frameInfo.mNow, GetSource(pointCtrl[i]));
+    if (it > weight) {
+      weight = it;
+      best = i;
+    }
+  }
+  if (weight == 0) {
+    mDrift.Pause();
+    return;
+  }
+  mDrift.Update(
+    std::chrono::nanoseconds(frameInfo.mNow),
+    *pointCtrl[best].mDirection,
+    *handTracking[best].mDirection,
+    weight);
+}
+
+InputState FusionSource::FuseHand(
+  PointerMode pointerMode,
+  const FrameInfo& frameInfo,
+  const InputState& handTracking,
+  const InputState& pointCtrl,
+  FusionFilter* hand) {
+  InputState ret {handTracking.mHand};
+
+  if (mConfig->PinchToClick) {
+    ret.mActions.mPrimary = handTracking.mActions.mPrimary;
+    ret.mActions.mSecondary = handTracking.mActions.mSecondary;
+  }
+  if (mConfig->PinchToScroll) {
+    ret.mActions.mValueChange = handTracking.mActions.mValueChange;
+  }
+  if (mConfig->PointCtrlFCUMapping != PointCtrlFCUMapping::Disabled) {
+    ret.mActions.mPrimary
+      = ret.mActions.mPrimary || pointCtrl.mActions.mPrimary;
+    ret.mActions.mSecondary
+      = ret.mActions.mSecondary || pointCtrl.mActions.mSecondary;
+    if (pointCtrl.mActions.mValueChange != ActionState::ValueChange::None) {
+      ret.mActions.mValueChange = pointCtrl.mActions.mValueChange;
+    }
+  }
+
+  const auto fused = hand->Update(
+    *mConfig,
+    frameInfo.mNow,
+    GetSource(handTracking),
+    GetSource(pointCtrl));
+  const auto bias = hand->GetBias();
+
+  const auto drift = mDrift.GetCorrection();
+  TraceLoggingWrite(
+    gTraceProvider,
+    "FusionUpdate",
+    TraceLoggingValue(static_cast<int>(ret.mHand), "Hand"),
+    TraceLoggingValue(fused.mHandTrackingConfidence, "HandTrackingConfidence"),
+    TraceLoggingValue(fused.mPointCtrlConfidence, "PointCtrlConfidence"),
+    TraceLoggingValue(bias.x, "BiasX"),
+    TraceLoggingValue(bias.y, "BiasY"),
+    TraceLoggingValue(drift.mScale.x, "DriftScaleX"),
+    TraceLoggingValue(drift.mScale.y, "DriftScaleY"),
+    TraceLoggingValue(drift.mOffset.x, "DriftOffsetX"),
+    TraceLoggingValue(drift.mOffset.y, "DriftOffsetY"));
+
+  if (!fused.mDirection) {
+    return ret;
+  }
+  ret.mDirection = fused.mDirection;
+  ret.mPositionUpdatedAt
+    = std::max(handTracking.mPositionUpdatedAt, pointCtrl.mPositionUpdatedAt);
+
+  if (pointerMode != PointerMode::Pose) {
+    return ret;
+  }
+
+  // Project the fused direction out to the hand, or to ProjectionDistance if
+  // we don't have a hand position
+  auto distance = mConfig->ProjectionDistance;
+  if (handTracking.mPose) {
+    const auto inView = *handTracking.mPose * frameInfo.mLocalInView;
+    distance = XrVecToSM(inView.position).Length();
+  }
+
+  const auto rotation
+    = Quaternion::CreateFromAxisAngle(Vector3::UnitX, ret.mDirection->x)
+    * Quaternion::CreateFromAxisAngle(Vector3::UnitY, -ret.mDirection->y);
+  const XrPosef viewPose {
+    .orientation = SMQuatToXr(rotation),
+    .position
+    = SMVecToXr(Vector3::Transform({0.0f, 0.0f, -distance}, rotation)),
+  };
+  ret.mPose = viewPose * frameInfo.mViewInLocal;
+  return ret;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,75 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <memory>
+#include <tuple>
+
+#include "Config.h"
+#include "FusionFilter.h"
+#include "InputSource.h"
+#include "PointCtrlDriftEstimator.h"
+
+namespace HandTrackedCockpitClicking {
+
+class HandTrackingSource;
+class PointCtrlSource;
+
+/** Combines PointCtrl and OpenXR hand tracking into a single pointer.
+ *
+ * This is a complementary filter: PointCtrl is low-latency but only gives a
+ * direction, and drifts as the sensor moves on the finger; hand tracking is
+ * noisier and slower, but gives an absolute position.
+ *
+ * The pointer follows PointCtrl, plus a per-hand bias that is continuously
+ * pulled towards the hand tracking direction at `FusionCorrectionRate`.
+ * Each source is weighted by how recently its position was updated; as
+ * PointCtrl goes stale, the pointer fades over to hand tracking, so there is
+ * no jump when PointCtrl stops reporting. This part is in `FusionFilter`, so
+ * that it can be replayed.
+ *
+ * If hand tracking has a pose, its distance from the headset is used for the
+ * depth of the fused pose.
+ *
+ * If `FusionDriftCorrection` is enabled, PointCtrl is first corrected for
+ * scale and center drift by a `PointCtrlDriftEstimator`; this is much slower
+ * than the bias, but also corrects scale, and is shared by both hands, as
+ * it's the same sensor.
+ */
+class FusionSource final : public InputSource {
+ public:
+  FusionSource(
+    HandTrackingSource*,
+    PointCtrlSource*,
+    std::shared_ptr<const Config::Snapshot>);
+
+  std::tuple<InputState, InputState> Update(PointerMode, const FrameInfo&)
+    override;
+
+  void ReloadConfig(std::shared_ptr<const Config::Snapshot>);
+
+ private:
+  HandTrackingSource* mHandTracking {nullptr};
+  PointCtrlSource* mPointCtrl {nullptr};
+  std::shared_ptr<const Config::Snapshot> mConfig;
+
+  PointCtrlDriftEstimator mDrift {
+    PointCtrlDriftEstimator::Parameters::FromConfig(*mConfig)};
+
+  std::array<FusionFilter, 2> mHands {};
+
+  void UpdateDrift(
+    const FrameInfo&,
+    const std::array<InputState, 2>& handTracking,
+    const std::array<InputState, 2>& pointCtrl);
+
+  InputState FuseHand(
+    PointerMode,
+    const FrameInfo&,
+    const InputState& handTracking,
+    const InputState& pointCtrl,
+    FusionFilter* hand);
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -7,7 +7,6 @@
 #include <array>
 #include <chrono>
 #include <cmath>
-#include <thread>
 
 #include "Config.h"
 #include "Environment.h"
@@ -19,27 +18,54 @@ namespace HandTrackedCockpitClicking {
 HandTrackingSource::HandTrackingSource(
   const std::shared_ptr<OpenXRNext>& next,
   XrInstance instance,
+  const Environment::InstanceInfo& environment,
   XrSession session,
   XrSpace viewSpace,
-  XrSpace localSpace)
+  XrSpace localSpace,
+  std::shared_ptr<const Config::Snapshot> config)
   : mOpenXR(next),
     mInstance(instance),
+    mHaveAimFB(environment.Have_XR_FB_hand_tracking_aim),
     mSession(session),
     mViewSpace(viewSpace),
-    mLocalSpace(localSpace) {
+    mLocalSpace(localSpace),
+    mConfig(std::move(config)),
+    mWakeStateMachine(HandWakeStateMachine::Timings::FromConfig(*mConfig)),
+    mGates(HandTrackingGates::Parameters::FromConfig(*mConfig)),
+    mLeftHand(XR_HAND_LEFT_EXT, *mConfig),
+    mRightHand(XR_HAND_RIGHT_EXT, *mConfig) {
   DebugPrint(
     "HandTrackingSource - PointerSource: {}; PinchToClick: {}; PinchToScroll: "
     "{}",
-    Config::PointerSource == PointerSource::OpenXRHandTracking,
-    Config::PinchToClick,
-    Config::PinchToScroll);
+    mConfig->PointerSource != PointerSource::PointCtrl,
+    mConfig->PinchToClick,
+    mConfig->PinchToScroll);
+
+  if (!mConfig->HandTrackingCaptureFile.empty()) {
+    mCapture = std::make_unique<SessionCapture::Writer>(
+      std::filesystem::path {mConfig->HandTrackingCaptureFile});
+  }
+}
+
+HandTrackingSource::Hand::Hand(XrHandEXT hand, const Config::Snapshot& config)
+  : mHand(hand),
+    mPinchDetector(PinchDetector::Thresholds::FromConfig(config)),
+    mPinchOnset(PinchOnsetPredictor::Parameters::FromConfig(config)),
+    mSamplePinchDetector(PinchDetector::Thresholds::FromConfig(config)) {
 }
 
 HandTrackingSource::~HandTrackingSource() {
-  for (const auto& hand: {mLeftHand, mRightHand}) {
-    if (hand.mTracker) {
-      mOpenXR->xrDestroyHandTrackerEXT(hand.mTracker);
+  for (const auto hand: {&mLeftHand, &mRightHand}) {
+    if (hand->mTracker) {
+      mOpenXR->xrDestroyHandTrackerEXT(hand->mTracker);
     }
+    DebugPrint(
+      "Hand {}: located joints {} times; skipped {} frames and {} samples "
+      "while idle",
+      static_cast<int>(hand->mHand),
+      hand->mLocateCount,
+      hand->mSkippedLocateCount,
+      hand->mSkippedSampleCount);
   }
 }
 
@@ -48,37 +74,15 @@ static constexpr bool HasFlags(Actual actual, Wanted wanted) {
   return (actual & wanted) == wanted;
 }
 
-std::tuple<XrPosef, XrVector2f> HandTrackingSource::RaycastPose(
-  const FrameInfo& frameInfo,
-  const XrPosef& pose) {
-  const auto& p = (pose * frameInfo.mLocalInView).position;
-  const auto rx = std::atan2f(p.y, -p.z);
-  const auto ry = std::atan2f(p.x, -p.z);
-
-  const auto o = Quaternion::CreateFromAxisAngle(Vector3::UnitX, rx)
-    * Quaternion::CreateFromAxisAngle(Vector3::UnitY, -ry);
-  const XrPosef retView = {
-    {o.x, o.y, o.z, o.w},
-    pose.position,
-  };
-
-  return {
-    {
-      (retView * frameInfo.mViewInLocal).orientation,
-      pose.position,
-    },
-    {rx, ry},
-  };
-}
-
 static void PopulateInteractions(
+  const Config::Snapshot& config,
   XrHandTrackingAimFlagsFB status,
   ActionState* hand) {
-  hand->mPrimary = Config::PinchToClick
+  hand->mPrimary = config.PinchToClick
     && HasFlags(status, XR_HAND_TRACKING_AIM_INDEX_PINCHING_BIT_FB);
-  hand->mSecondary = Config::PinchToClick
+  hand->mSecondary = config.PinchToClick
     && HasFlags(status, XR_HAND_TRACKING_AIM_MIDDLE_PINCHING_BIT_FB);
-  if (!Config::PinchToScroll) {
+  if (!config.PinchToScroll) {
     return;
   }
 
@@ -92,20 +96,58 @@ static void PopulateInteractions(
   }
 }
 
-static bool UseHandTrackingAimPointFB() {
-  return Config::UseHandTrackingAimPointFB
-    && Environment::Have_XR_FB_hand_tracking_aim;
+// Pinch bits for the hand, from XR_FB_hand_tracking_aim if available,
+// otherwise from the joint locations
+static XrHandTrackingAimFlagsFB PinchStatus(
+  const XrHandJointLocationsEXT& joints,
+  const std::array<XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT>&
+    jointLocations,
+  const XrHandTrackingAimStateFB* aimFB,
+  PinchDetector* detector) {
+  if (!joints.isActive) {
+    detector->Reset();
+    return {};
+  }
+  if (aimFB) {
+    return aimFB->status;
+  }
+  return detector->Update(jointLocations);
+}
+
+static HandWakeStateMachine::Hand WakeHand(XrHandEXT hand) {
+  return (hand == XR_HAND_LEFT_EXT) ? HandWakeStateMachine::Hand::Left
+                                    : HandWakeStateMachine::Hand::Right;
+}
+
+static HandWakeStateMachine::Time WakeTime(XrTime time) {
+  return std::chrono::nanoseconds(time);
 }
 
+
 std::tuple<InputState, InputState> HandTrackingSource::Update(
   PointerMode,
   const FrameInfo& frameInfo) {
   this->UpdateHand(frameInfo, &mLeftHand);
   this->UpdateHand(frameInfo, &mRightHand);
+  if (mCapture) {
+    mCapture->Write({
+      frameInfo,
+      {mLeftHand.mObservation, mRightHand.mObservation},
+      mCapturedPointCtrl,
+    });
+    mCapturedPointCtrl = {};
+  }
+  // With idle polling off, idle hands are still sampled between frames
+  const auto throttle = (mConfig->HandTrackingIdlePollMilliseconds > 0);
+  for (const auto hand: {&mLeftHand, &mRightHand}) {
+    hand->mIdle.store(
+      throttle && mWakeStateMachine.IsIdle(WakeHand(hand->mHand)),
+      std::memory_order_relaxed);
+  }
 
   const auto& leftState = mLeftHand.mState;
   const auto& rightState = mRightHand.mState;
-  if (!Config::OneHandOnly) {
+  if (!mConfig->OneHandOnly) {
     return {leftState, rightState};
   }
 
@@ -139,9 +181,82 @@ std::tuple<InputState, InputState> HandTrackingSource::Update(
   return {{XR_HAND_LEFT_EXT}, rightState};
 }
 
+void HandTrackingSource::Sample(XrTime now) {
+  // Only the pinch state is sampled; the pose is still located once per frame
+  // at the predicted display time
+  for (const auto hand: {&mLeftHand, &mRightHand}) {
+    if (!hand->mTrackerReady.load(std::memory_order_acquire)) {
+      continue;
+    }
+    if (hand->mIdle.load(std::memory_order_relaxed)) {
+      ++hand->mSkippedSampleCount;
+      continue;
+    }
+
+    XrHandJointsLocateInfoEXT locateInfo {
+      .type = XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT,
+      .baseSpace = mLocalSpace,
+      .time = now,
+    };
+    std::array<XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT> jointLocations;
+    XrHandTrackingAimStateFB aimFB {XR_TYPE_HAND_TRACKING_AIM_STATE_FB};
+    XrHandJointLocationsEXT joints {
+      .type = XR_TYPE_HAND_JOINT_LOCATIONS_EXT,
+      .jointCount = jointLocations.size(),
+      .jointLocations = jointLocations.data(),
+    };
+    if (mHaveAimFB) {
+      joints.next = &aimFB;
+    }
+    if (!mOpenXR->check_xrLocateHandJointsEXT(
+          hand->mTracker, &locateInfo, &joints)) {
+      continue;
+    }
+    const auto status = PinchStatus(
+      joints,
+      jointLocations,
+      mHaveAimFB ? &aimFB : nullptr,
+      &hand->mSamplePinchDetector);
+    hand->mSamples.Push({now, status});
+  }
+}
+
 void HandTrackingSource::KeepAlive(XrHandEXT handID, const FrameInfo& info) {
-  auto& hand = (handID == XR_HAND_LEFT_EXT) ? mLeftHand : mRightHand;
-  hand.mLastKeepAliveAt = info.mNow;
+  mWakeStateMachine.KeepAlive(WakeHand(handID), WakeTime(info.mNow));
+}
+
+void HandTrackingSource::ReloadConfig(
+  std::shared_ptr<const Config::Snapshot> config) {
+  mConfig = std::move(config);
+  mWakeStateMachine.SetTimings(
+    HandWakeStateMachine::Timings::FromConfig(*mConfig));
+  mGates
+    = HandTrackingGates {HandTrackingGates::Parameters::FromConfig(*mConfig)};
+}
+
+void HandTrackingSource::CapturePointCtrl(
+  const InputState& left,
+  const InputState& right) {
+  if (mCapture) {
+    mCapturedPointCtrl = {
+      SessionCapture::PointCtrlObservation {left},
+      SessionCapture::PointCtrlObservation {right},
+    };
+  }
+}
+
+bool HandTrackingSource::IsAwake(XrHandEXT handID) const {
+  return mWakeStateMachine.GetState(WakeHand(handID))
+    == HandWakeStateMachine::State::Awake;
+}
+
+bool HandTrackingSource::IsTracked(XrHandEXT handID) const {
+  return (handID == XR_HAND_LEFT_EXT) ? mLeftHand.mTracked
+                                      : mRightHand.mTracked;
+}
+
+bool HandTrackingSource::IsHibernating() const {
+  return mWakeStateMachine.IsHibernating();
 }
 
 void HandTrackingSource::UpdateHand(const FrameInfo& frameInfo, Hand* hand) {
@@ -151,10 +266,37 @@ void HandTrackingSource::UpdateHand(const FrameInfo& frameInfo, Hand* hand) {
     return;
   }
 
+  // If the sampler is running, it may have seen a gesture start between
+  // frames; record when it was actually first seen. This is drained even if
+  // we bail out early below, so that stale samples don't build up.
+  const auto wakeHand = WakeHand(hand->mHand);
+  const auto now = WakeTime(frameInfo.mNow);
+  hand->mSamples.Drain([this, hand](const HandSample& sample) {
+    ActionState sampled {};
+    PopulateInteractions(*mConfig, sample.mAimStatus, &sampled);
+    this->ObserveRawActions(hand, sampled, sample.mTime);
+  });
+
+  // While a hand is asleep or hibernating, we only need to locate it often
+  // enough to notice that it might be time to wake up
+  if (
+    hand->mLastLocateAt && mWakeStateMachine.IsIdle(wakeHand)
+    && std::chrono::nanoseconds(frameInfo.mNow - hand->mLastLocateAt)
+      < std::chrono::milliseconds(mConfig->HandTrackingIdlePollMilliseconds)) {
+    ++hand->mSkippedLocateCount;
+    hand->mObservation = {};
+    hand->mState = {hand->mHand};
+    mWakeStateMachine.Step(wakeHand, now, {});
+    return;
+  }
+  hand->mLastLocateAt = frameInfo.mNow;
+  ++hand->mLocateCount;
+
   const auto displayTime = frameInfo.mPredictedDisplayTime;
 
   auto& state = hand->mState;
   state.mHand = hand->mHand;
+  auto& observation = hand->mObservation;
 
   XrHandJointsLocateInfoEXT locateInfo {
     .type = XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT,
@@ -172,23 +314,26 @@ void HandTrackingSource::UpdateHand(const FrameInfo& frameInfo, Hand* hand) {
   };
 
   XrHandTrackingAimStateFB aimFB {XR_TYPE_HAND_TRACKING_AIM_STATE_FB};
-  if (Environment::Have_XR_FB_hand_tracking_aim) {
+  if (mHaveAimFB) {
     joints.next = &aimFB;
   }
 
+  hand->mTracked = false;
   if (!mOpenXR->check_xrLocateHandJointsEXT(
         hand->mTracker, &locateInfo, &joints)) {
+    observation = {};
     state = {hand->mHand};
+    mWakeStateMachine.Step(wakeHand, now, {});
     return;
   }
 
   if (
-    UseHandTrackingAimPointFB()
+    mHaveAimFB && mConfig->UseHandTrackingAimPointFB
     && HasFlags(aimFB.status, XR_HAND_TRACKING_AIM_VALID_BIT_FB)) {
     state.mPositionUpdatedAt = frameInfo.mNow;
     state.mPose = {aimFB.aimPose};
   } else if (joints.isActive) {
-    if (const auto joint = jointLocations[Config::HandTrackingAimJoint];
+    if (const auto joint = jointLocations[mConfig->HandTrackingAimJoint];
         HasFlags(joint.locationFlags, XR_SPACE_LOCATION_ORIENTATION_VALID_BIT)
         && HasFlags(
           joint.locationFlags, XR_SPACE_LOCATION_POSITION_VALID_BIT)) {
@@ -198,153 +343,150 @@ void HandTrackingSource::UpdateHand(const FrameInfo& frameInfo, Hand* hand) {
   }
 
   if (!state.mPose) {
+    observation = {.mTracking = HandWakeStateMachine::Tracking::Untracked};
     state = {hand->mHand};
-    if (
-      hand->mLastKeepAliveAt && (!hand->mSleeping)
-      && std::chrono::nanoseconds(frameInfo.mNow - hand->mLastKeepAliveAt)
-        >= std::chrono::milliseconds(Config::HandTrackingSleepMilliseconds)) {
-      hand->mWakeConditionsSince = {};
-      hand->mHibernateGestureSince = {};
-      hand->mSleeping = true;
-      PlayBeeps(BeepEvent::Sleep);
-    }
+    HandleWakeEvents(
+      *hand,
+      mWakeStateMachine.Step(
+        wakeHand, now, mGates.GetWakeInput(frameInfo, observation)));
     return;
   }
 
   const auto age
     = std::chrono::nanoseconds(frameInfo.mNow - state.mPositionUpdatedAt);
   if (age > std::chrono::milliseconds(200)) {
+    observation = {};
     state = {hand->mHand};
+    mWakeStateMachine.Step(wakeHand, now, {});
     return;
   }
 
-  const auto [raycastPose, rotation] = RaycastPose(frameInfo, *state.mPose);
+  hand->mTracked = true;
 
-  const auto arx = std::abs(rotation.x);
-  const auto ary = std::abs(rotation.y);
-  if (
-    arx <= (Config::HandTrackingWakeVFOV / 2)
-    && ary <= (Config::HandTrackingWakeHFOV / 2)) {
-    if (!hand->mWakeConditionsSince) {
-      hand->mWakeConditionsSince = frameInfo.mNow;
-    }
-  } else {
-    hand->mWakeConditionsSince = {};
+  observation = {
+    .mTracking = HandWakeStateMachine::Tracking::Tracked,
+    .mPositionUpdatedAt = state.mPositionUpdatedAt,
+    .mPose = *state.mPose,
+  };
+  PopulateInteractions(
+    *mConfig,
+    PinchStatus(
+      joints,
+      jointLocations,
+      mHaveAimFB ? &aimFB : nullptr,
+      &hand->mPinchDetector),
+    &observation.mRawActions);
+  this->UpdatePinchOnset(hand, frameInfo.mNow, joints);
+  this->ObserveRawActions(hand, observation.mRawActions, frameInfo.mNow);
+  observation.mRawActionsSince
+    = mWakeStateMachine.GetRawActionsSince(wakeHand).count();
+
+  const auto output = mWakeStateMachine.Step(
+    wakeHand, now, mGates.GetWakeInput(frameInfo, observation));
+  HandleWakeEvents(*hand, output);
+
+  if (!output.mActive) {
+    state = {hand->mHand};
+    hand->mHeldPointer = {};
+    return;
   }
 
-  const bool wasSleeping = hand->mSleeping;
+  state = mGates.GetInputState(
+    hand->mHand, frameInfo, observation, output.mActions);
 
-  const auto inActionFOV = arx <= (Config::HandTrackingActionVFOV / 2)
-    && ary <= (Config::HandTrackingActionHFOV / 2);
+  if (mConfig->HandTrackingPinchPoseRollback) {
+    this->ApplyPoseRollback(hand, frameInfo.mNow);
+  }
+}
 
-  if (inActionFOV) {
-    hand->mLastKeepAliveAt = frameInfo.mNow;
+void HandTrackingSource::ApplyPoseRollback(Hand* hand, XrTime now) {
+  auto& state = hand->mState;
+  if (!(state.mActions.mPrimary || state.mActions.mSecondary)) {
+    hand->mHeldPointer = {};
+    hand->mPointerHistory[hand->mPointerHistoryNext] = {
+      now,
+      state.mPose,
+      state.mDirection,
+    };
+    hand->mPointerHistoryNext
+      = (hand->mPointerHistoryNext + 1) % hand->mPointerHistory.size();
+    return;
   }
 
-  if (
-    hand->mWakeConditionsSince
-    && std::chrono::nanoseconds(frameInfo.mNow - hand->mWakeConditionsSince)
-      >= std::chrono::milliseconds(Config::HandTrackingWakeMilliseconds)) {
-    hand->mSleeping = false;
-  } else if (
-    hand->mLastKeepAliveAt
-    && std::chrono::nanoseconds(frameInfo.mNow - hand->mLastKeepAliveAt)
-      >= std::chrono::milliseconds(Config::HandTrackingSleepMilliseconds)) {
-    hand->mSleeping = true;
-  }
-
-  {
-    ActionState rawActions {};
-    PopulateInteractions(aimFB.status, &rawActions);
-    if (rawActions != hand->mRawActions) {
-      hand->mRawActionsSince = frameInfo.mNow;
-      hand->mRawActions = rawActions;
-    } else if (
-      hand->mRawActionsSince
-      && std::chrono::nanoseconds(frameInfo.mNow - hand->mRawActionsSince)
-        >= std::chrono::milliseconds(Config::HandTrackingGestureMilliseconds)) {
-      // Inverted because l-r movement is rotation in x axis
-#define FILTER_ACTION(x) \
-  state.mActions.x = rawActions.x && (state.mActions.x || inActionFOV)
-      FILTER_ACTION(mPrimary);
-      FILTER_ACTION(mSecondary);
-#undef FILTER_ACTION
-      using ValueChange = ActionState::ValueChange;
+  if (!hand->mHeldPointer) {
+    // Use the most recent sample from before the pinch started; if we don't
+    // have a recent one, the current pose is the best we can do.
+    const auto onset
+      = mWakeStateMachine.GetRawActionsSince(WakeHand(hand->mHand)).count();
+    const PointerSample* best = nullptr;
+    for (const auto& sample: hand->mPointerHistory) {
       if (
-        inActionFOV
-        || (rawActions.mValueChange == state.mActions.mValueChange)) {
-        state.mActions.mValueChange = rawActions.mValueChange;
-      } else {
-        state.mActions.mValueChange = ValueChange::None;
+        (!sample.mTime) || sample.mTime >= onset
+        || std::chrono::nanoseconds(onset - sample.mTime)
+          > std::chrono::milliseconds(200)) {
+        continue;
+      }
+      if ((!best) || sample.mTime > best->mTime) {
+        best = &sample;
       }
     }
+    hand->mHeldPointer = best
+      ? *best
+      : PointerSample {now, state.mPose, state.mDirection};
   }
 
-  if (
-    Config::HandTrackingHibernateGestureEnabled
-    && Config::HandTrackingHibernateIntervalMilliseconds
-    && Config::HandTrackingHibernateCutoff > 0.001
-    && rotation.x >= Config::HandTrackingHibernateCutoff
-    && hand->mState.mPose->position.y > frameInfo.mViewInLocal.position.y
-    && std::chrono::nanoseconds(frameInfo.mNow - mLastHibernationChangeAt)
-      >= std::chrono::milliseconds(
-         Config::HandTrackingHibernateIntervalMilliseconds)) {
-    if (!hand->mHibernateGestureSince) {
-      hand->mHibernateGestureSince = frameInfo.mNow;
-    }
-  } else {
-    hand->mHibernateGestureSince = {};
-  }
-
-  if (state.mActions.Any()) {
-    hand->mLastKeepAliveAt = frameInfo.mNow;
-    hand->mHibernateGestureSince = {};
+  state.mPose = hand->mHeldPointer->mPose;
+  state.mDirection = hand->mHeldPointer->mDirection;
+}
 
-    hand->mSleeping = false;
+void HandTrackingSource::UpdatePinchOnset(
+  Hand* hand,
+  XrTime now,
+  const XrHandJointLocationsEXT& joints) {
+  const auto& thumb = joints.jointLocations[XR_HAND_JOINT_THUMB_TIP_EXT];
+  const auto& index = joints.jointLocations[XR_HAND_JOINT_INDEX_TIP_EXT];
+  if (!(joints.isActive
+        && HasFlags(thumb.locationFlags, XR_SPACE_LOCATION_POSITION_VALID_BIT)
+        && HasFlags(
+          index.locationFlags, XR_SPACE_LOCATION_POSITION_VALID_BIT))) {
+    hand->mPinchOnset.Reset();
+    return;
   }
 
-  if (hand->mSleeping && !wasSleeping) {
-    DebugPrint("Sleeping hand {}", static_cast<int>(hand->mHand));
-    PlayBeeps(BeepEvent::Sleep);
-  } else if (wasSleeping && !hand->mSleeping) {
-    DebugPrint("Waking hand {}", static_cast<int>(hand->mHand));
-    PlayBeeps(BeepEvent::Wake);
+  const auto distance = Vector3::Distance(
+    {thumb.pose.position.x, thumb.pose.position.y, thumb.pose.position.z},
+    {index.pose.position.x, index.pose.position.y, index.pose.position.z});
+  hand->mObservation.mPinchDistance = distance;
+  const auto result = hand->mPinchOnset.Observe(WakeTime(now), distance);
+  if (result == PinchOnsetPredictor::Result::Cancelled) {
+    TraceLoggingWrite(
+      gTraceProvider,
+      "PinchOnsetCancelled",
+      TraceLoggingValue(static_cast<int>(hand->mHand), "Hand"));
   }
+}
 
-  if (
-    hand->mHibernateGestureSince && Config::HandTrackingHibernateMilliseconds
-    && std::chrono::nanoseconds(frameInfo.mNow - hand->mHibernateGestureSince)
-      >= std::chrono::milliseconds(Config::HandTrackingHibernateMilliseconds)) {
-    hand->mHibernateGestureSince = {};
-    mLastHibernationChangeAt = frameInfo.mNow;
-    if (mHibernating) {
-      DebugPrint("Waking from hibernation");
-      PlayBeeps(BeepEvent::HibernateWake);
-      mHibernating = false;
-    } else {
-      DebugPrint("Entering hibernation");
-      PlayBeeps(BeepEvent::HibernateSleep);
-      mHibernating = true;
+// Start the debounce period from the predicted pinch onset, if any
+void HandTrackingSource::ObserveRawActions(
+  Hand* hand,
+  const ActionState& actions,
+  XrTime at) {
+  auto since = WakeTime(at);
+  if (actions.mPrimary && !hand->mRawPrimary) {
+    if (const auto onset = hand->mPinchOnset.TakeOnset(since)) {
+      TraceLoggingWrite(
+        gTraceProvider,
+        "PinchOnsetPredicted",
+        TraceLoggingValue(static_cast<int>(hand->mHand), "Hand"),
+        TraceLoggingValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(since - *onset)
+            .count(),
+          "LeadMicroseconds"));
+      since = *onset;
     }
   }
-
-  if (hand->mSleeping || mHibernating) {
-    state = {hand->mHand};
-    return;
-  }
-
-  state.mDirection = {rotation};
-  switch (Config::HandTrackingOrientation) {
-    case HandTrackingOrientation::Raw:
-      break;
-    case HandTrackingOrientation::RayCast:
-      state.mPose = raycastPose;
-      break;
-    case HandTrackingOrientation::RayCastWithReprojection:
-      // reproject from direction
-      state.mPose = {};
-      break;
-  }
+  hand->mRawPrimary = actions.mPrimary;
+  mWakeStateMachine.ObserveRawActions(WakeHand(hand->mHand), actions, since);
 }
 
 void HandTrackingSource::InitHandTracker(Hand* hand) {
@@ -356,13 +498,13 @@ void HandTrackingSource::InitHandTracker(Hand* hand) {
   }
 
   if (
-    Config::HandTrackingHands == HandTrackingHands::Left
+    mConfig->HandTrackingHands == HandTrackingHands::Left
     && hand->mHand == XR_HAND_RIGHT_EXT) {
     return;
   }
 
   if (
-    Config::HandTrackingHands == HandTrackingHands::Right
+    mConfig->HandTrackingHands == HandTrackingHands::Right
     && hand->mHand == XR_HAND_LEFT_EXT) {
     return;
   }
@@ -383,48 +525,46 @@ void HandTrackingSource::InitHandTracker(Hand* hand) {
     return;
   }
 
+  hand->mTrackerReady.store(true, std::memory_order_release);
   DebugPrint("Initialized hand tracker {}.", static_cast<int>(hand->mHand));
 }
 
-void HandTrackingSource::PlayBeeps(BeepEvent event) const {
-  switch (event) {
+void HandTrackingSource::HandleWakeEvents(
+  const Hand& hand,
+  const HandWakeStateMachine::Output& output) {
+  using Event = HandWakeStateMachine::Event;
+  if (output.mHandEvent) {
+    DebugPrint(
+      "{} hand {}",
+      (*output.mHandEvent == Event::Sleep) ? "Sleeping" : "Waking",
+      static_cast<int>(hand.mHand));
+    PlayBeeps({*output.mHandEvent, WakeHand(hand.mHand)});
+  }
+  if (output.mHibernationEvent) {
+    DebugPrint(
+      "{}",
+      (*output.mHibernationEvent == Event::HibernateSleep)
+        ? "Entering hibernation"
+        : "Waking from hibernation");
+    PlayBeeps({*output.mHibernationEvent});
+  }
+}
+
+void HandTrackingSource::PlayBeeps(const Feedback& feedback) {
+  switch (feedback.mEvent) {
     case BeepEvent::Wake:
     case BeepEvent::Sleep:
-      if (!Config::HandTrackingWakeSleepBeeps) {
+      if (!mConfig->HandTrackingWakeSleepBeeps) {
         return;
       }
     case BeepEvent::HibernateWake:
     case BeepEvent::HibernateSleep:
-      if (!Config::HandTrackingHibernateBeeps) {
+      if (!mConfig->HandTrackingHibernateBeeps) {
         return;
       }
   }
 
-  std::thread beepThread {[event]() {
-    constexpr DWORD lowNote {262};// C4
-    constexpr DWORD highNote {440};// A4
-    constexpr DWORD ms = {100};
-
-    switch (event) {
-      case BeepEvent::HibernateWake:
-        Beep(lowNote, ms);
-        Beep(highNote, ms);
-        [[fallthrough]];
-      case BeepEvent::Wake:
-        Beep(lowNote, ms);
-        Beep(highNote, ms);
-        return;
-      case BeepEvent::HibernateSleep:
-        Beep(highNote, ms);
-        Beep(lowNote, ms);
-        [[fallthrough]];
-      case BeepEvent::Sleep:
-        Beep(highNote, ms);
-        Beep(lowNote, ms);
-        return;
-    }
-  }};
-  beepThread.detach();
+  mFeedback.Enqueue(feedback);
 }
 
 }// namespace HandTrackedCockpitClicking
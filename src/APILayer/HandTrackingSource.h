@@ -4,10 +4,22 @@
 
 #include <openxr/openxr.h>
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <tuple>
 
+#include "Config.h"
+#include "Environment.h"
+#include "FeedbackWorker.h"
+#include "HandTrackingGates.h"
+#include "HandWakeStateMachine.h"
 #include "InputSource.h"
 #include "OpenXRNext.h"
+#include "PinchDetector.h"
+#include "PinchOnsetPredictor.h"
+#include "SampleRing.h"
+#include "SessionCapture.h"
 
 namespace HandTrackedCockpitClicking {
 
@@ -16,56 +28,110 @@ class HandTrackingSource final : public InputSource {
   HandTrackingSource(
     const std::shared_ptr<OpenXRNext>& next,
     XrInstance instance,
+    const Environment::InstanceInfo&,
     XrSession session,
     XrSpace viewSpace,
-    XrSpace localSpace);
+    XrSpace localSpace,
+    std::shared_ptr<const Config::Snapshot>);
   ~HandTrackingSource();
 
   std::tuple<InputState, InputState> Update(PointerMode, const FrameInfo&)
     override;
+  void Sample(XrTime now) override;
 
   void KeepAlive(XrHandEXT, const FrameInfo&);
+  // Switch to a new config; the pinch detectors keep the thresholds they were
+  // created with
+  void ReloadConfig(std::shared_ptr<const Config::Snapshot>);
+  // Include PointCtrl in the next captured frame, if capturing
+  void CapturePointCtrl(const InputState& left, const InputState& right);
+
+  bool IsAwake(XrHandEXT) const;
+  // True if the runtime is tracking the hand, even if it's asleep
+  bool IsTracked(XrHandEXT) const;
+  bool IsHibernating() const;
 
  private:
   std::shared_ptr<OpenXRNext> mOpenXR;
   XrInstance mInstance {};
+  // XR_FB_hand_tracking_aim was enabled for the instance
+  bool mHaveAimFB {false};
   XrSession mSession {};
   XrSpace mViewSpace {};
   XrSpace mLocalSpace {};
+  // Only used on the frame thread
+  std::shared_ptr<const Config::Snapshot> mConfig;
+
+  struct HandSample {
+    XrTime mTime {};
+    XrHandTrackingAimFlagsFB mAimStatus {};
+  };
+
+  struct PointerSample {
+    XrTime mTime {};
+    std::optional<XrPosef> mPose;
+    std::optional<XrVector2f> mDirection;
+  };
 
   struct Hand {
+    Hand(XrHandEXT, const Config::Snapshot&);
+
     XrHandEXT mHand;
     InputState mState {mHand};
     XrHandTrackerEXT mTracker {};
     std::optional<XrResult> mTrackerError;
-    bool mSleeping {true};
-    XrTime mLastKeepAliveAt {};
-    XrTime mWakeConditionsSince {};
-    XrTime mHibernateGestureSince {};
+    // Set once mTracker is usable from the sampler thread
+    std::atomic_bool mTrackerReady {false};
+    SampleRing<HandSample, 64> mSamples;
+    // Mirrors IsIdle() for the sampler thread
+    std::atomic_bool mIdle {false};
 
-    ActionState mRawActions {};
-    XrTime mRawActionsSince {};
+    XrTime mLastLocateAt {};
+    // As of the last locate
+    bool mTracked {false};
+    // As of the last frame, whether or not the hand was located
+    HandObservation mObservation {};
+    uint64_t mLocateCount {};
+    uint64_t mSkippedLocateCount {};
+    // Used if XR_FB_hand_tracking_aim is unavailable
+    PinchDetector mPinchDetector;
+    PinchOnsetPredictor mPinchOnset;
+    bool mRawPrimary {false};
+
+    // Recent pointer positions, for HandTrackingPinchPoseRollback
+    std::array<PointerSample, 32> mPointerHistory {};
+    std::size_t mPointerHistoryNext {};
+    std::optional<PointerSample> mHeldPointer;
+
+    // Only touched by the sampler thread
+    uint64_t mSkippedSampleCount {};
+    PinchDetector mSamplePinchDetector;
   };
 
-  bool mHibernating {false};
-  XrTime mLastHibernationChangeAt {};
+  HandWakeStateMachine mWakeStateMachine;
+  HandTrackingGates mGates;
+
+  // Only if HandTrackingCaptureFile is set
+  std::unique_ptr<SessionCapture::Writer> mCapture;
+  std::array<SessionCapture::PointCtrlObservation, 2> mCapturedPointCtrl {};
 
-  Hand mLeftHand {XR_HAND_LEFT_EXT};
-  Hand mRightHand {XR_HAND_RIGHT_EXT};
+  Hand mLeftHand;
+  Hand mRightHand;
 
   void InitHandTracker(Hand* hand);
   void UpdateHand(const FrameInfo&, Hand* hand);
-  std::tuple<XrPosef, XrVector2f> RaycastPose(
-    const FrameInfo&,
-    const XrPosef& pose);
-
-  enum class BeepEvent {
-    Wake,
-    Sleep,
-    HibernateWake,
-    HibernateSleep,
-  };
-  void PlayBeeps(BeepEvent) const;
+  void UpdatePinchOnset(
+    Hand* hand,
+    XrTime now,
+    const XrHandJointLocationsEXT& joints);
+  void ObserveRawActions(Hand* hand, const ActionState&, XrTime at);
+  void ApplyPoseRollback(Hand* hand, XrTime now);
+  void HandleWakeEvents(const Hand&, const HandWakeStateMachine::Output&);
+
+  FeedbackWorker mFeedback {std::make_unique<BeepFeedbackOutput>()};
+
+  using BeepEvent = FeedbackEvent;
+  void PlayBeeps(const Feedback&);
 };
 
 }// namespace HandTrackedCockpitClicking
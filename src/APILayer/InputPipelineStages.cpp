@@ -0,0 +1,295 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "InputPipelineStages.h"
+
+#include <directxtk/SimpleMath.h>
+
+#include <cmath>
+
+#include "Config.h"
+#include "EyeGazeSource.h"
+#include "FusionSource.h"
+#include "HandTrackingSource.h"
+#include "PointCtrlSource.h"
+#include "SmoothingStage.h"
+#include "VirtualControllerSink.h"
+#include "VirtualTouchScreenSink.h"
+#include "openxr.h"
+
+using namespace DirectX::SimpleMath;
+
+namespace HandTrackedCockpitClicking {
+
+HandTrackingStage::HandTrackingStage(
+  HandTrackingSource* source,
+  PointerMode pointerMode,
+  const Config::Snapshot& config)
+  : mSource(source),
+    mPointerMode(pointerMode),
+    mUsePointer(config.PointerSource == PointerSource::OpenXRHandTracking),
+    mUseClicks(config.PinchToClick),
+    mUseScroll(config.PinchToScroll) {
+}
+
+std::string_view HandTrackingStage::GetName() const {
+  return "HandTracking";
+}
+
+void HandTrackingStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  const auto [l, r] = mSource->Update(
+    mUsePointer ? mPointerMode : PointerMode::None, frameInfo);
+  const InputPipeline::Hands source {l, r};
+
+  for (std::size_t i = 0; i < hands->size(); ++i) {
+    auto& hand = (*hands)[i];
+    const auto& in = source[i];
+    if (mUsePointer) {
+      hand.mPointerMode = mPointerMode;
+      hand.mPose = in.mPose;
+      hand.mDirection = in.mDirection;
+    }
+    if (mUseClicks) {
+      hand.mActions.mPrimary = in.mActions.mPrimary;
+      hand.mActions.mSecondary = in.mActions.mSecondary;
+    }
+    if (mUseScroll) {
+      hand.mActions.mValueChange = in.mActions.mValueChange;
+    }
+  }
+}
+
+PointCtrlStage::PointCtrlStage(
+  PointCtrlSource* source,
+  PointerMode pointerMode,
+  const Config::Snapshot& config)
+  : mSource(source),
+    mPointerMode(pointerMode),
+    mUsePointer(config.PointerSource == PointerSource::PointCtrl),
+    mUseActions(config.PointCtrlFCUMapping != PointCtrlFCUMapping::Disabled) {
+}
+
+std::string_view PointCtrlStage::GetName() const {
+  return "PointCtrl";
+}
+
+void PointCtrlStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  const auto [l, r] = mSource->Update(mPointerMode, frameInfo);
+  const InputPipeline::Hands source {l, r};
+
+  for (std::size_t i = 0; i < hands->size(); ++i) {
+    auto& hand = (*hands)[i];
+    const auto& in = source[i];
+    if (mUsePointer) {
+      hand.mPointerMode = mPointerMode;
+      hand.mPose = in.mPose;
+      hand.mDirection = in.mDirection;
+    }
+    if (mUseActions) {
+      hand.mActions.mPrimary = hand.mActions.mPrimary || in.mActions.mPrimary;
+      hand.mActions.mSecondary
+        = hand.mActions.mSecondary || in.mActions.mSecondary;
+      if (in.mActions.mValueChange != ActionState::ValueChange::None) {
+        hand.mActions.mValueChange = in.mActions.mValueChange;
+      }
+    }
+  }
+}
+
+FusionStage::FusionStage(FusionSource* source, PointerMode pointerMode)
+  : mSource(source), mPointerMode(pointerMode) {
+}
+
+std::string_view FusionStage::GetName() const {
+  return "Fusion";
+}
+
+void FusionStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  const auto [l, r] = mSource->Update(mPointerMode, frameInfo);
+  *hands = {l, r};
+  for (auto& hand: *hands) {
+    hand.mPointerMode = mPointerMode;
+  }
+}
+
+EyeGazeStage::EyeGazeStage(EyeGazeSource* source, PointerMode pointerMode)
+  : mSource(source), mPointerMode(pointerMode) {
+}
+
+std::string_view EyeGazeStage::GetName() const {
+  return "EyeGaze";
+}
+
+void EyeGazeStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  // Always reported as the right hand
+  const auto gaze = std::get<1>(mSource->Update(mPointerMode, frameInfo));
+
+  auto& [left, right] = *hands;
+  auto& pointing
+    = (left.mActions.Any() && !right.mActions.Any()) ? left : right;
+  for (auto& hand: *hands) {
+    hand.mPose = {};
+    hand.mDirection = {};
+  }
+  pointing.mDirection = gaze.mDirection;
+  pointing.mPositionUpdatedAt = gaze.mPositionUpdatedAt;
+}
+
+KeepAliveStage::KeepAliveStage(HandTrackingSource* handTracking)
+  : mHandTracking(handTracking) {
+}
+
+std::string_view KeepAliveStage::GetName() const {
+  return "KeepAlive";
+}
+
+void KeepAliveStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  for (const auto& hand: *hands) {
+    if (hand.mActions.Any()) {
+      mHandTracking->KeepAlive(hand.mHand, frameInfo);
+    }
+  }
+}
+
+HotspotStage::HotspotStage(
+  std::shared_ptr<const HotspotIndex> hotspots,
+  float snapAngle)
+  : mHotspots(std::move(hotspots)), mSnapAngle(snapAngle) {
+}
+
+std::string_view HotspotStage::GetName() const {
+  return "Hotspots";
+}
+
+void HotspotStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  for (auto& hand: *hands) {
+    this->SnapToHotspot(frameInfo, &hand);
+  }
+}
+
+void HotspotStage::SnapToHotspot(const FrameInfo& frameInfo, InputState* hand)
+  const {
+  // Find the pointer ray in LOCAL space; prefer the direction, as that's
+  // relative to the headset, which is what the user is aiming with
+  Vector3 origin;
+  Vector3 forward;
+  if (hand->mDirection) {
+    const auto rotation
+      = Quaternion::CreateFromAxisAngle(Vector3::UnitX, hand->mDirection->x)
+      * Quaternion::CreateFromAxisAngle(Vector3::UnitY, -hand->mDirection->y);
+    const auto& view = frameInfo.mViewInLocal;
+    origin = XrVecToSM(view.position);
+    forward = Vector3::Transform(
+      Vector3::Transform(Vector3::Forward, rotation),
+      XrQuatToSM(view.orientation));
+  } else if (hand->mPose) {
+    origin = XrVecToSM(hand->mPose->position);
+    forward = Vector3::Transform(
+      Vector3::Forward, XrQuatToSM(hand->mPose->orientation));
+  } else {
+    return;
+  }
+  forward.Normalize();
+
+  const auto hit = mHotspots->FindNearest(origin, forward, mSnapAngle);
+  if (!hit) {
+    return;
+  }
+
+  if (hand->mDirection) {
+    const XrPosef hotspotInLocal {
+      .orientation = XR_POSEF_IDENTITY.orientation,
+      .position = SMVecToXr(hit->mPosition),
+    };
+    const auto& p = (hotspotInLocal * frameInfo.mLocalInView).position;
+    hand->mDirection = {std::atan2f(p.y, -p.z), std::atan2f(p.x, -p.z)};
+  }
+
+  if (hand->mPose) {
+    const auto position = XrVecToSM(hand->mPose->position);
+    auto toHotspot = hit->mPosition - position;
+    if (toHotspot.LengthSquared() < 1e-12f) {
+      return;
+    }
+    toHotspot.Normalize();
+    const auto orientation = XrQuatToSM(hand->mPose->orientation);
+    const auto poseForward = Vector3::Transform(Vector3::Forward, orientation);
+    hand->mPose->orientation = SMQuatToXr(
+      orientation * Quaternion::FromToRotation(poseForward, toHotspot));
+  }
+}
+
+VirtualTouchScreenStage::VirtualTouchScreenStage(
+  std::shared_ptr<const Config::Snapshot> config,
+  const std::shared_ptr<OpenXRNext>& next,
+  XrSession session,
+  XrSpace viewSpace,
+  const std::optional<XrViewConfigurationType>* viewConfigurationType,
+  std::unique_ptr<VirtualTouchScreenSink>* sink)
+  : mConfig(std::move(config)),
+    mOpenXR(next),
+    mSession(session),
+    mViewSpace(viewSpace),
+    mViewConfigurationType(viewConfigurationType),
+    mSink(sink) {
+}
+
+std::string_view VirtualTouchScreenStage::GetName() const {
+  return "VirtualTouchScreen";
+}
+
+void VirtualTouchScreenStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  auto& sink = *mSink;
+  if (!sink) {
+    // Set by xrBeginSession()
+    if (!mViewConfigurationType->has_value()) {
+      return;
+    }
+    sink = std::make_unique<VirtualTouchScreenSink>(
+      mConfig,
+      mOpenXR,
+      mSession,
+      mViewConfigurationType->value(),
+      frameInfo.mPredictedDisplayTime,
+      mViewSpace);
+  }
+  const auto& [left, right] = *hands;
+  sink->Update(frameInfo, left, right);
+}
+
+VirtualControllerStage::VirtualControllerStage(
+  VirtualControllerSink* sink,
+  float projectionDistance)
+  : mSink(sink), mProjectionDistance(projectionDistance) {
+}
+
+std::string_view VirtualControllerStage::GetName() const {
+  return "VirtualController";
+}
+
+void VirtualControllerStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  for (auto& hand: *hands) {
+    if (!hand.mPose) {
+      hand.mPose = ProjectDirection(frameInfo, hand, mProjectionDistance);
+    }
+  }
+  const auto& [left, right] = *hands;
+  mSink->Update(frameInfo, left, right);
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,140 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <memory>
+#include <optional>
+
+#include "Config.h"
+#include "HotspotIndex.h"
+#include "InputPipeline.h"
+
+namespace HandTrackedCockpitClicking {
+
+class EyeGazeSource;
+class FusionSource;
+class HandTrackingSource;
+class OpenXRNext;
+class PointCtrlSource;
+class VirtualControllerSink;
+class VirtualTouchScreenSink;
+
+// Merges hand tracking poses and pinches into the hands
+class HandTrackingStage final : public InputPipeline::Stage {
+ public:
+  HandTrackingStage(HandTrackingSource*, PointerMode, const Config::Snapshot&);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  HandTrackingSource* mSource {nullptr};
+  PointerMode mPointerMode {PointerMode::None};
+  bool mUsePointer {false};
+  bool mUseClicks {false};
+  bool mUseScroll {false};
+};
+
+// Merges PointCtrl poses and FCU buttons into the hands
+class PointCtrlStage final : public InputPipeline::Stage {
+ public:
+  PointCtrlStage(PointCtrlSource*, PointerMode, const Config::Snapshot&);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  PointCtrlSource* mSource {nullptr};
+  PointerMode mPointerMode {PointerMode::None};
+  bool mUsePointer {false};
+  bool mUseActions {false};
+};
+
+// Replaces the hands with the combined hand tracking and PointCtrl input
+class FusionStage final : public InputPipeline::Stage {
+ public:
+  FusionStage(FusionSource*, PointerMode);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  FusionSource* mSource {nullptr};
+  PointerMode mPointerMode {PointerMode::None};
+};
+
+// Points the hand that's clicking with the user's gaze; must be after the
+// action sources
+class EyeGazeStage final : public InputPipeline::Stage {
+ public:
+  EyeGazeStage(EyeGazeSource*, PointerMode);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  EyeGazeSource* mSource {nullptr};
+  PointerMode mPointerMode {PointerMode::None};
+};
+
+// Keeps tracked hands awake while any source is clicking with them
+class KeepAliveStage final : public InputPipeline::Stage {
+ public:
+  KeepAliveStage(HandTrackingSource*);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  HandTrackingSource* mHandTracking {nullptr};
+};
+
+// Snaps pointer rays to the nearest hotspot
+class HotspotStage final : public InputPipeline::Stage {
+ public:
+  HotspotStage(std::shared_ptr<const HotspotIndex>, float snapAngle);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  std::shared_ptr<const HotspotIndex> mHotspots;
+  float mSnapAngle {};
+
+  void SnapToHotspot(const FrameInfo&, InputState* hand) const;
+};
+
+// Creates the touch screen sink once the view configuration is known, then
+// forwards the hands to it; the sink is owned by the caller, so it outlives
+// the stage
+class VirtualTouchScreenStage final : public InputPipeline::Stage {
+ public:
+  VirtualTouchScreenStage(
+    std::shared_ptr<const Config::Snapshot>,
+    const std::shared_ptr<OpenXRNext>&,
+    XrSession,
+    XrSpace viewSpace,
+    const std::optional<XrViewConfigurationType>* viewConfigurationType,
+    std::unique_ptr<VirtualTouchScreenSink>* sink);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  std::shared_ptr<const Config::Snapshot> mConfig;
+  std::shared_ptr<OpenXRNext> mOpenXR;
+  XrSession mSession {};
+  XrSpace mViewSpace {};
+  const std::optional<XrViewConfigurationType>* mViewConfigurationType {
+    nullptr};
+
+  std::unique_ptr<VirtualTouchScreenSink>* mSink {nullptr};
+};
+
+class VirtualControllerStage final : public InputPipeline::Stage {
+ public:
+  VirtualControllerStage(VirtualControllerSink*, float projectionDistance);
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  VirtualControllerSink* mSink {nullptr};
+  float mProjectionDistance {};
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,194 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "TelemetryWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include "DebugPrint.h"
+#include "HandTrackingSource.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+// About a second at 90Hz
+constexpr uint32_t AcquireIntervalFrames = 90;
+
+uint64_t MakeWriterID() {
+  static std::atomic<uint32_t> sNextInstance {1};
+  return Telemetry::MakeWriterID(GetCurrentProcessId(), sNextInstance++);
+}
+
+bool IsRunning(DWORD processID) {
+  if (processID == GetCurrentProcessId()) {
+    return true;
+  }
+  wil::unique_handle process {OpenProcess(SYNCHRONIZE, FALSE, processID)};
+  if (!process) {
+    // Access denied means it exists
+    return GetLastError() != ERROR_INVALID_PARAMETER;
+  }
+  return WaitForSingleObject(process.get(), 0) == WAIT_TIMEOUT;
+}
+
+Telemetry::HandRecord ToRecord(const InputState& state) {
+  using Flags = Telemetry::HandRecord::Flags;
+  Telemetry::HandRecord ret {
+    .mPointerMode = static_cast<uint8_t>(state.mPointerMode),
+    .mPositionUpdatedAt = state.mPositionUpdatedAt,
+  };
+
+  if (state.mPose) {
+    ret.mFlags |= Flags::HavePose;
+    const auto& p = state.mPose->position;
+    const auto& o = state.mPose->orientation;
+    ret.mPosition = {p.x, p.y, p.z};
+    ret.mOrientation = {o.x, o.y, o.z, o.w};
+  }
+  if (state.mDirection) {
+    ret.mFlags |= Flags::HaveDirection;
+    ret.mDirection = {state.mDirection->x, state.mDirection->y};
+  }
+
+  const auto& actions = state.mActions;
+  if (actions.mPrimary) {
+    ret.mFlags |= Flags::Primary;
+  }
+  if (actions.mSecondary) {
+    ret.mFlags |= Flags::Secondary;
+  }
+  switch (actions.mValueChange) {
+    case ActionState::ValueChange::None:
+      break;
+    case ActionState::ValueChange::Decrease:
+      ret.mValueChange = -1;
+      break;
+    case ActionState::ValueChange::Increase:
+      ret.mValueChange = 1;
+      break;
+  }
+  return ret;
+}
+}// namespace
+
+TelemetryWriter::TelemetryWriter() : mWriterID(MakeWriterID()) {
+  const std::wstring name {Telemetry::SharedMemoryName};
+  mMapping.reset(CreateFileMappingW(
+    INVALID_HANDLE_VALUE,
+    nullptr,
+    PAGE_READWRITE,
+    0,
+    sizeof(Telemetry::Buffer),
+    name.c_str()));
+  if (!mMapping) {
+    DebugPrint("Failed to create telemetry shared memory: {}", GetLastError());
+    return;
+  }
+
+  mBuffer.reset(static_cast<Telemetry::Buffer*>(MapViewOfFile(
+    mMapping.get(), FILE_MAP_WRITE, 0, 0, sizeof(Telemetry::Buffer))));
+  if (!mBuffer) {
+    DebugPrint("Failed to map telemetry shared memory: {}", GetLastError());
+    return;
+  }
+
+  if (!this->TryAcquire()) {
+    DebugPrint(
+      "Telemetry is already being published by process {}; waiting for it "
+      "to stop",
+      Telemetry::GetWriterProcessID(Telemetry::GetWriter(mBuffer.get())));
+  }
+}
+
+TelemetryWriter::~TelemetryWriter() {
+  if (mIsWriter) {
+    Telemetry::ReleaseWriter(mBuffer.get(), mWriterID);
+  }
+}
+
+bool TelemetryWriter::TryAcquire() {
+  // Readers keep the mapping open between games, so another game may still
+  // be writing to it, or may have crashed while doing so
+  const auto current = Telemetry::GetWriter(mBuffer.get());
+  if (current && IsRunning(Telemetry::GetWriterProcessID(current))) {
+    return false;
+  }
+  if (!Telemetry::TryAcquireWriter(mBuffer.get(), mWriterID, current)) {
+    return false;
+  }
+  mIsWriter = true;
+
+  // New mappings are zero-filled; existing ones carry on from the last frame
+  // number, so readers don't see it go backwards
+  if (!Telemetry::Reader(mBuffer.get()).IsCompatible()) {
+    Telemetry::Initialize(mBuffer.get());
+  }
+  DebugPrint("Publishing telemetry");
+  return true;
+}
+
+void TelemetryWriter::Write(
+  const FrameInfo& frameInfo,
+  const InputPipeline& pipeline,
+  std::size_t sourceStageCount,
+  const HandTrackingSource* handTracking) {
+  if (!mBuffer) {
+    return;
+  }
+  if (!mIsWriter) {
+    if (++mFramesSinceAcquire < AcquireIntervalFrames) {
+      return;
+    }
+    mFramesSinceAcquire = 0;
+    if (!this->TryAcquire()) {
+      return;
+    }
+  }
+
+  Telemetry::FrameRecord record {
+    .mNow = frameInfo.mNow,
+    .mPredictedDisplayTime = frameInfo.mPredictedDisplayTime,
+  };
+
+  const auto timings = pipeline.GetTimings();
+  if (!timings.empty()) {
+    const auto rawIndex
+      = std::clamp<std::size_t>(sourceStageCount, 1, timings.size()) - 1;
+    const auto& raw = pipeline.GetOutput(rawIndex);
+    const auto& output = pipeline.GetOutput(timings.size() - 1);
+    for (std::size_t i = 0; i < 2; ++i) {
+      record.mRaw[i] = ToRecord(raw[i]);
+      record.mFinal[i] = ToRecord(output[i]);
+    }
+  }
+
+  if (handTracking) {
+    record.mHibernating = handTracking->IsHibernating();
+    for (std::size_t i = 0; i < 2; ++i) {
+      const auto hand = (i == 0) ? XR_HAND_LEFT_EXT : XR_HAND_RIGHT_EXT;
+      using Flags = Telemetry::HandRecord::Flags;
+      if (handTracking->IsAwake(hand)) {
+        record.mRaw[i].mFlags |= Flags::Awake;
+      }
+      if (handTracking->IsTracked(hand)) {
+        record.mRaw[i].mFlags |= Flags::Tracked;
+      }
+    }
+  }
+
+  record.mStageCount = static_cast<uint8_t>(
+    std::min(timings.size(), Telemetry::MaxStages));
+  for (std::size_t i = 0; i < record.mStageCount; ++i) {
+    auto& stage = record.mStages[i];
+    const auto& timing = timings[i];
+    const auto nameLength = std::min(timing.mName.size(), stage.mName.size());
+    std::copy_n(timing.mName.data(), nameLength, stage.mName.data());
+    stage.mNanoseconds = static_cast<uint32_t>(
+      std::min<int64_t>(timing.mLast.count(), UINT32_MAX));
+  }
+
+  Telemetry::Write(mBuffer.get(), record);
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,50 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <wil/resource.h>
+
+#include "FrameInfo.h"
+#include "InputPipeline.h"
+#include "Telemetry.h"
+
+namespace HandTrackedCockpitClicking {
+
+class HandTrackingSource;
+
+/** Publishes each frame's pipeline state to shared memory.
+ *
+ * See `Telemetry.h` for the layout; this only adds the Windows shared memory
+ * and the conversion from pipeline state.
+ *
+ * Only one writer - across all processes - publishes at a time; others do
+ * nothing until it goes away, then one of them takes over.
+ */
+class TelemetryWriter final {
+ public:
+  TelemetryWriter();
+  ~TelemetryWriter();
+
+  /* Record the state of `pipeline` after `Run()`.
+   *
+   * `sourceStageCount` is the number of stages before the first filter;
+   * `handTracking` may be null.
+   */
+  void Write(
+    const FrameInfo&,
+    const InputPipeline& pipeline,
+    std::size_t sourceStageCount,
+    const HandTrackingSource* handTracking);
+
+ private:
+  wil::unique_handle mMapping;
+  wil::unique_mapview_ptr<Telemetry::Buffer> mBuffer;
+
+  const uint64_t mWriterID;
+  bool mIsWriter {false};
+  uint32_t mFramesSinceAcquire {};
+
+  bool TryAcquire();
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -12,9 +12,11 @@
 #include <limits>
 #include <numbers>
 #include <string_view>
+#include <utility>
 
 #include "Environment.h"
 #include "InputState.h"
+#include "LocateSpaces.h"
 #include "openxr.h"
 
 using namespace DirectX::SimpleMath;
@@ -43,15 +45,15 @@ static constexpr std::array gPassThroughInteractionProfiles {
   "/interaction_profiles/ext/eye_gaze_interaction"sv,
 };
 
-static bool UseDCSActions() {
-  return VirtualControllerSink::IsActionSink()
-    && (Config::VRControllerActionSinkMapping
+static bool UseDCSActions(const Config::Snapshot& config) {
+  return VirtualControllerSink::IsActionSink(config)
+    && (config.VRControllerActionSinkMapping
         == VRControllerActionSinkMapping::DCS);
 }
 
-static bool UseMSFSActions() {
-  return VirtualControllerSink::IsActionSink()
-    && (Config::VRControllerActionSinkMapping
+static bool UseMSFSActions(const Config::Snapshot& config) {
+  return VirtualControllerSink::IsActionSink(config)
+    && (config.VRControllerActionSinkMapping
         == VRControllerActionSinkMapping::MSFS);
 }
 
@@ -59,8 +61,10 @@ VirtualControllerSink::VirtualControllerSink(
   const std::shared_ptr<OpenXRNext>& openXR,
   XrInstance instance,
   XrSession session,
-  XrSpace viewSpace)
-  : mOpenXR(openXR),
+  XrSpace viewSpace,
+  std::shared_ptr<const Config::Snapshot> config)
+  : mConfig(std::move(config)),
+    mOpenXR(openXR),
     mInstance(instance),
     mSession(session),
     mViewSpace(viewSpace) {
@@ -80,30 +84,32 @@ VirtualControllerSink::VirtualControllerSink(
 
   DebugPrint(
     "Initialized virtual VR controller - PointerSink: {}; ActionSink: {}",
-    IsPointerSink(),
-    IsActionSink());
+    IsPointerSink(*mConfig),
+    IsActionSink(*mConfig));
 }
 
-bool VirtualControllerSink::IsPointerSink() {
-  return Config::PointerSink == PointerSink::VirtualVRController;
+bool VirtualControllerSink::IsPointerSink(const Config::Snapshot& config) {
+  return config.PointerSink == PointerSink::VirtualVRController;
 }
 
-static bool IsActionSink(ActionSink actionSink) {
+static bool IsActionSink(
+  const Config::Snapshot& config,
+  ActionSink actionSink) {
   return (actionSink == ActionSink::VirtualVRController)
     || ((actionSink == ActionSink::MatchPointerSink)
-        && VirtualControllerSink::IsPointerSink());
+        && VirtualControllerSink::IsPointerSink(config));
 }
 
-static bool IsClickActionSink() {
-  return IsActionSink(Config::ClickActionSink);
+static bool IsClickActionSink(const Config::Snapshot& config) {
+  return IsActionSink(config, config.ClickActionSink);
 }
 
-static bool IsScrollActionSink() {
-  return IsActionSink(Config::ScrollActionSink);
+static bool IsScrollActionSink(const Config::Snapshot& config) {
+  return IsActionSink(config, config.ScrollActionSink);
 }
 
-bool VirtualControllerSink::IsActionSink() {
-  return IsClickActionSink() || IsScrollActionSink();
+bool VirtualControllerSink::IsActionSink(const Config::Snapshot& config) {
+  return IsClickActionSink(config) || IsScrollActionSink(config);
 }
 
 void VirtualControllerSink::Update(
@@ -114,8 +120,8 @@ void VirtualControllerSink::Update(
   UpdateHand(info, rightHand, &mRightController);
 }
 
-static bool WorldLockOrientation() {
-  switch (Config::VRControllerPointerSinkWorldLock) {
+static bool WorldLockOrientation(const Config::Snapshot& config) {
+  switch (config.VRControllerPointerSinkWorldLock) {
     case VRControllerPointerSinkWorldLock::Nothing:
       return false;
     case VRControllerPointerSinkWorldLock::Orientation:
@@ -129,6 +135,9 @@ std::optional<XrPosef> VirtualControllerSink::GetInputPose(
   const FrameInfo& frameInfo,
   const InputState& hand,
   ControllerState* controller) {
+  const auto hadActions
+    = std::exchange(controller->mHadActions, hand.mActions.Any());
+
   if (hand.mActions.Any() && !hand.mPose) {
     return controller->savedAimPose;
   }
@@ -161,18 +170,22 @@ std::optional<XrPosef> VirtualControllerSink::GetInputPose(
   }
 
   auto inputPose = OffsetPointerPose(frameInfo, *hand.mPose);
-  if (!(hand.mActions.Any() && controller->savedAimPose)) {
+  // With pose rollback, the first frame with actions already has the
+  // pre-pinch pose, which is a better anchor than the previous frame's
+  const auto lockToSaved = controller->savedAimPose
+    && (hadActions || !mConfig->HandTrackingPinchPoseRollback);
+  if (!(hand.mActions.Any() && lockToSaved)) {
     controller->savedAimPose = inputPose;
     controller->mUnlockedPosition = false;
     return inputPose;
   }
 
-  if (WorldLockOrientation()) {
+  if (WorldLockOrientation(*mConfig)) {
     inputPose.orientation = controller->savedAimPose->orientation;
   }
 
   if (
-    Config::VRControllerPointerSinkWorldLock
+    mConfig->VRControllerPointerSinkWorldLock
     != VRControllerPointerSinkWorldLock::OrientationAndSoftPosition) {
     return inputPose;
   }
@@ -184,7 +197,7 @@ std::optional<XrPosef> VirtualControllerSink::GetInputPose(
   const auto a = XrVecToSM(inputPose.position);
   const auto b = XrVecToSM(controller->savedAimPose->position);
   const auto distance = std::abs(Vector3::Distance(a, b));
-  if (distance < Config::VRControllerPointerSinkSoftWorldLockDistance) {
+  if (distance < mConfig->VRControllerPointerSinkSoftWorldLockDistance) {
     inputPose.position = controller->savedAimPose->position;
   } else {
     controller->mUnlockedPosition = true;
@@ -214,14 +227,14 @@ void VirtualControllerSink::SetControllerActions(
   XrTime predictedDisplayTime,
   const ActionState& hand,
   ControllerState* controller) {
-  if (!IsActionSink()) {
+  if (!IsActionSink(*mConfig)) {
     return;
   }
-  if (UseDCSActions()) {
+  if (UseDCSActions(*mConfig)) {
     SetDCSControllerActions(predictedDisplayTime, hand, controller);
     return;
   }
-  if (UseMSFSActions()) {
+  if (UseMSFSActions(*mConfig)) {
     SetMSFSControllerActions(predictedDisplayTime, hand, controller);
     return;
   }
@@ -237,7 +250,7 @@ void VirtualControllerSink::SetDCSControllerActions(
   XrTime predictedDisplayTime,
   const ActionState& hand,
   ControllerState* controller) {
-  if (IsClickActionSink()) {
+  if (IsClickActionSink(*mConfig)) {
     controller->thumbstickY.changedSinceLastSync = true;
     if (hand.mPrimary) {
       controller->thumbstickY.currentState = -1.0f;
@@ -248,7 +261,7 @@ void VirtualControllerSink::SetDCSControllerActions(
     }
   }
 
-  if (!IsScrollActionSink()) {
+  if (!IsScrollActionSink(*mConfig)) {
     return;
   }
 
@@ -272,7 +285,7 @@ void VirtualControllerSink::SetDCSControllerActions(
                     .count();
   const auto rate = std::clamp<float>(
     minimumRate
-      * (1 + (ms / Config::VRControllerScrollAccelerationDelayMilliseconds)),
+      * (1 + (ms / mConfig->VRControllerScrollAccelerationDelayMilliseconds)),
     0.0f,
     1.0f);
 
@@ -294,10 +307,10 @@ void VirtualControllerSink::SetMSFSControllerActions(
   const ActionState& hand,
   ControllerState* controller) {
   using ValueChange = ActionState::ValueChange;
-  const auto rawPrimary = IsClickActionSink() && hand.mPrimary;
-  const auto rawSecondary = IsClickActionSink() && hand.mSecondary;
+  const auto rawPrimary = IsClickActionSink(*mConfig) && hand.mPrimary;
+  const auto rawSecondary = IsClickActionSink(*mConfig) && hand.mSecondary;
   const auto rawValueChange
-    = IsScrollActionSink() ? hand.mValueChange : ValueChange::None;
+    = IsScrollActionSink(*mConfig) ? hand.mValueChange : ValueChange::None;
 
   const auto emulatePrimaryInteraction
     = (!rawPrimary) && (rawSecondary || rawValueChange != ValueChange::None);
@@ -363,7 +376,7 @@ void VirtualControllerSink::SetMSFSControllerActions(
       / 1000.0f;
 
     const auto secondsPerRotation
-      = Config::VRControllerActionSinkSecondsPerRotation;
+      = mConfig->VRControllerActionSinkSecondsPerRotation;
     const auto rotations = seconds / secondsPerRotation;
     const auto radians = rotations * 2 * std::numbers::pi_v<float>;
     if (controller->mRotationDirection == Rotation::Clockwise) {
@@ -389,14 +402,12 @@ void VirtualControllerSink::SetMSFSControllerActions(
 XrResult VirtualControllerSink::xrSyncActions(
   XrSession session,
   const XrActionsSyncInfo* syncInfo) {
-  static bool sFirstRun = true;
   for (auto hand: {&mLeftController, &mRightController}) {
     const bool presenceChanged
-      = sFirstRun || (hand->present != hand->presentLastSync);
-    sFirstRun = false;
+      = mFirstSync || (hand->present != hand->presentLastSync);
     hand->presentLastSync = hand->present;
 
-    switch (Config::VRControllerGripSqueeze) {
+    switch (mConfig->VRControllerGripSqueeze) {
       case VRControllerGripSqueeze::Never:
         hand->squeezeValue.currentState = 0.0f;
         break;
@@ -416,13 +427,12 @@ XrResult VirtualControllerSink::xrSyncActions(
     hand->thumbstickY.isActive = hand->present;
     hand->triggerValue.isActive = hand->present;
   }
+  mFirstSync = false;
 
   return mOpenXR->xrSyncActions(session, syncInfo);
 }
 
-XrResult VirtualControllerSink::xrPollEvent(
-  XrInstance instance,
-  XrEventDataBuffer* eventData) {
+bool VirtualControllerSink::PollEvent(XrEventDataBuffer* eventData) {
   if (
     mHaveSuggestedBindings && (
     mLeftController.present != mLeftController.presentLastPollEvent
@@ -433,10 +443,10 @@ XrResult VirtualControllerSink::xrPollEvent(
       .type = XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED,
       .session = mSession,
     };
-    return XR_SUCCESS;
+    return true;
   }
 
-  return mOpenXR->xrPollEvent(instance, eventData);
+  return false;
 }
 
 std::string_view VirtualControllerSink::ResolvePath(XrPath path) {
@@ -479,7 +489,7 @@ XrResult VirtualControllerSink::xrGetCurrentInteractionProfile(
   // We need the side effect of populating m(Left|Right)Hand.path
   const auto pathStr = ResolvePath(path);
 
-  if (Config::VerboseDebug >= 1) {
+  if (mConfig->VerboseDebug >= 1) {
     DebugPrint("Requested interaction profile for {}", pathStr);
   }
 
@@ -511,17 +521,17 @@ XrResult VirtualControllerSink::xrSuggestInteractionProfileBindings(
       instance, suggestedBindings);
   }
 
-  if (interactionProfile != Config::VirtualControllerInteractionProfilePath) {
+  if (interactionProfile != mConfig->VirtualControllerInteractionProfilePath) {
     DebugPrint(
       "Profile '{}' does not match desired profile '{}', dropping",
       interactionProfile,
-      Config::VirtualControllerInteractionProfilePath);
+      mConfig->VirtualControllerInteractionProfilePath);
     return XR_SUCCESS;
   }
 
   DebugPrint(
     "Found desired profile '{}'",
-    Config::VirtualControllerInteractionProfilePath);
+    mConfig->VirtualControllerInteractionProfilePath);
   mProfilePath = suggestedBindings->interactionProfile;
 
   for (uint32_t i = 0; i < suggestedBindings->countSuggestedBindings; ++i) {
@@ -533,20 +543,12 @@ XrResult VirtualControllerSink::xrSuggestInteractionProfileBindings(
   return XR_SUCCESS;
 }
 
-XrResult VirtualControllerSink::xrCreateAction(
-  XrActionSet actionSet,
+void VirtualControllerSink::AddActionBindings(
   const XrActionCreateInfo* createInfo,
-  XrAction* action) {
-  const auto ret = mOpenXR->xrCreateAction(actionSet, createInfo, action);
-  if (!XR_SUCCEEDED(ret)) {
-    return ret;
-  }
-
+  XrAction action) {
   for (uint32_t i = 0; i < createInfo->countSubactionPaths; ++i) {
-    AddBinding(createInfo->subactionPaths[i], *action);
+    AddBinding(createInfo->subactionPaths[i], action);
   }
-
-  return ret;
 }
 
 void VirtualControllerSink::AddBinding(XrPath path, XrAction action) {
@@ -561,7 +563,7 @@ void VirtualControllerSink::AddBinding(XrPath path, XrAction action) {
     return;
   }
 
-  if (IsPointerSink()) {
+  if (IsPointerSink(*mConfig)) {
     if (binding.ends_with(gAimPosePath)) {
       state->aimActions.emplace(action);
       if (mActionSpaces.contains(action)) {
@@ -604,7 +606,7 @@ void VirtualControllerSink::AddBinding(XrPath path, XrAction action) {
     }
   }
 
-  if (IsActionSink()) {
+  if (IsActionSink(*mConfig)) {
     if (binding.ends_with(gThumbstickXPath)) {
       state->thumbstickXActions.emplace(action);
       DebugPrint("Thumbstick X action found");
@@ -789,13 +791,13 @@ XrPosef VirtualControllerSink::OffsetPointerPose(
     = Vector3(
         handInView.position.x, handInView.position.y, handInView.position.z)
         .Length();
-  const auto nearFarDistance = Config::VRFarDistance - nearDistance;
+  const auto nearFarDistance = mConfig->VRFarDistance - nearDistance;
 
-  const auto rx = std::atan2f(Config::VRVerticalOffset, nearFarDistance);
+  const auto rx = std::atan2f(mConfig->VRVerticalOffset, nearFarDistance);
 
   const XrVector3f position {
     handInView.position.x,
-    handInView.position.y + Config::VRVerticalOffset,
+    handInView.position.y + mConfig->VRVerticalOffset,
     handInView.position.z,
   };
 
@@ -810,75 +812,145 @@ XrPosef VirtualControllerSink::OffsetPointerPose(
   return XrPosef {orientation, position} * frameInfo.mViewInLocal;
 }
 
-XrResult VirtualControllerSink::xrLocateSpace(
-  XrSpace space,
-  XrSpace baseSpace,
-  XrTime time,
-  XrSpaceLocation* location) {
-  for (const ControllerState& hand: {mLeftController, mRightController}) {
-    const bool isAimSpace = hand.aimSpaces.contains(space);
-    const bool isGripSpace = hand.gripSpaces.contains(space);
-    if (!(isAimSpace || isGripSpace)) {
-      TraceLoggingWrite(gTraceProvider, "xrLocateSpace_notAimOrGripSpace");
-      continue;
+std::optional<VirtualControllerSink::ControllerSpace>
+VirtualControllerSink::FindControllerSpace(XrSpace space) const {
+  for (const auto hand: {&mLeftController, &mRightController}) {
+    if (hand->aimSpaces.contains(space)) {
+      return ControllerSpace {hand, true};
     }
-
-    if (!hand.present) {
-      *location = {XR_TYPE_SPACE_LOCATION};
-      TraceLoggingWrite(gTraceProvider, "xrLocateSpace_handNotPresent");
-      return XR_SUCCESS;
+    if (hand->gripSpaces.contains(space)) {
+      return ControllerSpace {hand, false};
     }
+  }
+  return std::nullopt;
+}
 
-    const auto nextRet
-      = mOpenXR->xrLocateSpace(mLocalSpace, baseSpace, time, location);
-    if (!XR_SUCCEEDED(nextRet)) {
-      TraceLoggingWrite(
-        gTraceProvider,
-        "xrLocateSpace_failedNext",
-        TraceLoggingValue(static_cast<const int64_t>(nextRet), "XrResult"));
-      return nextRet;
-    }
+XrSpaceLocationData VirtualControllerSink::LocateControllerSpace(
+  const ControllerSpace& controllerSpace,
+  const XrSpaceLocationData& localSpace) const {
+  const auto& hand = *controllerSpace.mHand;
+  if (!hand.present) {
+    return {};
+  }
 
-    constexpr auto poseValid = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT
-      | XR_SPACE_LOCATION_POSITION_VALID_BIT;
-    constexpr auto poseTracked = XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT
-      | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+  constexpr auto poseValid = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT
+    | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+  constexpr auto poseTracked = XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT
+    | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
 
-    const auto spacePose = ((location->locationFlags & poseValid) == poseValid)
-      ? location->pose
-      : XR_POSEF_IDENTITY;
-    const auto aimPose = hand.aimPose;
+  const auto spacePose = ((localSpace.locationFlags & poseValid) == poseValid)
+    ? localSpace.pose
+    : XR_POSEF_IDENTITY;
+  const auto aimPose = hand.aimPose;
+  const auto locationFlags = localSpace.locationFlags | poseValid | poseTracked;
 
-    if (isAimSpace) {
-      location->pose = aimPose * spacePose;
-      location->locationFlags |= poseValid | poseTracked;
-      TraceLoggingWrite(gTraceProvider, "xrLocateSpace_handAimSpace");
-      return XR_SUCCESS;
-    }
+  if (controllerSpace.mIsAimSpace) {
+    return {locationFlags, aimPose * spacePose};
+  }
 
-    // Just experimentation; use PointCtrl to calibrate this: as it's
-    // a 2D source, the 'laser' should always be straight line
-    auto aimToGripQ = Quaternion::CreateFromAxisAngle(
-                        Vector3::UnitX, std::numbers::pi_v<float> * 0.23f)
-      * Quaternion::CreateFromAxisAngle(
-                        Vector3::UnitY,
-                        (hand.hand == XR_HAND_LEFT_EXT ? 1 : -1)
-                          * std::numbers::pi_v<float> * 0.1f);
-
-    XrPosef aimToGrip {
-      .orientation = {aimToGripQ.x, aimToGripQ.y, aimToGripQ.z, aimToGripQ.w},
-    };
+  // Just experimentation; use PointCtrl to calibrate this: as it's
+  // a 2D source, the 'laser' should always be straight line
+  auto aimToGripQ = Quaternion::CreateFromAxisAngle(
+                      Vector3::UnitX, std::numbers::pi_v<float> * 0.23f)
+    * Quaternion::CreateFromAxisAngle(
+                      Vector3::UnitY,
+                      (hand.hand == XR_HAND_LEFT_EXT ? 1 : -1)
+                        * std::numbers::pi_v<float> * 0.1f);
 
-    const auto handPose = aimToGrip * aimPose;
+  XrPosef aimToGrip {
+    .orientation = {aimToGripQ.x, aimToGripQ.y, aimToGripQ.z, aimToGripQ.w},
+  };
 
-    location->pose = handPose * spacePose;
-    location->locationFlags |= poseValid | poseTracked;
-    TraceLoggingWrite(gTraceProvider, "xrLocateSpace_handGripSpace");
+  const auto handPose = aimToGrip * aimPose;
+  return {locationFlags, handPose * spacePose};
+}
+
+XrResult VirtualControllerSink::xrLocateSpace(
+  XrSpace space,
+  XrSpace baseSpace,
+  XrTime time,
+  XrSpaceLocation* location) {
+  const auto controllerSpace = this->FindControllerSpace(space);
+  if (!controllerSpace) {
+    TraceLoggingWrite(gTraceProvider, "xrLocateSpace_notAimOrGripSpace");
+    return mOpenXR->xrLocateSpace(space, baseSpace, time, location);
+  }
 
+  if (!controllerSpace->mHand->present) {
+    *location = {XR_TYPE_SPACE_LOCATION};
+    TraceLoggingWrite(gTraceProvider, "xrLocateSpace_handNotPresent");
     return XR_SUCCESS;
   }
 
-  return mOpenXR->xrLocateSpace(space, baseSpace, time, location);
+  const auto nextRet
+    = mOpenXR->xrLocateSpace(mLocalSpace, baseSpace, time, location);
+  if (!XR_SUCCEEDED(nextRet)) {
+    TraceLoggingWrite(
+      gTraceProvider,
+      "xrLocateSpace_failedNext",
+      TraceLoggingValue(static_cast<const int64_t>(nextRet), "XrResult"));
+    return nextRet;
+  }
+
+  const auto it = this->LocateControllerSpace(
+    *controllerSpace, {location->locationFlags, location->pose});
+  location->locationFlags = it.locationFlags;
+  location->pose = it.pose;
+  if (controllerSpace->mIsAimSpace) {
+    TraceLoggingWrite(gTraceProvider, "xrLocateSpace_handAimSpace");
+  } else {
+    TraceLoggingWrite(gTraceProvider, "xrLocateSpace_handGripSpace");
+  }
+  return XR_SUCCESS;
+}
+
+template <class TNext>
+XrResult VirtualControllerSink::LocateSpaces(
+  const XrSpacesLocateInfo* locateInfo,
+  XrSpaceLocations* spaceLocations,
+  TNext&& next) {
+  // Only one runtime call per batch, however many of our spaces it has: our
+  // spaces are located relative to mLocalSpace, which is added to the batch
+  return HandTrackedCockpitClicking::LocateSpaces(
+    locateInfo,
+    spaceLocations,
+    mLocalSpace,
+    [this](XrSpace space) {
+      return this->FindControllerSpace(space).has_value();
+    },
+    [this](XrSpace space, const XrSpaceLocationData& localSpace) {
+      return this->LocateControllerSpace(
+        *this->FindControllerSpace(space), localSpace);
+    },
+    std::forward<TNext>(next));
+}
+
+XrResult VirtualControllerSink::xrLocateSpaces(
+  XrSession session,
+  const XrSpacesLocateInfo* locateInfo,
+  XrSpaceLocations* spaceLocations) {
+  TraceLoggingWrite(
+    gTraceProvider,
+    "xrLocateSpaces",
+    TraceLoggingValue(locateInfo->spaceCount, "SpaceCount"));
+  return this->LocateSpaces(
+    locateInfo, spaceLocations, [=, this](auto info, auto locations) {
+      return mOpenXR->xrLocateSpaces(session, info, locations);
+    });
+}
+
+XrResult VirtualControllerSink::xrLocateSpacesKHR(
+  XrSession session,
+  const XrSpacesLocateInfoKHR* locateInfo,
+  XrSpaceLocationsKHR* spaceLocations) {
+  TraceLoggingWrite(
+    gTraceProvider,
+    "xrLocateSpacesKHR",
+    TraceLoggingValue(locateInfo->spaceCount, "SpaceCount"));
+  return this->LocateSpaces(
+    locateInfo, spaceLocations, [=, this](auto info, auto locations) {
+      return mOpenXR->xrLocateSpacesKHR(session, info, locations);
+    });
 }
 
 }// namespace HandTrackedCockpitClicking
@@ -20,24 +20,24 @@ class VirtualControllerSink final {
     const std::shared_ptr<OpenXRNext>& oxr,
     XrInstance instance,
     XrSession session,
-    XrSpace viewSpace);
+    XrSpace viewSpace,
+    std::shared_ptr<const Config::Snapshot>);
 
   void Update(
     const FrameInfo&,
     const InputState& leftHand,
     const InputState& rightHand);
 
-  static bool IsActionSink();
-  static bool IsPointerSink();
+  static bool IsActionSink(const Config::Snapshot&);
+  static bool IsPointerSink(const Config::Snapshot&);
 
   XrResult xrSuggestInteractionProfileBindings(
     XrInstance instance,
     const XrInteractionProfileSuggestedBinding* suggestedBindings);
 
-  XrResult xrCreateAction(
-    XrActionSet actionSet,
-    const XrActionCreateInfo* createInfo,
-    XrAction* action);
+  // Call after the action has been created; as actions are per-instance,
+  // this may be called for several sessions
+  void AddActionBindings(const XrActionCreateInfo* createInfo, XrAction action);
 
   XrResult xrCreateActionSpace(
     XrSession session,
@@ -65,9 +65,20 @@ class VirtualControllerSink final {
     XrTime time,
     XrSpaceLocation* location);
 
+  XrResult xrLocateSpaces(
+    XrSession session,
+    const XrSpacesLocateInfo* locateInfo,
+    XrSpaceLocations* spaceLocations);
+  XrResult xrLocateSpacesKHR(
+    XrSession session,
+    const XrSpacesLocateInfoKHR* locateInfo,
+    XrSpaceLocationsKHR* spaceLocations);
+
   XrResult xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo);
 
-  XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData);
+  // Returns true if `eventData` was filled with an event from this sink;
+  // otherwise, the caller should poll the runtime
+  bool PollEvent(XrEventDataBuffer* eventData);
 
   XrResult xrGetCurrentInteractionProfile(
     XrSession session,
@@ -92,6 +103,7 @@ class VirtualControllerSink final {
 
     std::optional<XrPosef> savedAimPose {};
     bool mUnlockedPosition {false};
+    bool mHadActions {false};
     XrPosef aimPose {};
     std::unordered_set<XrSpace> aimSpaces {};
     std::unordered_set<XrAction> aimActions {};
@@ -139,7 +151,27 @@ class VirtualControllerSink final {
     const InputState& hand,
     ControllerState* controller);
 
+  struct ControllerSpace {
+    const ControllerState* mHand {nullptr};
+    bool mIsAimSpace {false};
+  };
+  std::optional<ControllerSpace> FindControllerSpace(XrSpace) const;
+  // Where a controller space is, given where mLocalSpace is
+  XrSpaceLocationData LocateControllerSpace(
+    const ControllerSpace&,
+    const XrSpaceLocationData& localSpace) const;
+  template <class TNext>
+  XrResult LocateSpaces(
+    const XrSpacesLocateInfo* locateInfo,
+    XrSpaceLocations* spaceLocations,
+    TNext&& next);
+
+  // Never replaced, as the game calls us from its own threads; changing
+  // these settings needs a restart
+  std::shared_ptr<const Config::Snapshot> mConfig;
+
   bool mHaveSuggestedBindings {false};
+  bool mFirstSync {true};
   std::shared_ptr<OpenXRNext> mOpenXR;
   XrInstance mInstance {};
   XrSession mSession {};
@@ -13,15 +13,19 @@
 
 #include <array>
 #include <chrono>
+#include <format>
 #include <iostream>
-#include <numbers>
+#include <optional>
 #include <thread>
+#include <vector>
 
 #include "CheckHResult.hpp"
+#include "Clock.h"
 #include "Config.h"
 #include "DebugPrint.h"
 #include "Environment.h"
 #include "OpenXRNext.h"
+#include "PointCtrlDistortionModel.h"
 #include "PointCtrlSource.h"
 
 using namespace HandTrackedCockpitClicking;
@@ -36,15 +40,15 @@ EXTENSION_FUNCTIONS
 
 constexpr uint32_t TextureHeight = 1024;
 constexpr uint32_t TextureWidth = 1024;
-// 2 pi radians in a circle, so pi / 18 radians is 10 degrees
-constexpr float OffsetInRadians = std::numbers::pi_v<float> / 18;
 constexpr float DistanceInMeters = 1.0f;
 constexpr float SizeInMeters = 0.25f;
+// Frames to average for each target; about half a second
+constexpr size_t SamplesPerTarget = 45;
 
 enum class CalibrationState {
   NoInput,
-  WaitForCenter,
-  WaitForOffset,
+  WaitForTarget,
+  SampleTarget,
   Test,
 };
 
@@ -149,12 +153,25 @@ void InitDrawingResources(ID3D11DeviceContext* context) {
     res.mTextFormat.put()));
 }
 
+// Place the layer in `direction`, as in `InputState::mDirection`
+static XrPosef GetLayerPose(const XrVector2f& direction) {
+  const auto o = DirectX::SimpleMath::Quaternion::CreateFromYawPitchRoll(
+    -direction.y, direction.x, 0);
+  const auto p = DirectX::SimpleMath::Vector3::Transform(
+    {0.0f, 0.0f, -DistanceInMeters}, o);
+  return {
+    .orientation = {o.x, o.y, o.z, o.w},
+    .position = {p.x, p.y, p.z},
+  };
+}
+
 void DrawLayer(
   CalibrationState state,
   ID3D11DeviceContext* context,
   ID3D11Texture2D* texture,
   XrPosef* layerPose,
-  const XrVector2f& calibratedRXRY) {
+  const XrVector2f& direction,
+  std::wstring_view progress) {
   InitDrawingResources(context);
 
   auto& res = sDrawingResources;
@@ -170,53 +187,26 @@ void DrawLayer(
   rt->DrawLine(
     {0, TextureHeight / 2.0}, {TextureWidth, TextureHeight / 2.0}, brush, 5.0f);
 
-  std::wstring_view message;
+  *layerPose = GetLayerPose(direction);
+
+  std::wstring message;
   switch (state) {
     case CalibrationState::NoInput:
-      *layerPose = {
-        .orientation = XR_POSEF_IDENTITY.orientation,
-        .position = {0.0f, 0.0f, -DistanceInMeters},
-      };
       message
         = L"The sensor can't see the LED - press FCU3 to wake it if it's "
           L"turned off";
       break;
-    case CalibrationState::WaitForCenter:
-      *layerPose = {
-        .orientation = XR_POSEF_IDENTITY.orientation,
-        .position = {0.0f, 0.0f, -DistanceInMeters},
-      };
-      message
-        = L"Reach for the center of the crosshair, then press FCU button 1";
+    case CalibrationState::WaitForTarget:
+      message = std::format(
+        L"{}: reach for the center of the crosshair, then press FCU button 1",
+        progress);
       break;
-    case CalibrationState::WaitForOffset: {
-      const auto o = DirectX::SimpleMath::Quaternion::CreateFromYawPitchRoll(
-        -OffsetInRadians, OffsetInRadians, 0);
-      const auto p = DirectX::SimpleMath::Vector3::Transform(
-        {0.0f, 0.0f, -DistanceInMeters}, o);
-
-      *layerPose = {
-        .orientation = {o.x, o.y, o.z, o.w},
-        .position = {p.x, p.y, p.z},
-      };
-
-      message
-        = L"Reach for the center of the crosshair, then press FCU button 1";
+    case CalibrationState::SampleTarget:
+      message = std::format(L"{}: hold still...", progress);
       break;
-    }
-    case CalibrationState::Test: {
-      auto o = DirectX::SimpleMath::Quaternion::CreateFromYawPitchRoll(
-        -calibratedRXRY.y, -calibratedRXRY.x, 0);
-      const auto p = DirectX::SimpleMath::Vector3::Transform(
-        {0.0f, 0.0f, -DistanceInMeters}, o);
-
-      *layerPose = {
-        .orientation = {o.x, o.y, o.z, o.w},
-        .position = {p.x, p.y, p.z},
-      };
+    case CalibrationState::Test:
       message = L"Press FCU button 1 to confirm, or button 2 to restart";
       break;
-    }
     default:
       DebugBreak();
   }
@@ -237,10 +227,15 @@ void DrawLayer(
   context->CopyResource(texture, res.mTexture.get());
 }
 
-int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
+int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR commandLine, int) {
   CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
   Environment::IsPointCtrlCalibration = true;
 
+  // 9 targets are needed to fit the edges of the sensor; 5 are quicker, but
+  // only correct the overall scale and skew
+  const auto targets = PointCtrlDistortionModel::GetTargets(
+    std::wstring_view {commandLine}.contains(L"--five-point") ? 5 : 9);
+
   XrInstance instance {};
   {
     const std::vector<const char*> enabledExtensions = {
@@ -351,6 +346,7 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
   }
   const auto openXR
     = std::make_shared<OpenXRNext>(instance, &xrGetInstanceProcAddr);
+  const OpenXRClock clock(openXR.get(), instance);
   PointCtrlSource pointCtrl;
   while (!pointCtrl.IsConnected()) {
     const auto result = MessageBoxW(
@@ -377,8 +373,9 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
          "===== TO EXIT =====\n\n"
          "Press FCU 3, Ctrl+C, or close this window"
          "===== Step 1: Calibration =====\n\n"
-         "Reach out and try to touch the center of the crosshair - don't\n"
-         "Once you're as close as you can, press FCU 1.\n\n"
+         "The crosshair will appear in several places; for each one, reach\n"
+         "out and try to touch its center. Once you're as close as you can,\n"
+         "press FCU 1, and hold still until the crosshair moves.\n\n"
          "===== Step 2: Testing =====\n\n"
          "Move your hand around in front of you; the cursor should follow\n"
          "your hand. If you're happy with the calibration, press FCU 1 to\n"
@@ -389,14 +386,13 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
   bool xrRunning = false;
   XrSwapchain swapchain {};
   std::vector<XrSwapchainImageD3D11KHR> swapchainImages;
-  CalibrationState state {CalibrationState::WaitForCenter};
+  CalibrationState state {CalibrationState::WaitForTarget};
   PointCtrlSource::RawValues rawValues;
-  D2D1_POINT_2U centerPoint {};
-  D2D1_POINT_2U offsetPoint {};
-  XrVector2f radiansPerUnit {
-    Config::Defaults::PointCtrlRadiansPerUnitX,
-    Config::Defaults::PointCtrlRadiansPerUnitY,
-  };
+  std::vector<PointCtrlDistortionModel::Sample> samples;
+  // Raw values for the current target
+  XrVector2f sampleSum {};
+  size_t sampleCount {};
+  std::optional<PointCtrlDistortionModel> model;
 
   bool saveAndExit = false;
   XrTime nextDisplayTime {};
@@ -501,7 +497,7 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
         PointerMode::Direction,
         {
           openXR.get(),
-          instance,
+          clock,
           localSpace,
           viewSpace,
           frameState.predictedDisplayTime,
@@ -520,6 +516,7 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
           context.get(),
           swapchainImages.at(imageIndex).texture,
           &layer.pose,
+          {},
           {});
       } else {
         const auto x = newRaw.mX;
@@ -529,50 +526,68 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
         const auto click2 = newRaw.FCU2() && !rawValues.FCU2();
         rawValues = newRaw;
         if (click2) {
-          state = CalibrationState::WaitForCenter;
+          state = CalibrationState::WaitForTarget;
+          samples.clear();
+          model = {};
         }
 
         if (click1) {
           switch (state) {
-            case CalibrationState::WaitForCenter:
-              centerPoint = {x, y};
-              DebugPrint("Center at ({}, {})", x, y);
-              // Skip second calibration point as we have angular sensitivity
-              // of the sensor
-              //
-              // state = CalibrationState::WaitForOffset;
-              state = CalibrationState::Test;
+            case CalibrationState::WaitForTarget:
+              state = CalibrationState::SampleTarget;
+              sampleSum = {};
+              sampleCount = 0;
               break;
-            case CalibrationState::WaitForOffset:
-              offsetPoint = {x, y};
-              radiansPerUnit = {
-                OffsetInRadians / (static_cast<float>(x) - centerPoint.x),
-                OffsetInRadians / (centerPoint.y - static_cast<float>(y)),
-              };
-              DebugPrint(
-                "Offset point at ({}, {}); radians per unit: ({}, {}); "
-                "degrees "
-                "per unit: ({}, {})",
-                x,
-                y,
-                radiansPerUnit.x,
-                radiansPerUnit.y,
-                (radiansPerUnit.x * 180) / std::numbers::pi_v<float>,
-                (radiansPerUnit.y * 180) / std::numbers::pi_v<float>);
-              state = CalibrationState::Test;
+            case CalibrationState::SampleTarget:
               break;
             case CalibrationState::Test:
               saveAndExit = true;
               break;
           }
         }
-        XrVector2f calibratedRotation {};
 
+        if (state == CalibrationState::SampleTarget) {
+          sampleSum.x += x;
+          sampleSum.y += y;
+          if (++sampleCount == SamplesPerTarget) {
+            const auto& target = targets[samples.size()];
+            const PointCtrlDistortionModel::Sample sample {
+              {sampleSum.x / sampleCount, sampleSum.y / sampleCount},
+              target,
+            };
+            DebugPrint(
+              "Target ({}, {}) at ({}, {})",
+              target.x,
+              target.y,
+              sample.mRaw.x,
+              sample.mRaw.y);
+            samples.push_back(sample);
+            state = CalibrationState::WaitForTarget;
+          }
+        }
+
+        if (
+          state == CalibrationState::WaitForTarget
+          && samples.size() == targets.size()) {
+          model = PointCtrlDistortionModel::Fit(samples);
+          if (model) {
+            DebugPrint(
+              "Fitted model '{}' with RMS error {} radians",
+              model->Serialize(),
+              model->GetRMSError(samples));
+            state = CalibrationState::Test;
+          } else {
+            DebugPrint("Failed to fit a model to the targets; restarting");
+            samples.clear();
+          }
+        }
+
+        XrVector2f direction {};
         if (state == CalibrationState::Test) {
-          calibratedRotation = {
-            (static_cast<float>(y) - centerPoint.y) * radiansPerUnit.y,
-            (static_cast<float>(x) - centerPoint.x) * radiansPerUnit.x,
-          };
+          direction = model->Evaluate(
+            {static_cast<float>(x), static_cast<float>(y)});
+        } else {
+          direction = targets[samples.size()];
         }
 
         DrawLayer(
@@ -580,7 +595,8 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
           context.get(),
           swapchainImages.at(imageIndex).texture,
           &layer.pose,
-          calibratedRotation);
+          direction,
+          std::format(L"{} of {}", samples.size() + 1, targets.size()));
       }
       check_xr(xrReleaseSwapchainImage(swapchain, nullptr));
 
@@ -597,10 +613,15 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
     }
   }
 
-  Config::SavePointCtrlCenterX(centerPoint.x);
-  Config::SavePointCtrlCenterY(centerPoint.y);
-  Config::SavePointCtrlRadiansPerUnitX(radiansPerUnit.x);
-  Config::SavePointCtrlRadiansPerUnitY(radiansPerUnit.y);
+  // The first target is the center; these are still used if the model is
+  // removed
+  Config::SavePointCtrlCenterX(static_cast<uint16_t>(samples.front().mRaw.x));
+  Config::SavePointCtrlCenterY(static_cast<uint16_t>(samples.front().mRaw.y));
+  Config::SavePointCtrlRadiansPerUnitX(
+    Config::Defaults::PointCtrlRadiansPerUnitX);
+  Config::SavePointCtrlRadiansPerUnitY(
+    Config::Defaults::PointCtrlRadiansPerUnitY);
+  Config::SavePointCtrlCalibrationModel(model->Serialize());
 
   // Also save the FOV while we're here; this isn't needed when running as
   // an OpenXR API layer, but opens the possibility of supporting
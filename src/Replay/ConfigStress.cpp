@@ -0,0 +1,443 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "ConfigStress.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "Clock.h"
+#include "Config.h"
+#include "InputInjector.h"
+#include "InputPipeline.h"
+#include "InputSampler.h"
+#include "InputSource.h"
+#include "SmoothingStage.h"
+#include "VirtualTouchScreenSink.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+constexpr std::chrono::nanoseconds FrameInterval {11'111'111};
+
+struct Toggle {
+  std::string_view mName;
+  // Every published snapshot has either the first or second value for every
+  // toggle
+  std::array<std::string_view, 2> mValues;
+  // Only changes on every other publish, so that some config changes keep
+  // the same value
+  bool mSlow {false};
+};
+
+// These change which stages are built, whether the sampler runs, and whether
+// the sink sends clicks; the strings aren't used, but they're where a torn
+// copy would be most likely to show
+constexpr std::array Toggles {
+  Toggle {"ClickActionSink", {"0", "2"}},
+  Toggle {"ScrollActionSink", {"2", "0"}},
+  Toggle {"InputSampleRateHz", {"1000", "0"}, true},
+  Toggle {"SmoothingFactor", {"0.5", "1"}},
+  Toggle {"VirtualTouchScreenMaxUpdateHz", {"0", "60"}},
+  Toggle {"ScrollWheelDelayMilliseconds", {"100", "600"}},
+  Toggle {"HotspotFile", {"", "C:\\HTCC\\ConfigStressHotspots.json"}},
+  Toggle {
+    "VirtualControllerInteractionProfilePath",
+    {
+      "/interaction_profiles/oculus/touch_controller",
+      "/interaction_profiles/htc/vive_controller",
+    },
+  },
+};
+
+// Every combination of fast and slow toggles
+using Variants = std::array<Config::Snapshot, 4>;
+
+Variants MakeVariants() {
+  Variants ret;
+  for (std::size_t i = 0; i < ret.size(); ++i) {
+    auto& config = ret.at(i);
+    config.PointerSink = PointerSink::VirtualTouchScreen;
+    for (const auto& toggle: Toggles) {
+      Config::Set(
+        &config, toggle.mName, toggle.mValues.at(toggle.mSlow ? i / 2 : i % 2));
+    }
+  }
+  return ret;
+}
+
+bool IsComplete(const Config::Snapshot& config, const Variants& variants) {
+  return std::ranges::any_of(variants, [&config](const auto& variant) {
+    return std::ranges::all_of(Toggles, [&](const Toggle& toggle) {
+      return Config::Get(config, toggle.mName)
+        == Config::Get(variant, toggle.mName);
+    });
+  });
+}
+
+/** Stands in for HandTrackingSource and PointCtrlSource.
+ *
+ * Like them, this doesn't read its config from the sampler thread, so the
+ * sampler can keep running while the config changes.
+ */
+class StressSource final : public InputSource {
+ public:
+  void ReloadConfig(std::shared_ptr<const Config::Snapshot> config) {
+    mConfig = std::move(config);
+  }
+
+  void SetSampling(bool sampling) override {
+    if (sampling) {
+      ++mStartCount;
+    }
+    mSampling = sampling;
+  }
+
+  void Sample(XrTime) override {
+    if (!mSampling) {
+      ++mSamplesWhileStopped;
+    }
+    ++mSampleCount;
+  }
+
+  std::tuple<InputState, InputState> Update(
+    PointerMode pointerMode,
+    const FrameInfo& frameInfo) override {
+    const auto frame = frameInfo.mNow / FrameInterval.count();
+    const auto cycle = frame / 50;
+    const auto phase = frame % 50;
+
+    InputState right {
+      .mHand = XR_HAND_RIGHT_EXT,
+      .mPositionUpdatedAt = frameInfo.mNow,
+      .mPointerMode = pointerMode,
+    };
+    const auto t = static_cast<float>(frame) / 90;
+    right.mDirection = XrVector2f {0.2f * std::sin(t), 0.2f * std::cos(t)};
+
+    // Buttons are held for almost half of every cycle, so that config changes
+    // regularly land while one is down
+    auto& actions = right.mActions;
+    actions.mPrimary = (phase < 20);
+    actions.mSecondary = (cycle % 3 == 0) && (phase >= 25) && (phase < 45);
+    if (cycle % 3 == 1 && phase >= 25) {
+      actions.mValueChange = ActionState::ValueChange::Increase;
+    }
+    return {InputState {XR_HAND_LEFT_EXT}, right};
+  }
+
+  // How many times a sampler has started sampling this source
+  uint64_t GetStartCount() const {
+    return mStartCount;
+  }
+
+  uint64_t GetSampleCount() const {
+    return mSampleCount;
+  }
+
+  uint64_t GetSamplesWhileStopped() const {
+    return mSamplesWhileStopped;
+  }
+
+ private:
+  std::shared_ptr<const Config::Snapshot> mConfig;
+  std::atomic<bool> mSampling {false};
+  uint64_t mStartCount {};
+  std::atomic<uint64_t> mSampleCount {};
+  std::atomic<uint64_t> mSamplesWhileStopped {};
+};
+
+class StressSourceStage final : public InputPipeline::Stage {
+ public:
+  StressSourceStage(StressSource* source, PointerMode pointerMode)
+    : mSource(source), mPointerMode(pointerMode) {
+  }
+
+  std::string_view GetName() const override {
+    return "StressSource";
+  }
+
+  void Process(const FrameInfo& frameInfo, InputPipeline::Hands* hands)
+    override {
+    const auto [left, right] = mSource->Update(mPointerMode, frameInfo);
+    *hands = {left, right};
+  }
+
+ private:
+  StressSource* mSource {nullptr};
+  PointerMode mPointerMode {};
+};
+
+struct ButtonCounts {
+  uint64_t mLeftDown {};
+  uint64_t mLeftUp {};
+  uint64_t mRightDown {};
+  uint64_t mRightUp {};
+};
+
+class CountingInjector final : public InputInjector {
+ public:
+  explicit CountingInjector(ButtonCounts* counts) : mCounts(counts) {
+  }
+
+  void Inject(std::span<const INPUT> events) override {
+    for (const auto& event: events) {
+      if (event.type != INPUT_MOUSE) {
+        continue;
+      }
+      const auto flags = event.mi.dwFlags;
+      mCounts->mLeftDown += !!(flags & MOUSEEVENTF_LEFTDOWN);
+      mCounts->mLeftUp += !!(flags & MOUSEEVENTF_LEFTUP);
+      mCounts->mRightDown += !!(flags & MOUSEEVENTF_RIGHTDOWN);
+      mCounts->mRightUp += !!(flags & MOUSEEVENTF_RIGHTUP);
+    }
+  }
+
+ private:
+  ButtonCounts* mCounts {nullptr};
+};
+
+uint64_t Unreleased(uint64_t down, uint64_t up) {
+  return (down > up) ? (down - up) : 0;
+}
+
+// As APILayer::PreparedPipeline
+struct PreparedPipeline {
+  std::shared_ptr<const Config::Snapshot> mConfig;
+  uint64_t mConfigGeneration {};
+  std::unique_ptr<InputPipeline> mPipeline;
+};
+
+// The parts of a session that the publisher can see
+struct SessionSlot {
+  StressSource mSource;
+  // Guarded by Publisher::mMutex
+  std::unique_ptr<PreparedPipeline> mPrepared;
+};
+
+std::unique_ptr<PreparedPipeline> BuildPipeline(
+  StressSource* source,
+  const std::shared_ptr<const Config::Snapshot>& config,
+  uint64_t generation) {
+  auto ret = std::make_unique<PreparedPipeline>();
+  ret->mConfig = config;
+  ret->mConfigGeneration = generation;
+  ret->mPipeline = std::make_unique<InputPipeline>();
+  ret->mPipeline->AddStage(
+    std::make_unique<StressSourceStage>(source, PointerMode::Direction));
+  if (config->SmoothingFactor <= 0.99f) {
+    ret->mPipeline->AddStage(std::make_unique<SmoothingStage>(
+      SmoothingStage::Parameters::FromConfig(*config)));
+  }
+  return ret;
+}
+
+// Stands in for the ConfigWatcher's callback, and the APILayer's latest config
+class Publisher final {
+ public:
+  uint64_t GetGeneration() const {
+    return mGeneration.load();
+  }
+
+  // Returns the current config and generation
+  std::tuple<std::shared_ptr<const Config::Snapshot>, uint64_t> Register(
+    SessionSlot* slot) {
+    std::unique_lock lock(mMutex);
+    mSlots.push_back(slot);
+    return {mConfig, mGeneration.load()};
+  }
+
+  void Unregister(SessionSlot* slot) {
+    std::unique_lock lock(mMutex);
+    std::erase(mSlots, slot);
+  }
+
+  // As APILayer::ApplyConfig(); nullptr if there's nothing to take, or if the
+  // publisher is busy
+  std::unique_ptr<PreparedPipeline> TryTakePrepared(SessionSlot* slot) {
+    std::unique_lock lock(mMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return nullptr;
+    }
+    return std::move(slot->mPrepared);
+  }
+
+  // As APILayer::OnConfigChanged()
+  void Publish(std::shared_ptr<const Config::Snapshot> config) {
+    std::unique_lock lock(mMutex);
+    mConfig = std::move(config);
+    const auto generation = mGeneration.load() + 1;
+    for (auto slot: mSlots) {
+      slot->mPrepared = BuildPipeline(&slot->mSource, mConfig, generation);
+    }
+    mGeneration.store(generation, std::memory_order_release);
+  }
+
+ private:
+  std::mutex mMutex;
+  std::shared_ptr<const Config::Snapshot> mConfig;
+  std::vector<SessionSlot*> mSlots;
+  std::atomic<uint64_t> mGeneration {};
+};
+
+void RunSession(
+  std::stop_token stop,
+  Publisher& publisher,
+  const Variants& variants,
+  ConfigStress::Results* results) {
+  const auto clock = std::make_shared<VirtualClock>();
+  ButtonCounts buttons;
+  SessionSlot slot;
+  auto& source = slot.mSource;
+  uint64_t neededStarts {};
+
+  std::shared_ptr<const Config::Snapshot> config;
+  uint64_t generation {};
+  std::tie(config, generation) = publisher.Register(&slot);
+  source.ReloadConfig(config);
+
+  // In the same order as APILayer::Session, so they're destroyed in the same
+  // order
+  std::unique_ptr<VirtualTouchScreenSink> sink;
+  auto pipeline
+    = std::move(BuildPipeline(&source, config, generation)->mPipeline);
+  std::unique_ptr<InputSampler> sampler;
+
+  const auto startSampler = [&]() {
+    if (!config->InputSampleRateHz) {
+      return;
+    }
+    ++neededStarts;
+    sampler = std::make_unique<InputSampler>(
+      clock, config->InputSampleRateHz, std::vector<InputSource*> {&source});
+  };
+  startSampler();
+
+  while (!stop.stop_requested()) {
+    clock->Advance(FrameInterval);
+
+    if (publisher.GetGeneration() != generation) {
+      if (auto prepared = publisher.TryTakePrepared(&slot)) {
+        ++results->mReloadCount;
+        if (!IsComplete(*prepared->mConfig, variants)) {
+          ++results->mIncompleteSnapshotCount;
+        }
+
+        // As APILayer::ApplyConfig()
+        const auto previousSampleRate = config->InputSampleRateHz;
+        config = prepared->mConfig;
+        generation = prepared->mConfigGeneration;
+        source.ReloadConfig(config);
+        if (sink) {
+          sink->ReloadConfig(config);
+        }
+        pipeline = std::move(prepared->mPipeline);
+        if (config->InputSampleRateHz != previousSampleRate) {
+          ++results->mSamplerRestartCount;
+          sampler.reset();
+          startSampler();
+        }
+      }
+    }
+
+    FrameInfo frameInfo;
+    frameInfo.mNow = clock->Now();
+    frameInfo.mPredictedDisplayTime = frameInfo.mNow + FrameInterval.count();
+    pipeline->Run(frameInfo);
+
+    if (!sink) {
+      sink = std::make_unique<VirtualTouchScreenSink>(
+        config,
+        VirtualTouchScreenSink::Calibration {
+          .mWindowInputFov = {1.0f, 1.0f},
+          .mWindowInputFovOrigin0To1 = {0.5f, 0.5f},
+        },
+        GetCurrentProcessId(),
+        std::make_unique<CountingInjector>(&buttons));
+    }
+    const auto& [left, right]
+      = pipeline->GetOutput(pipeline->GetStageCount() - 1);
+    sink->Update(frameInfo, left, right);
+    ++results->mFrameCount;
+  }
+
+  publisher.Unregister(&slot);
+  sampler.reset();
+  // Releases any held buttons
+  sink.reset();
+
+  results->mClickCount = buttons.mLeftDown + buttons.mRightDown;
+  results->mStuckButtonCount = Unreleased(buttons.mLeftDown, buttons.mLeftUp)
+    + Unreleased(buttons.mRightDown, buttons.mRightUp);
+  results->mSampleCount = source.GetSampleCount();
+  results->mSamplesWhileStopped = source.GetSamplesWhileStopped();
+  results->mUnneededRestartCount = source.GetStartCount() - neededStarts;
+}
+
+}// namespace
+
+bool ConfigStress::Results::Passed() const {
+  // No clicks means nothing was tested
+  return mClickCount > 0 && mIncompleteSnapshotCount == 0
+    && mSamplesWhileStopped == 0 && mUnneededRestartCount == 0
+    && mStuckButtonCount == 0;
+}
+
+ConfigStress::ConfigStress(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+ConfigStress::Results ConfigStress::Run() const {
+  const auto variants = MakeVariants();
+  Publisher publisher;
+  publisher.Publish(std::make_shared<const Config::Snapshot>(variants.at(0)));
+
+  Results ret;
+  std::vector<Results> sessions(
+    std::max<uint32_t>(mParameters.mSessionCount, 1));
+  {
+    std::vector<std::jthread> threads;
+    for (auto& session: sessions) {
+      threads.emplace_back([&](std::stop_token stop) {
+        RunSession(stop, publisher, variants, &session);
+      });
+    }
+
+    const auto until = std::chrono::steady_clock::now() + mParameters.mDuration;
+    while (std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(mParameters.mPublishInterval);
+      // A new copy each time, so that snapshots are freed while other
+      // sessions might still be switching away from them
+      ++ret.mPublishCount;
+      publisher.Publish(std::make_shared<const Config::Snapshot>(
+        variants.at(ret.mPublishCount % variants.size())));
+    }
+    // Destroying the jthreads stops and joins them
+  }
+
+  for (const auto& session: sessions) {
+    ret.mFrameCount += session.mFrameCount;
+    ret.mReloadCount += session.mReloadCount;
+    ret.mSamplerRestartCount += session.mSamplerRestartCount;
+    ret.mClickCount += session.mClickCount;
+    ret.mSampleCount += session.mSampleCount;
+    ret.mIncompleteSnapshotCount += session.mIncompleteSnapshotCount;
+    ret.mSamplesWhileStopped += session.mSamplesWhileStopped;
+    ret.mUnneededRestartCount += session.mUnneededRestartCount;
+    ret.mStuckButtonCount += session.mStuckButtonCount;
+  }
+  return ret;
+}
+
+}// namespace HandTrackedCockpitClicking
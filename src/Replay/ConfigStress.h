@@ -0,0 +1,61 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+
+namespace HandTrackedCockpitClicking {
+
+/** Keeps changing settings while several simulated sessions are running.
+ *
+ * Each session runs frames as fast as it can on its own thread, with an input
+ * sampler, a pipeline, and a virtual touch screen sink that's clicking and
+ * scrolling. Another thread keeps publishing new snapshots, building each
+ * session's pipeline before bumping the generation; when a session sees a new
+ * generation, it swaps the pipeline in the same way as
+ * `APILayer::ApplyConfig()`.
+ *
+ * This checks that sessions only ever see complete snapshots, that nothing
+ * is sampled after the sampler is stopped, that the sampler is only restarted
+ * when its rate changes, and that every button that's pressed is released,
+ * even if the config changes while it's held. Data races don't reliably fail
+ * these checks, so this is best run in an AddressSanitizer build too.
+ */
+class ConfigStress final {
+ public:
+  struct Parameters {
+    uint32_t mSessionCount {4};
+    std::chrono::milliseconds mDuration {std::chrono::seconds(10)};
+    std::chrono::microseconds mPublishInterval {std::chrono::milliseconds(1)};
+  };
+
+  struct Results {
+    uint64_t mFrameCount {};
+    uint64_t mPublishCount {};
+    // Sessions can skip generations, so this can be less than
+    // `mPublishCount * sessions`
+    uint64_t mReloadCount {};
+    uint64_t mSamplerRestartCount {};
+    uint64_t mClickCount {};
+    uint64_t mSampleCount {};
+
+    // Failures
+    uint64_t mIncompleteSnapshotCount {};
+    uint64_t mSamplesWhileStopped {};
+    uint64_t mUnneededRestartCount {};
+    uint64_t mStuckButtonCount {};
+
+    bool Passed() const;
+  };
+
+  ConfigStress() = delete;
+  explicit ConfigStress(const Parameters&);
+
+  Results Run() const;
+
+ private:
+  Parameters mParameters;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,115 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "DriftReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "HandTrackingGates.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+// Equivalent to FusionSource's: 1 if just updated, falling to 0 when stale
+float Confidence(
+  const Config::Snapshot& config,
+  XrTime now,
+  XrTime positionUpdatedAt) {
+  if (config.FusionStaleMilliseconds == 0) {
+    return 1.0f;
+  }
+  const auto age = std::chrono::nanoseconds(now - positionUpdatedAt);
+  const std::chrono::duration<float, std::milli> stale {
+    config.FusionStaleMilliseconds};
+  return std::clamp(1.0f - (age / stale), 0.0f, 1.0f);
+}
+
+float SquaredDistance(const XrVector2f& a, const XrVector2f& b) {
+  return std::pow(a.x - b.x, 2.0f) + std::pow(a.y - b.y, 2.0f);
+}
+
+}// namespace
+
+DriftReplay::DriftReplay(
+  const Config::Snapshot& config,
+  const Injection& injection)
+  : mConfig(config), mInjection(injection) {
+}
+
+DriftReplay::Metrics DriftReplay::Run(
+  std::span<const SessionCapture::Frame> frames,
+  const SampleCallback& onSample) const {
+  using Tracking = HandWakeStateMachine::Tracking;
+
+  PointCtrlDriftEstimator drift {
+    PointCtrlDriftEstimator::Parameters::FromConfig(mConfig)};
+  Metrics metrics;
+  double uncorrected {};
+  double corrected {};
+
+  for (const auto& frame: frames) {
+    ++metrics.mFrameCount;
+    const auto& frameInfo = frame.mFrameInfo;
+    const auto now = frameInfo.mNow;
+
+    // As in FusionSource, only the most confident hand is used; unlike the
+    // API layer, hand tracking is used even while it's asleep, as this
+    // doesn't replay the wake state machine
+    Sample sample {.mTime = now};
+    float weight {};
+    for (std::size_t i = 0; i < 2; ++i) {
+      const auto& hand = frame.mHands[i];
+      const auto& pointCtrl = frame.mPointCtrl[i];
+      if (!(hand.mTracking == Tracking::Tracked && pointCtrl.mValid)) {
+        continue;
+      }
+      const auto it = Confidence(mConfig, now, hand.mPositionUpdatedAt)
+        * Confidence(mConfig, now, pointCtrl.mPositionUpdatedAt);
+      if (it <= weight) {
+        continue;
+      }
+      weight = it;
+      const auto& raw = pointCtrl.mDirection;
+      sample.mPointCtrl = {
+        (raw.x * mInjection.mScale.x) + mInjection.mOffset.x,
+        (raw.y * mInjection.mScale.y) + mInjection.mOffset.y,
+      };
+      sample.mHandTracking
+        = std::get<1>(HandTrackingGates::RaycastPose(frameInfo, hand.mPose));
+    }
+
+    if (weight == 0) {
+      drift.Pause();
+      continue;
+    }
+
+    // Measure what the API layer would have shown before this sample
+    sample.mCorrected = drift.Apply(sample.mPointCtrl);
+    drift.Update(
+      std::chrono::nanoseconds(now),
+      sample.mPointCtrl,
+      sample.mHandTracking,
+      weight);
+    sample.mCorrection = drift.GetCorrection();
+
+    ++metrics.mSampleCount;
+    uncorrected += SquaredDistance(sample.mPointCtrl, sample.mHandTracking);
+    corrected += SquaredDistance(sample.mCorrected, sample.mHandTracking);
+    if (onSample) {
+      onSample(sample);
+    }
+  }
+
+  if (metrics.mSampleCount) {
+    metrics.mUncorrectedError
+      = static_cast<float>(std::sqrt(uncorrected / metrics.mSampleCount));
+    metrics.mCorrectedError
+      = static_cast<float>(std::sqrt(corrected / metrics.mSampleCount));
+  }
+  metrics.mCorrection = drift.GetCorrection();
+  return metrics;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,63 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cinttypes>
+#include <functional>
+#include <span>
+
+#include "Config.h"
+#include "PointCtrlDriftEstimator.h"
+#include "SessionCapture.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Runs PointCtrl drift correction over a capture, offline.
+ *
+ * This needs a capture made with the Fusion pointer source, so that it has
+ * both PointCtrl and hand tracking. The estimator is the same code as the API
+ * layer uses, with parameters from the given snapshot.
+ *
+ * A known drift can be injected into the recorded PointCtrl directions, to
+ * check that the estimate recovers its inverse.
+ */
+class DriftReplay final {
+ public:
+  // Applied to PointCtrl as `scale * direction + offset`
+  struct Injection {
+    XrVector2f mScale {1.0f, 1.0f};
+    XrVector2f mOffset {};
+  };
+
+  struct Metrics {
+    uint64_t mFrameCount {};
+    // Frames where both sources were fresh enough to use
+    uint64_t mSampleCount {};
+    // RMS difference between PointCtrl and hand tracking, in radians
+    float mUncorrectedError {};
+    float mCorrectedError {};
+    PointCtrlDriftEstimator::Correction mCorrection {};
+  };
+
+  struct Sample {
+    XrTime mTime {};
+    XrVector2f mPointCtrl {};
+    XrVector2f mHandTracking {};
+    XrVector2f mCorrected {};
+    PointCtrlDriftEstimator::Correction mCorrection {};
+  };
+  using SampleCallback = std::function<void(const Sample&)>;
+
+  DriftReplay() = delete;
+  DriftReplay(const Config::Snapshot&, const Injection&);
+
+  Metrics Run(
+    std::span<const SessionCapture::Frame>,
+    const SampleCallback& onSample = {}) const;
+
+ private:
+  Config::Snapshot mConfig;
+  Injection mInjection;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,165 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "FusionReplay.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <optional>
+
+#include "FusionFilter.h"
+#include "HandTrackingGates.h"
+#include "PointCtrlDriftEstimator.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+float Distance(const XrVector2f& a, const XrVector2f& b) {
+  return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+class JumpAccumulator final {
+ public:
+  void Add(float jump) {
+    ++mJumps.mCount;
+    mTotal += jump;
+    mJumps.mMax = std::max(mJumps.mMax, jump);
+  }
+
+  FusionReplay::Jumps Get() const {
+    auto ret = mJumps;
+    if (ret.mCount) {
+      ret.mMean = static_cast<float>(mTotal / ret.mCount);
+    }
+    return ret;
+  }
+
+ private:
+  FusionReplay::Jumps mJumps;
+  double mTotal {};
+};
+
+}// namespace
+
+FusionReplay::FusionReplay(const Config::Snapshot& config) : mConfig(config) {
+}
+
+FusionReplay::Metrics FusionReplay::Run(
+  std::span<const SessionCapture::Frame> frames) const {
+  using Tracking = HandWakeStateMachine::Tracking;
+
+  PointCtrlDriftEstimator drift {
+    PointCtrlDriftEstimator::Parameters::FromConfig(mConfig)};
+  std::array<FusionFilter, 2> filters {};
+  // The previous frame's result for each hand
+  std::array<FusionFilter::Result, 2> previous {};
+
+  Metrics metrics;
+  double pointCtrlError {};
+  double fusedError {};
+  double movement {};
+  uint64_t movementCount {};
+  JumpAccumulator pointCtrlStale;
+  JumpAccumulator handTrackingStale;
+
+  for (const auto& frame: frames) {
+    ++metrics.mFrameCount;
+    const auto& frameInfo = frame.mFrameInfo;
+    const auto now = frameInfo.mNow;
+
+    std::array<FusionFilter::Source, 2> handTracking {};
+    std::array<FusionFilter::Source, 2> pointCtrl {};
+    for (std::size_t i = 0; i < 2; ++i) {
+      const auto& hand = frame.mHands[i];
+      if (hand.mTracking == Tracking::Tracked) {
+        handTracking[i] = {
+          std::get<1>(HandTrackingGates::RaycastPose(frameInfo, hand.mPose)),
+          hand.mPositionUpdatedAt,
+        };
+      }
+      const auto& observation = frame.mPointCtrl[i];
+      if (observation.mValid) {
+        pointCtrl[i]
+          = {observation.mDirection, observation.mPositionUpdatedAt};
+      }
+    }
+
+    // As FusionSource::UpdateDrift()
+    if (mConfig.FusionDriftCorrection) {
+      float weight {};
+      std::size_t best {};
+      for (std::size_t i = 0; i < 2; ++i) {
+        const auto it
+          = FusionFilter::Confidence(mConfig, now, handTracking[i])
+          * FusionFilter::Confidence(mConfig, now, pointCtrl[i]);
+        if (it > weight) {
+          weight = it;
+          best = i;
+        }
+      }
+      if (weight == 0) {
+        drift.Pause();
+      } else {
+        drift.Update(
+          std::chrono::nanoseconds(now),
+          *pointCtrl[best].mDirection,
+          *handTracking[best].mDirection,
+          weight);
+      }
+      for (auto& source: pointCtrl) {
+        if (source.mDirection) {
+          source.mDirection = drift.Apply(*source.mDirection);
+        }
+      }
+    }
+
+    for (std::size_t i = 0; i < 2; ++i) {
+      const auto result
+        = filters[i].Update(mConfig, now, handTracking[i], pointCtrl[i]);
+      const auto& last = previous[i];
+
+      if (
+        result.mHandTrackingConfidence > 0
+        && result.mPointCtrlConfidence > 0) {
+        const auto& target = *handTracking[i].mDirection;
+        ++metrics.mSampleCount;
+        pointCtrlError
+          += std::pow(Distance(*pointCtrl[i].mDirection, target), 2.0f);
+        fusedError += std::pow(Distance(*result.mDirection, target), 2.0f);
+      }
+
+      if (last.mDirection && result.mDirection) {
+        const auto jump = Distance(*last.mDirection, *result.mDirection);
+        movement += jump;
+        ++movementCount;
+        if (
+          last.mPointCtrlConfidence > 0 && result.mPointCtrlConfidence == 0) {
+          pointCtrlStale.Add(jump);
+        }
+        if (
+          last.mHandTrackingConfidence > 0
+          && result.mHandTrackingConfidence == 0) {
+          handTrackingStale.Add(jump);
+        }
+      }
+      previous[i] = result;
+    }
+  }
+
+  if (metrics.mSampleCount) {
+    metrics.mPointCtrlError
+      = static_cast<float>(std::sqrt(pointCtrlError / metrics.mSampleCount));
+    metrics.mFusedError
+      = static_cast<float>(std::sqrt(fusedError / metrics.mSampleCount));
+  }
+  if (movementCount) {
+    metrics.mMeanMovement = static_cast<float>(movement / movementCount);
+  }
+  metrics.mPointCtrlStale = pointCtrlStale.Get();
+  metrics.mHandTrackingStale = handTrackingStale.Get();
+  return metrics;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,54 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cinttypes>
+#include <span>
+
+#include "Config.h"
+#include "SessionCapture.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Runs FusionSource's complementary filter over a capture, offline.
+ *
+ * Like `DriftReplay`, this needs a capture made with the Fusion pointer
+ * source. The filter and drift correction are the same code as the API layer
+ * uses, with parameters from the given snapshot; hand tracking directions are
+ * raycast from the recorded poses, without smoothing or the wake state
+ * machine.
+ */
+class FusionReplay final {
+ public:
+  // The fused pointer's movement on the frame a source went stale
+  struct Jumps {
+    uint64_t mCount {};
+    // In radians
+    float mMean {};
+    float mMax {};
+  };
+
+  struct Metrics {
+    uint64_t mFrameCount {};
+    // Hand-frames where both sources had some confidence
+    uint64_t mSampleCount {};
+    // RMS difference from hand tracking over those samples, in radians
+    float mPointCtrlError {};
+    float mFusedError {};
+    // Mean movement of the fused pointer between consecutive frames, as a
+    // scale for the jumps
+    float mMeanMovement {};
+    Jumps mPointCtrlStale;
+    Jumps mHandTrackingStale;
+  };
+
+  FusionReplay() = delete;
+  explicit FusionReplay(const Config::Snapshot&);
+
+  Metrics Run(std::span<const SessionCapture::Frame>) const;
+
+ private:
+  Config::Snapshot mConfig;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,1106 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Config.h"
+#include "ConfigStress.h"
+#include "DriftReplay.h"
+#include "FusionReplay.h"
+#include "HotspotBenchmark.h"
+#include "LocateSpacesBenchmark.h"
+#include "ParallelFor.h"
+#include "PinchBenchmark.h"
+#include "PinchOnsetReplay.h"
+#include "ReplaySession.h"
+#include "SessionCapture.h"
+#include "TouchScreenCheck.h"
+#include "Tuner.h"
+#include "Utf8.h"
+#include "WakeTraceCheck.h"
+
+using namespace HandTrackedCockpitClicking;
+
+namespace {
+
+constexpr auto Usage = R"(Usage:
+  HTCCReplay run CAPTURE [options] [--out FRAMES.csv]
+  HTCCReplay sweep CAPTURE [options] --grid NAME=V1,V2,... [--grid ...]
+    [--threads N] [--out RESULTS.csv]
+  HTCCReplay tune CAPTURE [options] --labels LABELS.txt [--candidates N]
+    [--threads N] [--seed N] [--weight NAME=VALUE] [--exe GAME.exe]
+    [--out RECOMMENDED.reg]
+  HTCCReplay drift CAPTURE [options] [--inject-scale X,Y]
+    [--inject-offset X,Y] [--out SAMPLES.csv]
+  HTCCReplay fusion CAPTURE [options]
+  HTCCReplay pinch-onset CAPTURE [options]
+  HTCCReplay bench-locate-spaces [--spaces N] [--controller-spaces N]
+    [--iterations N] [--call-cost-ns N] [--space-cost-ns N]
+  HTCCReplay stress-config [--sessions N] [--seconds N]
+    [--publish-interval-us N]
+  HTCCReplay check-wake [--capture CAPTURE]... [--walks N] [--seed N]
+  HTCCReplay bench-wake [--steps N] [--seed N]
+  HTCCReplay bench-hotspots [--hotspots N] [--queries N] [--seed N]
+  HTCCReplay bench-pinch [--frames N] [--passes N] [--seed N]
+  HTCCReplay check-touch-screen
+
+CAPTURE is a file recorded with the HandTrackingCaptureFile setting.
+
+Options:
+  --config FILE      start from settings in a .reg file, instead of the
+                     registry
+  --set NAME=VALUE   override a setting
+
+'run' replays the capture once, printing metrics, and optionally writing the
+final state of each hand for every frame. 'sweep' replays the capture once
+for every combination of the --grid values, in parallel, and writes one CSV
+row of metrics for each.
+
+'tune' searches for the wake, sleep, and gesture times, wake and action FOVs,
+and smoothing factor that best fit the labels, and writes them as a .reg file
+(or prints them, if there's no --out). Each line of LABELS.txt is the start
+and end of a period when you meant to click, in seconds from the start of the
+capture. Candidates are scored on:
+
+  latency   per millisecond of mean click latency (default 1)
+  jitter    per milliradian of pointer jitter (default 10)
+  false     per click outside any label (default 500)
+  missed    per label without a click (default 1000)
+
+--weight changes these, e.g. --weight false=1000. With --exe, the .reg file
+contains overrides for that game only.
+
+'drift' replays PointCtrl drift correction over a capture made with
+PointerSource set to Fusion, printing how far PointCtrl was from hand
+tracking with and without correction, and the final correction. To check
+that a known drift is found, --inject-scale and --inject-offset (in radians)
+change the recorded PointCtrl directions first; the correction should then
+be close to their inverse.
+
+'fusion' replays the Fusion pointer source's filter, including drift
+correction if FusionDriftCorrection is set, over a capture made with
+PointerSource set to Fusion. It prints how far PointCtrl and the fused pointer
+were from hand tracking while both were fresh, and how far the fused pointer
+jumped on frames where PointCtrl or hand tracking went stale, compared to its
+mean movement per frame.
+
+'pinch-onset' replays the recorded thumb-index distances and pinches with
+pinch onset prediction off, then with the configured
+HandTrackingPinchPredictionMilliseconds, printing the click latency, how much
+earlier pinches were predicted, and how many predictions were false onsets
+that weren't followed by a pinch.
+
+'bench-locate-spaces' doesn't need a capture; it times locating a batch of
+--spaces spaces (default 16), of which --controller-spaces (default 4) are
+virtual controller spaces, with one xrLocateSpace call per space, and with a
+single xrLocateSpaces call. The runtime is simulated, taking --call-cost-ns
+per call plus --space-cost-ns per space (default 0), so this measures the
+API layer's own overhead, and how many runtime calls each approach makes.
+
+'stress-config' doesn't need a capture; it runs --sessions simulated sessions
+(default 4) for --seconds (default 10), each clicking and scrolling with a
+virtual touch screen as fast as it can, while publishing a new config every
+--publish-interval-us (default 1000). Sessions switch config in the same way
+as the API layer. It fails if a session sees an incomplete config, if a
+source is sampled after its sampler stopped, if the sampler is restarted
+without its rate changing, or if a button is left held.
+
+'check-wake' replays traces through the hand wake state machine with the
+default settings, checking every step: for example, that hands only wake
+once the wake conditions have held for long enough, and that clicks only
+start in the action FOV. The traces are every pair of distinct inputs, then
+--walks random walks (default 1000) from --seed, then each --capture. It
+fails if any check fails, or if the synthetic traces missed any kind of
+event. 'bench-wake' times the state machine over a random walk of --steps
+steps (default 1000000).
+
+'bench-hotspots' doesn't need a capture; it times finding the hotspot to snap
+to for --queries random rays (default 100000), among --hotspots random
+hotspots (default 500) from --seed, with the API layer's index and by
+checking every hotspot. It fails if they find different hotspots.
+
+'bench-pinch' doesn't need a capture, as captures don't include hand joints;
+it times detecting pinches with the default thresholds over --frames
+synthetic frames (default 10000) from --seed, repeated --passes times
+(default 100), with PinchDetector's SIMD path and with a scalar loop over
+the fingers. It fails if they detect different pinches on any frame.
+
+'check-touch-screen' doesn't need a capture; it drives the virtual touch
+screen with scripted hands and a simulated clock, recording the mouse events
+instead of sending them. It fails unless the scroll wheel delay and interval,
+the order of moves and clicks, and the skipping of unchanged or too-frequent
+moves all match the settings exactly.
+)";
+
+struct Grid {
+  std::string mName;
+  std::vector<std::string> mValues;
+};
+
+struct Arguments {
+  std::string mCommand;
+  std::filesystem::path mCapture;
+  std::optional<std::filesystem::path> mConfig;
+  std::vector<std::pair<std::string, std::string>> mSettings;
+  std::vector<Grid> mGrid;
+  unsigned int mThreads {};
+  std::optional<std::filesystem::path> mOut;
+
+  // 'tune' only
+  std::optional<std::filesystem::path> mLabels;
+  Tuner::Parameters mTuner {};
+  std::wstring mExecutable;
+
+  // 'drift' only
+  DriftReplay::Injection mInjection {};
+};
+
+std::optional<std::pair<std::string, std::string>> SplitSetting(
+  std::string_view arg) {
+  const auto equals = arg.find('=');
+  if (equals == std::string_view::npos || equals == 0) {
+    return std::nullopt;
+  }
+  return std::pair {
+    std::string {arg.substr(0, equals)},
+    std::string {arg.substr(equals + 1)},
+  };
+}
+
+std::vector<std::string> SplitList(std::string_view list) {
+  std::vector<std::string> ret;
+  while (true) {
+    const auto comma = list.find(',');
+    ret.emplace_back(list.substr(0, comma));
+    if (comma == std::string_view::npos) {
+      return ret;
+    }
+    list.remove_prefix(comma + 1);
+  }
+}
+
+bool SetWeight(
+  Tuner::Weights* weights,
+  const std::pair<std::string, std::string>& weight) {
+  const auto& [name, value] = weight;
+  float* member = nullptr;
+  if (name == "latency") {
+    member = &weights->mLatency;
+  } else if (name == "jitter") {
+    member = &weights->mJitter;
+  } else if (name == "false") {
+    member = &weights->mFalseClick;
+  } else if (name == "missed") {
+    member = &weights->mMissedClick;
+  } else {
+    return false;
+  }
+
+  const auto first = value.data();
+  const auto last = first + value.size();
+  const auto [end, error] = std::from_chars(first, last, *member);
+  return error == std::errc {} && end == last;
+}
+
+std::optional<XrVector2f> ParseVector(std::string_view value) {
+  const auto parts = SplitList(value);
+  if (parts.size() != 2) {
+    return std::nullopt;
+  }
+  const auto parse = [](const std::string& part, float* member) {
+    const auto first = part.data();
+    const auto last = first + part.size();
+    const auto [end, error] = std::from_chars(first, last, *member);
+    return error == std::errc {} && end == last;
+  };
+  XrVector2f ret {};
+  if (!(parse(parts[0], &ret.x) && parse(parts[1], &ret.y))) {
+    return std::nullopt;
+  }
+  return ret;
+}
+
+std::optional<LocateSpacesBenchmark::Parameters> ParseBenchmarkArguments(
+  const std::vector<std::string>& args) {
+  LocateSpacesBenchmark::Parameters ret {};
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string_view arg {args.at(i)};
+    if (i + 1 == args.size()) {
+      std::println(stderr, "Missing value for '{}'", arg);
+      return std::nullopt;
+    }
+    const auto value = std::stoul(args.at(++i));
+
+    if (arg == "--spaces") {
+      ret.mSpaceCount = static_cast<uint32_t>(value);
+    } else if (arg == "--controller-spaces") {
+      ret.mControllerSpaceCount = static_cast<uint32_t>(value);
+    } else if (arg == "--iterations") {
+      ret.mIterations = static_cast<uint32_t>(value);
+    } else if (arg == "--call-cost-ns") {
+      ret.mRuntimeCallCost = std::chrono::nanoseconds {value};
+    } else if (arg == "--space-cost-ns") {
+      ret.mRuntimeSpaceCost = std::chrono::nanoseconds {value};
+    } else {
+      std::println(stderr, "Unrecognized option '{}'", arg);
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+std::optional<ConfigStress::Parameters> ParseStressArguments(
+  const std::vector<std::string>& args) {
+  ConfigStress::Parameters ret {};
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string_view arg {args.at(i)};
+    if (i + 1 == args.size()) {
+      std::println(stderr, "Missing value for '{}'", arg);
+      return std::nullopt;
+    }
+    const auto value = std::stoul(args.at(++i));
+
+    if (arg == "--sessions") {
+      ret.mSessionCount = static_cast<uint32_t>(value);
+    } else if (arg == "--seconds") {
+      ret.mDuration = std::chrono::seconds {value};
+    } else if (arg == "--publish-interval-us") {
+      ret.mPublishInterval = std::chrono::microseconds {value};
+    } else {
+      std::println(stderr, "Unrecognized option '{}'", arg);
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+struct WakeArguments {
+  std::vector<std::filesystem::path> mCaptures;
+  std::size_t mWalks {1000};
+  std::size_t mSteps {1000000};
+  uint32_t mSeed {};
+};
+
+std::optional<WakeArguments> ParseWakeArguments(
+  const std::vector<std::string>& args) {
+  WakeArguments ret {};
+  const auto check = (args.front() == "check-wake");
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string_view arg {args.at(i)};
+    if (i + 1 == args.size()) {
+      std::println(stderr, "Missing value for '{}'", arg);
+      return std::nullopt;
+    }
+    const auto& value = args.at(++i);
+
+    if (arg == "--capture" && check) {
+      ret.mCaptures.push_back(Utf8::ToWide(value));
+    } else if (arg == "--walks" && check) {
+      ret.mWalks = std::stoull(value);
+    } else if (arg == "--steps" && !check) {
+      ret.mSteps = std::stoull(value);
+    } else if (arg == "--seed") {
+      ret.mSeed = static_cast<uint32_t>(std::stoul(value));
+    } else {
+      std::println(stderr, "Unrecognized option '{}'", arg);
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+std::optional<HotspotBenchmark::Parameters> ParseHotspotBenchmarkArguments(
+  const std::vector<std::string>& args) {
+  HotspotBenchmark::Parameters ret {
+    .mMaxAngle = Config::Snapshot {}.HotspotSnapAngle,
+  };
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string_view arg {args.at(i)};
+    if (i + 1 == args.size()) {
+      std::println(stderr, "Missing value for '{}'", arg);
+      return std::nullopt;
+    }
+    const auto value = std::stoul(args.at(++i));
+
+    if (arg == "--hotspots") {
+      ret.mHotspotCount = static_cast<uint32_t>(value);
+    } else if (arg == "--queries") {
+      ret.mQueryCount = static_cast<uint32_t>(value);
+    } else if (arg == "--seed") {
+      ret.mSeed = static_cast<uint32_t>(value);
+    } else {
+      std::println(stderr, "Unrecognized option '{}'", arg);
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+std::optional<PinchBenchmark::Parameters> ParsePinchBenchmarkArguments(
+  const std::vector<std::string>& args) {
+  PinchBenchmark::Parameters ret {
+    .mThresholds = PinchDetector::Thresholds::FromConfig(Config::Snapshot {}),
+  };
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string_view arg {args.at(i)};
+    if (i + 1 == args.size()) {
+      std::println(stderr, "Missing value for '{}'", arg);
+      return std::nullopt;
+    }
+    const auto value = std::stoul(args.at(++i));
+
+    if (arg == "--frames") {
+      ret.mFrameCount = static_cast<uint32_t>(value);
+    } else if (arg == "--passes") {
+      ret.mPassCount = static_cast<uint32_t>(value);
+    } else if (arg == "--seed") {
+      ret.mSeed = static_cast<uint32_t>(value);
+    } else {
+      std::println(stderr, "Unrecognized option '{}'", arg);
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+std::optional<Arguments> ParseArguments(const std::vector<std::string>& args) {
+  if (args.size() < 2) {
+    return std::nullopt;
+  }
+
+  Arguments ret {
+    .mCommand = args.at(0),
+    .mCapture = Utf8::ToWide(args.at(1)),
+  };
+  if (
+    ret.mCommand != "run" && ret.mCommand != "sweep"
+    && ret.mCommand != "tune" && ret.mCommand != "drift"
+    && ret.mCommand != "fusion" && ret.mCommand != "pinch-onset") {
+    return std::nullopt;
+  }
+
+  for (std::size_t i = 2; i < args.size(); ++i) {
+    const std::string_view arg {args.at(i)};
+    if (i + 1 == args.size()) {
+      std::println(stderr, "Missing value for '{}'", arg);
+      return std::nullopt;
+    }
+    const std::string_view value {args.at(++i)};
+
+    const auto tune = (ret.mCommand == "tune");
+    const auto drift = (ret.mCommand == "drift");
+    if (arg == "--config") {
+      ret.mConfig = Utf8::ToWide(value);
+    } else if (arg == "--out") {
+      ret.mOut = Utf8::ToWide(value);
+    } else if (arg == "--threads") {
+      ret.mThreads = static_cast<unsigned int>(std::stoul(std::string {value}));
+      ret.mTuner.mThreads = ret.mThreads;
+    } else if (arg == "--set") {
+      const auto setting = SplitSetting(value);
+      if (!setting) {
+        std::println(stderr, "Expected NAME=VALUE, got '{}'", value);
+        return std::nullopt;
+      }
+      ret.mSettings.push_back(*setting);
+    } else if (arg == "--grid" && ret.mCommand == "sweep") {
+      const auto setting = SplitSetting(value);
+      if (!setting) {
+        std::println(stderr, "Expected NAME=V1,V2,..., got '{}'", value);
+        return std::nullopt;
+      }
+      ret.mGrid.push_back({setting->first, SplitList(setting->second)});
+    } else if (arg == "--labels" && tune) {
+      ret.mLabels = Utf8::ToWide(value);
+    } else if (arg == "--candidates" && tune) {
+      ret.mTuner.mCandidates = std::stoull(std::string {value});
+    } else if (arg == "--seed" && tune) {
+      ret.mTuner.mSeed = static_cast<uint32_t>(std::stoul(std::string {value}));
+    } else if (arg == "--exe" && tune) {
+      ret.mExecutable = Utf8::ToWide(value);
+    } else if (arg == "--weight" && tune) {
+      const auto weight = SplitSetting(value);
+      if (!(weight && SetWeight(&ret.mTuner.mWeights, *weight))) {
+        std::println(stderr, "Invalid weight '{}'", value);
+        return std::nullopt;
+      }
+    } else if (
+      (arg == "--inject-scale" || arg == "--inject-offset") && drift) {
+      const auto vector = ParseVector(value);
+      if (!vector) {
+        std::println(stderr, "Expected X,Y, got '{}'", value);
+        return std::nullopt;
+      }
+      auto& injection = ret.mInjection;
+      (arg == "--inject-scale" ? injection.mScale : injection.mOffset)
+        = *vector;
+    } else {
+      std::println(stderr, "Unrecognized option '{}'", arg);
+      return std::nullopt;
+    }
+  }
+
+  if (ret.mCommand == "sweep" && ret.mGrid.empty()) {
+    std::println(stderr, "'sweep' needs at least one --grid");
+    return std::nullopt;
+  }
+  if (ret.mCommand == "tune" && !ret.mLabels) {
+    std::println(stderr, "'tune' needs --labels");
+    return std::nullopt;
+  }
+  return ret;
+}
+
+bool ApplySetting(
+  Config::Snapshot* config,
+  std::string_view name,
+  std::string_view value) {
+  if (Config::Set(config, name, value)) {
+    return true;
+  }
+  std::println(stderr, "Invalid setting: {}={}", name, value);
+  return false;
+}
+
+std::string FormatMetricsHeader() {
+  return "Frames,Clicks,ShortClicks,MissedClicks,Wakes,MeanClickLatencyMs,"
+         "MaxClickLatencyMs,Jitter";
+}
+
+std::string FormatMetrics(const ReplaySession::Metrics& metrics) {
+  return std::format(
+    "{},{},{},{},{},{:.2f},{:.2f},{:.6f}",
+    metrics.mFrameCount,
+    metrics.mClickCount,
+    metrics.mShortClickCount,
+    metrics.mMissedClickCount,
+    metrics.mWakeCount,
+    metrics.mMeanClickLatencyMilliseconds,
+    metrics.mMaxClickLatencyMilliseconds,
+    metrics.mJitter);
+}
+
+void WriteFrame(
+  std::ostream& out,
+  const SessionCapture::Frame& frame,
+  const InputPipeline::Hands& hands) {
+  for (const auto& hand: hands) {
+    const auto direction = hand.mDirection.value_or(XrVector2f {});
+    const auto position = hand.mPose.value_or(XR_POSEF_IDENTITY).position;
+    std::println(
+      out,
+      "{},{},{},{},{},{},{},{},{},{},{},{},{}",
+      frame.mFrameInfo.mNow,
+      (hand.mHand == XR_HAND_LEFT_EXT) ? "Left" : "Right",
+      hand.mDirection.has_value(),
+      direction.x,
+      direction.y,
+      hand.mPose.has_value(),
+      position.x,
+      position.y,
+      position.z,
+      hand.mActions.mPrimary,
+      hand.mActions.mSecondary,
+      static_cast<int>(hand.mActions.mValueChange),
+      hand.mPositionUpdatedAt);
+  }
+}
+
+int Run(
+  const Arguments& args,
+  const Config::Snapshot& config,
+  std::span<const SessionCapture::Frame> frames) {
+  std::ofstream out;
+  if (args.mOut) {
+    out.open(*args.mOut);
+    if (!out) {
+      std::println(stderr, "Failed to open output file");
+      return 1;
+    }
+    std::println(
+      out,
+      "Time,Hand,HaveDirection,DirectionX,DirectionY,HavePose,PositionX,"
+      "PositionY,PositionZ,Primary,Secondary,ValueChange,PositionUpdatedAt");
+  }
+
+  ReplaySession::FrameCallback onFrame;
+  if (out.is_open()) {
+    onFrame = [&out](const auto& frame, const auto& hands) {
+      WriteFrame(out, frame, hands);
+    };
+  }
+
+  const auto metrics = ReplaySession(config).Run(frames, onFrame);
+  std::println("{}", FormatMetricsHeader());
+  std::println("{}", FormatMetrics(metrics));
+  return 0;
+}
+
+int Sweep(
+  const Arguments& args,
+  const Config::Snapshot& base,
+  std::span<const SessionCapture::Frame> frames) {
+  // Every combination of grid values; the last grid varies fastest
+  std::vector<Config::Snapshot> variants {base};
+  for (const auto& grid: args.mGrid) {
+    std::vector<Config::Snapshot> next;
+    next.reserve(variants.size() * grid.mValues.size());
+    for (const auto& variant: variants) {
+      for (const auto& value: grid.mValues) {
+        auto& config = next.emplace_back(variant);
+        if (!ApplySetting(&config, grid.mName, value)) {
+          return 1;
+        }
+      }
+    }
+    variants = std::move(next);
+  }
+
+  std::println(
+    stderr,
+    "Replaying {} frames with {} configurations",
+    frames.size(),
+    variants.size());
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<ReplaySession::Metrics> results(variants.size());
+  ParallelFor(variants.size(), args.mThreads, [&](std::size_t i) {
+    results[i] = ReplaySession(variants[i]).Run(frames);
+  });
+
+  std::println(
+    stderr,
+    "Finished in {}",
+    std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start));
+
+  std::ofstream file;
+  if (args.mOut) {
+    file.open(*args.mOut);
+    if (!file) {
+      std::println(stderr, "Failed to open output file");
+      return 1;
+    }
+  }
+  std::ostream& out = file.is_open() ? file : std::cout;
+
+  std::string header;
+  for (const auto& grid: args.mGrid) {
+    header += grid.mName + ",";
+  }
+  std::println(out, "{}{}", header, FormatMetricsHeader());
+
+  std::size_t i = 0;
+  for (const auto& metrics: results) {
+    // Recover this variant's grid values from its index
+    std::string row;
+    auto remainder = i++;
+    std::vector<std::string_view> values(args.mGrid.size());
+    for (std::size_t g = args.mGrid.size(); g-- > 0;) {
+      const auto& grid = args.mGrid.at(g);
+      values.at(g) = grid.mValues.at(remainder % grid.mValues.size());
+      remainder /= grid.mValues.size();
+    }
+    for (const auto value: values) {
+      row += std::format("{},", value);
+    }
+    std::println(out, "{}{}", row, FormatMetrics(metrics));
+  }
+  return 0;
+}
+
+int Tune(
+  const Arguments& args,
+  const Config::Snapshot& base,
+  std::span<const SessionCapture::Frame> frames) {
+  if (frames.empty()) {
+    std::println(stderr, "The capture is empty");
+    return 1;
+  }
+  auto labels
+    = Tuner::LoadLabels(*args.mLabels, frames.front().mFrameInfo.mNow);
+  if (!labels) {
+    std::println(stderr, "Failed to load labels");
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto results
+    = Tuner(frames, std::move(*labels), base, args.mTuner).Run();
+  if (results.empty()) {
+    std::println(stderr, "No candidates were evaluated");
+    return 1;
+  }
+  std::println(
+    stderr,
+    "Finished in {}",
+    std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start));
+
+  std::println(
+    stderr, "Cost,FalseClicks,MissedClicks,{}", FormatMetricsHeader());
+  for (std::size_t i = 0; i < std::min<std::size_t>(results.size(), 5); ++i) {
+    const auto& result = results.at(i);
+    std::println(
+      stderr,
+      "{:.1f},{},{},{}",
+      result.mCost,
+      result.mFalseClicks,
+      result.mMissedClicks,
+      FormatMetrics(result.mMetrics));
+  }
+
+  const auto& best = results.front().mConfig;
+  const auto names = Tuner::GetSettingNames();
+  if (args.mOut) {
+    if (!Config::SaveSnapshotToFile(
+          *args.mOut, best, names, args.mExecutable)) {
+      std::println(stderr, "Failed to write recommended settings");
+      return 1;
+    }
+    return 0;
+  }
+
+  // Print in the same format as --set, so they can be tweaked and replayed
+  for (const auto name: names) {
+    std::println("{}={}", name, Config::Get(best, name).value_or(""));
+  }
+  return 0;
+}
+
+int Drift(
+  const Arguments& args,
+  const Config::Snapshot& config,
+  std::span<const SessionCapture::Frame> frames) {
+  std::ofstream out;
+  if (args.mOut) {
+    out.open(*args.mOut);
+    if (!out) {
+      std::println(stderr, "Failed to open output file");
+      return 1;
+    }
+    std::println(
+      out,
+      "Time,PointCtrlX,PointCtrlY,HandTrackingX,HandTrackingY,CorrectedX,"
+      "CorrectedY,ScaleX,ScaleY,OffsetX,OffsetY");
+  }
+
+  DriftReplay::SampleCallback onSample;
+  if (out.is_open()) {
+    onSample = [&out](const DriftReplay::Sample& sample) {
+      const auto& correction = sample.mCorrection;
+      std::println(
+        out,
+        "{},{},{},{},{},{},{},{},{},{},{}",
+        sample.mTime,
+        sample.mPointCtrl.x,
+        sample.mPointCtrl.y,
+        sample.mHandTracking.x,
+        sample.mHandTracking.y,
+        sample.mCorrected.x,
+        sample.mCorrected.y,
+        correction.mScale.x,
+        correction.mScale.y,
+        correction.mOffset.x,
+        correction.mOffset.y);
+    };
+  }
+
+  const auto metrics
+    = DriftReplay(config, args.mInjection).Run(frames, onSample);
+  if (metrics.mSampleCount == 0) {
+    std::println(
+      stderr,
+      "The capture has no frames with both PointCtrl and hand tracking; it "
+      "must be recorded with PointerSource set to Fusion");
+    return 1;
+  }
+
+  const auto& correction = metrics.mCorrection;
+  std::println(
+    "Frames,Samples,UncorrectedError,CorrectedError,ScaleX,ScaleY,OffsetX,"
+    "OffsetY");
+  std::println(
+    "{},{},{:.6f},{:.6f},{:.4f},{:.4f},{:.6f},{:.6f}",
+    metrics.mFrameCount,
+    metrics.mSampleCount,
+    metrics.mUncorrectedError,
+    metrics.mCorrectedError,
+    correction.mScale.x,
+    correction.mScale.y,
+    correction.mOffset.x,
+    correction.mOffset.y);
+  return 0;
+}
+
+int Fusion(
+  const Config::Snapshot& config,
+  std::span<const SessionCapture::Frame> frames) {
+  const auto metrics = FusionReplay(config).Run(frames);
+  if (metrics.mSampleCount == 0) {
+    std::println(
+      stderr,
+      "The capture has no frames with both PointCtrl and hand tracking; it "
+      "must be recorded with PointerSource set to Fusion");
+    return 1;
+  }
+
+  const auto& pc = metrics.mPointCtrlStale;
+  const auto& ht = metrics.mHandTrackingStale;
+  std::println(
+    "Frames,Samples,PointCtrlError,FusedError,MeanMovement,PointCtrlStale,"
+    "PointCtrlStaleMeanJump,PointCtrlStaleMaxJump,HandTrackingStale,"
+    "HandTrackingStaleMeanJump,HandTrackingStaleMaxJump");
+  std::println(
+    "{},{},{:.6f},{:.6f},{:.6f},{},{:.6f},{:.6f},{},{:.6f},{:.6f}",
+    metrics.mFrameCount,
+    metrics.mSampleCount,
+    metrics.mPointCtrlError,
+    metrics.mFusedError,
+    metrics.mMeanMovement,
+    pc.mCount,
+    pc.mMean,
+    pc.mMax,
+    ht.mCount,
+    ht.mMean,
+    ht.mMax);
+  return 0;
+}
+
+int PinchOnset(
+  const Config::Snapshot& config,
+  std::span<const SessionCapture::Frame> frames) {
+  if (config.HandTrackingPinchPredictionMilliseconds == 0) {
+    std::println(
+      stderr,
+      "Pinch onset prediction is disabled; use --set "
+      "HandTrackingPinchPredictionMilliseconds=N");
+    return 1;
+  }
+  auto off = config;
+  off.HandTrackingPinchPredictionMilliseconds = 0;
+
+  const auto without = PinchOnsetReplay(off).Run(frames);
+  if (without.mSampleCount == 0) {
+    std::println(stderr, "The capture has no thumb-index distances");
+    return 1;
+  }
+  const auto with = PinchOnsetReplay(config).Run(frames);
+
+  std::println(
+    "Prediction,Frames,Pinches,Clicks,PredictedPinches,FalseOnsets,"
+    "MeanLeadMs,MeanClickLatencyMs,MaxClickLatencyMs");
+  const auto print = [](std::string_view name, const auto& metrics) {
+    std::println(
+      "{},{},{},{},{},{},{:.2f},{:.2f},{:.2f}",
+      name,
+      metrics.mFrameCount,
+      metrics.mPinchCount,
+      metrics.mClickCount,
+      metrics.mPredictedPinchCount,
+      metrics.mFalseOnsetCount,
+      metrics.mMeanLead.count(),
+      metrics.mMeanClickLatency.count(),
+      metrics.mMaxClickLatency.count());
+  };
+  print("Off", without);
+  print("On", with);
+  std::println(
+    stderr,
+    "Mean click latency reduced by {:.2f}ms, with {} false onsets",
+    (without.mMeanClickLatency - with.mMeanClickLatency).count(),
+    with.mFalseOnsetCount);
+  return 0;
+}
+
+int BenchLocateSpaces(const LocateSpacesBenchmark::Parameters& parameters) {
+  const auto results = LocateSpacesBenchmark(parameters).Run();
+  if (!results.mMatched) {
+    std::println(
+      stderr, "xrLocateSpace and xrLocateSpaces gave different locations");
+    return 1;
+  }
+
+  std::println("Path,NanosecondsPerBatch,RuntimeCallsPerBatch");
+  const auto print = [](std::string_view name, const auto& result) {
+    std::println(
+      "{},{:.1f},{:.1f}",
+      name,
+      result.mTimePerBatch.count(),
+      result.mRuntimeCallsPerBatch);
+  };
+  print("xrLocateSpace", results.mSingle);
+  print("xrLocateSpaces", results.mBatched);
+  return 0;
+}
+
+int StressConfig(const ConfigStress::Parameters& parameters) {
+  std::println(
+    stderr,
+    "Changing config every {} for {} with {} sessions",
+    parameters.mPublishInterval,
+    parameters.mDuration,
+    parameters.mSessionCount);
+  const auto results = ConfigStress(parameters).Run();
+
+  std::println(
+    "Frames,Publishes,Reloads,SamplerRestarts,Clicks,Samples,"
+    "IncompleteSnapshots,SamplesWhileStopped,UnneededRestarts,StuckButtons");
+  std::println(
+    "{},{},{},{},{},{},{},{},{},{}",
+    results.mFrameCount,
+    results.mPublishCount,
+    results.mReloadCount,
+    results.mSamplerRestartCount,
+    results.mClickCount,
+    results.mSampleCount,
+    results.mIncompleteSnapshotCount,
+    results.mSamplesWhileStopped,
+    results.mUnneededRestartCount,
+    results.mStuckButtonCount);
+  if (!results.Passed()) {
+    std::println(stderr, "FAILED");
+    return 1;
+  }
+  return 0;
+}
+
+int CheckWake(const WakeArguments& args) {
+  const Config::Snapshot config {};
+  const auto timings = HandWakeStateMachine::Timings::FromConfig(config);
+
+  std::println(
+    "Trace,Steps,Wakes,Sleeps,HibernateWakes,HibernateSleeps,Failures");
+  bool passed = true;
+  const auto print = [&passed](
+                       std::string_view name,
+                       const WakeTraceCheck::Results& results,
+                       bool synthetic) {
+    const auto& events = results.mEventCounts;
+    std::println(
+      "{},{},{},{},{},{},{}",
+      name,
+      results.mStepCount,
+      events.at(0),
+      events.at(1),
+      events.at(2),
+      events.at(3),
+      results.mFailureCount);
+    for (const auto& failure: results.mFailures) {
+      std::println(stderr, "{}: {}", name, failure);
+    }
+    if (results.mFailureCount) {
+      passed = false;
+    }
+    // Otherwise, the checks for the missing events weren't exercised
+    if (synthetic && std::ranges::contains(events, 0)) {
+      std::println(stderr, "{}: not every kind of event happened", name);
+      passed = false;
+    }
+  };
+
+  print("InputPairs", WakeTraceCheck::CheckInputPairs(timings), true);
+  print(
+    "RandomWalks",
+    WakeTraceCheck::CheckRandomWalks(timings, args.mSeed, args.mWalks, 5000),
+    args.mWalks > 0);
+  for (const auto& path: args.mCaptures) {
+    const auto frames = SessionCapture::Load(path);
+    if (!frames) {
+      std::println(stderr, "Failed to load capture '{}'", path.string());
+      return 1;
+    }
+    print(
+      path.filename().string(),
+      WakeTraceCheck::CheckCapture(config, *frames),
+      false);
+  }
+  return passed ? 0 : 1;
+}
+
+int BenchWake(const WakeArguments& args) {
+  const auto timings
+    = HandWakeStateMachine::Timings::FromConfig(Config::Snapshot {});
+  const auto perStep
+    = WakeTraceCheck::Benchmark(timings, args.mSeed, args.mSteps);
+  std::println("Steps,NanosecondsPerStep");
+  std::println("{},{:.1f}", args.mSteps, perStep.count());
+  return 0;
+}
+
+int BenchHotspots(const HotspotBenchmark::Parameters& parameters) {
+  const auto results = HotspotBenchmark(parameters).Run();
+  if (!results.mMatched) {
+    std::println(
+      stderr, "HotspotIndex and a linear scan found different hotspots");
+    return 1;
+  }
+
+  std::println(
+    "Path,Hotspots,Queries,Hits,NanosecondsPerQuery,BuildMicroseconds");
+  const auto print = [&](std::string_view name, const auto& result) {
+    std::println(
+      "{},{},{},{},{:.1f},{:.1f}",
+      name,
+      parameters.mHotspotCount,
+      parameters.mQueryCount,
+      results.mHitCount,
+      result.mTimePerQuery.count(),
+      result.mBuildTime.count());
+  };
+  print("Linear", results.mLinear);
+  print("HotspotIndex", results.mIndexed);
+  return 0;
+}
+
+int BenchPinch(const PinchBenchmark::Parameters& parameters) {
+  const auto results = PinchBenchmark(parameters).Run();
+  if (results.mMismatchCount) {
+    std::println(
+      stderr,
+      "PinchDetector and a scalar loop detected different pinches on {} "
+      "frames",
+      results.mMismatchCount);
+    return 1;
+  }
+
+  std::println("Path,Frames,Passes,Pinching,Changes,NanosecondsPerUpdate");
+  const auto print = [&](std::string_view name, const auto& result) {
+    std::println(
+      "{},{},{},{},{},{:.1f}",
+      name,
+      parameters.mFrameCount,
+      parameters.mPassCount,
+      results.mPinchingCount,
+      results.mChangeCount,
+      result.mTimePerUpdate.count());
+  };
+  print("Scalar", results.mScalar);
+  print("SIMD", results.mSIMD);
+  return 0;
+}
+
+int CheckTouchScreen() {
+  std::println("Check,Checks,Failures");
+  bool passed = true;
+  for (const auto& results: TouchScreenCheck::Run()) {
+    std::println(
+      "{},{},{}", results.mName, results.mCheckCount, results.mFailureCount);
+    for (const auto& failure: results.mFailures) {
+      std::println(stderr, "{}: {}", results.mName, failure);
+    }
+    if (results.mFailureCount || !results.mCheckCount) {
+      passed = false;
+    }
+  }
+  return passed ? 0 : 1;
+}
+
+}// namespace
+
+int wmain(int argc, wchar_t* argv[]) {
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    args.push_back(Utf8::FromWide(argv[i]));
+  }
+
+  if (!args.empty() && args.front() == "bench-locate-spaces") {
+    const auto parameters = ParseBenchmarkArguments(args);
+    if (!parameters) {
+      std::print(stderr, "{}", Usage);
+      return 1;
+    }
+    return BenchLocateSpaces(*parameters);
+  }
+  if (!args.empty() && args.front() == "stress-config") {
+    const auto parameters = ParseStressArguments(args);
+    if (!parameters) {
+      std::print(stderr, "{}", Usage);
+      return 1;
+    }
+    return StressConfig(*parameters);
+  }
+  if (
+    !args.empty()
+    && (args.front() == "check-wake" || args.front() == "bench-wake")) {
+    const auto parsed = ParseWakeArguments(args);
+    if (!parsed) {
+      std::print(stderr, "{}", Usage);
+      return 1;
+    }
+    return (args.front() == "check-wake") ? CheckWake(*parsed)
+                                          : BenchWake(*parsed);
+  }
+
+  if (!args.empty() && args.front() == "bench-hotspots") {
+    const auto parameters = ParseHotspotBenchmarkArguments(args);
+    if (!parameters) {
+      std::print(stderr, "{}", Usage);
+      return 1;
+    }
+    return BenchHotspots(*parameters);
+  }
+
+  if (!args.empty() && args.front() == "bench-pinch") {
+    const auto parameters = ParsePinchBenchmarkArguments(args);
+    if (!parameters) {
+      std::print(stderr, "{}", Usage);
+      return 1;
+    }
+    return BenchPinch(*parameters);
+  }
+
+  if (args.size() == 1 && args.front() == "check-touch-screen") {
+    return CheckTouchScreen();
+  }
+
+  const auto parsed = ParseArguments(args);
+  if (!parsed) {
+    std::print(stderr, "{}", Usage);
+    return 1;
+  }
+
+  const auto frames = SessionCapture::Load(parsed->mCapture);
+  if (!frames) {
+    std::println(stderr, "Failed to load capture '{}'", args.at(1));
+    return 1;
+  }
+
+  auto config = parsed->mConfig
+    ? *Config::LoadSnapshotFromFile(*parsed->mConfig, {})
+    : *Config::LoadSnapshot({});
+  for (const auto& [name, value]: parsed->mSettings) {
+    if (!ApplySetting(&config, name, value)) {
+      return 1;
+    }
+  }
+
+  if (parsed->mCommand == "run") {
+    return Run(*parsed, config, *frames);
+  }
+  if (parsed->mCommand == "tune") {
+    return Tune(*parsed, config, *frames);
+  }
+  if (parsed->mCommand == "drift") {
+    return Drift(*parsed, config, *frames);
+  }
+  if (parsed->mCommand == "fusion") {
+    return Fusion(config, *frames);
+  }
+  if (parsed->mCommand == "pinch-onset") {
+    return PinchOnset(config, *frames);
+  }
+  return Sweep(*parsed, config, *frames);
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "HotspotBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "HotspotIndex.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+using Vector3 = HotspotIndex::Vector3;
+using Hit = HotspotIndex::Hit;
+
+struct Ray {
+  Vector3 mOrigin;
+  Vector3 mDirection;
+};
+
+// Panels from knee height to above the head, and around to either side;
+// meters, in LOCAL space with the user at the origin
+const Vector3 CockpitMin {-0.7f, -0.6f, -0.9f};
+const Vector3 CockpitMax {0.7f, 0.4f, -0.3f};
+
+// Where the pointer ray starts, relative to the user
+const Vector3 HandMin {-0.3f, -0.4f, -0.4f};
+const Vector3 HandMax {0.3f, -0.1f, -0.1f};
+
+class RandomPoints final {
+ public:
+  explicit RandomPoints(uint32_t seed) : mRandom(seed) {
+  }
+
+  Vector3 Get(const Vector3& min, const Vector3& max) {
+    return {
+      this->Get(min.x, max.x),
+      this->Get(min.y, max.y),
+      this->Get(min.z, max.z),
+    };
+  }
+
+  float Get(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(mRandom);
+  }
+
+ private:
+  std::mt19937 mRandom;
+};
+
+// The same as HotspotIndex, including ignoring points at the origin
+std::optional<float> AngleTo(const Ray& ray, const Vector3& point) {
+  const auto offset = point - ray.mOrigin;
+  const auto distance = offset.Length();
+  if (distance < 1e-6f) {
+    return std::nullopt;
+  }
+  return std::acos(
+    std::clamp(offset.Dot(ray.mDirection) / distance, -1.0f, 1.0f));
+}
+
+std::optional<Hit> FindNearestLinear(
+  std::span<const Vector3> hotspots,
+  const Ray& ray,
+  float maxAngle) {
+  std::optional<Hit> ret;
+  auto bestAngle = maxAngle;
+  for (const auto& hotspot: hotspots) {
+    const auto angle = AngleTo(ray, hotspot);
+    if (angle && *angle <= bestAngle) {
+      bestAngle = *angle;
+      ret = Hit {hotspot, *angle};
+    }
+  }
+  return ret;
+}
+
+// Ties can be broken differently, so only the angle has to match
+bool SameHit(const std::optional<Hit>& a, const std::optional<Hit>& b) {
+  if (a.has_value() != b.has_value()) {
+    return false;
+  }
+  return !a || std::abs(a->mAngle - b->mAngle) < 1e-6f;
+}
+
+}// namespace
+
+HotspotBenchmark::HotspotBenchmark(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+HotspotBenchmark::Results HotspotBenchmark::Run() const {
+  const auto& p = mParameters;
+  const auto queryCount = std::max<uint32_t>(p.mQueryCount, 1);
+  RandomPoints random {p.mSeed};
+
+  std::vector<Vector3> hotspots;
+  hotspots.reserve(p.mHotspotCount);
+  for (uint32_t i = 0; i < p.mHotspotCount; ++i) {
+    hotspots.push_back(random.Get(CockpitMin, CockpitMax));
+  }
+
+  // Aimed at the cockpit, but not precisely at hotspots, as with a real
+  // hand
+  std::vector<Ray> rays;
+  rays.reserve(queryCount);
+  for (uint32_t i = 0; i < queryCount; ++i) {
+    const auto origin = random.Get(HandMin, HandMax);
+    auto direction = random.Get(CockpitMin, CockpitMax) - origin;
+    direction.Normalize();
+    rays.push_back({origin, direction});
+  }
+
+  const auto measure = [queryCount](auto&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::nano> elapsed
+      = std::chrono::steady_clock::now() - start;
+    return elapsed / queryCount;
+  };
+
+  Results results;
+
+  std::vector<std::optional<Hit>> linearHits(queryCount);
+  results.mLinear.mTimePerQuery = measure([&] {
+    for (uint32_t i = 0; i < queryCount; ++i) {
+      linearHits[i] = FindNearestLinear(hotspots, rays[i], p.mMaxAngle);
+    }
+  });
+
+  const auto buildStart = std::chrono::steady_clock::now();
+  const HotspotIndex index {hotspots};
+  results.mIndexed.mBuildTime = std::chrono::steady_clock::now() - buildStart;
+
+  std::vector<std::optional<Hit>> indexedHits(queryCount);
+  results.mIndexed.mTimePerQuery = measure([&] {
+    for (uint32_t i = 0; i < queryCount; ++i) {
+      const auto& ray = rays[i];
+      indexedHits[i]
+        = index.FindNearest(ray.mOrigin, ray.mDirection, p.mMaxAngle);
+    }
+  });
+
+  results.mHitCount = std::ranges::count_if(
+    linearHits, [](const auto& hit) { return hit.has_value(); });
+  results.mMatched = std::ranges::equal(linearHits, indexedHits, &SameHit);
+  return results;
+}
+
+}// namespace HandTrackedCockpitClicking
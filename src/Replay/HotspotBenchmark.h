@@ -0,0 +1,51 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+
+namespace HandTrackedCockpitClicking {
+
+/** Compares `HotspotIndex::FindNearest()` to checking every hotspot.
+ *
+ * Hotspots are spread through a cockpit-sized volume in front of the user,
+ * and each query is a ray from around the hand, aimed near a random point in
+ * that volume - so, like a real cockpit, some rays snap to a hotspot and
+ * some don't. Both approaches must find the same hotspot for every ray.
+ */
+class HotspotBenchmark final {
+ public:
+  struct Parameters {
+    uint32_t mHotspotCount {500};
+    uint32_t mQueryCount {100000};
+    uint32_t mSeed {1};
+    // Radians; defaults to the `HotspotSnapAngle` default
+    float mMaxAngle {0.035f};
+  };
+
+  struct Result {
+    std::chrono::duration<double, std::nano> mTimePerQuery {};
+    // Zero for the linear scan
+    std::chrono::duration<double, std::micro> mBuildTime {};
+  };
+
+  struct Results {
+    // Every hotspot, for every query
+    Result mLinear;
+    Result mIndexed;
+    uint64_t mHitCount {};
+    // Whether both approaches found the same hotspots
+    bool mMatched {false};
+  };
+
+  HotspotBenchmark() = delete;
+  explicit HotspotBenchmark(const Parameters&);
+
+  Results Run() const;
+
+ private:
+  Parameters mParameters;
+};
+
+}// namespace HandTrackedCockpitClicking
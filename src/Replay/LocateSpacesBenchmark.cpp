@@ -0,0 +1,193 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "LocateSpacesBenchmark.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "LocateSpaces.h"
+#include "openxr.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+constexpr auto PoseValid
+  = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT
+  | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+
+// Stands in for the runtime: every space is at a position derived from its
+// handle, so results can be compared
+class SimulatedRuntime final {
+ public:
+  SimulatedRuntime(
+    std::chrono::nanoseconds callCost,
+    std::chrono::nanoseconds spaceCost)
+    : mCallCost(callCost), mSpaceCost(spaceCost) {
+  }
+
+  XrResult LocateSpace(XrSpace space, XrSpaceLocation* location) {
+    this->Wait(1);
+    location->locationFlags = PoseValid;
+    location->pose = GetPose(space);
+    return XR_SUCCESS;
+  }
+
+  XrResult LocateSpaces(
+    const XrSpacesLocateInfo* info,
+    XrSpaceLocations* locations) {
+    this->Wait(info->spaceCount);
+    for (uint32_t i = 0; i < info->spaceCount; ++i) {
+      locations->locations[i] = {PoseValid, GetPose(info->spaces[i])};
+    }
+    return XR_SUCCESS;
+  }
+
+  uint64_t GetCallCount() const {
+    return mCallCount;
+  }
+
+ private:
+  std::chrono::nanoseconds mCallCost {};
+  std::chrono::nanoseconds mSpaceCost {};
+  uint64_t mCallCount {};
+
+  static XrPosef GetPose(XrSpace space) {
+    auto pose = XR_POSEF_IDENTITY;
+    pose.position.x = static_cast<float>(reinterpret_cast<uintptr_t>(space));
+    return pose;
+  }
+
+  // Busy-wait, as sleeping is far less precise than a runtime call
+  void Wait(uint32_t spaceCount) {
+    ++mCallCount;
+    const auto cost = mCallCost + (mSpaceCost * spaceCount);
+    if (cost == cost.zero()) {
+      return;
+    }
+    const auto until = std::chrono::steady_clock::now() + cost;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+  }
+};
+
+bool SameLocation(
+  const XrSpaceLocationData& a,
+  const XrSpaceLocationData& b) {
+  const auto& ap = a.pose.position;
+  const auto& bp = b.pose.position;
+  return a.locationFlags == b.locationFlags && ap.x == bp.x && ap.y == bp.y
+    && ap.z == bp.z;
+}
+
+}// namespace
+
+LocateSpacesBenchmark::LocateSpacesBenchmark(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+LocateSpacesBenchmark::Results LocateSpacesBenchmark::Run() const {
+  const auto& p = mParameters;
+  const auto spaceCount = std::max<uint32_t>(p.mSpaceCount, 1);
+  const auto controllerSpaceCount
+    = std::min(p.mControllerSpaceCount, spaceCount);
+  const auto iterations = std::max<uint32_t>(p.mIterations, 1);
+
+  // Handles are never dereferenced; 0 is XR_NULL_HANDLE
+  const auto anchor = reinterpret_cast<XrSpace>(uintptr_t {1});
+  std::vector<XrSpace> spaces;
+  for (uintptr_t i = 0; i < spaceCount; ++i) {
+    spaces.push_back(reinterpret_cast<XrSpace>(i + 2));
+  }
+
+  // Like VirtualControllerSink's aim and grip spaces, spread out through the
+  // batch
+  std::unordered_set<XrSpace> controllerSpaces;
+  for (uint32_t i = 0; i < controllerSpaceCount; ++i) {
+    controllerSpaces.emplace(
+      spaces.at((i * spaceCount) / controllerSpaceCount));
+  }
+  const auto isControllerSpace
+    = [&](XrSpace space) { return controllerSpaces.contains(space); };
+
+  XrPosef aimPose {XR_POSEF_IDENTITY};
+  aimPose.position.y = 1.0f;
+  const auto locateControllerSpace
+    = [&](XrSpace, const XrSpaceLocationData& anchorLocation) {
+        return XrSpaceLocationData {
+          anchorLocation.locationFlags,
+          aimPose * anchorLocation.pose,
+        };
+      };
+
+  const XrSpacesLocateInfo info {
+    .type = XR_TYPE_SPACES_LOCATE_INFO,
+    .spaceCount = spaceCount,
+    .spaces = spaces.data(),
+  };
+  std::vector<XrSpaceLocationData> singleLocations(spaceCount);
+  std::vector<XrSpaceLocationData> batchedLocations(spaceCount);
+  XrSpaceLocations locations {
+    .type = XR_TYPE_SPACE_LOCATIONS,
+    .locationCount = spaceCount,
+    .locations = batchedLocations.data(),
+  };
+
+  const auto measure = [iterations](auto&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      f();
+    }
+    const std::chrono::duration<double, std::nano> elapsed
+      = std::chrono::steady_clock::now() - start;
+    return elapsed / iterations;
+  };
+
+  Results results;
+
+  // As VirtualControllerSink::xrLocateSpace
+  {
+    SimulatedRuntime runtime {p.mRuntimeCallCost, p.mRuntimeSpaceCost};
+    results.mSingle.mTimePerBatch = measure([&] {
+      for (uint32_t i = 0; i < spaceCount; ++i) {
+        const auto space = spaces[i];
+        XrSpaceLocation location {XR_TYPE_SPACE_LOCATION};
+        if (!isControllerSpace(space)) {
+          runtime.LocateSpace(space, &location);
+          singleLocations[i] = {location.locationFlags, location.pose};
+          continue;
+        }
+        runtime.LocateSpace(anchor, &location);
+        singleLocations[i] = locateControllerSpace(
+          space, {location.locationFlags, location.pose});
+      }
+    });
+    results.mSingle.mRuntimeCallsPerBatch
+      = static_cast<double>(runtime.GetCallCount()) / iterations;
+  }
+
+  // As VirtualControllerSink::xrLocateSpaces
+  {
+    SimulatedRuntime runtime {p.mRuntimeCallCost, p.mRuntimeSpaceCost};
+    results.mBatched.mTimePerBatch = measure([&] {
+      LocateSpaces(
+        &info,
+        &locations,
+        anchor,
+        isControllerSpace,
+        locateControllerSpace,
+        [&runtime](const auto* info, auto* locations) {
+          return runtime.LocateSpaces(info, locations);
+        });
+    });
+    results.mBatched.mRuntimeCallsPerBatch
+      = static_cast<double>(runtime.GetCallCount()) / iterations;
+  }
+
+  results.mMatched
+    = std::ranges::equal(singleLocations, batchedLocations, &SameLocation);
+  return results;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,51 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+
+namespace HandTrackedCockpitClicking {
+
+/** Compares locating virtual controller spaces with one batched
+ * xrLocateSpaces call, to locating them one at a time with xrLocateSpace.
+ *
+ * Both use the same approach as the API layer, but with a simulated runtime
+ * that takes a fixed time per call and per space, so this measures the
+ * layer's own overhead, and how many runtime calls each approach makes.
+ */
+class LocateSpacesBenchmark final {
+ public:
+  struct Parameters {
+    uint32_t mSpaceCount {16};
+    // How many of the spaces are virtual controller aim or grip spaces
+    uint32_t mControllerSpaceCount {4};
+    uint32_t mIterations {100000};
+    std::chrono::nanoseconds mRuntimeCallCost {};
+    std::chrono::nanoseconds mRuntimeSpaceCost {};
+  };
+
+  struct Result {
+    std::chrono::duration<double, std::nano> mTimePerBatch {};
+    double mRuntimeCallsPerBatch {};
+  };
+
+  struct Results {
+    // xrLocateSpace for every space
+    Result mSingle;
+    // One xrLocateSpaces for the whole batch
+    Result mBatched;
+    // Whether both approaches gave the same locations
+    bool mMatched {false};
+  };
+
+  LocateSpacesBenchmark() = delete;
+  explicit LocateSpacesBenchmark(const Parameters&);
+
+  Results Run() const;
+
+ private:
+  Parameters mParameters;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,43 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "ParallelFor.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <thread>
+#include <vector>
+
+namespace HandTrackedCockpitClicking {
+
+void ParallelFor(
+  std::size_t count,
+  unsigned int threadCount,
+  const std::function<void(std::size_t)>& job) {
+  if (!threadCount) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threadCount
+    = static_cast<unsigned int>(std::min<std::size_t>(threadCount, count));
+
+  std::atomic<std::size_t> next {0};
+  const auto worker = [&](unsigned int index) {
+    SetThreadDescription(
+      GetCurrentThread(), std::format(L"HTCC Replay Worker {}", index).c_str());
+    for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      job(i);
+    }
+  };
+
+  std::vector<std::jthread> threads;
+  threads.reserve(threadCount);
+  for (unsigned int i = 0; i < threadCount; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  // std::jthread joins on destruction
+}
+
+}// namespace HandTrackedCockpitClicking
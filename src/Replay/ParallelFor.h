@@ -0,0 +1,23 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace HandTrackedCockpitClicking {
+
+/** Calls `job(i)` for every `i` in `[0, count)`, spread across threads.
+ *
+ * Each thread claims the next index from a shared counter when it finishes
+ * its previous job, so threads that get quick jobs simply run more of them;
+ * no thread sits idle while work remains.
+ *
+ * If `threadCount` is zero, one thread per core is used.
+ */
+void ParallelFor(
+  std::size_t count,
+  unsigned int threadCount,
+  const std::function<void(std::size_t)>& job);
+
+}// namespace HandTrackedCockpitClicking
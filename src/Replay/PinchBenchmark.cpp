@@ -0,0 +1,210 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "PinchBenchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "openxr.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+using Joints = std::array<XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT>;
+
+constexpr std::array FingerTips {
+  XR_HAND_JOINT_INDEX_TIP_EXT,
+  XR_HAND_JOINT_MIDDLE_TIP_EXT,
+  XR_HAND_JOINT_RING_TIP_EXT,
+  XR_HAND_JOINT_LITTLE_TIP_EXT,
+};
+
+constexpr std::array<XrHandTrackingAimFlagsFB, 4> FingerPinchBits {
+  XR_HAND_TRACKING_AIM_INDEX_PINCHING_BIT_FB,
+  XR_HAND_TRACKING_AIM_MIDDLE_PINCHING_BIT_FB,
+  XR_HAND_TRACKING_AIM_RING_PINCHING_BIT_FB,
+  XR_HAND_TRACKING_AIM_LITTLE_PINCHING_BIT_FB,
+};
+
+constexpr XrSpaceLocationFlags ValidFlags
+  = XR_SPACE_LOCATION_POSITION_VALID_BIT
+  | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT
+  | XR_SPACE_LOCATION_POSITION_TRACKED_BIT
+  | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+
+// How often the thumb or a fingertip isn't tracked
+constexpr float UntrackedChance = 0.01f;
+
+/** The same as PinchDetector, one finger at a time.
+ *
+ * The arithmetic is in the same order, so that distances at the thresholds
+ * round in the same way, as long as `XMVectorMultiplyAdd()` isn't fused.
+ */
+class ScalarPinchDetector final {
+ public:
+  explicit ScalarPinchDetector(const PinchDetector::Thresholds& thresholds) {
+    const auto releaseRatio = std::max(thresholds.mReleaseRatio, 1.0f);
+    for (std::size_t i = 0; i < FingerTips.size(); ++i) {
+      const auto pinch = thresholds.mPinchDistance.at(i);
+      const auto release = pinch * releaseRatio;
+      mPinchDistanceSq.at(i) = pinch * pinch;
+      mReleaseDistanceSq.at(i) = release * release;
+    }
+  }
+
+  XrHandTrackingAimFlagsFB Update(const Joints& joints) {
+    const auto& thumb = joints[XR_HAND_JOINT_THUMB_TIP_EXT];
+    if (!(thumb.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT)) {
+      mPinching = {};
+      return {};
+    }
+
+    XrHandTrackingAimFlagsFB ret {};
+    for (std::size_t i = 0; i < FingerTips.size(); ++i) {
+      const auto& tip = joints[FingerTips[i]];
+      const auto dx = tip.pose.position.x - thumb.pose.position.x;
+      const auto dy = tip.pose.position.y - thumb.pose.position.y;
+      const auto dz = tip.pose.position.z - thumb.pose.position.z;
+      const auto distanceSq = (dz * dz) + ((dy * dy) + (dx * dx));
+
+      const auto wasPinching = mPinching.at(i);
+      const auto threshold
+        = wasPinching ? mReleaseDistanceSq.at(i) : mPinchDistanceSq.at(i);
+      mPinching.at(i)
+        = (tip.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT)
+        && (distanceSq < threshold);
+      if (mPinching.at(i)) {
+        ret |= FingerPinchBits.at(i);
+      }
+    }
+    return ret;
+  }
+
+ private:
+  std::array<float, 4> mPinchDistanceSq {};
+  std::array<float, 4> mReleaseDistanceSq {};
+  std::array<bool, 4> mPinching {};
+};
+
+// Each fingertip moves in and out at its own rate, spending some time
+// pinched, some released, and some between the two thresholds
+std::vector<Joints> MakeFrames(const PinchBenchmark::Parameters& p) {
+  std::mt19937 random {p.mSeed};
+  std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+  std::uniform_real_distribution<float> chance {0.0f, 1.0f};
+  std::array<float, 4> phases {};
+  std::array<float, 4> rates {};
+  for (std::size_t i = 0; i < FingerTips.size(); ++i) {
+    phases.at(i) = chance(random) * 2 * std::numbers::pi_v<float>;
+    // Radians per frame; a pinch every 0.5-2 seconds at 90Hz
+    rates.at(i)
+      = 2 * std::numbers::pi_v<float> / (45 + (135 * chance(random)));
+  }
+
+  std::vector<Joints> ret(p.mFrameCount);
+  XrVector3f thumb {0.1f, -0.2f, -0.3f};
+  for (uint32_t frame = 0; frame < p.mFrameCount; ++frame) {
+    auto& joints = ret.at(frame);
+    for (auto& joint: joints) {
+      joint = {
+        .locationFlags = ValidFlags,
+        .pose = XR_POSEF_IDENTITY,
+        .radius = 0.01f,
+      };
+    }
+
+    // Wander around, but stay in front of the user
+    thumb.x = std::clamp(thumb.x + (unit(random) * 0.005f), -0.3f, 0.3f);
+    thumb.y = std::clamp(thumb.y + (unit(random) * 0.005f), -0.4f, 0.0f);
+    thumb.z = std::clamp(thumb.z + (unit(random) * 0.005f), -0.5f, -0.2f);
+    joints[XR_HAND_JOINT_THUMB_TIP_EXT].pose.position = thumb;
+    if (chance(random) < UntrackedChance) {
+      joints[XR_HAND_JOINT_THUMB_TIP_EXT].locationFlags = 0;
+    }
+
+    for (std::size_t i = 0; i < FingerTips.size(); ++i) {
+      const auto pinch = p.mThresholds.mPinchDistance.at(i);
+      const auto wave
+        = std::sin(phases.at(i) + (rates.at(i) * static_cast<float>(frame)));
+      // 0.2 to 2.3 times the pinch distance
+      const auto distance = pinch * (1.25f + wave + (unit(random) * 0.05f));
+
+      XrVector3f direction {unit(random), unit(random), unit(random)};
+      const auto length = std::sqrt(
+        (direction.x * direction.x) + (direction.y * direction.y)
+        + (direction.z * direction.z));
+      const auto scale = (length > 1e-3f) ? (distance / length) : 0.0f;
+
+      auto& tip = joints[FingerTips[i]];
+      tip.pose.position = {
+        thumb.x + (direction.x * scale),
+        thumb.y + (direction.y * scale),
+        thumb.z + (direction.z * scale),
+      };
+      if (chance(random) < UntrackedChance) {
+        tip.locationFlags = 0;
+      }
+    }
+  }
+  return ret;
+}
+
+}// namespace
+
+PinchBenchmark::PinchBenchmark(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+PinchBenchmark::Results PinchBenchmark::Run() const {
+  const auto& p = mParameters;
+  const auto frames = MakeFrames(p);
+  const auto passCount = std::max<uint32_t>(p.mPassCount, 1);
+  const auto updateCount = std::max<std::size_t>(frames.size() * passCount, 1);
+
+  const auto measure = [&](auto& detector, auto* pinches) {
+    pinches->resize(frames.size() * passCount);
+    auto it = pinches->begin();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+      for (const auto& joints: frames) {
+        *(it++) = detector.Update(joints);
+      }
+    }
+    const std::chrono::duration<double, std::nano> elapsed
+      = std::chrono::steady_clock::now() - start;
+    return Result {elapsed / updateCount};
+  };
+
+  Results results;
+
+  std::vector<XrHandTrackingAimFlagsFB> scalarPinches;
+  ScalarPinchDetector scalar {p.mThresholds};
+  results.mScalar = measure(scalar, &scalarPinches);
+
+  std::vector<XrHandTrackingAimFlagsFB> simdPinches;
+  PinchDetector simd {p.mThresholds};
+  results.mSIMD = measure(simd, &simdPinches);
+
+  XrHandTrackingAimFlagsFB previous {};
+  for (std::size_t i = 0; i < scalarPinches.size(); ++i) {
+    const auto pinches = scalarPinches.at(i);
+    if (pinches != simdPinches.at(i)) {
+      ++results.mMismatchCount;
+    }
+    if (pinches) {
+      ++results.mPinchingCount;
+    }
+    if (pinches != previous) {
+      ++results.mChangeCount;
+    }
+    previous = pinches;
+  }
+  return results;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,53 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+
+#include "PinchDetector.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Compares `PinchDetector`'s SIMD path to testing one finger at a time.
+ *
+ * Captures don't include hand joints, so the joints are synthetic: each
+ * fingertip moves towards and away from the thumb, crossing the pinch and
+ * release distances, with some noise and the occasional untracked joint.
+ * Both approaches must give the same pinches for every frame.
+ */
+class PinchBenchmark final {
+ public:
+  struct Parameters {
+    PinchDetector::Thresholds mThresholds {};
+    uint32_t mFrameCount {10000};
+    // Each pass continues from the previous pass's state
+    uint32_t mPassCount {100};
+    uint32_t mSeed {1};
+  };
+
+  struct Result {
+    std::chrono::duration<double, std::nano> mTimePerUpdate {};
+  };
+
+  struct Results {
+    Result mScalar;
+    Result mSIMD;
+    // Frames with at least one finger pinching
+    uint64_t mPinchingCount {};
+    // Frames where a finger started or stopped pinching
+    uint64_t mChangeCount {};
+    // Frames where the two approaches disagreed
+    uint64_t mMismatchCount {};
+  };
+
+  PinchBenchmark() = delete;
+  explicit PinchBenchmark(const Parameters&);
+
+  Results Run() const;
+
+ private:
+  Parameters mParameters;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,102 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "PinchOnsetReplay.h"
+
+#include <algorithm>
+#include <array>
+
+#include "HandTrackingGates.h"
+#include "PinchOnsetPredictor.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+using Time = PinchOnsetPredictor::Time;
+
+struct HandReplay {
+  PinchOnsetPredictor mPredictor;
+  bool mRawPrimary {false};
+  bool mClicked {false};
+  Time mPinchSeenAt {};
+  // When the debounce period started; earlier than `mPinchSeenAt` if the
+  // pinch was predicted
+  Time mDebounceFrom {};
+};
+
+}// namespace
+
+PinchOnsetReplay::PinchOnsetReplay(const Config::Snapshot& config)
+  : mConfig(config) {
+}
+
+PinchOnsetReplay::Metrics PinchOnsetReplay::Run(
+  std::span<const SessionCapture::Frame> frames) const {
+  const auto parameters = PinchOnsetPredictor::Parameters::FromConfig(mConfig);
+  const std::chrono::milliseconds gesture {
+    mConfig.HandTrackingGestureMilliseconds};
+
+  std::array<HandReplay, 2> hands {
+    HandReplay {.mPredictor = PinchOnsetPredictor {parameters}},
+    HandReplay {.mPredictor = PinchOnsetPredictor {parameters}},
+  };
+  Metrics metrics;
+  uint64_t predictionCount {};
+  Duration totalLatency {};
+  Duration totalLead {};
+
+  for (const auto& frame: frames) {
+    ++metrics.mFrameCount;
+    const Time now {frame.mFrameInfo.mNow};
+    for (std::size_t i = 0; i < hands.size(); ++i) {
+      const auto& observation = frame.mHands.at(i);
+      auto& hand = hands.at(i);
+
+      // As in HandTrackingSource: the distance is observed before the
+      // actions, so a pinch can use a prediction from the same frame
+      if (observation.mPinchDistance < 0) {
+        hand.mPredictor.Reset();
+      } else {
+        ++metrics.mSampleCount;
+        if (
+          hand.mPredictor.Observe(now, observation.mPinchDistance)
+          == PinchOnsetPredictor::Result::Predicted) {
+          ++predictionCount;
+        }
+      }
+
+      const auto raw = observation.mRawActions.mPrimary;
+      if (raw && !hand.mRawPrimary) {
+        ++metrics.mPinchCount;
+        hand.mClicked = false;
+        hand.mPinchSeenAt = now;
+        hand.mDebounceFrom = now;
+        if (const auto onset = hand.mPredictor.TakeOnset(now)) {
+          ++metrics.mPredictedPinchCount;
+          hand.mDebounceFrom = *onset;
+          totalLead += now - *onset;
+        }
+      }
+      hand.mRawPrimary = raw;
+
+      if (raw && !hand.mClicked && (now - hand.mDebounceFrom) >= gesture) {
+        hand.mClicked = true;
+        ++metrics.mClickCount;
+        const Duration latency = now - hand.mPinchSeenAt;
+        totalLatency += latency;
+        metrics.mMaxClickLatency = std::max(metrics.mMaxClickLatency, latency);
+      }
+    }
+  }
+
+  metrics.mFalseOnsetCount = predictionCount - metrics.mPredictedPinchCount;
+  if (metrics.mClickCount) {
+    metrics.mMeanClickLatency = totalLatency / metrics.mClickCount;
+  }
+  if (metrics.mPredictedPinchCount) {
+    metrics.mMeanLead = totalLead / metrics.mPredictedPinchCount;
+  }
+  return metrics;
+}
+
+}// namespace HandTrackedCockpitClicking
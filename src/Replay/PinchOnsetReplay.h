@@ -0,0 +1,55 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <span>
+
+#include "Config.h"
+#include "SessionCapture.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Runs pinch onset prediction over a capture, offline.
+ *
+ * This replays the thumb-index distances recorded by the API layer through
+ * `PinchOnsetPredictor`, and the recorded raw primary action through the
+ * same debounce period as `HandWakeStateMachine`, using
+ * `HandTrackingGestureMilliseconds` and the prediction settings from the
+ * given snapshot. Only the primary action is considered, and the hands are
+ * treated as always awake.
+ */
+class PinchOnsetReplay final {
+ public:
+  using Duration = std::chrono::duration<float, std::milli>;
+
+  struct Metrics {
+    uint64_t mFrameCount {};
+    // Hand-frames with a recorded thumb-index distance
+    uint64_t mSampleCount {};
+    // Raw primary actions reported by the runtime
+    uint64_t mPinchCount {};
+    // Pinches that were held for long enough to click
+    uint64_t mClickCount {};
+    // Pinches that started the debounce period from a predicted onset
+    uint64_t mPredictedPinchCount {};
+    // Predictions that were cancelled, expired, or otherwise not used
+    uint64_t mFalseOnsetCount {};
+    // From the runtime reporting a pinch to its click
+    Duration mMeanClickLatency {};
+    Duration mMaxClickLatency {};
+    // How much earlier than reported predicted pinches started
+    Duration mMeanLead {};
+  };
+
+  PinchOnsetReplay() = delete;
+  explicit PinchOnsetReplay(const Config::Snapshot&);
+
+  Metrics Run(std::span<const SessionCapture::Frame>) const;
+
+ private:
+  Config::Snapshot mConfig;
+};
+
+}// namespace HandTrackedCockpitClicking
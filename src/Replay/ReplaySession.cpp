@@ -0,0 +1,284 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "ReplaySession.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <optional>
+
+#include "HandTrackingGates.h"
+#include "HandWakeStateMachine.h"
+#include "SmoothingStage.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+using Frame = SessionCapture::Frame;
+using Tracking = HandWakeStateMachine::Tracking;
+
+HandWakeStateMachine::Hand WakeHand(std::size_t index) {
+  return (index == 0) ? HandWakeStateMachine::Hand::Left
+                      : HandWakeStateMachine::Hand::Right;
+}
+
+HandWakeStateMachine::Time WakeTime(XrTime time) {
+  return std::chrono::nanoseconds(time);
+}
+
+float ToMilliseconds(XrTime nanoseconds) {
+  return static_cast<float>(nanoseconds) / 1'000'000;
+}
+
+// Stands in for both HandTrackingSource and HandTrackingStage, using the
+// recorded observations instead of the runtime
+class ReplayHandTrackingStage final : public InputPipeline::Stage {
+ public:
+  explicit ReplayHandTrackingStage(const Config::Snapshot& config)
+    : mWakeStateMachine(HandWakeStateMachine::Timings::FromConfig(config)),
+      mGates(HandTrackingGates::Parameters::FromConfig(config)),
+      mPointerMode(
+        (config.PointerSink == PointerSink::VirtualTouchScreen)
+          ? PointerMode::Direction
+          : PointerMode::Pose) {
+  }
+
+  std::string_view GetName() const override {
+    return "HandTracking";
+  }
+
+  void SetFrame(const Frame* frame) {
+    mFrame = frame;
+  }
+
+  void KeepAlive(std::size_t index, XrTime now) {
+    mWakeStateMachine.KeepAlive(WakeHand(index), WakeTime(now));
+  }
+
+  uint64_t GetWakeCount() const {
+    return mWakeCount;
+  }
+
+  void Process(const FrameInfo& frameInfo, InputPipeline::Hands* hands)
+    override {
+    for (std::size_t i = 0; i < hands->size(); ++i) {
+      auto& hand = (*hands)[i];
+      const auto& observation = mFrame->mHands[i];
+      const auto which = WakeHand(i);
+
+      if (observation.mTracking == Tracking::Tracked) {
+        mWakeStateMachine.ObserveRawActions(
+          which,
+          observation.mRawActions,
+          WakeTime(observation.mRawActionsSince));
+      }
+      const auto output = mWakeStateMachine.Step(
+        which,
+        WakeTime(frameInfo.mNow),
+        mGates.GetWakeInput(frameInfo, observation));
+      if (output.mHandEvent == HandWakeStateMachine::Event::Wake) {
+        ++mWakeCount;
+      }
+
+      if (observation.mTracking != Tracking::Tracked || !output.mActive) {
+        hand = {hand.mHand};
+        continue;
+      }
+      hand = mGates.GetInputState(
+        hand.mHand, frameInfo, observation, output.mActions);
+      hand.mPointerMode = mPointerMode;
+    }
+  }
+
+ private:
+  HandWakeStateMachine mWakeStateMachine;
+  HandTrackingGates mGates;
+  PointerMode mPointerMode;
+
+  const Frame* mFrame {nullptr};
+  uint64_t mWakeCount {};
+};
+
+// Equivalent to KeepAliveStage
+class ReplayKeepAliveStage final : public InputPipeline::Stage {
+ public:
+  explicit ReplayKeepAliveStage(ReplayHandTrackingStage* source)
+    : mSource(source) {
+  }
+
+  std::string_view GetName() const override {
+    return "KeepAlive";
+  }
+
+  void Process(const FrameInfo& frameInfo, InputPipeline::Hands* hands)
+    override {
+    for (std::size_t i = 0; i < hands->size(); ++i) {
+      if ((*hands)[i].mActions.Any()) {
+        mSource->KeepAlive(i, frameInfo.mNow);
+      }
+    }
+  }
+
+ private:
+  ReplayHandTrackingStage* mSource {nullptr};
+};
+
+class MetricsBuilder final {
+ public:
+  void Add(const Frame& frame, const InputPipeline::Hands& output) {
+    ++mMetrics.mFrameCount;
+    const auto now = frame.mFrameInfo.mNow;
+    for (std::size_t i = 0; i < output.size(); ++i) {
+      auto& hand = mHands[i];
+      this->AddActions(&hand, now, frame.mHands[i], output[i]);
+      this->AddDirection(&hand, frame.mFrameInfo, output[i]);
+    }
+  }
+
+  ReplaySession::Metrics Finish() {
+    if (mClickLatencyCount) {
+      mMetrics.mMeanClickLatencyMilliseconds
+        = static_cast<float>(mClickLatencySum / mClickLatencyCount);
+    }
+    if (mJitterCount) {
+      mMetrics.mJitter
+        = static_cast<float>(std::sqrt(mJitterSumOfSquares / mJitterCount));
+    }
+    return mMetrics;
+  }
+
+ private:
+  struct HandState {
+    bool mRawPrimary {false};
+    XrTime mRawPrimarySince {};
+    bool mClicked {false};
+
+    bool mFinalPrimary {false};
+    XrTime mFinalPrimarySince {};
+
+    std::optional<XrVector2f> mDirection;
+    std::optional<XrVector2f> mVelocity;
+  };
+
+  ReplaySession::Metrics mMetrics {};
+  std::array<HandState, 2> mHands {};
+
+  double mClickLatencySum {};
+  uint64_t mClickLatencyCount {};
+  double mJitterSumOfSquares {};
+  uint64_t mJitterCount {};
+
+  void AddActions(
+    HandState* hand,
+    XrTime now,
+    const HandObservation& observation,
+    const InputState& output) {
+    const auto rawPrimary = (observation.mTracking == Tracking::Tracked)
+      && observation.mRawActions.mPrimary;
+    if (rawPrimary && !hand->mRawPrimary) {
+      hand->mRawPrimarySince = observation.mRawActionsSince;
+      hand->mClicked = false;
+    } else if (hand->mRawPrimary && !rawPrimary && !hand->mClicked) {
+      ++mMetrics.mMissedClickCount;
+    }
+    hand->mRawPrimary = rawPrimary;
+
+    const auto finalPrimary = output.mActions.mPrimary;
+    if (finalPrimary && !hand->mFinalPrimary) {
+      ++mMetrics.mClickCount;
+      hand->mFinalPrimarySince = now;
+      if (rawPrimary && !hand->mClicked) {
+        const auto latency = ToMilliseconds(now - hand->mRawPrimarySince);
+        mClickLatencySum += latency;
+        ++mClickLatencyCount;
+        mMetrics.mMaxClickLatencyMilliseconds
+          = std::max(mMetrics.mMaxClickLatencyMilliseconds, latency);
+      }
+      hand->mClicked = true;
+    } else if (hand->mFinalPrimary && !finalPrimary) {
+      const auto duration
+        = std::chrono::nanoseconds(now - hand->mFinalPrimarySince);
+      if (duration < ReplaySession::ShortClick) {
+        ++mMetrics.mShortClickCount;
+      }
+    }
+    hand->mFinalPrimary = finalPrimary;
+  }
+
+  void AddDirection(
+    HandState* hand,
+    const FrameInfo& frameInfo,
+    const InputState& output) {
+    auto direction = output.mDirection;
+    if (output.mPose && !direction) {
+      direction
+        = std::get<1>(HandTrackingGates::RaycastPose(frameInfo, *output.mPose));
+    }
+    if (!direction) {
+      hand->mDirection = {};
+      hand->mVelocity = {};
+      return;
+    }
+
+    if (hand->mDirection) {
+      const XrVector2f velocity {
+        direction->x - hand->mDirection->x,
+        direction->y - hand->mDirection->y,
+      };
+      if (hand->mVelocity) {
+        const double ax = velocity.x - hand->mVelocity->x;
+        const double ay = velocity.y - hand->mVelocity->y;
+        mJitterSumOfSquares += (ax * ax) + (ay * ay);
+        ++mJitterCount;
+      }
+      hand->mVelocity = velocity;
+    }
+    hand->mDirection = direction;
+  }
+};
+
+}// namespace
+
+ReplaySession::ReplaySession(const Config::Snapshot& config)
+  : mConfig(config) {
+}
+
+ReplaySession::Metrics ReplaySession::Run(
+  std::span<const SessionCapture::Frame> frames,
+  const FrameCallback& onFrame,
+  std::stop_token stop) const {
+  // Built the same way as APILayer::BuildInputPipeline(), minus the stages
+  // that need a game or other devices
+  InputPipeline pipeline;
+  auto source = std::make_unique<ReplayHandTrackingStage>(mConfig);
+  const auto sourcePtr = source.get();
+  pipeline.AddStage(std::move(source));
+  pipeline.AddStage(std::make_unique<ReplayKeepAliveStage>(sourcePtr));
+  if (mConfig.SmoothingFactor <= 0.99f) {
+    pipeline.AddStage(std::make_unique<SmoothingStage>(
+      SmoothingStage::Parameters::FromConfig(mConfig)));
+  }
+  const auto outputStage = pipeline.GetStageCount() - 1;
+
+  MetricsBuilder metrics;
+  for (const auto& frame: frames) {
+    if (stop.stop_requested()) {
+      break;
+    }
+    sourcePtr->SetFrame(&frame);
+    pipeline.Run(frame.mFrameInfo);
+    const auto& output = pipeline.GetOutput(outputStage);
+    metrics.Add(frame, output);
+    if (onFrame) {
+      onFrame(frame, output);
+    }
+  }
+
+  auto ret = metrics.Finish();
+  ret.mWakeCount = sourcePtr->GetWakeCount();
+  return ret;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,62 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <functional>
+#include <span>
+#include <stop_token>
+
+#include "Config.h"
+#include "InputPipeline.h"
+#include "SessionCapture.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Runs a captured session through the hand tracking pipeline offline.
+ *
+ * The wake state machine, FOV gates, and smoothing are the same code that the
+ * API layer runs each frame, but their parameters come from the given
+ * snapshot instead of the global config, so any number of replays with
+ * different settings can run at once.
+ */
+class ReplaySession final {
+ public:
+  struct Metrics {
+    uint64_t mFrameCount {};
+    // Rising edges of the final primary action, either hand
+    uint64_t mClickCount {};
+    // Clicks shorter than `ShortClick`; usually flicker, not real clicks
+    uint64_t mShortClickCount {};
+    // Raw pinches that never produced a click
+    uint64_t mMissedClickCount {};
+    uint64_t mWakeCount {};
+    // From the raw pinch starting to the click being output
+    float mMeanClickLatencyMilliseconds {};
+    float mMaxClickLatencyMilliseconds {};
+    // RMS frame-to-frame change in pointer velocity, in radians; this ignores
+    // steady movement, but not shaking
+    float mJitter {};
+  };
+
+  static constexpr std::chrono::milliseconds ShortClick {100};
+
+  using FrameCallback = std::function<void(
+    const SessionCapture::Frame&,
+    const InputPipeline::Hands& output)>;
+
+  ReplaySession() = delete;
+  explicit ReplaySession(const Config::Snapshot&);
+
+  // If `stop` is requested, the metrics only cover the frames replayed so far
+  Metrics Run(
+    std::span<const SessionCapture::Frame>,
+    const FrameCallback& onFrame = {},
+    std::stop_token stop = {}) const;
+
+ private:
+  Config::Snapshot mConfig;
+};
+
+}// namespace HandTrackedCockpitClicking
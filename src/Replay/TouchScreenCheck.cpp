@@ -0,0 +1,480 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "TouchScreenCheck.h"
+
+#include <Windows.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "Clock.h"
+#include "Config.h"
+#include "FrameInfo.h"
+#include "InputInjector.h"
+#include "InputState.h"
+#include "VirtualTouchScreenSink.h"
+
+namespace HandTrackedCockpitClicking::TouchScreenCheck {
+
+namespace {
+
+using namespace std::chrono_literals;
+using Time = std::chrono::nanoseconds;
+using ValueChange = ActionState::ValueChange;
+
+constexpr std::size_t MaxFailures = 10;
+constexpr Time FrameInterval {10ms};
+
+// A multiple of the frame interval, so that every event is on a frame
+constexpr uint16_t ScrollDelayMilliseconds = 500;
+constexpr uint16_t ScrollIntervalMilliseconds = 100;
+
+// With this calibration, each milliradian is a pixel, and the origin is in
+// the middle of the window
+const WindowTracker::Window TestWindow {
+  .mClientRect = {0, 0, 1000, 1000},
+  .mMonitorRect = {0, 0, 1000, 1000},
+};
+const VirtualTouchScreenSink::Calibration TestCalibration {
+  .mWindowInputFov = {1.0f, 1.0f},
+  .mWindowInputFovOrigin0To1 = {0.5f, 0.5f},
+};
+
+enum class Kind {
+  Move,
+  LeftDown,
+  LeftUp,
+  RightDown,
+  RightUp,
+  WheelForward,
+  WheelBackward,
+  Other,
+};
+
+std::string_view GetName(Kind kind) {
+  switch (kind) {
+    case Kind::Move:
+      return "Move";
+    case Kind::LeftDown:
+      return "LeftDown";
+    case Kind::LeftUp:
+      return "LeftUp";
+    case Kind::RightDown:
+      return "RightDown";
+    case Kind::RightUp:
+      return "RightUp";
+    case Kind::WheelForward:
+      return "WheelForward";
+    case Kind::WheelBackward:
+      return "WheelBackward";
+    case Kind::Other:
+      break;
+  }
+  return "Other";
+}
+
+Kind GetKind(const INPUT& input) {
+  if (input.type != INPUT_MOUSE) {
+    return Kind::Other;
+  }
+  const auto& mi = input.mi;
+  switch (mi.dwFlags) {
+    case MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE:
+      return Kind::Move;
+    case MOUSEEVENTF_LEFTDOWN:
+      return Kind::LeftDown;
+    case MOUSEEVENTF_LEFTUP:
+      return Kind::LeftUp;
+    case MOUSEEVENTF_RIGHTDOWN:
+      return Kind::RightDown;
+    case MOUSEEVENTF_RIGHTUP:
+      return Kind::RightUp;
+    case MOUSEEVENTF_WHEEL:
+      return (static_cast<int32_t>(mi.mouseData) > 0) ? Kind::WheelForward
+                                                       : Kind::WheelBackward;
+  }
+  return Kind::Other;
+}
+
+struct Batch {
+  Time mTime {};
+  std::vector<Kind> mKinds;
+  // Of the move, if there is one
+  std::optional<POINT> mPosition;
+};
+
+std::string Describe(const std::vector<Kind>& kinds) {
+  std::string ret;
+  for (const auto kind: kinds) {
+    if (!ret.empty()) {
+      ret += ", ";
+    }
+    ret += GetName(kind);
+  }
+  return std::format("[{}]", ret);
+}
+
+std::string Describe(const std::vector<Time>& times) {
+  std::string ret;
+  for (const auto time: times) {
+    if (!ret.empty()) {
+      ret += ", ";
+    }
+    ret += std::format(
+      "{}", std::chrono::duration_cast<std::chrono::milliseconds>(time));
+  }
+  return std::format("[{}]", ret);
+}
+
+std::string Describe(const std::vector<Batch>& batches) {
+  std::string ret;
+  for (const auto& batch: batches) {
+    ret += Describe(batch.mKinds);
+  }
+  return ret.empty() ? "nothing" : ret;
+}
+
+// The absolute position that a move to `direction` should have
+POINT GetExpectedPosition(const XrVector2f& direction) {
+  return {
+    std::lround((0.5f + direction.y) * 65535),
+    std::lround((0.5f - direction.x) * 65535),
+  };
+}
+
+// Offsets from the middle of the window, in pixels
+XrVector2f Pixels(float x, float y) {
+  return {-y / 1000, x / 1000};
+}
+
+Config::Snapshot MakeConfig() {
+  Config::Snapshot ret;
+  ret.PointerSink = PointerSink::VirtualTouchScreen;
+  ret.ClickActionSink = ActionSink::VirtualTouchScreen;
+  ret.ScrollActionSink = ActionSink::VirtualTouchScreen;
+  ret.ScrollWheelDelayMilliseconds = ScrollDelayMilliseconds;
+  ret.ScrollWheelIntervalMilliseconds = ScrollIntervalMilliseconds;
+  ret.VirtualTouchScreenMaxUpdateHz = 0;
+  return ret;
+}
+
+// A sink, and the events it sent in the last frame
+class Harness final {
+ public:
+  // Starts well after zero, like a real XrTime; otherwise, the first move
+  // would be throttled
+  explicit Harness(const Config::Snapshot& config)
+    : mClock(std::make_shared<VirtualClock>(Time {1s}.count())) {
+    auto injector = std::make_unique<RecordingInputInjector>(mClock);
+    mInjector = injector.get();
+    mSink = std::make_unique<VirtualTouchScreenSink>(
+      std::make_shared<const Config::Snapshot>(config),
+      TestCalibration,
+      TestWindow,
+      std::move(injector));
+  }
+
+  // Advances by a frame, then updates with the right hand pointing at
+  // `direction`
+  std::vector<Batch> Step(
+    const XrVector2f& direction,
+    const ActionState& actions = {}) {
+    mClock->Advance(FrameInterval);
+    FrameInfo frameInfo;
+    frameInfo.mNow = mClock->Now();
+    frameInfo.mPredictedDisplayTime = frameInfo.mNow + FrameInterval.count();
+
+    const InputState right {
+      .mHand = XR_HAND_RIGHT_EXT,
+      .mPositionUpdatedAt = frameInfo.mNow,
+      .mPointerMode = PointerMode::Direction,
+      .mDirection = direction,
+      .mActions = actions,
+    };
+    mSink->Update(frameInfo, InputState {XR_HAND_LEFT_EXT}, right);
+    return this->TakeBatches();
+  }
+
+  std::vector<Batch> ReloadConfig(const Config::Snapshot& config) {
+    mSink->ReloadConfig(std::make_shared<const Config::Snapshot>(config));
+    return this->TakeBatches();
+  }
+
+  Time Now() const {
+    return Time {mClock->Now()};
+  }
+
+ private:
+  std::shared_ptr<VirtualClock> mClock;
+  RecordingInputInjector* mInjector {nullptr};
+  std::unique_ptr<VirtualTouchScreenSink> mSink;
+
+  std::vector<Batch> TakeBatches() {
+    std::vector<Batch> ret;
+    std::optional<std::size_t> batchID;
+    for (const auto& event: mInjector->TakeEvents()) {
+      if (event.mBatch != batchID) {
+        batchID = event.mBatch;
+        ret.push_back({Time {event.mTime}});
+      }
+      auto& batch = ret.back();
+      const auto kind = GetKind(event.mInput);
+      batch.mKinds.push_back(kind);
+      if (kind == Kind::Move) {
+        batch.mPosition = POINT {event.mInput.mi.dx, event.mInput.mi.dy};
+      }
+    }
+    return ret;
+  }
+};
+
+class Checker final {
+ public:
+  explicit Checker(std::string_view name) {
+    mResults.mName = name;
+  }
+
+  template <class... Args>
+  void Check(bool passed, std::format_string<Args...> what, Args&&... args) {
+    ++mResults.mCheckCount;
+    if (passed) {
+      return;
+    }
+    if (mResults.mFailureCount++ < MaxFailures) {
+      mResults.mFailures.push_back(
+        std::format(what, std::forward<Args>(args)...));
+    }
+  }
+
+  // Exactly one batch, containing exactly `kinds`
+  void Expect(
+    std::string_view what,
+    const std::vector<Batch>& actual,
+    const std::vector<Kind>& kinds) {
+    this->Check(
+      actual.size() == 1 && actual.front().mKinds == kinds,
+      "{}: expected {}, got {}",
+      what,
+      Describe(kinds),
+      Describe(actual));
+  }
+
+  void ExpectNothing(std::string_view what, const std::vector<Batch>& actual) {
+    this->Check(
+      actual.empty(), "{}: expected nothing, got {}", what, Describe(actual));
+  }
+
+  void ExpectPosition(
+    std::string_view what,
+    const std::vector<Batch>& actual,
+    const XrVector2f& direction) {
+    const auto expected = GetExpectedPosition(direction);
+    const auto position
+      = actual.empty() ? std::nullopt : actual.back().mPosition;
+    // Allow for rounding
+    this->Check(
+      position && std::abs(position->x - expected.x) <= 1
+        && std::abs(position->y - expected.y) <= 1,
+      "{}: expected a move to ({}, {})",
+      what,
+      expected.x,
+      expected.y);
+  }
+
+  Results Take() {
+    return std::move(mResults);
+  }
+
+ private:
+  Results mResults;
+};
+
+// Holds a scroll direction, returning the time of each wheel event relative
+// to the first frame
+std::vector<Time> HoldScroll(
+  Checker* checker,
+  Harness* harness,
+  ValueChange direction,
+  Time duration) {
+  const auto expectedKind = (direction == ValueChange::Increase)
+    ? Kind::WheelForward
+    : Kind::WheelBackward;
+  std::vector<Time> ret;
+  std::optional<Time> start;
+  for (Time held {}; held < duration; held += FrameInterval) {
+    const auto batches
+      = harness->Step(Pixels(0, 0), {.mValueChange = direction});
+    if (!start) {
+      start = harness->Now();
+    }
+    if (batches.empty()) {
+      continue;
+    }
+    // Moves are always sent with scrolls, in case something else moved the
+    // cursor
+    checker->Expect("Scroll", batches, {Kind::Move, expectedKind});
+    ret.push_back(batches.front().mTime - *start);
+  }
+  return ret;
+}
+
+Results CheckScrollTiming() {
+  Checker checker {"ScrollTiming"};
+  Harness harness {MakeConfig()};
+  checker.Expect("First frame", harness.Step(Pixels(0, 0)), {Kind::Move});
+
+  const auto check = [&checker](
+                       std::string_view what,
+                       const std::vector<Time>& actual,
+                       const std::vector<Time>& expected) {
+    checker.Check(
+      actual == expected,
+      "{}: expected wheel events at {}, got {}",
+      what,
+      Describe(expected),
+      Describe(actual));
+  };
+  const Time delay = std::chrono::milliseconds(ScrollDelayMilliseconds);
+  const Time interval = std::chrono::milliseconds(ScrollIntervalMilliseconds);
+
+  // Immediate, then after the delay, then at every interval
+  check(
+    "Held",
+    HoldScroll(&checker, &harness, ValueChange::Increase, 1s),
+    {
+      0ns,
+      delay,
+      delay + interval,
+      delay + (2 * interval),
+      delay + (3 * interval),
+      delay + (4 * interval),
+    });
+
+  checker.ExpectNothing("Released", harness.Step(Pixels(0, 0)));
+
+  // Shorter than the delay, so only one each time
+  for (int i = 0; i < 3; ++i) {
+    check(
+      "Tapped",
+      HoldScroll(&checker, &harness, ValueChange::Decrease, delay / 2),
+      {0ns});
+    checker.ExpectNothing("Released", harness.Step(Pixels(0, 0)));
+  }
+
+  // Changing direction starts again, without waiting for the interval
+  check(
+    "Before reversing",
+    HoldScroll(&checker, &harness, ValueChange::Increase, delay + interval),
+    {0ns, delay});
+  check(
+    "Reversed",
+    HoldScroll(&checker, &harness, ValueChange::Decrease, delay + interval),
+    {0ns, delay});
+
+  return checker.Take();
+}
+
+Results CheckClickOrdering() {
+  Checker checker {"ClickOrdering"};
+  const auto config = MakeConfig();
+  Harness harness {config};
+  const auto here = Pixels(10, 20);
+  const ActionState left {.mPrimary = true};
+  const ActionState both {.mPrimary = true, .mSecondary = true};
+
+  checker.Expect("First frame", harness.Step(here), {Kind::Move});
+  // Moves are sent with clicks even if the cursor didn't move, then the
+  // click, in the same batch
+  checker.Expect(
+    "Press", harness.Step(here, left), {Kind::Move, Kind::LeftDown});
+  checker.ExpectNothing("Hold", harness.Step(here, left));
+  checker.Expect(
+    "Add right", harness.Step(here, both), {Kind::Move, Kind::RightDown});
+  checker.Expect(
+    "Release", harness.Step(here), {Kind::Move, Kind::LeftUp, Kind::RightUp});
+
+  // Moving and clicking on the same frame clicks at the new position
+  const auto there = Pixels(-30, 40);
+  const auto moved = harness.Step(there, left);
+  checker.Expect("Move and press", moved, {Kind::Move, Kind::LeftDown});
+  checker.ExpectPosition("Move and press", moved, there);
+
+  checker.Expect(
+    "Both", harness.Step(there, both), {Kind::Move, Kind::RightDown});
+  // Releasing because of a config change doesn't move
+  auto noClicks = config;
+  noClicks.ClickActionSink = ActionSink::VirtualVRController;
+  checker.Expect(
+    "Config change",
+    harness.ReloadConfig(noClicks),
+    {Kind::LeftUp, Kind::RightUp});
+  checker.ExpectNothing("After config change", harness.Step(there, both));
+
+  return checker.Take();
+}
+
+// The move suppression from `VirtualTouchScreenMaxUpdateHz`, and skipping
+// moves within the same pixel
+Results CheckMoveSuppression() {
+  Checker checker {"MoveSuppression"};
+  {
+    Harness harness {MakeConfig()};
+    checker.Expect("First frame", harness.Step(Pixels(0, 0)), {Kind::Move});
+    checker.ExpectNothing("Same direction", harness.Step(Pixels(0, 0)));
+    checker.ExpectNothing("Same pixel", harness.Step(Pixels(0.2f, -0.2f)));
+    const auto moved = harness.Step(Pixels(1, 0));
+    checker.Expect("Next pixel", moved, {Kind::Move});
+    checker.ExpectPosition("Next pixel", moved, Pixels(1, 0));
+  }
+
+  // 50Hz, so every other frame
+  auto config = MakeConfig();
+  config.VirtualTouchScreenMaxUpdateHz = 50;
+  Harness harness {config};
+  checker.Expect("First frame", harness.Step(Pixels(0, 0)), {Kind::Move});
+
+  uint64_t moveCount {};
+  for (int i = 1; i <= 20; ++i) {
+    const auto batches = harness.Step(Pixels(static_cast<float>(i), 0));
+    if ((i % 2) == 0) {
+      checker.Expect("Throttled, due", batches, {Kind::Move});
+      checker.ExpectPosition(
+        "Throttled, due", batches, Pixels(static_cast<float>(i), 0));
+    } else {
+      checker.ExpectNothing("Throttled", batches);
+    }
+    moveCount += batches.size();
+  }
+  checker.Check(moveCount == 10, "Expected 10 moves in 20 frames");
+
+  // If a move is skipped and the pointer then stops, the skipped position is
+  // still sent
+  checker.ExpectNothing("Skipped", harness.Step(Pixels(40, 0)));
+  const auto caughtUp = harness.Step(Pixels(40, 0));
+  checker.Expect("Caught up", caughtUp, {Kind::Move});
+  checker.ExpectPosition("Caught up", caughtUp, Pixels(40, 0));
+
+  // Clicks aren't throttled, and are still sent with a move
+  const auto clicked = harness.Step(Pixels(41, 0), {.mPrimary = true});
+  checker.Expect("Click", clicked, {Kind::Move, Kind::LeftDown});
+  checker.ExpectPosition("Click", clicked, Pixels(41, 0));
+
+  return checker.Take();
+}
+
+}// namespace
+
+std::vector<Results> Run() {
+  return {
+    CheckScrollTiming(),
+    CheckClickOrdering(),
+    CheckMoveSuppression(),
+  };
+}
+
+}// namespace HandTrackedCockpitClicking::TouchScreenCheck
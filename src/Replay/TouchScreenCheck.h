@@ -0,0 +1,35 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** Drives `VirtualTouchScreenSink` with scripted hands and a `VirtualClock`.
+ *
+ * Events go to a `RecordingInputInjector`, and the sink maps to a fixed
+ * window, so each check can assert exactly which batches are sent, and when:
+ *
+ * - the first scroll is immediate, the second is after
+ *   `ScrollWheelDelayMilliseconds`, then every
+ *   `ScrollWheelIntervalMilliseconds`
+ * - clicks are in the same batch as a move, after it
+ * - moves are only sent when the cursor moves to another pixel, no more
+ *   often than `VirtualTouchScreenMaxUpdateHz`, and the latest position isn't
+ *   lost when one is skipped
+ */
+namespace HandTrackedCockpitClicking::TouchScreenCheck {
+
+struct Results {
+  std::string_view mName;
+  uint64_t mCheckCount {};
+  uint64_t mFailureCount {};
+  // The first few failures
+  std::vector<std::string> mFailures;
+};
+
+std::vector<Results> Run();
+
+}// namespace HandTrackedCockpitClicking::TouchScreenCheck
@@ -0,0 +1,332 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "Tuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numbers>
+#include <print>
+#include <sstream>
+#include <type_traits>
+
+#include "ParallelFor.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+struct Dimension {
+  std::string_view mName;
+  float mMin {};
+  float mMax {};
+  float (*mGet)(const Config::Snapshot&) {nullptr};
+  void (*mSet)(Config::Snapshot*, float) {nullptr};
+};
+
+template <auto Member>
+constexpr auto GetSetting = [](const Config::Snapshot& config) {
+  return static_cast<float>(config.*Member);
+};
+
+template <auto Member>
+constexpr auto SetSetting = [](Config::Snapshot* config, float value) {
+  using T = std::remove_cvref_t<decltype(config->*Member)>;
+  if constexpr (std::is_integral_v<T>) {
+    config->*Member = static_cast<T>(std::lround(value));
+  } else {
+    config->*Member = value;
+  }
+};
+
+const std::array<Dimension, 8> Dimensions {{
+#define IT(name, min, max) \
+  {#name, \
+   min, \
+   max, \
+   GetSetting<&Config::Snapshot::name>, \
+   SetSetting<&Config::Snapshot::name>}
+  IT(HandTrackingWakeMilliseconds, 0, 500),
+  IT(HandTrackingSleepMilliseconds, 100, 2000),
+  IT(HandTrackingGestureMilliseconds, 0, 200),
+  IT(HandTrackingWakeHFOV, 0.2f, std::numbers::pi_v<float>),
+  IT(HandTrackingWakeVFOV, 0.2f, std::numbers::pi_v<float>),
+  IT(HandTrackingActionHFOV, 0.2f, std::numbers::pi_v<float>),
+  IT(HandTrackingActionVFOV, 0.2f, std::numbers::pi_v<float>),
+  IT(SmoothingFactor, 0.3f, 1.0f),
+#undef IT
+}};
+static_assert(std::tuple_size_v<decltype(Dimensions)> == Tuner::SettingCount);
+
+// Allow the label to end a little before the click is output
+constexpr XrTime LabelSlack
+  = std::chrono::nanoseconds(std::chrono::milliseconds(500)).count();
+
+// Matches output clicks against the labels as frames are replayed
+class Scorer final {
+ public:
+  Scorer(std::span<const Tuner::Label> labels, const Tuner::Weights& weights)
+    : mLabels(labels), mWeights(weights), mHit(labels.size(), false) {
+  }
+
+  void Add(
+    const SessionCapture::Frame& frame,
+    const InputPipeline::Hands& hands) {
+    const auto now = frame.mFrameInfo.mNow;
+    for (std::size_t i = 0; i < hands.size(); ++i) {
+      const auto primary = hands[i].mActions.mPrimary;
+      if (primary && !mPrimary[i]) {
+        this->AddClick(now);
+      }
+      mPrimary[i] = primary;
+    }
+
+    while (mNextOpenLabel < mLabels.size()
+           && now > mLabels[mNextOpenLabel].mEnd + LabelSlack) {
+      if (!mHit[mNextOpenLabel]) {
+        ++mMissedClicks;
+      }
+      ++mNextOpenLabel;
+    }
+  }
+
+  void Finish() {
+    for (; mNextOpenLabel < mLabels.size(); ++mNextOpenLabel) {
+      if (!mHit[mNextOpenLabel]) {
+        ++mMissedClicks;
+      }
+    }
+  }
+
+  // The cost so far can only go up
+  float GetLowerBound() const {
+    return (mWeights.mFalseClick * mFalseClicks)
+      + (mWeights.mMissedClick * mMissedClicks);
+  }
+
+  float GetCost(const ReplaySession::Metrics& metrics) const {
+    return this->GetLowerBound()
+      + (mWeights.mLatency * metrics.mMeanClickLatencyMilliseconds)
+      + (mWeights.mJitter * metrics.mJitter * 1000);
+  }
+
+  uint64_t GetFalseClicks() const {
+    return mFalseClicks;
+  }
+
+  uint64_t GetMissedClicks() const {
+    return mMissedClicks;
+  }
+
+ private:
+  std::span<const Tuner::Label> mLabels;
+  Tuner::Weights mWeights;
+  std::vector<bool> mHit;
+  // Labels before this have ended, and been counted if missed
+  std::size_t mNextOpenLabel {};
+
+  std::array<bool, 2> mPrimary {};
+  uint64_t mFalseClicks {};
+  uint64_t mMissedClicks {};
+
+  void AddClick(XrTime now) {
+    for (auto i = mNextOpenLabel; i < mLabels.size(); ++i) {
+      const auto& label = mLabels[i];
+      if (now < label.mStart) {
+        break;
+      }
+      if (now <= label.mEnd + LabelSlack) {
+        mHit[i] = true;
+        return;
+      }
+    }
+    ++mFalseClicks;
+  }
+};
+
+}// namespace
+
+
+Tuner::Tuner(
+  std::span<const SessionCapture::Frame> frames,
+  std::vector<Label> labels,
+  const Config::Snapshot& base,
+  const Parameters& parameters)
+  : mFrames(frames),
+    mLabels(std::move(labels)),
+    mBase(base),
+    mParameters(parameters),
+    mRandom(parameters.mSeed),
+    mBestCost(std::numeric_limits<float>::infinity()) {
+  std::ranges::sort(mLabels, {}, &Label::mStart);
+}
+
+std::vector<std::string_view> Tuner::GetSettingNames() {
+  std::vector<std::string_view> ret;
+  for (const auto& dimension: Dimensions) {
+    ret.push_back(dimension.mName);
+  }
+  return ret;
+}
+
+std::optional<std::vector<Tuner::Label>> Tuner::LoadLabels(
+  const std::filesystem::path& path,
+  XrTime captureStart) {
+  std::ifstream file(path);
+  if (!file) {
+    return std::nullopt;
+  }
+
+  const auto toTime = [captureStart](double seconds) {
+    return captureStart + static_cast<XrTime>(seconds * 1'000'000'000);
+  };
+
+  std::vector<Label> ret;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    std::istringstream stream(line);
+    double start {};
+    double end {};
+    if (!(stream >> start >> end) || end < start) {
+      return std::nullopt;
+    }
+    ret.push_back({toTime(start), toTime(end)});
+  }
+  return ret;
+}
+
+Tuner::Candidate Tuner::GetBaseCandidate() const {
+  Candidate ret {};
+  for (std::size_t i = 0; i < Dimensions.size(); ++i) {
+    ret[i] = Dimensions[i].mGet(mBase);
+  }
+  return ret;
+}
+
+Tuner::Candidate Tuner::GetRandomCandidate() {
+  Candidate ret {};
+  for (std::size_t i = 0; i < Dimensions.size(); ++i) {
+    const auto& dimension = Dimensions[i];
+    ret[i] = std::uniform_real_distribution<float>(
+      dimension.mMin, dimension.mMax)(mRandom);
+  }
+  return ret;
+}
+
+Tuner::Candidate Tuner::Perturb(const Candidate& parent, float scale) {
+  Candidate ret {};
+  for (std::size_t i = 0; i < Dimensions.size(); ++i) {
+    const auto& dimension = Dimensions[i];
+    const auto range = dimension.mMax - dimension.mMin;
+    const auto step
+      = std::normal_distribution<float>(0, range * scale)(mRandom);
+    ret[i] = std::clamp(parent[i] + step, dimension.mMin, dimension.mMax);
+  }
+  return ret;
+}
+
+std::optional<Tuner::Result> Tuner::Evaluate(const Candidate& candidate) {
+  Result result {.mConfig = mBase};
+  for (std::size_t i = 0; i < Dimensions.size(); ++i) {
+    Dimensions[i].mSet(&result.mConfig, candidate[i]);
+  }
+
+  Scorer scorer(mLabels, mParameters.mWeights);
+  std::stop_source stop;
+  const auto onFrame = [&](const auto& frame, const auto& hands) {
+    scorer.Add(frame, hands);
+    if (scorer.GetLowerBound() > mBestCost.load(std::memory_order_relaxed)) {
+      stop.request_stop();
+    }
+  };
+  result.mMetrics
+    = ReplaySession(result.mConfig).Run(mFrames, onFrame, stop.get_token());
+  if (stop.stop_requested()) {
+    ++mStoppedCount;
+    return std::nullopt;
+  }
+
+  scorer.Finish();
+  result.mFalseClicks = scorer.GetFalseClicks();
+  result.mMissedClicks = scorer.GetMissedClicks();
+  result.mCost = scorer.GetCost(result.mMetrics);
+
+  auto best = mBestCost.load(std::memory_order_relaxed);
+  while (result.mCost < best
+         && !mBestCost.compare_exchange_weak(
+           best, result.mCost, std::memory_order_relaxed)) {
+  }
+  return result;
+}
+
+void Tuner::EvaluateAll(std::span<const Candidate> candidates) {
+  std::vector<std::optional<Result>> results(candidates.size());
+  ParallelFor(candidates.size(), mParameters.mThreads, [&](std::size_t i) {
+    results[i] = this->Evaluate(candidates[i]);
+  });
+
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    if (results[i]) {
+      mResults.emplace_back(candidates[i], std::move(*results[i]));
+    }
+  }
+  std::ranges::sort(mResults, {}, [](const auto& it) {
+    return it.second.mCost;
+  });
+}
+
+std::vector<Tuner::Result> Tuner::Run() {
+  const auto total = std::max<std::size_t>(mParameters.mCandidates, 2);
+
+  // Explore: the current settings, and random points across the whole range
+  std::vector<Candidate> batch {this->GetBaseCandidate()};
+  while (batch.size() < total / 2) {
+    batch.push_back(this->GetRandomCandidate());
+  }
+  this->EvaluateAll(batch);
+  auto evaluated = batch.size();
+  const auto printProgress = [&] {
+    if (mResults.empty()) {
+      return;
+    }
+    std::println(
+      stderr,
+      "Evaluated {}/{} candidates; best cost {:.1f}; {} stopped early",
+      evaluated,
+      total,
+      mResults.front().second.mCost,
+      mStoppedCount.load());
+  };
+  printProgress();
+
+  // Refine: perturb the best so far, by less each round
+  constexpr std::size_t Parents = 8;
+  constexpr std::size_t Rounds = 10;
+  const auto perRound = ((total - evaluated) + Rounds - 1) / Rounds;
+  for (std::size_t round = 0; round < Rounds && evaluated < total; ++round) {
+    if (mResults.empty()) {
+      break;
+    }
+    const auto scale = 0.2f * std::pow(0.1f, round / (Rounds - 1.0f));
+    batch.clear();
+    for (std::size_t i = 0; i < perRound && evaluated + i < total; ++i) {
+      const auto& parent = mResults[i % std::min(Parents, mResults.size())];
+      batch.push_back(this->Perturb(parent.first, scale));
+    }
+    this->EvaluateAll(batch);
+    evaluated += batch.size();
+    printProgress();
+  }
+
+  std::vector<Result> ret;
+  for (auto& [candidate, result]: mResults) {
+    ret.push_back(std::move(result));
+  }
+  return ret;
+}
+
+}// namespace HandTrackedCockpitClicking
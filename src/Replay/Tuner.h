@@ -0,0 +1,113 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "Config.h"
+#include "ReplaySession.h"
+#include "SessionCapture.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Searches for the hand tracking settings that best fit a labelled capture.
+ *
+ * Labels are the periods in which the user meant to click. Each candidate
+ * configuration is replayed and scored on click latency, pointer jitter,
+ * clicks outside any label, and labels without a click; lower is better.
+ *
+ * Candidates are replayed in parallel. A replay is abandoned as soon as its
+ * false and missed clicks alone cost more than the best complete result so
+ * far, so most poor candidates only replay a fraction of the capture.
+ *
+ * The search samples the whole range of each setting, then repeatedly
+ * perturbs the best results by shrinking amounts.
+ */
+class Tuner final {
+ public:
+  struct Label {
+    XrTime mStart {};
+    XrTime mEnd {};
+  };
+
+  struct Weights {
+    // Per millisecond of mean click latency
+    float mLatency {1.0f};
+    // Per milliradian of jitter
+    float mJitter {10.0f};
+    float mFalseClick {500.0f};
+    float mMissedClick {1000.0f};
+  };
+
+  struct Parameters {
+    std::size_t mCandidates {2000};
+    // Zero for one per core
+    unsigned int mThreads {};
+    uint32_t mSeed {};
+    Weights mWeights {};
+  };
+
+  struct Result {
+    Config::Snapshot mConfig;
+    ReplaySession::Metrics mMetrics {};
+    uint64_t mFalseClicks {};
+    uint64_t mMissedClicks {};
+    float mCost {};
+  };
+
+  Tuner() = delete;
+  Tuner(
+    std::span<const SessionCapture::Frame>,
+    std::vector<Label>,
+    const Config::Snapshot& base,
+    const Parameters&);
+
+  // The best results, best first
+  std::vector<Result> Run();
+
+  // The settings that are searched
+  static constexpr std::size_t SettingCount = 8;
+  static std::vector<std::string_view> GetSettingNames();
+
+  /* Load labels from a text file.
+   *
+   * Each line is the start and end of a label in seconds since
+   * `captureStart`, separated by whitespace; blank lines and lines starting
+   * with `#` are ignored.
+   */
+  static std::optional<std::vector<Label>> LoadLabels(
+    const std::filesystem::path&,
+    XrTime captureStart);
+
+ private:
+  // One value for each of `GetSettingNames()`
+  using Candidate = std::array<float, SettingCount>;
+
+  std::span<const SessionCapture::Frame> mFrames;
+  std::vector<Label> mLabels;
+  Config::Snapshot mBase;
+  Parameters mParameters;
+
+  std::mt19937 mRandom;
+  std::atomic<float> mBestCost;
+  std::atomic<uint64_t> mStoppedCount {};
+
+  std::vector<std::pair<Candidate, Result>> mResults;
+
+  Candidate GetBaseCandidate() const;
+  Candidate GetRandomCandidate();
+  Candidate Perturb(const Candidate&, float scale);
+
+  void EvaluateAll(std::span<const Candidate>);
+  std::optional<Result> Evaluate(const Candidate&);
+};
+
+}// namespace HandTrackedCockpitClicking
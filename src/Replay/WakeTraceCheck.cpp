@@ -0,0 +1,431 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "WakeTraceCheck.h"
+
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <random>
+#include <string_view>
+
+#include "Config.h"
+#include "HandTrackingGates.h"
+
+namespace HandTrackedCockpitClicking::WakeTraceCheck {
+
+namespace {
+
+using Event = HandWakeStateMachine::Event;
+using Hand = HandWakeStateMachine::Hand;
+using Input = HandWakeStateMachine::Input;
+using Output = HandWakeStateMachine::Output;
+using State = HandWakeStateMachine::State;
+using Time = HandWakeStateMachine::Time;
+using Tracking = HandWakeStateMachine::Tracking;
+
+constexpr std::size_t MaxFailures = 10;
+
+constexpr std::array Trackings {
+  Tracking::Unavailable,
+  Tracking::Untracked,
+  Tracking::Tracked,
+};
+constexpr std::array RawActions {
+  ActionState {},
+  ActionState {.mPrimary = true},
+  ActionState {.mSecondary = true},
+  ActionState {.mValueChange = ActionState::ValueChange::Increase},
+};
+// Raw actions vary slowest, so that an input can keep everything else, but
+// change its raw actions
+constexpr std::size_t InputsPerRawAction = Trackings.size() * 2 * 2 * 2;
+constexpr std::size_t InputCount = InputsPerRawAction * RawActions.size();
+
+Input GetInput(std::size_t index) {
+  return {
+    .mTracking = Trackings.at(index % Trackings.size()),
+    .mInWakeFOV = ((index / 3) % 2) == 1,
+    .mInActionFOV = ((index / 6) % 2) == 1,
+    .mInHibernateGesture = ((index / 12) % 2) == 1,
+    .mRawActions = RawActions.at(index / InputsPerRawAction),
+  };
+}
+
+std::size_t WithRawActions(std::size_t index, std::size_t rawActions) {
+  return (index % InputsPerRawAction) + (rawActions * InputsPerRawAction);
+}
+
+void Merge(Results* into, const Results& from) {
+  into->mStepCount += from.mStepCount;
+  for (std::size_t i = 0; i < from.mEventCounts.size(); ++i) {
+    into->mEventCounts.at(i) += from.mEventCounts.at(i);
+  }
+  into->mFailureCount += from.mFailureCount;
+  for (const auto& failure: from.mFailures) {
+    if (into->mFailures.size() < MaxFailures) {
+      into->mFailures.push_back(failure);
+    }
+  }
+}
+
+// Wraps a HandWakeStateMachine, checking each step against a model that only
+// knows the inputs
+class Checker final {
+ public:
+  explicit Checker(const Timings& timings)
+    : mTimings(timings), mMachine(timings) {
+  }
+
+  Output Step(Hand which, Time now, const Input& input) {
+    auto& hand = Get(which);
+    const auto previousState = mMachine.GetState(which);
+    const auto wasHibernating = mMachine.IsHibernating();
+    const auto tracked = (input.mTracking == Tracking::Tracked);
+
+    // Everything here can only make the model's timers start earlier than the
+    // machine's, so the checks below can't fail spuriously
+    bool rawActionsChanged = false;
+    if (tracked) {
+      if (input.mRawActions != hand.mRawActions) {
+        hand.mRawActions = input.mRawActions;
+        hand.mRawActionsSince = now;
+        rawActionsChanged = true;
+      }
+      hand.mWakeSince = input.mInWakeFOV
+        ? std::optional {hand.mWakeSince.value_or(now)}
+        : std::nullopt;
+      hand.mGestureSince = input.mInHibernateGesture
+        ? std::optional {hand.mGestureSince.value_or(now)}
+        : std::nullopt;
+      if (input.mInActionFOV) {
+        hand.mKeepAliveAt = now;
+      }
+    }
+    if (input.mTracking != Tracking::Unavailable) {
+      hand.mInActionFOV = tracked && input.mInActionFOV;
+    }
+
+    const auto out = mMachine.Step(which, now, input);
+    ++mResults.mStepCount;
+    const auto state = mMachine.GetState(which);
+    const auto hibernating = mMachine.IsHibernating();
+    const auto check = [&](bool ok, std::string_view what) {
+      if (!ok) {
+        this->Fail(which, now, what);
+      }
+    };
+
+    check(out.mActive || !out.mActions.Any(), "inactive hand has actions");
+    check(
+      !out.mActive || (state == State::Awake && !hibernating),
+      "sleeping or hibernating hand is active");
+    check(!(out.mActive && mMachine.IsIdle(which)), "active hand is idle");
+    check(
+      !(mMachine.IsIdle(which)
+        && (hand.mInActionFOV || hand.mRawActions.Any())),
+      "hand in the action FOV, or with raw actions, is idle");
+
+    if (input.mTracking == Tracking::Unavailable) {
+      check(
+        !(out.mActive || out.mHandEvent || out.mHibernationEvent),
+        "unavailable hand is active, or changed state");
+    }
+
+    if (out.mHandEvent == Event::Wake) {
+      ++mResults.mEventCounts.at(static_cast<std::size_t>(Event::Wake));
+      check(
+        previousState == State::Sleeping && state == State::Awake,
+        "wake event, but the hand didn't wake");
+      const auto gesture = hand.mRawActions.Any() && !rawActionsChanged
+        && Elapsed(hand.mRawActionsSince, now, mTimings.mGesture);
+      const auto wakeFOV = Elapsed(hand.mWakeSince, now, mTimings.mWake);
+      check(tracked && (gesture || wakeFOV), "woke too early");
+    } else if (out.mHandEvent == Event::Sleep) {
+      ++mResults.mEventCounts.at(static_cast<std::size_t>(Event::Sleep));
+      check(
+        previousState == State::Awake && state == State::Sleeping,
+        "sleep event, but the hand didn't sleep");
+      check(
+        !hand.mKeepAliveAt || Elapsed(hand.mKeepAliveAt, now, mTimings.mSleep),
+        "slept too early");
+    } else {
+      check(!out.mHandEvent, "hibernation event as a hand event");
+      check(state == previousState, "hand changed state without an event");
+    }
+
+    if (out.mHibernationEvent) {
+      const auto event = *out.mHibernationEvent;
+      ++mResults.mEventCounts.at(static_cast<std::size_t>(event));
+      check(
+        hibernating != wasHibernating
+          && event
+            == (hibernating ? Event::HibernateSleep : Event::HibernateWake),
+        "hibernation event doesn't match the change");
+      check(
+        tracked && mTimings.mHibernateGesture.count()
+          && mTimings.mHibernateInterval.count(),
+        "hibernation changed while untracked or disabled");
+      check(
+        Elapsed(hand.mGestureSince, now, mTimings.mHibernateGesture),
+        "hibernation changed too early");
+      check(
+        Elapsed(mLastHibernationChangeAt, now, mTimings.mHibernateInterval)
+          || !mLastHibernationChangeAt,
+        "hibernation changed too soon after the last change");
+      mLastHibernationChangeAt = now;
+    } else {
+      check(hibernating == wasHibernating, "hibernation changed silently");
+    }
+
+    // Clicks can only start inside the action FOV, but can continue outside
+    const auto& previousActions = hand.mOutputActions;
+    const auto started
+      = (out.mActions.mPrimary && !previousActions.mPrimary)
+      || (out.mActions.mSecondary && !previousActions.mSecondary);
+    check(!started || input.mInActionFOV, "click started outside action FOV");
+
+    // ... and once they're stable there, they must be used
+    if (
+      tracked && input.mInActionFOV && hand.mRawActions.Any() && !hibernating
+      && !rawActionsChanged
+      && Elapsed(hand.mRawActionsSince, now, mTimings.mGesture)) {
+      check(
+        out.mActive && out.mActions == hand.mRawActions,
+        "stable actions in the action FOV were ignored");
+    }
+
+    // The machine definitely restarted its keep-alive timer
+    if (tracked && out.mActive && out.mActions.Any()) {
+      hand.mKeepAliveAt = now;
+    }
+    hand.mOutputActions = out.mActions;
+    return out;
+  }
+
+  void KeepAlive(Hand which, Time now) {
+    mMachine.KeepAlive(which, now);
+    Get(which).mKeepAliveAt = now;
+  }
+
+  void ObserveRawActions(Hand which, const ActionState& actions, Time at) {
+    if (mMachine.ObserveRawActions(which, actions, at)) {
+      auto& hand = Get(which);
+      hand.mRawActions = actions;
+      hand.mRawActionsSince = at;
+    }
+  }
+
+  const Results& GetResults() const {
+    return mResults;
+  }
+
+ private:
+  struct HandModel {
+    ActionState mRawActions {};
+    std::optional<Time> mRawActionsSince;
+    std::optional<Time> mWakeSince;
+    std::optional<Time> mGestureSince;
+    std::optional<Time> mKeepAliveAt;
+    // As of the last step where it was tracked or untracked
+    bool mInActionFOV {false};
+    ActionState mOutputActions {};
+  };
+
+  Timings mTimings;
+  HandWakeStateMachine mMachine;
+  std::array<HandModel, 2> mHands {};
+  std::optional<Time> mLastHibernationChangeAt;
+  Results mResults;
+
+  HandModel& Get(Hand which) {
+    return mHands.at(static_cast<std::size_t>(which));
+  }
+
+  static bool Elapsed(
+    const std::optional<Time>& since,
+    Time now,
+    std::chrono::milliseconds duration) {
+    return since && (now - *since) >= duration;
+  }
+
+  void Fail(Hand which, Time now, std::string_view what) {
+    ++mResults.mFailureCount;
+    if (mResults.mFailures.size() < MaxFailures) {
+      mResults.mFailures.push_back(std::format(
+        "{} hand at {}: {}",
+        (which == Hand::Left) ? "Left" : "Right",
+        now,
+        what));
+    }
+  }
+};
+
+// As KeepAliveStage
+void StepAndKeepAlive(Checker* checker, Hand which, Time now, Input input) {
+  const auto out = checker->Step(which, now, input);
+  if (out.mActive && out.mActions.Any()) {
+    checker->KeepAlive(which, now);
+  }
+}
+
+// An arbitrary non-zero start, as zero means 'never' to the machine
+constexpr Time StartTime = std::chrono::seconds(1);
+
+// Each frame, each hand's input either stays the same, or changes to a random
+// one; holding inputs for a while lets the timers elapse
+class RandomWalk final {
+ public:
+  explicit RandomWalk(uint32_t seed) : mRandom(seed) {
+  }
+
+  Time NextFrame() {
+    mNow += std::chrono::milliseconds(mFrameInterval(mRandom));
+    return mNow;
+  }
+
+  // If set, the raw actions were seen by the sampler before the frame
+  std::optional<Time> NextInput(Hand which, Input* input) {
+    auto& index = mInputs.at(static_cast<std::size_t>(which));
+    if (mChange(mRandom)) {
+      index = mInput(mRandom);
+    }
+    std::optional<Time> sampledAt;
+    if (mSample(mRandom)) {
+      index = WithRawActions(index, mRawActions(mRandom));
+      sampledAt = mNow - std::chrono::milliseconds(mSampleAge(mRandom));
+    }
+    *input = GetInput(index);
+    return sampledAt;
+  }
+
+ private:
+  std::mt19937 mRandom;
+  Time mNow {StartTime};
+  std::array<std::size_t, 2> mInputs {};
+
+  std::uniform_int_distribution<int> mFrameInterval {5, 25};
+  std::uniform_int_distribution<int> mSampleAge {0, 4};
+  std::bernoulli_distribution mChange {0.05};
+  std::bernoulli_distribution mSample {0.02};
+  std::uniform_int_distribution<std::size_t> mInput {0, InputCount - 1};
+  std::uniform_int_distribution<std::size_t> mRawActions {
+    0, RawActions.size() - 1};
+};
+
+}// namespace
+
+Results CheckInputPairs(const Timings& timings) {
+  constexpr std::chrono::milliseconds FrameInterval {10};
+  const auto longest = timings.mWake + timings.mSleep + timings.mGesture
+    + timings.mHibernateGesture + timings.mHibernateInterval;
+  const auto framesPerInput
+    = static_cast<std::size_t>(2 * (longest / FrameInterval)) + 2;
+
+  Results ret;
+  for (std::size_t first = 0; first < InputCount; ++first) {
+    for (std::size_t second = 0; second < InputCount; ++second) {
+      Checker checker(timings);
+      auto now = StartTime;
+      for (const auto index: {first, second}) {
+        const auto input = GetInput(index);
+        for (std::size_t i = 0; i < framesPerInput; ++i) {
+          now += FrameInterval;
+          StepAndKeepAlive(&checker, Hand::Right, now, input);
+        }
+      }
+      Merge(&ret, checker.GetResults());
+    }
+  }
+  return ret;
+}
+
+Results CheckRandomWalks(
+  const Timings& timings,
+  uint32_t seed,
+  std::size_t walkCount,
+  std::size_t framesPerWalk) {
+  Results ret;
+  for (std::size_t walk = 0; walk < walkCount; ++walk) {
+    Checker checker(timings);
+    RandomWalk random(seed + static_cast<uint32_t>(walk));
+    for (std::size_t frame = 0; frame < framesPerWalk; ++frame) {
+      const auto now = random.NextFrame();
+      for (const auto which: {Hand::Left, Hand::Right}) {
+        Input input;
+        if (const auto sampledAt = random.NextInput(which, &input)) {
+          checker.ObserveRawActions(which, input.mRawActions, *sampledAt);
+        }
+        StepAndKeepAlive(&checker, which, now, input);
+      }
+    }
+    Merge(&ret, checker.GetResults());
+  }
+  return ret;
+}
+
+Results CheckCapture(
+  const Config::Snapshot& config,
+  std::span<const SessionCapture::Frame> frames) {
+  Checker checker(Timings::FromConfig(config));
+  const HandTrackingGates gates(
+    HandTrackingGates::Parameters::FromConfig(config));
+  for (const auto& frame: frames) {
+    const Time now {frame.mFrameInfo.mNow};
+    for (std::size_t i = 0; i < frame.mHands.size(); ++i) {
+      const auto which = (i == 0) ? Hand::Left : Hand::Right;
+      const auto& observation = frame.mHands[i];
+      if (observation.mTracking == Tracking::Tracked) {
+        checker.ObserveRawActions(
+          which, observation.mRawActions, Time(observation.mRawActionsSince));
+      }
+      StepAndKeepAlive(
+        &checker,
+        which,
+        now,
+        gates.GetWakeInput(frame.mFrameInfo, observation));
+    }
+  }
+  return checker.GetResults();
+}
+
+std::chrono::duration<double, std::nano>
+Benchmark(const Timings& timings, uint32_t seed, std::size_t stepCount) {
+  struct Step {
+    Hand mHand {};
+    Time mNow {};
+    Input mInput {};
+  };
+  // Generated first, so that only the machine is timed
+  std::vector<Step> steps;
+  steps.reserve(stepCount);
+  RandomWalk random(seed);
+  while (steps.size() < stepCount) {
+    const auto now = random.NextFrame();
+    for (const auto which: {Hand::Left, Hand::Right}) {
+      Input input;
+      random.NextInput(which, &input);
+      steps.push_back({which, now, input});
+    }
+  }
+
+  HandWakeStateMachine machine(timings);
+  uint64_t activeCount {};
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& step: steps) {
+    const auto out = machine.Step(step.mHand, step.mNow, step.mInput);
+    activeCount += out.mActive;
+    if (out.mActive && out.mActions.Any()) {
+      machine.KeepAlive(step.mHand, step.mNow);
+    }
+  }
+  const std::chrono::duration<double, std::nano> elapsed
+    = std::chrono::steady_clock::now() - start;
+
+  // Otherwise the loop could be optimized away
+  if (activeCount > steps.size()) {
+    return {};
+  }
+  return elapsed / static_cast<double>(steps.size());
+}
+
+}// namespace HandTrackedCockpitClicking::WakeTraceCheck
@@ -0,0 +1,60 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "HandWakeStateMachine.h"
+#include "SessionCapture.h"
+
+/** Replays traces through `HandWakeStateMachine`, checking every step.
+ *
+ * The checks only use the inputs, not the machine's internals - for example,
+ * a hand can only wake once its wake conditions have held for the wake time,
+ * or its raw actions have been stable for the gesture time - so they catch
+ * mistakes in the transition table as well as in the code that runs it.
+ */
+namespace HandTrackedCockpitClicking::WakeTraceCheck {
+
+using Timings = HandWakeStateMachine::Timings;
+
+struct Results {
+  uint64_t mStepCount {};
+  // Indexed by `HandWakeStateMachine::Event`
+  std::array<uint64_t, 4> mEventCounts {};
+  uint64_t mFailureCount {};
+  // The first few failures
+  std::vector<std::string> mFailures;
+};
+
+/** Every pair of inputs, one after the other.
+ *
+ * Inputs are every combination of tracking state, FOVs, hibernate gesture,
+ * and one of each kind of raw action; each is held long enough for every
+ * timer to elapse.
+ */
+Results CheckInputPairs(const Timings&);
+
+// Random walks through the same inputs, with raw actions also changing
+// between frames, as they do with the input sampler
+Results CheckRandomWalks(
+  const Timings&,
+  uint32_t seed,
+  std::size_t walkCount,
+  std::size_t framesPerWalk);
+
+// A capture, replayed in the same way as `ReplaySession`
+Results CheckCapture(
+  const Config::Snapshot&,
+  std::span<const SessionCapture::Frame>);
+
+// Mean time for `HandWakeStateMachine::Step()`, over a random walk
+std::chrono::duration<double, std::nano>
+Benchmark(const Timings&, uint32_t seed, std::size_t stepCount);
+
+}// namespace HandTrackedCockpitClicking::WakeTraceCheck
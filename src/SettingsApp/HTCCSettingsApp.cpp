@@ -13,16 +13,21 @@
 
 #include <FredEmmott/GUI.hpp>
 #include <FredEmmott/GUI/StaticTheme/Common.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <format>
+#include <numbers>
 #include <optional>
+#include <span>
 #include <string_view>
+#include <vector>
 
 #include "../lib/Config.h"
 #include "../lib/PointCtrlSource.h"
 #include "CheckHResult.hpp"
 #include "Licenses.hpp"
 #include "OpenXRSettings.h"
+#include "TelemetryClient.h"
 #include "version.h"
 
 using namespace FredEmmott::GUI;
@@ -46,11 +51,14 @@ const auto VersionString = std::format(
   Version::BuildMode);
 
 static OpenXRSettings gOpenXRSettings;
+static TelemetryClient gTelemetry;
 
 void PointerSourceGUI() {
   constexpr auto Options = std::array {
     "OpenXR hand tracking",
     "PointCTRL",
+    "PointCTRL, corrected by OpenXR hand tracking",
+    "Eye tracking",
   };
   static auto idx = static_cast<std::size_t>(HTCC::Config::PointerSource);
   if (!ComboBox(&idx, Options).Caption("Hand tracking method")) {
@@ -236,7 +244,7 @@ static void UltraleapGUI() {
 static void OpenXRGUI() {
   const auto openxrLock = std::shared_lock(gOpenXRSettings);
   BeginEnabled(
-    HTCC::Config::PointerSource == HTCC::PointerSource::OpenXRHandTracking);
+    HTCC::Config::PointerSource != HTCC::PointerSource::PointCtrl);
 
   Label("OpenXR hand tracking").Subtitle();
 
@@ -336,7 +344,8 @@ static void PointCtrlButtonMappingGUI() {
 }
 
 static void PointCtrlGUI() {
-  BeginEnabled(HTCC::Config::PointerSource == HTCC::PointerSource::PointCtrl);
+  BeginEnabled(
+    HTCC::Config::PointerSource != HTCC::PointerSource::OpenXRHandTracking);
   Label("PointCTRL").Subtitle();
   BeginCard();
   BeginVStackPanel();
@@ -349,6 +358,121 @@ static void PointCtrlGUI() {
   EndEnabled();
 }
 
+// Scaled so that the largest value is a full bar
+static std::string Sparkline(std::span<const float> values) {
+  constexpr auto Bars = std::array {
+    "\u2581",
+    "\u2582",
+    "\u2583",
+    "\u2584",
+    "\u2585",
+    "\u2586",
+    "\u2587",
+    "\u2588",
+  };
+  const auto max = values.empty() ? 0.0f : std::ranges::max(values);
+  std::string ret;
+  for (const auto value: values) {
+    const auto index = (max > 0)
+      ? static_cast<std::size_t>((value / max) * (Bars.size() - 1))
+      : 0;
+    ret += Bars[index];
+  }
+  return ret;
+}
+
+/* One metric over the last few seconds.
+ *
+ * If `sparse`, zero means 'nothing happened' rather than a measurement, e.g.
+ * for latencies.
+ */
+static void DiagnosticRow(
+  const std::string_view label,
+  const std::span<const HTCC::TelemetryStats::Bucket> buckets,
+  float HTCC::TelemetryStats::Bucket::* member,
+  const float scale,
+  const std::string_view unit,
+  const bool sparse,
+  const ID id = ID {std::source_location::current()}) {
+  // 10 seconds
+  const auto recent = buckets.last(std::min<std::size_t>(buckets.size(), 40));
+  std::vector<float> values;
+  values.reserve(recent.size());
+  for (const auto& bucket: recent) {
+    values.push_back(bucket.*member * scale);
+  }
+
+  std::string summary {"-"};
+  const auto latest = sparse
+    ? std::ranges::find_if(values.rbegin(), values.rend(), std::identity {})
+    : values.rbegin();
+  if (latest != values.rend()) {
+    summary = std::format(
+      "{:.2f}{} (max {:.2f}{})",
+      *latest,
+      unit,
+      std::ranges::max(values),
+      unit);
+  }
+
+  const auto row = BeginHStackPanel(id).Scoped().Styled(Style().Gap(8));
+  Label(label).Styled(Style().Width(160));
+  Label(Sparkline(values)).Styled(Style().FlexGrow(1));
+  Label(summary);
+}
+
+static void DiagnosticsGUI() {
+  Label("Diagnostics").Subtitle();
+  BeginCard();
+  BeginVStackPanel();
+
+  if (ToggleSwitch(&HTCC::Config::EnableTelemetry)
+        .Caption("Share live diagnostics from games")) {
+    HTCC::Config::SaveEnableTelemetry();
+  }
+
+  const auto stats = gTelemetry.GetStats();
+  const auto buckets = stats.GetBuckets();
+  if (!(gTelemetry.IsActive() && !buckets.empty())) {
+    TextBlock(
+      HTCC::Config::EnableTelemetry
+        ? "Waiting for a game using HTCC..."
+        : "Turn this on to see latency and jitter while a game is running.");
+  } else {
+    using Bucket = HTCC::TelemetryStats::Bucket;
+    constexpr auto Degrees = 180 / std::numbers::pi_v<float>;
+    DiagnosticRow(
+      "Pointer jitter", buckets, &Bucket::mJitter, Degrees, "\u00b0", false);
+    DiagnosticRow(
+      "Tracking loss",
+      buckets,
+      &Bucket::mTrackingLossRate,
+      1,
+      "/s",
+      false);
+    DiagnosticRow(
+      "Wake latency", buckets, &Bucket::mWakeLatency, 1, "ms", true);
+    DiagnosticRow(
+      "Click latency", buckets, &Bucket::mClickLatency, 1, "ms", true);
+
+    const auto& last = buckets.back();
+    const auto names = stats.GetStageNames();
+    std::string stages;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      stages += std::format(
+        "{}{}: {:.1f}\u00b5s",
+        stages.empty() ? "" : "\n",
+        names[i],
+        last.mStageMicroseconds[i]);
+    }
+    Label("CPU time per frame").Body();
+    TextBlock(stages);
+  }
+
+  EndVStackPanel();
+  EndCard();
+}
+
 static void LicensesDialogContent() {
   static const HandTrackedCockpitClicking::Licenses licenses;
   struct Product {
@@ -443,6 +567,7 @@ static void FrameTick() {
   UnsupportedSettingsGUI();
   OpenXRGUI();
   PointCtrlGUI();
+  DiagnosticsGUI();
   AboutGUI();
 }
 
@@ -466,6 +591,8 @@ int WINAPI wWinMain(
             gWindowHandle = window.GetNativeHandle();
             gOpenXRSettings.OnReload(
               std::bind_front(&Window::InterruptWaitFrame, &window));
+            gTelemetry.OnUpdate(
+              std::bind_front(&Window::InterruptWaitFrame, &window));
         },
       },
     });
@@ -0,0 +1,98 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "TelemetryClient.h"
+
+#include <string>
+
+namespace Telemetry = HandTrackedCockpitClicking::Telemetry;
+
+namespace {
+// Fast enough to keep up with the ring; it holds a few seconds of frames
+constexpr std::chrono::milliseconds PollInterval {100};
+// How long without new frames before we assume the game has gone away
+constexpr std::chrono::seconds ActiveTimeout {2};
+}// namespace
+
+TelemetryClient::TelemetryClient() {
+  mThread = std::jthread {std::bind_front(&TelemetryClient::Run, this)};
+}
+
+TelemetryClient::~TelemetryClient() {
+  mThread.request_stop();
+  mThread.join();
+}
+
+bool TelemetryClient::IsActive() const {
+  const auto lock = std::unique_lock(mMutex);
+  return mIsActive;
+}
+
+TelemetryClient::TelemetryStats TelemetryClient::GetStats() const {
+  const auto lock = std::unique_lock(mMutex);
+  return mStats;
+}
+
+void TelemetryClient::Run(std::stop_token stopToken) {
+  SetThreadDescription(GetCurrentThread(), L"HTCC Telemetry Client");
+  while (!stopToken.stop_requested()) {
+    if (mBuffer || this->Attach()) {
+      this->Poll();
+    }
+    std::this_thread::sleep_for(PollInterval);
+  }
+}
+
+bool TelemetryClient::Attach() {
+  const std::wstring name {Telemetry::SharedMemoryName};
+  mMapping.reset(OpenFileMappingW(FILE_MAP_READ, FALSE, name.c_str()));
+  if (!mMapping) {
+    return false;
+  }
+  mBuffer.reset(static_cast<const Buffer*>(MapViewOfFile(
+    mMapping.get(), FILE_MAP_READ, 0, 0, sizeof(Buffer))));
+  if (!(mBuffer && Telemetry::Reader(mBuffer.get()).IsCompatible())) {
+    mBuffer.reset();
+    mMapping.reset();
+    return false;
+  }
+  mCursor = Telemetry::Reader(mBuffer.get()).GetNextFrame();
+  return true;
+}
+
+void TelemetryClient::Poll() {
+  const Telemetry::Reader reader(mBuffer.get());
+  const auto now = std::chrono::steady_clock::now();
+
+  bool notify = false;
+  {
+    const auto lock = std::unique_lock(mMutex);
+    const auto count = reader.ReadSince(
+      &mCursor, [this](const auto& record) { mStats.Add(record); });
+    if (count) {
+      mLastFrameAt = now;
+    }
+
+    const auto isActive = (now - mLastFrameAt) < ActiveTimeout;
+    if (isActive != mIsActive) {
+      mIsActive = isActive;
+      notify = true;
+      if (!isActive) {
+        mStats.Reset();
+      }
+    }
+
+    // No point redrawing more often than the stats change
+    if (count && now - mLastNotifyAt >= TelemetryStats::BucketDuration) {
+      notify = true;
+    }
+  }
+
+  if (!notify) {
+    return;
+  }
+  mLastNotifyAt = now;
+  const auto lock = std::unique_lock(mMutex);
+  for (auto&& onUpdate: mOnUpdate) {
+    onUpdate();
+  }
+}
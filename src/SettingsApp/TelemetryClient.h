@@ -0,0 +1,59 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <wil/resource.h>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../lib/Telemetry.h"
+#include "../lib/TelemetryStats.h"
+
+/** Reads telemetry published by a running game, if any.
+ *
+ * Polls the shared memory on a background thread, folding new records into a
+ * `TelemetryStats`; the UI only ever copies the summarized buckets.
+ */
+class TelemetryClient final {
+ public:
+  using TelemetryStats = HandTrackedCockpitClicking::TelemetryStats;
+
+  TelemetryClient();
+  ~TelemetryClient();
+
+  // True if a game has published a frame recently
+  bool IsActive() const;
+  TelemetryStats GetStats() const;
+
+  // Called on the background thread when the stats change
+  template <std::convertible_to<std::function<void()>> F>
+  void OnUpdate(F&& onUpdate) {
+    const auto lock = std::unique_lock(mMutex);
+    mOnUpdate.emplace_back(std::forward<F>(onUpdate));
+  }
+
+ private:
+  using Buffer = HandTrackedCockpitClicking::Telemetry::Buffer;
+
+  mutable std::mutex mMutex;
+  TelemetryStats mStats;
+  bool mIsActive {false};
+  std::vector<std::function<void()>> mOnUpdate;
+
+  // Only touched by mThread
+  wil::unique_handle mMapping;
+  wil::unique_mapview_ptr<const Buffer> mBuffer;
+  uint64_t mCursor {};
+  std::chrono::steady_clock::time_point mLastFrameAt {};
+  std::chrono::steady_clock::time_point mLastNotifyAt {};
+
+  std::jthread mThread;
+
+  void Run(std::stop_token);
+  bool Attach();
+  void Poll();
+};
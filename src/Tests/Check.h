@@ -0,0 +1,33 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the portable tests; these run without Windows or any
+// test framework.
+namespace HandTrackedCockpitClicking::Tests {
+
+inline int sFailureCount {};
+
+// The exit code for `main()`
+inline int Finish(const char* name) {
+  if (sFailureCount) {
+    std::fprintf(stderr, "%s: %d failures\n", name, sFailureCount);
+    return EXIT_FAILURE;
+  }
+  std::printf("%s: all tests passed\n", name);
+  return EXIT_SUCCESS;
+}
+
+}// namespace HandTrackedCockpitClicking::Tests
+
+#define CHECK(x) \
+  do { \
+    if (!(x)) { \
+      std::fprintf( \
+        stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+      ++::HandTrackedCockpitClicking::Tests::sFailureCount; \
+    } \
+  } while (false)
@@ -0,0 +1,261 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+
+// Checks that settings files round-trip, that invalid values are ignored,
+// and that app overrides take precedence; also times loading a full file.
+
+#include <chrono>
+#include <cstdio>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Check.h"
+#include "ConfigParser.h"
+
+using namespace HandTrackedCockpitClicking;
+
+namespace {
+
+constexpr std::string_view SubKey {
+  "SOFTWARE\\Fred Emmott\\HandTrackedCockpitClicking"};
+
+constexpr std::string_view AllNames[] {
+#define IT(native_type, name, defaultValue) #name,
+  HandTrackedCockpitClicking_DWORD_SETTINGS
+#undef IT
+#define IT(name, defaultValue) #name,
+    HandTrackedCockpitClicking_FLOAT_SETTINGS
+    HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+};
+
+// As `LoadSnapshotFromFile()`, without the file
+Config::Snapshot Load(
+  const std::string& contents,
+  std::string_view executableFileName = {},
+  std::vector<std::string>* invalid = nullptr) {
+  std::istringstream file(contents);
+  const auto values = Config::ReadConfigFile(file, executableFileName);
+  Config::Snapshot ret;
+  for (const auto raw: {&values.mBase, &values.mOverrides}) {
+    for (auto& name: Config::Overlay(&ret, *raw)) {
+      if (invalid) {
+        invalid->push_back(std::move(name));
+      }
+    }
+  }
+  return ret;
+}
+
+std::string Save(
+  const Config::Snapshot& snapshot,
+  std::string_view subKey = SubKey) {
+  std::ostringstream file;
+  Config::WriteConfigFile(file, snapshot, AllNames, subKey);
+  return file.str();
+}
+
+// The names of the settings that differ
+std::vector<std::string_view> Differences(
+  const Config::Snapshot& a,
+  const Config::Snapshot& b) {
+  std::vector<std::string_view> ret;
+  for (const auto name: AllNames) {
+    if (Config::Get(a, name) != Config::Get(b, name)) {
+      ret.push_back(name);
+    }
+  }
+  return ret;
+}
+
+void TestRoundTrip() {
+  // The defaults
+  CHECK(Differences(Load(Save({})), {}).empty());
+
+  Config::Snapshot changed;
+  changed.Enabled = true;
+  changed.PointerSource = PointerSource::Fusion;
+  changed.ScrollWheelDelayMilliseconds = 1234;
+  changed.PointCtrlSleepMilliseconds = 0xdeadbeef;
+  changed.SmoothingFactor = 0.1f;
+  changed.VRVerticalOffset = -1.0e-7f;
+  changed.HandTrackingWakeVFOV = std::numbers::pi_v<float> / 7;
+  changed.HotspotFile = R"(C:\Users\"quoted"\hotspots.json)";
+  changed.HandTrackingCaptureFile = "spaces and ; semicolons";
+  CHECK(!Differences(changed, {}).empty());
+  CHECK(Differences(Load(Save(changed)), changed).empty());
+
+  // Floats aren't rounded
+  CHECK(
+    Load(Save(changed)).HandTrackingWakeVFOV == changed.HandTrackingWakeVFOV);
+
+  // Set() and Get() round-trip too
+  Config::Snapshot set;
+  for (const auto name: AllNames) {
+    CHECK(Config::Set(&set, name, *Config::Get(changed, name)));
+  }
+  CHECK(Differences(set, changed).empty());
+  CHECK(Config::Set(&set, "PointCtrlCenterX", "0x10"));
+  CHECK(set.PointCtrlCenterX == 16);
+  CHECK(!Config::Set(&set, "NoSuchSetting", "1"));
+  CHECK(!Config::Get(set, "NoSuchSetting"));
+}
+
+void TestInvalidValues() {
+  std::vector<std::string> invalid;
+  const auto loaded = Load(
+    R"(Windows Registry Editor Version 5.00
+
+[HKEY_LOCAL_MACHINE\SOFTWARE\Fred Emmott\HandTrackedCockpitClicking]
+"SmoothingFactor"="not a number"
+"VRFarDistance"="1.5m"
+"ProjectionDistance"=dword:00000001
+"HotspotSnapAngle"=""
+"HandTrackingPinchReleaseRatio"="2.5"
+"ScrollWheelDelayMilliseconds"=dword:zz
+"ScrollWheelIntervalMilliseconds"="100"
+"HotspotFile"=dword:00000001
+"Enabled"=dword:00000001
+"HandTrackingCaptureFile"="unterminated
+)",
+    {},
+    &invalid);
+
+  // Invalid floats are ignored and reported, not treated as 0
+  const Config::Snapshot defaults;
+  CHECK(loaded.SmoothingFactor == defaults.SmoothingFactor);
+  CHECK(loaded.VRFarDistance == defaults.VRFarDistance);
+  CHECK(loaded.ProjectionDistance == defaults.ProjectionDistance);
+  CHECK(loaded.HotspotSnapAngle == defaults.HotspotSnapAngle);
+  CHECK(
+    (invalid
+     == std::vector<std::string> {
+       "ProjectionDistance",
+       "VRFarDistance",
+       "SmoothingFactor",
+       "HotspotSnapAngle",
+     }));
+  // ... without affecting valid values
+  CHECK(loaded.HandTrackingPinchReleaseRatio == 2.5f);
+  CHECK(loaded.Enabled);
+
+  // Other types are ignored
+  CHECK(
+    loaded.ScrollWheelDelayMilliseconds
+    == defaults.ScrollWheelDelayMilliseconds);
+  CHECK(
+    loaded.ScrollWheelIntervalMilliseconds
+    == defaults.ScrollWheelIntervalMilliseconds);
+  CHECK(loaded.HotspotFile == defaults.HotspotFile);
+  CHECK(loaded.HandTrackingCaptureFile == defaults.HandTrackingCaptureFile);
+
+  Config::Snapshot set;
+  CHECK(!Config::Set(&set, "SmoothingFactor", "0.5x"));
+  CHECK(!Config::Set(&set, "SmoothingFactor", ""));
+  CHECK(!Config::Set(&set, "PointCtrlCenterX", "-1"));
+  CHECK(!Config::Set(&set, "PointCtrlCenterX", "0x"));
+  CHECK(Differences(set, defaults).empty());
+}
+
+std::string Section(std::string_view executable = {}) {
+  if (executable.empty()) {
+    return "\n[HKEY_LOCAL_MACHINE\\" + std::string {SubKey} + "]\n";
+  }
+  return "\n[HKEY_LOCAL_MACHINE\\" + std::string {SubKey}
+    + "\\AppOverrides\\" + std::string {executable} + "]\n";
+}
+
+void TestAppOverrides() {
+  const auto file = "Windows Registry Editor Version 5.00\n" + Section()
+    + "\"PointerSource\"=dword:00000001\n"
+      "\"SmoothingFactor\"=\"0.5\"\n"
+    + Section("DCS.exe")
+    + "\"PointerSource\"=dword:00000002\n"
+      "\"HotspotFile\"=\"dcs.json\"\n"
+    + Section("FlightSimulator.exe")
+    + "\"PointerSource\"=dword:00000003\n"
+      "\"SmoothingFactor\"=\"0.25\"\n"
+    + Section()
+    + "\"Enabled\"=dword:00000001\n"
+      "\"HotspotFile\"=\"base.json\"\n";
+
+  // Only the base settings
+  {
+    const auto loaded = Load(file);
+    CHECK(loaded.PointerSource == PointerSource::PointCtrl);
+    CHECK(loaded.SmoothingFactor == 0.5f);
+    CHECK(loaded.Enabled);
+    CHECK(loaded.HotspotFile == "base.json");
+  }
+
+  // Overrides win, even over base settings later in the file; executable
+  // names aren't case-sensitive
+  for (const auto executable: {"DCS.exe", "dcs.EXE"}) {
+    const auto loaded = Load(file, executable);
+    CHECK(loaded.PointerSource == PointerSource::Fusion);
+    CHECK(loaded.SmoothingFactor == 0.5f);
+    CHECK(loaded.Enabled);
+    CHECK(loaded.HotspotFile == "dcs.json");
+  }
+
+  {
+    const auto loaded = Load(file, "FlightSimulator.exe");
+    CHECK(loaded.PointerSource == PointerSource::EyeGaze);
+    CHECK(loaded.SmoothingFactor == 0.25f);
+    CHECK(loaded.HotspotFile == "base.json");
+  }
+
+  CHECK(Load(file, "Other.exe").PointerSource == PointerSource::PointCtrl);
+
+  // Saved overrides only apply to their executable
+  Config::Snapshot changed;
+  changed.PointerSource = PointerSource::Fusion;
+  const auto overrides
+    = Save(changed, std::string {SubKey} + "\\AppOverrides\\DCS.exe");
+  CHECK(Load(overrides, "DCS.exe").PointerSource == PointerSource::Fusion);
+  CHECK(Load(overrides).PointerSource == Config::Defaults::PointerSource);
+}
+
+// Loading happens in every process the layer is loaded into, so it must stay
+// cheap
+void TestLoadTime() {
+  Config::Snapshot snapshot;
+  snapshot.HotspotFile = "hotspots.json";
+  const auto file = Save(snapshot)
+    + Save(snapshot, std::string {SubKey} + "\\AppOverrides\\DCS.exe")
+    + Save(snapshot, std::string {SubKey} + "\\AppOverrides\\Other.exe");
+
+  constexpr std::size_t Iterations = 1000;
+  const auto start = std::chrono::steady_clock::now();
+  std::size_t loadedCount {};
+  for (std::size_t i = 0; i < Iterations; ++i) {
+    if (Load(file, "DCS.exe").HotspotFile == snapshot.HotspotFile) {
+      ++loadedCount;
+    }
+  }
+  const std::chrono::duration<double, std::micro> elapsed
+    = std::chrono::steady_clock::now() - start;
+  const auto perLoad = elapsed / Iterations;
+
+  std::printf(
+    "Loaded %zu settings in %gus\n",
+    std::size(AllNames) * 2,
+    perLoad.count());
+  CHECK(loadedCount == Iterations);
+  // Generous, for unoptimized builds
+  CHECK(perLoad < std::chrono::milliseconds(5));
+}
+
+}// namespace
+
+int main() {
+  TestRoundTrip();
+  TestInvalidValues();
+  TestAppOverrides();
+  TestLoadTime();
+
+  return Tests::Finish("Config");
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+
+// Checks that `FeedbackQueue` plays feedback in order, coalesces stale
+// feedback for each hand separately, and shuts down cleanly.
+
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "FeedbackQueue.h"
+
+using namespace HandTrackedCockpitClicking;
+
+namespace {
+
+using Event = FeedbackEvent;
+using Hand = HandWakeStateMachine::Hand;
+
+constexpr Feedback LeftWake {Event::Wake, Hand::Left};
+constexpr Feedback LeftSleep {Event::Sleep, Hand::Left};
+constexpr Feedback RightWake {Event::Wake, Hand::Right};
+constexpr Feedback RightSleep {Event::Sleep, Hand::Right};
+constexpr Feedback HibernateWake {Event::HibernateWake, std::nullopt};
+constexpr Feedback HibernateSleep {Event::HibernateSleep, std::nullopt};
+
+// Waits for the consumer thread to play `count` items
+std::vector<Feedback> WaitForFeedback(
+  RecordingFeedbackOutput* output,
+  std::size_t count) {
+  std::vector<Feedback> ret;
+  const auto until
+    = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (ret.size() < count && std::chrono::steady_clock::now() < until) {
+    for (const auto& it: output->TakeFeedback()) {
+      ret.push_back(it);
+    }
+    std::this_thread::yield();
+  }
+  return ret;
+}
+
+// One at a time, nothing is coalesced
+void TestOrdering() {
+  FeedbackQueue queue;
+  for (const auto& feedback:
+       {LeftWake, RightWake, HibernateSleep, HibernateWake, LeftSleep}) {
+    CHECK(queue.Push(feedback));
+    CHECK(queue.Take() == std::vector {feedback});
+  }
+
+  // Different hands and hibernation are all kept, in queue order
+  CHECK(queue.Push(RightWake));
+  CHECK(queue.Push(HibernateWake));
+  CHECK(queue.Push(LeftWake));
+  CHECK((queue.Take() == std::vector {RightWake, HibernateWake, LeftWake}));
+}
+
+void TestCoalescing() {
+  FeedbackQueue queue;
+
+  // Only the latest for the same hand
+  CHECK(queue.Push(LeftWake));
+  CHECK(queue.Push(LeftSleep));
+  CHECK(queue.Take() == std::vector {LeftSleep});
+
+  // ... but the other hand's cue isn't lost
+  CHECK(queue.Push(LeftWake));
+  CHECK(queue.Push(RightWake));
+  CHECK(queue.Push(LeftSleep));
+  CHECK((queue.Take() == std::vector {RightWake, LeftSleep}));
+
+  CHECK(queue.Push(RightSleep));
+  CHECK(queue.Push(LeftWake));
+  CHECK(queue.Push(RightWake));
+  CHECK(queue.Push(HibernateSleep));
+  CHECK(queue.Push(HibernateWake));
+  CHECK((queue.Take() == std::vector {LeftWake, RightWake, HibernateWake}));
+
+  // Full; the rest are dropped, not blocked on
+  for (std::size_t i = 0; i < 16; ++i) {
+    CHECK(queue.Push((i % 2) ? RightWake : RightSleep));
+  }
+  CHECK(!queue.Push(LeftWake));
+  CHECK(queue.Take() == std::vector {RightWake});
+  CHECK(queue.Push(LeftWake));
+  CHECK(queue.Take() == std::vector {LeftWake});
+}
+
+void TestConsumerThread() {
+  FeedbackQueue queue;
+  RecordingFeedbackOutput output;
+  std::jthread consumer {[&]() { queue.Run(&output); }};
+
+  CHECK(queue.Push(LeftWake));
+  CHECK(WaitForFeedback(&output, 1) == std::vector {LeftWake});
+  CHECK(queue.Push(RightWake));
+  CHECK(WaitForFeedback(&output, 1) == std::vector {RightWake});
+
+  queue.Close();
+  consumer.join();
+  CHECK(!queue.Push(LeftSleep));
+  CHECK(output.TakeFeedback().empty());
+}
+
+// Closing wakes a consumer that's waiting, and drops anything still queued
+void TestShutdown() {
+  {
+    FeedbackQueue queue;
+    RecordingFeedbackOutput output;
+    std::jthread consumer {[&]() { queue.Run(&output); }};
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto start = std::chrono::steady_clock::now();
+    queue.Close();
+    consumer.join();
+    const std::chrono::duration<double, std::milli> elapsed
+      = std::chrono::steady_clock::now() - start;
+    std::printf("Idle consumer stopped in %gms\n", elapsed.count());
+    CHECK(elapsed < std::chrono::seconds(1));
+    CHECK(output.TakeFeedback().empty());
+  }
+
+  {
+    FeedbackQueue queue;
+    CHECK(queue.Push(LeftWake));
+    queue.Close();
+    CHECK(queue.Take().empty());
+    CHECK(queue.Take().empty());
+  }
+}
+
+}// namespace
+
+int main() {
+  TestOrdering();
+  TestCoalescing();
+  TestConsumerThread();
+  TestShutdown();
+
+  return Tests::Finish("FeedbackQueue");
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+
+// Feeds synthetic gaze into `GazeDwellFilter`: fixations, saccades, glances
+// shorter than the dwell time, and blinks.
+
+#include <chrono>
+#include <cmath>
+#include <optional>
+
+#include "Check.h"
+#include "Config.h"
+#include "GazeDwellFilter.h"
+
+using namespace HandTrackedCockpitClicking;
+using namespace std::chrono_literals;
+
+// `Parameters::FromConfig()` reads the globals, which are in Config.cpp; that
+// isn't portable, and isn't needed here
+Config::Snapshot Config::Current() {
+  return {};
+}
+
+namespace {
+
+constexpr GazeDwellFilter::Parameters Parameters {
+  .mRadius = 0.05f,
+  .mDwell = 200ms,
+};
+// About 100Hz, so that the dwell time is a whole number of samples
+constexpr auto SampleInterval = 10ms;
+
+constexpr XrVector2f A {0.1f, 0.2f};
+constexpr XrVector2f B {-0.3f, 0.1f};
+constexpr XrVector2f C {0.4f, -0.2f};
+
+bool IsNear(const std::optional<XrVector2f>& actual, const XrVector2f& at) {
+  return actual && std::hypot(actual->x - at.x, actual->y - at.y) < 0.01f;
+}
+
+class Eye final {
+ public:
+  // A sample every `SampleInterval`, wobbling within the dwell radius
+  std::optional<XrVector2f> Look(const XrVector2f& at) {
+    const auto wobble = ((mSampleCount++ % 2) ? 1 : -1) * 0.015f;
+    return this->Update(XrVector2f {at.x + wobble, at.y - wobble});
+  }
+
+  std::optional<XrVector2f> Blink() {
+    return this->Update(std::nullopt);
+  }
+
+  // Looks at `at` for `duration`, returning the last result
+  std::optional<XrVector2f> Look(
+    const XrVector2f& at,
+    std::chrono::milliseconds duration) {
+    std::optional<XrVector2f> ret;
+    for (auto it = 0ms; it < duration; it += SampleInterval) {
+      ret = this->Look(at);
+    }
+    return ret;
+  }
+
+  std::optional<XrVector2f> Blink(std::chrono::milliseconds duration) {
+    std::optional<XrVector2f> ret;
+    for (auto it = 0ms; it < duration; it += SampleInterval) {
+      ret = this->Blink();
+    }
+    return ret;
+  }
+
+  void Reset() {
+    mFilter.Reset();
+  }
+
+ private:
+  GazeDwellFilter mFilter {Parameters};
+  GazeDwellFilter::Time mNow {1s};
+  uint32_t mSampleCount {};
+
+  std::optional<XrVector2f> Update(const std::optional<XrVector2f>& gaze) {
+    const auto ret = mFilter.Update(mNow, gaze);
+    mNow += SampleInterval;
+    return ret;
+  }
+};
+
+// The fixation only moves once the gaze has been on the new point for the
+// dwell time
+void TestFixationsAndSaccades() {
+  Eye eye;
+
+  // Nothing until the first fixation
+  CHECK(!eye.Look(A, Parameters.mDwell));
+  CHECK(IsNear(eye.Look(A), A));
+  CHECK(IsNear(eye.Look(A, 500ms), A));
+
+  // Saccade to B
+  CHECK(IsNear(eye.Look(B, Parameters.mDwell), A));
+  CHECK(IsNear(eye.Look(B), B));
+  CHECK(IsNear(eye.Look(B, 500ms), B));
+
+  // ... and back
+  CHECK(IsNear(eye.Look(A, Parameters.mDwell), B));
+  CHECK(IsNear(eye.Look(A), A));
+
+  eye.Reset();
+  CHECK(!eye.Look(A));
+}
+
+// Glances shorter than the dwell time leave the fixation in place
+void TestShortGlances() {
+  Eye eye;
+  eye.Look(A, 500ms);
+  CHECK(IsNear(eye.Look(A), A));
+
+  for (const auto duration: {10ms, 100ms, Parameters.mDwell - 10ms}) {
+    CHECK(IsNear(eye.Look(B, duration), A));
+    CHECK(IsNear(eye.Look(A), A));
+  }
+
+  // Several short glances in a row, each to a different point
+  for (auto i = 0; i < 10; ++i) {
+    CHECK(IsNear(eye.Look(B, 150ms), A));
+    CHECK(IsNear(eye.Look(C, 150ms), A));
+  }
+  CHECK(IsNear(eye.Look(A, 100ms), A));
+
+  // Glances don't add up: returning to the fixation restarts the dwell
+  CHECK(IsNear(eye.Look(B, 150ms), A));
+  CHECK(IsNear(eye.Look(A, 10ms), A));
+  CHECK(IsNear(eye.Look(B, 150ms), A));
+  CHECK(IsNear(eye.Look(A), A));
+}
+
+// Blinks keep the previous fixation, however long they last
+void TestBlinks() {
+  Eye eye;
+  CHECK(!eye.Blink(500ms));
+  CHECK(!eye.Look(A, 100ms));
+  CHECK(!eye.Blink(500ms));
+
+  eye.Look(A, 500ms);
+  CHECK(IsNear(eye.Blink(), A));
+  CHECK(IsNear(eye.Blink(1s), A));
+  CHECK(IsNear(eye.Look(A), A));
+
+  // A blink in the middle of a glance
+  CHECK(IsNear(eye.Look(B, 50ms), A));
+  CHECK(IsNear(eye.Blink(50ms), A));
+  CHECK(IsNear(eye.Look(A, 10ms), A));
+
+  // A blink during a saccade doesn't stop the fixation moving
+  CHECK(IsNear(eye.Look(B, 100ms), A));
+  CHECK(IsNear(eye.Blink(50ms), A));
+  CHECK(IsNear(eye.Look(B, 500ms), B));
+}
+
+}// namespace
+
+int main() {
+  TestFixationsAndSaccades();
+  TestShortGlances();
+  TestBlinks();
+
+  return Tests::Finish("GazeDwellFilter");
+}
@@ -0,0 +1,258 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+
+// Fits `PointCtrlDistortionModel` to synthetic sensors with known
+// distortion, and checks the fits, serialization, and lookup tables.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "PointCtrlDistortionModel.h"
+
+using namespace HandTrackedCockpitClicking;
+
+namespace {
+
+using Sample = PointCtrlDistortionModel::Sample;
+using Sensor = std::function<XrVector2f(const XrVector2f& direction)>;
+
+// Near the middle of the sensor's range, with the y axis flipped and a
+// little cross-talk, like the real thing
+XrVector2f LinearSensor(const XrVector2f& direction) {
+  return {
+    32000 + (direction.y * 9000) + (direction.x * 300),
+    33000 - (direction.x * 9000),
+  };
+}
+
+// Compressed toward the edges
+XrVector2f DistortedSensor(const XrVector2f& direction) {
+  return {
+    32000 + (std::sin(direction.y * 1.5f) * 20000) + (direction.x * 300),
+    33000 - (std::sin(direction.x * 1.5f) * 20000),
+  };
+}
+
+std::vector<Sample> MakeSamples(
+  const Sensor& sensor,
+  size_t count,
+  float noise = 0,
+  uint32_t seed = 1) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> distribution(0, noise);
+  std::vector<Sample> ret;
+  for (const auto& target: PointCtrlDistortionModel::GetTargets(count)) {
+    auto raw = sensor(target);
+    if (noise > 0) {
+      raw.x += distribution(rng);
+      raw.y += distribution(rng);
+    }
+    ret.push_back({raw, target});
+  }
+  return ret;
+}
+
+float Distance(const XrVector2f& a, const XrVector2f& b) {
+  return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+// Largest error over a grid of directions, in radians
+float GetMaxError(
+  const PointCtrlDistortionModel& model,
+  const Sensor& sensor,
+  float range) {
+  float ret {};
+  for (float x = -range; x <= range; x += range / 10) {
+    for (float y = -range; y <= range; y += range / 10) {
+      const XrVector2f direction {x, y};
+      ret = std::max(
+        ret, Distance(model.Evaluate(sensor(direction)), direction));
+    }
+  }
+  return ret;
+}
+
+void TestTargets() {
+  CHECK(PointCtrlDistortionModel::GetTargets(5).size() == 5);
+  CHECK(PointCtrlDistortionModel::GetTargets(9).size() == 9);
+  CHECK(PointCtrlDistortionModel::GetTargets(7).empty());
+
+  const auto targets = PointCtrlDistortionModel::GetTargets(9);
+  CHECK(targets[0].x == 0 && targets[0].y == 0);
+}
+
+// Without distortion, both models are exact
+void TestLinear() {
+  for (const auto count: {5, 9}) {
+    const auto samples = MakeSamples(LinearSensor, count);
+    const auto model = PointCtrlDistortionModel::Fit(samples);
+    CHECK(model);
+    if (!model) {
+      continue;
+    }
+    CHECK(model->GetRMSError(samples) < 1e-5f);
+    // Including outside of the calibrated area
+    CHECK(GetMaxError(*model, LinearSensor, 0.6f) < 1e-4f);
+  }
+}
+
+// The cubic model is needed toward the edges of the sensor
+void TestDistorted() {
+  const auto affine
+    = PointCtrlDistortionModel::Fit(MakeSamples(DistortedSensor, 5));
+  const auto cubic
+    = PointCtrlDistortionModel::Fit(MakeSamples(DistortedSensor, 9));
+  CHECK(affine && cubic);
+  if (!(affine && cubic)) {
+    return;
+  }
+
+  // The targets are at up to 20 degrees
+  const auto range = 0.35f;
+  const auto affineError = GetMaxError(*affine, DistortedSensor, range);
+  const auto cubicError = GetMaxError(*cubic, DistortedSensor, range);
+  std::printf(
+    "Max error within calibrated area: affine %g, cubic %g radians\n",
+    affineError,
+    cubicError);
+  CHECK(cubicError < 0.01f);
+  CHECK(cubicError * 2 < affineError);
+}
+
+void TestNoise() {
+  for (const auto count: {5, 9}) {
+    for (uint32_t seed = 1; seed <= 10; ++seed) {
+      const auto samples = MakeSamples(DistortedSensor, count, 20, seed);
+      const auto model = PointCtrlDistortionModel::Fit(samples);
+      CHECK(model);
+      if (!model) {
+        continue;
+      }
+      CHECK(model->GetRMSError(samples) < 0.01f);
+      CHECK(GetMaxError(*model, DistortedSensor, 0.35f) < 0.05f);
+    }
+  }
+}
+
+// Beyond the calibrated area, the cubic terms don't run away
+void TestExtrapolation() {
+  const auto model
+    = PointCtrlDistortionModel::Fit(MakeSamples(DistortedSensor, 9));
+  CHECK(model);
+  if (!model) {
+    return;
+  }
+
+  float previous {};
+  for (float y = 0.4f; y <= 1.0f; y += 0.1f) {
+    const auto direction = model->Evaluate(DistortedSensor({0, y}));
+    CHECK(std::abs(direction.x) < 0.05f);
+    // Monotonic, and no further off than the sensor's own compression
+    CHECK(direction.y > previous);
+    CHECK(direction.y > 0.5f * y && direction.y < 1.5f * y);
+    previous = direction.y;
+  }
+}
+
+void TestDegenerate() {
+  CHECK(!PointCtrlDistortionModel::Fit({}));
+
+  const auto samples = MakeSamples(LinearSensor, 9);
+  CHECK(!PointCtrlDistortionModel::Fit({samples.data(), 2}));
+
+  // Every target at the same raw position
+  auto stuck = samples;
+  for (auto& sample: stuck) {
+    sample.mRaw = {32000, 33000};
+  }
+  CHECK(!PointCtrlDistortionModel::Fit(stuck));
+
+  // Only one axis moves
+  auto line = samples;
+  for (auto& sample: line) {
+    sample.mRaw.y = 33000;
+  }
+  CHECK(!PointCtrlDistortionModel::Fit(line));
+}
+
+void TestSerialization() {
+  for (const auto count: {5, 9}) {
+    const auto model
+      = PointCtrlDistortionModel::Fit(MakeSamples(DistortedSensor, count));
+    CHECK(model);
+    if (!model) {
+      continue;
+    }
+    const auto text = model->Serialize();
+    const auto parsed = PointCtrlDistortionModel::Parse(text);
+    CHECK(parsed);
+    if (!parsed) {
+      continue;
+    }
+    CHECK(parsed->Serialize() == text);
+    for (float x = -0.6f; x <= 0.6f; x += 0.1f) {
+      const auto raw = DistortedSensor({x, -x});
+      CHECK(Distance(model->Evaluate(raw), parsed->Evaluate(raw)) < 1e-6f);
+    }
+  }
+
+  CHECK(!PointCtrlDistortionModel::Parse(""));
+  CHECK(!PointCtrlDistortionModel::Parse("x"));
+  CHECK(!PointCtrlDistortionModel::Parse("3 1 2"));
+  // Wrong number of coefficients for the term count
+  CHECK(!PointCtrlDistortionModel::Parse("3 0 0 1 -1 -1 1 1 0 1 0 0 0"));
+  CHECK(PointCtrlDistortionModel::Parse("3 0 0 1 -1 -1 1 1 0 1 0 0 0 1"));
+  // Unsupported term count
+  CHECK(!PointCtrlDistortionModel::Parse("2 0 0 1 -1 -1 1 1 0 1 0 0"));
+  // Zero scale, and an empty covered area
+  CHECK(!PointCtrlDistortionModel::Parse("3 0 0 0 -1 -1 1 1 0 1 0 0 0 1"));
+  CHECK(!PointCtrlDistortionModel::Parse("3 0 0 1 1 -1 -1 1 0 1 0 0 0 1"));
+  CHECK(!PointCtrlDistortionModel::Parse("3 0 0 1 -1 -1 1 1 0 1 0 0 0 nan"));
+}
+
+void TestLookupTable() {
+  for (const auto count: {5, 9}) {
+    const auto model
+      = PointCtrlDistortionModel::Fit(MakeSamples(DistortedSensor, count));
+    CHECK(model);
+    if (!model) {
+      continue;
+    }
+    const PointCtrlLookupTable table(*model);
+
+    float maxError {};
+    for (uint32_t y = 0; y <= UINT16_MAX; y += 257) {
+      for (uint32_t x = 0; x <= UINT16_MAX; x += 257) {
+        const auto fromTable = table.Evaluate(
+          static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+        const auto fromModel = model->Evaluate(
+          {static_cast<float>(x), static_cast<float>(y)});
+        maxError = std::max(maxError, Distance(fromTable, fromModel));
+      }
+    }
+    std::printf(
+      "Max lookup table error, %d samples: %g radians\n", count, maxError);
+    // About 0.1 degrees; much less than the sensor's noise
+    CHECK(maxError < 2e-3f);
+  }
+}
+
+}// namespace
+
+int main() {
+  TestTargets();
+  TestLinear();
+  TestDistorted();
+  TestNoise();
+  TestExtrapolation();
+  TestDegenerate();
+  TestSerialization();
+  TestLookupTable();
+
+  return Tests::Finish("PointCtrlDistortionModel");
+}
@@ -0,0 +1,283 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+
+// Checks the portable reader and writer in `Telemetry.h`, including readers
+// racing a writer on other threads.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "Telemetry.h"
+
+using namespace HandTrackedCockpitClicking;
+
+namespace {
+
+// Zero-filled, like fresh shared memory
+std::unique_ptr<Telemetry::Buffer> MakeBuffer() {
+  auto ret = std::make_unique<Telemetry::Buffer>();
+  std::memset(static_cast<void*>(ret.get()), 0, sizeof(Telemetry::Buffer));
+  return ret;
+}
+
+// Every field is derived from `frame`, so that torn reads are detectable
+Telemetry::FrameRecord MakeRecord(uint64_t frame) {
+  Telemetry::FrameRecord ret {
+    .mNow = static_cast<int64_t>(frame * 3),
+    .mPredictedDisplayTime = static_cast<int64_t>(frame * 5),
+    .mHibernating = static_cast<uint8_t>(frame % 2),
+    .mStageCount = static_cast<uint8_t>(frame % Telemetry::MaxStages),
+  };
+  for (auto& hand: ret.mRaw) {
+    hand.mPositionUpdatedAt = static_cast<int64_t>(frame);
+    hand.mPosition.fill(static_cast<float>(frame % 1000));
+  }
+  for (auto& hand: ret.mFinal) {
+    hand.mPositionUpdatedAt = static_cast<int64_t>(frame * 7);
+  }
+  for (auto& stage: ret.mStages) {
+    stage.mNanoseconds = static_cast<uint32_t>(frame);
+  }
+  return ret;
+}
+
+bool IsConsistent(const Telemetry::FrameRecord& record) {
+  const auto expected = MakeRecord(record.mFrame);
+  // Field by field, as padding isn't copied reliably
+  const auto handsMatch = [](const auto& a, const auto& b) {
+    return std::ranges::equal(a, b, [](const auto& x, const auto& y) {
+      return x.mPositionUpdatedAt == y.mPositionUpdatedAt
+        && x.mPosition == y.mPosition;
+    });
+  };
+  return record.mNow == expected.mNow
+    && record.mPredictedDisplayTime == expected.mPredictedDisplayTime
+    && record.mHibernating == expected.mHibernating
+    && record.mStageCount == expected.mStageCount
+    && handsMatch(record.mRaw, expected.mRaw)
+    && handsMatch(record.mFinal, expected.mFinal)
+    && std::ranges::equal(
+      record.mStages, expected.mStages, [](const auto& x, const auto& y) {
+        return x.mNanoseconds == y.mNanoseconds;
+      });
+}
+
+void TestEmpty() {
+  const auto buffer = MakeBuffer();
+  const Telemetry::Reader reader(buffer.get());
+  CHECK(!reader.IsCompatible());
+  CHECK(reader.GetNextFrame() == 0);
+  CHECK(!reader.Read(0));
+
+  Telemetry::Initialize(buffer.get());
+  CHECK(reader.IsCompatible());
+  CHECK(!reader.Read(0));
+
+  uint64_t cursor {};
+  CHECK(reader.ReadSince(&cursor, [](const auto&) {}) == 0);
+  CHECK(cursor == 0);
+}
+
+void TestReadWrite() {
+  const auto buffer = MakeBuffer();
+  Telemetry::Initialize(buffer.get());
+  const Telemetry::Reader reader(buffer.get());
+
+  for (uint64_t i = 0; i < 10; ++i) {
+    Telemetry::Write(buffer.get(), MakeRecord(i));
+  }
+  CHECK(reader.GetNextFrame() == 10);
+  const auto record = reader.Read(3);
+  CHECK(record && record->mFrame == 3 && IsConsistent(*record));
+  CHECK(!reader.Read(10));
+
+  uint64_t cursor {};
+  std::vector<uint64_t> frames;
+  CHECK(
+    reader.ReadSince(
+      &cursor, [&](const auto& record) { frames.push_back(record.mFrame); })
+    == 10);
+  CHECK(cursor == 10);
+  CHECK(frames.size() == 10 && frames.front() == 0 && frames.back() == 9);
+  CHECK(reader.ReadSince(&cursor, [](const auto&) {}) == 0);
+}
+
+void TestOverwritten() {
+  const auto buffer = MakeBuffer();
+  Telemetry::Initialize(buffer.get());
+  const Telemetry::Reader reader(buffer.get());
+
+  constexpr auto FrameCount = (Telemetry::Capacity * 2) + 10;
+  for (uint64_t i = 0; i < FrameCount; ++i) {
+    Telemetry::Write(buffer.get(), MakeRecord(i));
+  }
+  CHECK(!reader.Read(0));
+  CHECK(!reader.Read(FrameCount - Telemetry::Capacity - 1));
+  CHECK(reader.Read(FrameCount - Telemetry::Capacity));
+  CHECK(reader.Read(FrameCount - 1));
+
+  // A reader that fell behind skips to the oldest record that's still there
+  uint64_t cursor {};
+  uint64_t first {UINT64_MAX};
+  CHECK(
+    reader.ReadSince(
+      &cursor,
+      [&](const auto& record) { first = std::min(first, record.mFrame); })
+    == Telemetry::Capacity);
+  CHECK(first == FrameCount - Telemetry::Capacity);
+  CHECK(cursor == FrameCount);
+
+  // A cursor from before the writer restarted
+  cursor = FrameCount * 2;
+  CHECK(reader.ReadSince(&cursor, [](const auto&) {}) == Telemetry::Capacity);
+  CHECK(cursor == FrameCount);
+}
+
+void TestWriterOwnership() {
+  const auto buffer = MakeBuffer();
+  const auto a = Telemetry::MakeWriterID(123, 1);
+  const auto b = Telemetry::MakeWriterID(123, 2);
+  const auto c = Telemetry::MakeWriterID(456, 1);
+  CHECK(Telemetry::GetWriterProcessID(c) == 456);
+
+  CHECK(Telemetry::GetWriter(buffer.get()) == 0);
+  CHECK(Telemetry::TryAcquireWriter(buffer.get(), a));
+  CHECK(Telemetry::GetWriter(buffer.get()) == a);
+  CHECK(!Telemetry::TryAcquireWriter(buffer.get(), b));
+  CHECK(!Telemetry::TryAcquireWriter(buffer.get(), c));
+
+  // Only the current writer can release
+  Telemetry::ReleaseWriter(buffer.get(), b);
+  CHECK(Telemetry::GetWriter(buffer.get()) == a);
+  Telemetry::ReleaseWriter(buffer.get(), a);
+  CHECK(Telemetry::GetWriter(buffer.get()) == 0);
+
+  // Taking over from a writer that went away
+  CHECK(Telemetry::TryAcquireWriter(buffer.get(), b));
+  CHECK(!Telemetry::TryAcquireWriter(buffer.get(), c, a));
+  CHECK(Telemetry::TryAcquireWriter(buffer.get(), c, b));
+  CHECK(Telemetry::GetWriter(buffer.get()) == c);
+
+  // Initializing doesn't release it
+  Telemetry::Initialize(buffer.get());
+  CHECK(Telemetry::GetWriter(buffer.get()) == c);
+}
+
+// Many writers race to acquire; exactly one wins at a time
+void TestConcurrentAcquire() {
+  const auto buffer = MakeBuffer();
+  std::atomic<uint32_t> holders {};
+  std::atomic<uint64_t> acquired {};
+  std::atomic<bool> overlapped {false};
+  {
+    std::vector<std::jthread> threads;
+    for (uint32_t i = 1; i <= 8; ++i) {
+      threads.emplace_back([&, i]() {
+        const auto id = Telemetry::MakeWriterID(1, i);
+        for (int attempt = 0; attempt < 20000; ++attempt) {
+          if (!Telemetry::TryAcquireWriter(buffer.get(), id)) {
+            continue;
+          }
+          if (holders.fetch_add(1) != 0) {
+            overlapped = true;
+          }
+          ++acquired;
+          holders.fetch_sub(1);
+          Telemetry::ReleaseWriter(buffer.get(), id);
+        }
+      });
+    }
+  }
+  CHECK(!overlapped);
+  CHECK(acquired > 0);
+  CHECK(Telemetry::GetWriter(buffer.get()) == 0);
+}
+
+// Readers on other threads never see a torn or out-of-order record
+void TestConcurrentReaders() {
+  const auto buffer = MakeBuffer();
+  Telemetry::Initialize(buffer.get());
+
+  constexpr uint64_t FrameCount = 200000;
+  constexpr int ReaderCount = 3;
+  std::atomic<int> startedCount {};
+  std::atomic<bool> done {false};
+  std::atomic<uint64_t> readCount {};
+  std::atomic<uint64_t> tornCount {};
+  std::atomic<uint64_t> outOfOrderCount {};
+  {
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < ReaderCount; ++i) {
+      readers.emplace_back([&]() {
+        const Telemetry::Reader reader(buffer.get());
+        uint64_t cursor {};
+        uint64_t last {};
+        bool haveLast = false;
+        const auto visit = [&](const Telemetry::FrameRecord& record) {
+          ++readCount;
+          if (!IsConsistent(record)) {
+            ++tornCount;
+          }
+          if (haveLast && record.mFrame <= last) {
+            ++outOfOrderCount;
+          }
+          last = record.mFrame;
+          haveLast = true;
+        };
+        ++startedCount;
+        while (!done) {
+          reader.ReadSince(&cursor, visit);
+          // The oldest record shares a slot with the one being written, so
+          // this is where torn reads would be
+          const auto next = reader.GetNextFrame();
+          if (next < Telemetry::Capacity) {
+            continue;
+          }
+          if (const auto oldest = reader.Read(next - Telemetry::Capacity)) {
+            ++readCount;
+            if (!IsConsistent(*oldest)) {
+              ++tornCount;
+            }
+          }
+        }
+        reader.ReadSince(&cursor, visit);
+      });
+    }
+
+    while (startedCount < ReaderCount) {
+      std::this_thread::yield();
+    }
+    for (uint64_t i = 0; i < FrameCount; ++i) {
+      Telemetry::Write(buffer.get(), MakeRecord(i));
+    }
+    done = true;
+  }
+
+  CHECK(readCount > 0);
+  CHECK(tornCount == 0);
+  CHECK(outOfOrderCount == 0);
+  std::printf(
+    "Concurrent readers: %llu records read, %llu torn, %llu out of order\n",
+    static_cast<unsigned long long>(readCount.load()),
+    static_cast<unsigned long long>(tornCount.load()),
+    static_cast<unsigned long long>(outOfOrderCount.load()));
+}
+
+}// namespace
+
+int main() {
+  TestEmpty();
+  TestReadWrite();
+  TestOverwritten();
+  TestWriterOwnership();
+  TestConcurrentAcquire();
+  TestConcurrentReaders();
+
+  return Tests::Finish("Telemetry");
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2022-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+namespace HandTrackedCockpitClicking {
+
+struct ActionState {
+  bool mPrimary {false};// 'left click'
+  bool mSecondary {false};// 'right click'
+
+  enum class ValueChange {
+    None,
+    Decrease,// scroll wheel up
+    Increase,// scroll wheel down
+  };
+  ValueChange mValueChange {ValueChange::None};
+
+  constexpr bool Any() const {
+    return mPrimary || mSecondary || (mValueChange != ValueChange::None);
+  }
+
+  constexpr auto operator<=>(const ActionState&) const noexcept = default;
+};
+
+}// namespace HandTrackedCockpitClicking
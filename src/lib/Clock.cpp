@@ -0,0 +1,54 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "Clock.h"
+
+#include <Windows.h>
+
+#include "DebugPrint.h"
+#include "OpenXRNext.h"
+
+namespace HandTrackedCockpitClicking {
+
+OpenXRClock::OpenXRClock(OpenXRNext* openXR, XrInstance instance) {
+  LARGE_INTEGER frequency {};
+  QueryPerformanceFrequency(&frequency);
+  mFrequency = frequency.QuadPart;
+
+  LARGE_INTEGER nowPC {};
+  QueryPerformanceCounter(&nowPC);
+  if (!openXR->check_xrConvertWin32PerformanceCounterToTimeKHR(
+        instance, &nowPC, &mTimeAtSync)) {
+    DebugPrint("Failed to convert performance counter to XrTime");
+  }
+  mPerformanceCounterAtSync = nowPC.QuadPart;
+}
+
+XrTime OpenXRClock::Now() const {
+  LARGE_INTEGER nowPC {};
+  QueryPerformanceCounter(&nowPC);
+  const auto ticks = nowPC.QuadPart - mPerformanceCounterAtSync;
+
+  // Split to avoid overflowing `ticks * 1e9` after a few minutes
+  constexpr XrTime NanosecondsPerSecond = 1'000'000'000;
+  const auto seconds = ticks / mFrequency;
+  const auto remainder = ticks % mFrequency;
+  return mTimeAtSync + (seconds * NanosecondsPerSecond)
+    + ((remainder * NanosecondsPerSecond) / mFrequency);
+}
+
+VirtualClock::VirtualClock(XrTime now) : mNow(now) {
+}
+
+XrTime VirtualClock::Now() const {
+  return mNow.load(std::memory_order_acquire);
+}
+
+void VirtualClock::Set(XrTime now) {
+  mNow.store(now, std::memory_order_release);
+}
+
+void VirtualClock::Advance(std::chrono::nanoseconds duration) {
+  mNow.fetch_add(duration.count(), std::memory_order_acq_rel);
+}
+
+}// namespace HandTrackedCockpitClicking
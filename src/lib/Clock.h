@@ -0,0 +1,57 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace HandTrackedCockpitClicking {
+
+class OpenXRNext;
+
+// The current time, in the OpenXR runtime's time domain
+class Clock {
+ public:
+  virtual ~Clock() = default;
+
+  // Must be safe to call from any thread
+  virtual XrTime Now() const = 0;
+};
+
+/** The real time, as an XrTime.
+ *
+ * Converting with `xrConvertWin32PerformanceCounterToTimeKHR()` is a runtime
+ * call; as both clocks are monotonic, we only convert once, then extrapolate
+ * from the performance counter.
+ */
+class OpenXRClock final : public Clock {
+ public:
+  OpenXRClock(OpenXRNext*, XrInstance);
+
+  XrTime Now() const override;
+
+ private:
+  // Performance counter ticks per second
+  int64_t mFrequency {};
+  // The same instant in both domains
+  int64_t mPerformanceCounterAtSync {};
+  XrTime mTimeAtSync {};
+};
+
+// A clock that only moves when told to, for deterministic replay
+class VirtualClock final : public Clock {
+ public:
+  explicit VirtualClock(XrTime now = {});
+
+  XrTime Now() const override;
+  void Set(XrTime);
+  void Advance(std::chrono::nanoseconds);
+
+ private:
+  std::atomic<XrTime> mNow {};
+};
+
+}// namespace HandTrackedCockpitClicking
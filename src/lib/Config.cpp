@@ -2,8 +2,15 @@
 // SPDX-License-Identifier: MIT
 #include "Config.h"
 
+#include <wil/resource.h>
+
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
+#include <span>
 
+#include "ConfigParser.h"
 #include "DebugPrint.h"
 
 namespace HandTrackedCockpitClicking::Config {
@@ -18,8 +25,7 @@ HandTrackedCockpitClicking_DWORD_SETTINGS
     HandTrackedCockpitClicking_STRING_SETTINGS
 #undef IT
 
-  static const std::wstring BaseSubKey {
-    L"SOFTWARE\\Fred Emmott\\HandTrackedCockpitClicking"};
+  static const std::wstring BaseSubKey {RegistrySubKey};
 
 static std::wstring GetCurrentExecutableFileName() {
   static std::wstring sCache {};
@@ -39,94 +45,209 @@ static std::wstring AppOverrideSubKey(std::wstring_view executableFileName) {
   return std::format(L"{}\\AppOverrides\\{}", BaseSubKey, executableFileName);
 }
 
-template <class T>
-static void
-LoadDWord(const std::wstring& subKey, T& value, const wchar_t* valueName) {
-  DWORD data {};
-  DWORD dataSize = sizeof(data);
-  const auto result = RegGetValueW(
-    HKEY_LOCAL_MACHINE,
-    subKey.c_str(),
-    valueName,
-    RRF_RT_DWORD,
-    nullptr,
-    &data,
-    &dataSize);
-  if (result == ERROR_SUCCESS) {
-    value = static_cast<T>(data);
+namespace {
+
+// Logs and applies the values for one registry key or file section
+void OverlayAndLog(Snapshot& snapshot, const RawValues& values) {
+  for (const auto& name: Overlay(&snapshot, values)) {
+    DebugPrint("Ignoring invalid value for {}", name);
   }
 }
 
-static bool LoadString(
-  const std::wstring& subKey,
-  std::string& value,
-  const wchar_t* valueName) {
-  DWORD dataSize = 0;
-  const auto sizeResult = RegGetValueW(
-    HKEY_LOCAL_MACHINE,
-    subKey.c_str(),
-    valueName,
-    RRF_RT_REG_SZ,
-    nullptr,
-    nullptr,
-    &dataSize);
-  if (sizeResult != ERROR_SUCCESS && sizeResult != ERROR_MORE_DATA) {
-    return false;
+RawValues ReadRegistryKey(const std::wstring& subKey) {
+  RawValues ret;
+
+  wil::unique_hkey key;
+  if (
+    RegOpenKeyExW(
+      HKEY_LOCAL_MACHINE, subKey.c_str(), 0, KEY_QUERY_VALUE, key.put())
+    != ERROR_SUCCESS) {
+    return ret;
   }
 
-  std::vector<wchar_t> buffer(dataSize / sizeof(wchar_t), L'\0');
-  const auto dataResult = RegGetValueW(
-    HKEY_LOCAL_MACHINE,
-    subKey.c_str(),
-    valueName,
-    RRF_RT_REG_SZ,
-    nullptr,
-    buffer.data(),
-    &dataSize);
+  DWORD valueCount {};
+  DWORD maxNameLength {};
+  DWORD maxDataSize {};
+  if (
+    RegQueryInfoKeyW(
+      key.get(),
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      &valueCount,
+      &maxNameLength,
+      &maxDataSize,
+      nullptr,
+      nullptr)
+    != ERROR_SUCCESS) {
+    return ret;
+  }
+  ret.reserve(valueCount);
+
+  // Sized once for the largest value; the name length excludes the trailing
+  // null
+  std::wstring name(maxNameLength + 1, L'\0');
+  std::vector<wchar_t> data((maxDataSize / sizeof(wchar_t)) + 1, L'\0');
 
-  if (dataResult == ERROR_SUCCESS) {
-    value = Utf8::FromWide(buffer.data());
-    return true;
+  for (DWORD i = 0; i < valueCount; ++i) {
+    auto nameLength = static_cast<DWORD>(name.size());
+    auto dataSize = static_cast<DWORD>(data.size() * sizeof(wchar_t));
+    DWORD type {};
+    const auto result = RegEnumValueW(
+      key.get(),
+      i,
+      name.data(),
+      &nameLength,
+      nullptr,
+      &type,
+      reinterpret_cast<LPBYTE>(data.data()),
+      &dataSize);
+    if (result == ERROR_NO_MORE_ITEMS) {
+      break;
+    }
+    if (result != ERROR_SUCCESS) {
+      continue;
+    }
+
+    auto utf8Name = Utf8::FromWide({name.data(), nameLength});
+    if (type == REG_DWORD && dataSize >= sizeof(DWORD)) {
+      DWORD value {};
+      memcpy(&value, data.data(), sizeof(value));
+      ret.emplace(std::move(utf8Name), static_cast<uint32_t>(value));
+      continue;
+    }
+    if (type == REG_SZ) {
+      std::wstring_view value {data.data(), dataSize / sizeof(wchar_t)};
+      while (!value.empty() && value.back() == L'\0') {
+        value.remove_suffix(1);
+      }
+      ret.emplace(std::move(utf8Name), Utf8::FromWide(value));
+    }
   }
-  return false;
+  return ret;
+}
+
+void LogLoad(
+  const char* source,
+  std::chrono::steady_clock::time_point start,
+  std::size_t valueCount) {
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start);
+  DebugPrint(
+    "Loaded {} config values from {} in {}", valueCount, source, elapsed);
+  TraceLoggingWrite(
+    gTraceProvider,
+    "ConfigLoad",
+    TraceLoggingValue(source, "Source"),
+    TraceLoggingValue(static_cast<uint64_t>(valueCount), "ValueCount"),
+    TraceLoggingValue(elapsed.count(), "Microseconds"));
 }
 
-static void
-LoadFloat(const std::wstring& subKey, float& value, const wchar_t* valueName) {
-  std::string buffer;
-  if (LoadString(subKey, buffer, valueName)) {
-    value = std::atof(buffer.data());
+}// namespace
+
+std::shared_ptr<const Snapshot> LoadSnapshotFromFile(
+  const std::filesystem::path& path,
+  std::wstring_view executableFileName) {
+  const auto start = std::chrono::steady_clock::now();
+  DebugPrint(L"Loading settings from {}", path.wstring());
+
+  std::ifstream file(path);
+  if (!file) {
+    DebugPrint(L"Failed to open config file '{}'", path.wstring());
   }
+  const auto values
+    = ReadConfigFile(file, Utf8::FromWide(executableFileName));
+
+  auto snapshot = std::make_shared<Snapshot>();
+  OverlayAndLog(*snapshot, values.mBase);
+  OverlayAndLog(*snapshot, values.mOverrides);
+  LogLoad("file", start, values.mBase.size() + values.mOverrides.size());
+  return snapshot;
 }
 
-static void Load(const std::wstring& subKey) {
-#define IT(native_type, name, defaultValue) \
-  LoadDWord(subKey, Config::name, L#name);
+bool SaveSnapshotToFile(
+  const std::filesystem::path& path,
+  const Snapshot& snapshot,
+  std::span<const std::string_view> names,
+  std::wstring_view executableFileName) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) {
+    DebugPrint(L"Failed to open config file '{}' for writing", path.wstring());
+    return false;
+  }
+
+  const auto subKey = executableFileName.empty()
+    ? BaseSubKey
+    : AppOverrideSubKey(executableFileName);
+  WriteConfigFile(file, snapshot, names, Utf8::FromWide(subKey));
+  return file.good();
+}
+
+std::shared_ptr<const Snapshot> LoadSnapshot(
+  std::wstring_view executableFileName) {
+  if (const auto file = std::getenv("HTCC_CONFIG_FILE"); file && *file) {
+    return LoadSnapshotFromFile(file, executableFileName);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto snapshot = std::make_shared<Snapshot>();
+
+  DebugPrint(L"Loading settings from HKLM\\{}", BaseSubKey);
+  const auto base = ReadRegistryKey(BaseSubKey);
+  OverlayAndLog(*snapshot, base);
+  auto valueCount = base.size();
+
+  if (!executableFileName.empty()) {
+    const auto subKey = AppOverrideSubKey(executableFileName);
+    DebugPrint(L"Loading app overrides from HKLM\\{}", subKey);
+    const auto overrides = ReadRegistryKey(subKey);
+    OverlayAndLog(*snapshot, overrides);
+    valueCount += overrides.size();
+  }
+
+  LogLoad("registry", start, valueCount);
+  return snapshot;
+}
+
+void Apply(const Snapshot& snapshot) {
+#define IT(native_type, name, defaultValue) Config::name = snapshot.name;
   HandTrackedCockpitClicking_DWORD_SETTINGS
 #undef IT
-#define IT(name, defaultValue) LoadFloat(subKey, Config::name, L#name);
+#define IT(name, defaultValue) Config::name = snapshot.name;
     HandTrackedCockpitClicking_FLOAT_SETTINGS
+    HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+}
+
+Snapshot Current() {
+  Snapshot snapshot;
+#define IT(native_type, name, defaultValue) snapshot.name = Config::name;
+  HandTrackedCockpitClicking_DWORD_SETTINGS
 #undef IT
-#define IT(name, defaultValue) LoadString(subKey, Config::name, L#name);
+#define IT(name, defaultValue) snapshot.name = Config::name;
+    HandTrackedCockpitClicking_FLOAT_SETTINGS
     HandTrackedCockpitClicking_STRING_SETTINGS
 #undef IT
+  return snapshot;
 }
 
 void LoadBaseConfig() {
-  DebugPrint(L"Loading settings from HKLM\\{}", BaseSubKey);
-  Load(BaseSubKey);
+  Apply(*LoadSnapshot({}));
+}
+
+std::shared_ptr<const Snapshot> LoadSnapshotForCurrentProcess() {
+  return LoadSnapshot(GetCurrentExecutableFileName());
 }
 
 void LoadForCurrentProcess() {
-  LoadForExecutableFileName(GetCurrentExecutableFileName());
+  Apply(*LoadSnapshotForCurrentProcess());
 }
 
 void LoadForExecutableFileName(std::wstring_view executableFileName) {
-  LoadBaseConfig();
-
-  const auto subKey = AppOverrideSubKey(executableFileName);
-  DebugPrint(L"Loading app overrides from HKLM\\{}", subKey);
-  Load(subKey);
+  Apply(*LoadSnapshot(executableFileName));
 }
 
 template <class T>
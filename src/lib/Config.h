@@ -5,23 +5,31 @@
 #include <openxr/openxr.h>
 
 #include <cinttypes>
+#include <filesystem>
+#include <memory>
 #include <numbers>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 
 namespace HandTrackedCockpitClicking {
-enum class PointerSource : DWORD {
+enum class PointerSource : uint32_t {
   OpenXRHandTracking = 0,
   PointCtrl = 1,
+  Fusion = 2,
+  EyeGaze = 3,
 };
-enum class PointerSink : DWORD {
+enum class PointerSink : uint32_t {
   VirtualTouchScreen = 0,
   VirtualVRController = 1,
 };
-enum class ActionSink : DWORD {
+enum class ActionSink : uint32_t {
   MatchPointerSink = 0,
   VirtualTouchScreen = 1,
   VirtualVRController = 2,
 };
-enum class PointCtrlFCUMapping : DWORD {
+enum class PointCtrlFCUMapping : uint32_t {
   Disabled = 0,
   Classic = 1,
   Modal = 2,
@@ -30,25 +38,25 @@ enum class PointCtrlFCUMapping : DWORD {
   // registry
   DedicatedScrollButtons = 4,
 };
-enum class HandTrackingOrientation : DWORD {
+enum class HandTrackingOrientation : uint32_t {
   Raw = 0,
   RayCast = 1,
   RayCastWithReprojection = 2,
 };
-enum class VRControllerActionSinkMapping : DWORD {
+enum class VRControllerActionSinkMapping : uint32_t {
   DCS = 0,
   MSFS = 1,
 };
-enum class VRControllerPointerSinkWorldLock : DWORD {
+enum class VRControllerPointerSinkWorldLock : uint32_t {
   Nothing = 0,
   Orientation = 1,
   OrientationAndSoftPosition = 2,
 };
-enum class VRControllerGripSqueeze : DWORD {
+enum class VRControllerGripSqueeze : uint32_t {
   Never = 0,
   WhenTracking = 1,
 };
-enum class HandTrackingHands : DWORD {
+enum class HandTrackingHands : uint32_t {
   Both = 0,
   Left = 1,
   Right = 2,
@@ -122,6 +130,15 @@ enum class HandTrackingHands : DWORD {
   IT(bool, HandTrackingWakeSleepBeeps, false) \
   IT(bool, HandTrackingHibernateBeeps, true) \
   IT(uint32_t, HandTrackingGestureMilliseconds, 50) \
+  IT(uint32_t, HandTrackingIdlePollMilliseconds, 0) \
+  IT(uint32_t, HandTrackingPinchPredictionMilliseconds, 0) \
+  IT(bool, HandTrackingPinchPoseRollback, false) \
+  IT(uint32_t, FusionStaleMilliseconds, 100) \
+  IT(bool, FusionDriftCorrection, false) \
+  IT(uint32_t, EyeGazeDwellMilliseconds, 150) \
+  IT(uint16_t, InputSampleRateHz, 0) \
+  IT(uint16_t, VirtualTouchScreenMaxUpdateHz, 0) \
+  IT(bool, EnableTelemetry, false) \
   IT(uint16_t, PointCtrlVID, 0x04d8) \
   IT(uint16_t, PointCtrlPID, 0xeeec) \
   IT(uint8_t, PointCtrlFCUButtonL1, 0) \
@@ -149,7 +166,18 @@ enum class HandTrackingHands : DWORD {
   IT(HandTrackingActionVFOV, std::numbers::pi_v<float> / 2) \
   IT(HandTrackingActionHFOV, std::numbers::pi_v<float> / 2) \
   IT(HandTrackingHibernateCutoff, std::numbers::pi_v<float> / 8) \
+  IT(HandTrackingPinchIndexDistance, 0.015f) \
+  IT(HandTrackingPinchMiddleDistance, 0.015f) \
+  IT(HandTrackingPinchRingDistance, 0.02f) \
+  IT(HandTrackingPinchLittleDistance, 0.02f) \
+  IT(HandTrackingPinchReleaseRatio, 1.5f) \
+  IT(HandTrackingPinchPredictionSpeed, 0.1f) \
+  IT(FusionCorrectionRate, 2.0f) \
+  IT(FusionDriftWindowSeconds, 30.0f) \
+  IT(FusionDriftCorrectionRate, 0.05f) \
+  IT(EyeGazeDwellRadius, 0.035f) \
   IT(SmoothingFactor, 1.0f) \
+  IT(HotspotSnapAngle, 0.035f) \
   IT(LeftEyeFOVLeft, 0.0f) \
   IT(LeftEyeFOVRight, 0.0f) \
   IT(LeftEyeFOVUp, 0.0f) \
@@ -162,10 +190,17 @@ enum class HandTrackingHands : DWORD {
 #define HandTrackedCockpitClicking_STRING_SETTINGS \
   IT( \
     VirtualControllerInteractionProfilePath, \
-    "/interaction_profiles/oculus/touch_controller")
+    "/interaction_profiles/oculus/touch_controller") \
+  IT(HotspotFile, "") \
+  IT(HandTrackingCaptureFile, "") \
+  IT(PointCtrlCalibrationModel, "")
 
 namespace HandTrackedCockpitClicking::Config {
 
+// Under HKEY_LOCAL_MACHINE
+constexpr std::wstring_view RegistrySubKey {
+  L"SOFTWARE\\Fred Emmott\\HandTrackedCockpitClicking"};
+
 #define IT(native_type, name, defaultValue) \
   namespace Defaults { \
   constexpr native_type name {defaultValue}; \
@@ -195,11 +230,84 @@ HandTrackedCockpitClicking_DWORD_SETTINGS
   inline bool
   IsRaycastOrientation() {
   return Config::PointerSource == PointerSource::PointCtrl
+    || Config::PointerSource == PointerSource::Fusion
     || Config::HandTrackingOrientation == HandTrackingOrientation::RayCast
     || Config::HandTrackingOrientation
     == HandTrackingOrientation::RayCastWithReprojection;
 }
 
+/** Every setting, as loaded at a single point in time.
+ *
+ * Loading fills one of these with a single enumeration of each registry key,
+ * instead of one query per setting; `Apply()` then copies it to the globals
+ * above.
+ */
+struct Snapshot {
+#define IT(native_type, name, defaultValue) native_type name {Defaults::name};
+  HandTrackedCockpitClicking_DWORD_SETTINGS
+#undef IT
+#define IT(name, defaultValue) float name {Defaults::name};
+    HandTrackedCockpitClicking_FLOAT_SETTINGS
+#undef IT
+#define IT(name, defaultValue) std::string name {Defaults::name};
+      HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+};
+
+/** Load the base settings, then any overrides for the executable.
+ *
+ * If `executableFileName` is empty, only the base settings are loaded.
+ *
+ * Settings come from the registry, unless the `HTCC_CONFIG_FILE` environment
+ * variable names a file; see `LoadSnapshotFromFile()`.
+ */
+std::shared_ptr<const Snapshot> LoadSnapshot(
+  std::wstring_view executableFileName);
+
+std::shared_ptr<const Snapshot> LoadSnapshotForCurrentProcess();
+
+/** Load settings from a UTF-8 subset of the `.reg` file format.
+ *
+ * Only `"Name"=dword:0000000a` and `"Name"="value"` lines are supported;
+ * values in sections ending in `\AppOverrides\<executable>` only apply to
+ * that executable.
+ *
+ * The parsing is in `ConfigParser.h`, which only uses the standard library,
+ * so loading can be tested and benchmarked without a registry.
+ */
+std::shared_ptr<const Snapshot> LoadSnapshotFromFile(
+  const std::filesystem::path&,
+  std::wstring_view executableFileName);
+
+/** Write the named settings in the format read by `LoadSnapshotFromFile()`.
+ *
+ * This is also a valid `.reg` file. If `executableFileName` isn't empty, the
+ * settings are written as overrides for that executable.
+ */
+bool SaveSnapshotToFile(
+  const std::filesystem::path&,
+  const Snapshot&,
+  std::span<const std::string_view> names,
+  std::wstring_view executableFileName = {});
+
+/** Copy a snapshot to the globals.
+ *
+ * The globals aren't synchronized, so this must only be called before anything
+ * might read them; code that needs to see changes should keep a `Snapshot`.
+ */
+void Apply(const Snapshot&);
+// The reverse of `Apply()`: a copy of the current globals
+Snapshot Current();
+
+/** Set a setting by name, e.g. from a command line.
+ *
+ * DWORD settings are decimal, or hex with an `0x` prefix. Returns false if
+ * there's no such setting, or the value isn't valid for its type.
+ */
+bool Set(Snapshot*, std::string_view name, std::string_view value);
+// The reverse of `Set()`; nullopt if there's no such setting
+std::optional<std::string> Get(const Snapshot&, std::string_view name);
+
 void LoadForExecutableFileName(std::wstring_view file);
 void LoadBaseConfig();
 void LoadForCurrentProcess();
@@ -0,0 +1,278 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "ConfigParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <istream>
+#include <optional>
+#include <ostream>
+
+namespace HandTrackedCockpitClicking::Config {
+
+namespace {
+
+template <class T>
+void OverlayDWord(const RawValues& values, std::string_view name, T& value) {
+  const auto it = values.find(name);
+  if (it == values.end()) {
+    return;
+  }
+  if (const auto data = std::get_if<uint32_t>(&it->second)) {
+    value = static_cast<T>(*data);
+  }
+}
+
+void OverlayString(
+  const RawValues& values,
+  std::string_view name,
+  std::string& value) {
+  const auto it = values.find(name);
+  if (it == values.end()) {
+    return;
+  }
+  if (const auto data = std::get_if<std::string>(&it->second)) {
+    value = *data;
+  }
+}
+
+// False if there's a value, but it isn't a valid float
+bool OverlayFloat(
+  const RawValues& values,
+  std::string_view name,
+  float& value) {
+  const auto it = values.find(name);
+  if (it == values.end()) {
+    return true;
+  }
+  const auto data = std::get_if<std::string>(&it->second);
+  if (!data) {
+    return false;
+  }
+
+  float parsed {};
+  const auto first = data->data();
+  const auto last = first + data->size();
+  const auto [end, error] = std::from_chars(first, last, parsed);
+  if (error != std::errc {} || end != last) {
+    return false;
+  }
+  value = parsed;
+  return true;
+}
+
+std::string_view Trim(std::string_view value) {
+  constexpr std::string_view whitespace {" \t\r\n"};
+  const auto first = value.find_first_not_of(whitespace);
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = value.find_last_not_of(whitespace);
+  return value.substr(first, (last - first) + 1);
+}
+
+bool EqualsIgnoringASCIICase(std::string_view a, std::string_view b) {
+  return std::ranges::equal(a, b, [](char x, char y) {
+    const auto lower = [](char c) {
+      return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    };
+    return lower(x) == lower(y);
+  });
+}
+
+// Parses `"quoted \"string\""` into `quoted "string"`; returns the rest
+std::optional<std::string_view> ParseQuoted(
+  std::string_view in,
+  std::string* out) {
+  if (in.empty() || in.front() != '"') {
+    return {};
+  }
+  out->clear();
+  for (std::size_t i = 1; i < in.size(); ++i) {
+    const auto c = in[i];
+    if (c == '"') {
+      return in.substr(i + 1);
+    }
+    if (c == '\\' && i + 1 < in.size()) {
+      ++i;
+    }
+    out->push_back(in[i]);
+  }
+  return {};
+}
+
+std::string Quote(std::string_view value) {
+  std::string ret {'"'};
+  for (const auto c: value) {
+    if (c == '"' || c == '\\') {
+      ret.push_back('\\');
+    }
+    ret.push_back(c);
+  }
+  ret.push_back('"');
+  return ret;
+}
+
+}// namespace
+
+std::vector<std::string> Overlay(Snapshot* snapshot, const RawValues& values) {
+  std::vector<std::string> invalid;
+#define IT(native_type, name, defaultValue) \
+  OverlayDWord(values, #name, snapshot->name);
+  HandTrackedCockpitClicking_DWORD_SETTINGS
+#undef IT
+#define IT(name, defaultValue) \
+  if (!OverlayFloat(values, #name, snapshot->name)) { \
+    invalid.emplace_back(#name); \
+  }
+    HandTrackedCockpitClicking_FLOAT_SETTINGS
+#undef IT
+#define IT(name, defaultValue) OverlayString(values, #name, snapshot->name);
+      HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+  return invalid;
+}
+
+ConfigFileValues ReadConfigFile(
+  std::istream& file,
+  std::string_view executableFileName) {
+  constexpr std::string_view overridesSection {"\\AppOverrides\\"};
+
+  ConfigFileValues ret;
+  RawValues* section = &ret.mBase;
+  std::string line;
+  std::string name;
+  std::string value;
+  while (std::getline(file, line)) {
+    const auto trimmed = Trim(line);
+    if (trimmed.empty() || trimmed.front() == ';') {
+      continue;
+    }
+
+    if (trimmed.front() == '[' && trimmed.back() == ']') {
+      const auto key = trimmed.substr(1, trimmed.size() - 2);
+      const auto overridesAt = key.rfind(overridesSection);
+      if (overridesAt == std::string_view::npos) {
+        section = &ret.mBase;
+      } else {
+        const auto executable
+          = key.substr(overridesAt + overridesSection.size());
+        section = EqualsIgnoringASCIICase(executable, executableFileName)
+          ? &ret.mOverrides
+          : nullptr;
+      }
+      continue;
+    }
+
+    const auto rest = ParseQuoted(trimmed, &name);
+    if (!(section && rest && rest->starts_with('='))) {
+      continue;
+    }
+    const auto data = rest->substr(1);
+
+    constexpr std::string_view dwordPrefix {"dword:"};
+    if (data.starts_with(dwordPrefix)) {
+      uint32_t dword {};
+      const auto hex = data.substr(dwordPrefix.size());
+      const auto [end, error]
+        = std::from_chars(hex.data(), hex.data() + hex.size(), dword, 16);
+      if (error == std::errc {}) {
+        section->insert_or_assign(name, dword);
+      }
+      continue;
+    }
+    if (ParseQuoted(data, &value)) {
+      section->insert_or_assign(name, value);
+    }
+  }
+  return ret;
+}
+
+void WriteConfigFile(
+  std::ostream& file,
+  const Snapshot& snapshot,
+  std::span<const std::string_view> names,
+  std::string_view subKey) {
+  file << "Windows Registry Editor Version 5.00\n\n"
+       << std::format("[HKEY_LOCAL_MACHINE\\{}]\n", subKey);
+
+  for (const auto name: names) {
+#define IT(native_type, it, defaultValue) \
+  if (name == #it) { \
+    file << std::format( \
+      "\"{}\"=dword:{:08x}\n", name, static_cast<uint32_t>(snapshot.it)); \
+  }
+    HandTrackedCockpitClicking_DWORD_SETTINGS
+#undef IT
+#define IT(it, defaultValue) \
+  if (name == #it) { \
+    file << std::format( \
+      "\"{}\"={}\n", name, Quote(std::format("{}", snapshot.it))); \
+  }
+    HandTrackedCockpitClicking_FLOAT_SETTINGS
+    HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+  }
+}
+
+bool Set(Snapshot* snapshot, std::string_view name, std::string_view value) {
+  const auto first = value.data();
+  const auto last = first + value.size();
+
+#define IT(native_type, it, defaultValue) \
+  if (name == #it) { \
+    uint32_t dword {}; \
+    const auto hex = value.starts_with("0x"); \
+    const auto [end, error] \
+      = std::from_chars(hex ? first + 2 : first, last, dword, hex ? 16 : 10); \
+    if (error != std::errc {} || end != last) { \
+      return false; \
+    } \
+    snapshot->it = static_cast<native_type>(dword); \
+    return true; \
+  }
+  HandTrackedCockpitClicking_DWORD_SETTINGS
+#undef IT
+#define IT(it, defaultValue) \
+  if (name == #it) { \
+    float parsed {}; \
+    const auto [end, error] = std::from_chars(first, last, parsed); \
+    if (error != std::errc {} || end != last) { \
+      return false; \
+    } \
+    snapshot->it = parsed; \
+    return true; \
+  }
+  HandTrackedCockpitClicking_FLOAT_SETTINGS
+#undef IT
+#define IT(it, defaultValue) \
+  if (name == #it) { \
+    snapshot->it = std::string {value}; \
+    return true; \
+  }
+  HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+  return false;
+}
+
+std::optional<std::string> Get(
+  const Snapshot& snapshot,
+  std::string_view name) {
+#define IT(native_type, it, defaultValue) \
+  if (name == #it) { \
+    return std::format("{}", static_cast<uint32_t>(snapshot.it)); \
+  }
+  HandTrackedCockpitClicking_DWORD_SETTINGS
+#undef IT
+#define IT(it, defaultValue) \
+  if (name == #it) { \
+    return std::format("{}", snapshot.it); \
+  }
+  HandTrackedCockpitClicking_FLOAT_SETTINGS
+  HandTrackedCockpitClicking_STRING_SETTINGS
+#undef IT
+  return std::nullopt;
+}
+
+}// namespace HandTrackedCockpitClicking::Config
@@ -0,0 +1,65 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cinttypes>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "Config.h"
+
+/** The parts of loading and saving settings that don't need Windows.
+ *
+ * `Config.cpp` does the I/O and logging; everything here only uses the
+ * standard library, so it can be tested and benchmarked anywhere. `Set()` and
+ * `Get()` are also defined here.
+ */
+namespace HandTrackedCockpitClicking::Config {
+
+// Values as stored, before we know what type the setting wants
+using RawValue = std::variant<uint32_t, std::string>;
+
+struct StringHash {
+  using is_transparent = void;
+  std::size_t operator()(std::string_view value) const {
+    return std::hash<std::string_view> {}(value);
+  }
+};
+// Keyed by value name; transparent so that lookups don't allocate
+using RawValues
+  = std::unordered_map<std::string, RawValue, StringHash, std::equal_to<>>;
+
+/** Copy any values for known settings into the snapshot.
+ *
+ * Values that aren't valid for their setting are ignored. The names of
+ * floats that are ignored are returned, so that the caller can log them.
+ */
+std::vector<std::string> Overlay(Snapshot*, const RawValues&);
+
+struct ConfigFileValues {
+  RawValues mBase;
+  // From the `AppOverrides` section for the executable, if any
+  RawValues mOverrides;
+};
+
+/** Parse the `.reg` subset described by `LoadSnapshotFromFile()`.
+ *
+ * Sections for other executables are skipped, as are lines that don't parse.
+ */
+ConfigFileValues ReadConfigFile(
+  std::istream&,
+  std::string_view executableFileName);
+
+// Writes `names` as a `.reg` file for `HKEY_LOCAL_MACHINE\<subKey>`
+void WriteConfigFile(
+  std::ostream&,
+  const Snapshot&,
+  std::span<const std::string_view> names,
+  std::string_view subKey);
+
+}// namespace HandTrackedCockpitClicking::Config
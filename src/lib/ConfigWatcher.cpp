@@ -0,0 +1,36 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "ConfigWatcher.h"
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include "DebugPrint.h"
+
+namespace HandTrackedCockpitClicking {
+
+ConfigWatcher::ConfigWatcher(Callback callback)
+  : mCallback(std::move(callback)) {
+  if (const auto file = std::getenv("HTCC_CONFIG_FILE"); file && *file) {
+    DebugPrint("Not watching for config changes, as HTCC_CONFIG_FILE is set");
+    return;
+  }
+
+  const std::wstring subKey {Config::RegistrySubKey};
+  mWatcher = wil::make_registry_watcher_nothrow(
+    HKEY_LOCAL_MACHINE,
+    subKey.c_str(),
+    /* recursive = */ true,
+    [this](wil::RegistryChangeKind) { this->Reload(); });
+  if (!mWatcher) {
+    DebugPrint("Failed to watch the registry for config changes");
+  }
+}
+
+void ConfigWatcher::Reload() {
+  // Called on a threadpool thread
+  mCallback(Config::LoadSnapshotForCurrentProcess());
+}
+
+}// namespace HandTrackedCockpitClicking
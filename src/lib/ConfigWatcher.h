@@ -0,0 +1,39 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <wil/registry.h>
+
+#include <functional>
+#include <memory>
+
+#include "Config.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Reloads the config when the registry changes.
+ *
+ * Snapshots are loaded on a threadpool thread, and passed to the callback on
+ * that same thread, so the callback can also do any other slow work that the
+ * new config needs - such as loading files or building pipelines - before
+ * publishing it to the frame thread. Callbacks are not run concurrently, and
+ * none are running once the watcher is destroyed.
+ *
+ * Settings loaded from `HTCC_CONFIG_FILE` aren't watched.
+ */
+class ConfigWatcher final {
+ public:
+  using Callback
+    = std::function<void(std::shared_ptr<const Config::Snapshot>)>;
+
+  ConfigWatcher() = delete;
+  explicit ConfigWatcher(Callback);
+
+ private:
+  Callback mCallback;
+  wil::unique_registry_watcher_nothrow mWatcher;
+
+  void Reload();
+};
+
+}// namespace HandTrackedCockpitClicking
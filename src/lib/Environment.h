@@ -5,12 +5,19 @@
 #include <cinttypes>
 
 #define HandTrackedCockpitClicking_ENVIRONMENT_INFO \
+  IT(bool, IsPointCtrlCalibration, false)
+
+// Per-instance, as an app can create several instances with different
+// extensions enabled
+#define HandTrackedCockpitClicking_INSTANCE_ENVIRONMENT_INFO \
   IT(bool, App_Enabled_XR_EXT_hand_tracking, false) \
   IT(bool, App_Enabled_XR_KHR_win32_convert_performance_counter_time, false) \
+  IT(bool, App_Enabled_XR_KHR_locate_spaces, false) \
+  IT(bool, App_Enabled_XR_VERSION_1_1, false) \
   IT(bool, Have_XR_KHR_win32_convert_performance_counter_time, false) \
   IT(bool, Have_XR_EXT_hand_tracking, false) \
   IT(bool, Have_XR_FB_hand_tracking_aim, false) \
-  IT(bool, IsPointCtrlCalibration, false)
+  IT(bool, Have_XR_EXT_eye_gaze_interaction, false)
 
 namespace HandTrackedCockpitClicking::Environment {
 
@@ -22,4 +29,11 @@ void Load();
 HandTrackedCockpitClicking_ENVIRONMENT_INFO
 #undef IT
 
+// What the app asked for, and what we got, when creating an instance
+struct InstanceInfo {
+#define IT(native_type, name, default) native_type name {default};
+  HandTrackedCockpitClicking_INSTANCE_ENVIRONMENT_INFO
+#undef IT
+};
+
 }// namespace HandTrackedCockpitClicking::Environment
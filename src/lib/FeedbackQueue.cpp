@@ -0,0 +1,93 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "FeedbackQueue.h"
+
+#include <array>
+#include <utility>
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+// Each hand, and hibernation, are coalesced separately
+std::size_t GetChannel(const Feedback& feedback) {
+  switch (feedback.mEvent) {
+    case FeedbackEvent::HibernateWake:
+    case FeedbackEvent::HibernateSleep:
+      return 0;
+    case FeedbackEvent::Wake:
+    case FeedbackEvent::Sleep:
+      break;
+  }
+  return (feedback.mHand == HandWakeStateMachine::Hand::Right) ? 2 : 1;
+}
+
+}// namespace
+
+void RecordingFeedbackOutput::Play(const Feedback& feedback) {
+  std::unique_lock lock(mMutex);
+  mFeedback.push_back(feedback);
+}
+
+std::vector<Feedback> RecordingFeedbackOutput::TakeFeedback() {
+  std::unique_lock lock(mMutex);
+  return std::exchange(mFeedback, {});
+}
+
+bool FeedbackQueue::Push(const Feedback& feedback) {
+  if (mClosed.load(std::memory_order_relaxed) || !mFeedback.Push(feedback)) {
+    return false;
+  }
+  mPending.fetch_add(1, std::memory_order_release);
+  mPending.notify_one();
+  return true;
+}
+
+std::vector<Feedback> FeedbackQueue::Take() {
+  while (!mClosed.load(std::memory_order_acquire)) {
+    mPending.wait(0, std::memory_order_acquire);
+    mPending.store(0, std::memory_order_relaxed);
+    if (mClosed.load(std::memory_order_acquire)) {
+      return {};
+    }
+
+    std::vector<Feedback> queued;
+    mFeedback.Drain([&queued](const Feedback& it) { queued.push_back(it); });
+
+    // Keep the last of each channel, in queue order
+    std::array<std::size_t, 3> last {};
+    for (std::size_t i = 0; i < queued.size(); ++i) {
+      last.at(GetChannel(queued.at(i))) = i + 1;
+    }
+    std::vector<Feedback> ret;
+    for (std::size_t i = 0; i < queued.size(); ++i) {
+      if (last.at(GetChannel(queued.at(i))) == i + 1) {
+        ret.push_back(queued.at(i));
+      }
+    }
+    if (!ret.empty()) {
+      return ret;
+    }
+  }
+  return {};
+}
+
+void FeedbackQueue::Run(FeedbackOutput* output) {
+  while (true) {
+    const auto batch = this->Take();
+    if (batch.empty()) {
+      return;
+    }
+    for (const auto& feedback: batch) {
+      output->Play(feedback);
+    }
+  }
+}
+
+void FeedbackQueue::Close() {
+  mClosed.store(true, std::memory_order_release);
+  mPending.fetch_add(1, std::memory_order_release);
+  mPending.notify_one();
+}
+
+}// namespace HandTrackedCockpitClicking
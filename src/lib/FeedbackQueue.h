@@ -0,0 +1,79 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "HandWakeStateMachine.h"
+#include "SampleRing.h"
+
+namespace HandTrackedCockpitClicking {
+
+using FeedbackEvent = HandWakeStateMachine::Event;
+
+struct Feedback {
+  FeedbackEvent mEvent {};
+  // Only for wake and sleep; hibernation is shared between both hands
+  std::optional<HandWakeStateMachine::Hand> mHand;
+
+  bool operator==(const Feedback&) const = default;
+};
+
+class FeedbackOutput {
+ public:
+  virtual ~FeedbackOutput() = default;
+  // Called on the feedback worker thread; may block
+  virtual void Play(const Feedback&) = 0;
+};
+
+// Keeps feedback instead of playing it, for tests
+class RecordingFeedbackOutput final : public FeedbackOutput {
+ public:
+  void Play(const Feedback&) override;
+
+  // Returns and clears the recorded feedback
+  std::vector<Feedback> TakeFeedback();
+
+ private:
+  std::mutex mMutex;
+  std::vector<Feedback> mFeedback;
+};
+
+/** Passes feedback from the frame thread to the feedback worker.
+ *
+ * `Push()` never blocks or allocates. Anything still queued when the consumer
+ * gets to it is stale, so only the latest event for each hand, and the latest
+ * hibernation event, are played; for example, a hand that woke and fell
+ * asleep again while the previous cue was playing only needs the 'sleep' cue.
+ * What's left is played in the order it was queued.
+ *
+ * This doesn't depend on Windows, so it can be tested anywhere.
+ */
+class FeedbackQueue final {
+ public:
+  // Single producer only; false if the queue is full or closed
+  bool Push(const Feedback&);
+
+  /** Waits for feedback, then returns the coalesced batch.
+   *
+   * Single consumer only. Returns an empty batch once `Close()` is called;
+   * anything still queued is dropped.
+   */
+  std::vector<Feedback> Take();
+
+  // Plays everything that's taken until `Close()` is called
+  void Run(FeedbackOutput*);
+
+  // Wakes the consumer, and makes further calls to `Take()` return nothing
+  void Close();
+
+ private:
+  SampleRing<Feedback, 16> mFeedback;
+  std::atomic_uint32_t mPending {0};
+  std::atomic_bool mClosed {false};
+};
+
+}// namespace HandTrackedCockpitClicking
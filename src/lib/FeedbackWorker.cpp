@@ -0,0 +1,57 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "FeedbackWorker.h"
+
+#include <functional>
+
+#include "DebugPrint.h"
+
+namespace HandTrackedCockpitClicking {
+
+void BeepFeedbackOutput::Play(const Feedback& feedback) {
+  constexpr DWORD lowNote {262};// C4
+  constexpr DWORD highNote {440};// A4
+  constexpr DWORD ms = {100};
+
+  switch (feedback.mEvent) {
+    case FeedbackEvent::HibernateWake:
+      Beep(lowNote, ms);
+      Beep(highNote, ms);
+      [[fallthrough]];
+    case FeedbackEvent::Wake:
+      Beep(lowNote, ms);
+      Beep(highNote, ms);
+      return;
+    case FeedbackEvent::HibernateSleep:
+      Beep(highNote, ms);
+      Beep(lowNote, ms);
+      [[fallthrough]];
+    case FeedbackEvent::Sleep:
+      Beep(highNote, ms);
+      Beep(lowNote, ms);
+      return;
+  }
+}
+
+FeedbackWorker::FeedbackWorker(std::unique_ptr<FeedbackOutput> output)
+  : mOutput(std::move(output)) {
+  mThread = std::jthread {std::bind_front(&FeedbackWorker::Run, this)};
+}
+
+FeedbackWorker::~FeedbackWorker() {
+  mQueue.Close();
+  mThread.join();
+}
+
+void FeedbackWorker::Enqueue(const Feedback& feedback) {
+  if (!mQueue.Push(feedback)) {
+    DebugPrint("Feedback queue full, dropping event");
+  }
+}
+
+void FeedbackWorker::Run() {
+  SetThreadDescription(GetCurrentThread(), L"HTCC Feedback");
+  mQueue.Run(mOutput.get());
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,42 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <memory>
+#include <thread>
+
+#include "FeedbackQueue.h"
+
+namespace HandTrackedCockpitClicking {
+
+// Plays notes via the Win32 `Beep()` function
+class BeepFeedbackOutput final : public FeedbackOutput {
+ public:
+  void Play(const Feedback&) override;
+};
+
+/** Plays feedback on a single long-lived thread.
+ *
+ * `Enqueue()` never blocks or allocates, so it's safe to call from the game's
+ * frame thread. See `FeedbackQueue` for how events that are queued while the
+ * previous one is still playing are coalesced.
+ */
+class FeedbackWorker final {
+ public:
+  FeedbackWorker() = delete;
+  FeedbackWorker(std::unique_ptr<FeedbackOutput>);
+  ~FeedbackWorker();
+
+  // Single producer only
+  void Enqueue(const Feedback&);
+
+ private:
+  std::unique_ptr<FeedbackOutput> mOutput;
+  FeedbackQueue mQueue;
+
+  std::jthread mThread;
+
+  void Run();
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -2,8 +2,7 @@
 // SPDX-License-Identifier: MIT
 #include "FrameInfo.h"
 
-#include <Windows.h>
-
+#include "Clock.h"
 #include "OpenXRNext.h"
 
 namespace HandTrackedCockpitClicking {
@@ -12,15 +11,11 @@ class OpenXRNext;
 
 FrameInfo::FrameInfo(
   OpenXRNext* openXR,
-  XrInstance instance,
+  const Clock& clock,
   XrSpace localSpace,
   XrSpace viewSpace,
   XrTime predictedDisplayTime)
-  : mPredictedDisplayTime(predictedDisplayTime) {
-  LARGE_INTEGER nowPC;
-  QueryPerformanceCounter(&nowPC);
-  openXR->xrConvertWin32PerformanceCounterToTimeKHR(instance, &nowPC, &mNow);
-
+  : mNow(clock.Now()), mPredictedDisplayTime(predictedDisplayTime) {
   XrSpaceLocation location {XR_TYPE_SPACE_LOCATION};
   if (openXR->check_xrLocateSpace(
         localSpace, viewSpace, predictedDisplayTime, &location)) {
@@ -6,13 +6,14 @@
 
 namespace HandTrackedCockpitClicking {
 
+class Clock;
 class OpenXRNext;
 
 struct FrameInfo {
   FrameInfo() = default;
   FrameInfo(
     OpenXRNext* next,
-    XrInstance instance,
+    const Clock& clock,
     XrSpace localSpace,
     XrSpace viewSpace,
     XrTime predictedDisplayTime);
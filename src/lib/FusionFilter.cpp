@@ -0,0 +1,83 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "FusionFilter.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+XrVector2f Lerp(const XrVector2f& a, const XrVector2f& b, float t) {
+  return {a.x + ((b.x - a.x) * t), a.y + ((b.y - a.y) * t)};
+}
+
+}// namespace
+
+float FusionFilter::Confidence(
+  const Config::Snapshot& config,
+  XrTime now,
+  const Source& source) {
+  if (!source.mDirection) {
+    return 0.0f;
+  }
+  if (config.FusionStaleMilliseconds == 0) {
+    return 1.0f;
+  }
+  const auto age = std::chrono::nanoseconds(now - source.mPositionUpdatedAt);
+  const std::chrono::duration<float, std::milli> stale {
+    config.FusionStaleMilliseconds};
+  return std::clamp(1.0f - (age / stale), 0.0f, 1.0f);
+}
+
+FusionFilter::Result FusionFilter::Update(
+  const Config::Snapshot& config,
+  XrTime now,
+  const Source& handTracking,
+  const Source& pointCtrl) {
+  Result ret {
+    .mDirection = std::nullopt,
+    .mHandTrackingConfidence = Confidence(config, now, handTracking),
+    .mPointCtrlConfidence = Confidence(config, now, pointCtrl),
+  };
+  const auto htConfidence = ret.mHandTrackingConfidence;
+  const auto pcConfidence = ret.mPointCtrlConfidence;
+
+  if (htConfidence > 0 && pcConfidence > 0) {
+    // Pull the bias towards whatever makes PointCtrl agree with hand tracking;
+    // the first frame after a gap only sets the time, so we don't apply a
+    // large correction for time when one source wasn't there
+    if (mLastCorrectedAt) {
+      const std::chrono::duration<float> dt {
+        std::chrono::nanoseconds(now - mLastCorrectedAt)};
+      const auto gain
+        = std::min(1.0f, config.FusionCorrectionRate * dt.count())
+        * htConfidence * pcConfidence;
+      const auto& target = *handTracking.mDirection;
+      const auto& raw = *pointCtrl.mDirection;
+      mBias.x += (target.x - (raw.x + mBias.x)) * gain;
+      mBias.y += (target.y - (raw.y + mBias.y)) * gain;
+    }
+    mLastCorrectedAt = now;
+  } else {
+    mLastCorrectedAt = {};
+  }
+
+  if (pcConfidence > 0) {
+    const auto& raw = *pointCtrl.mDirection;
+    const XrVector2f corrected {raw.x + mBias.x, raw.y + mBias.y};
+    ret.mDirection = (htConfidence > 0)
+      ? Lerp(*handTracking.mDirection, corrected, pcConfidence)
+      : corrected;
+  } else if (htConfidence > 0) {
+    ret.mDirection = handTracking.mDirection;
+  }
+  return ret;
+}
+
+XrVector2f FusionFilter::GetBias() const {
+  return mBias;
+}
+
+}// namespace HandTrackedCockpitClicking
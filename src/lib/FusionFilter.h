@@ -0,0 +1,52 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <optional>
+
+#include "Config.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** The complementary filter from `FusionSource`, for one hand.
+ *
+ * The pointer follows PointCtrl plus a bias, which is pulled towards hand
+ * tracking at `FusionCorrectionRate`; each source is weighted by how recently
+ * it was updated, fading out at `FusionStaleMilliseconds`.
+ *
+ * This is separate from `FusionSource` so that offline replay runs the same
+ * code as the API layer.
+ */
+class FusionFilter final {
+ public:
+  struct Source {
+    std::optional<XrVector2f> mDirection;
+    XrTime mPositionUpdatedAt {};
+  };
+
+  struct Result {
+    std::optional<XrVector2f> mDirection;
+    float mHandTrackingConfidence {};
+    float mPointCtrlConfidence {};
+  };
+
+  // 1 if the position was just updated, falling to 0 when it's stale
+  static float Confidence(const Config::Snapshot&, XrTime now, const Source&);
+
+  Result Update(
+    const Config::Snapshot&,
+    XrTime now,
+    const Source& handTracking,
+    const Source& pointCtrl);
+
+  // Added to the PointCtrl direction
+  XrVector2f GetBias() const;
+
+ private:
+  XrVector2f mBias {};
+  XrTime mLastCorrectedAt {};
+};
+
+}// namespace HandTrackedCockpitClicking
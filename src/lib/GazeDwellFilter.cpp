@@ -0,0 +1,64 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "GazeDwellFilter.h"
+
+#include <cmath>
+
+#include "Config.h"
+
+namespace HandTrackedCockpitClicking {
+
+GazeDwellFilter::Parameters GazeDwellFilter::Parameters::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+GazeDwellFilter::Parameters GazeDwellFilter::Parameters::FromConfig(
+  const Config::Snapshot& config) {
+  return {
+    .mRadius = config.EyeGazeDwellRadius,
+    .mDwell = std::chrono::milliseconds(config.EyeGazeDwellMilliseconds),
+  };
+}
+
+GazeDwellFilter::GazeDwellFilter(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+void GazeDwellFilter::Reset() {
+  mCandidate = {};
+  mFixation = {};
+}
+
+XrVector2f GazeDwellFilter::Candidate::Mean() const {
+  return {mSum.x / mCount, mSum.y / mCount};
+}
+
+std::optional<XrVector2f> GazeDwellFilter::Update(
+  Time now,
+  const std::optional<XrVector2f>& gaze) {
+  if (!gaze) {
+    return mFixation;
+  }
+
+  if (mCandidate) {
+    const auto mean = mCandidate->Mean();
+    const auto distance = std::hypot(gaze->x - mean.x, gaze->y - mean.y);
+    if (distance > mParameters.mRadius) {
+      mCandidate = {};
+    }
+  }
+
+  if (!mCandidate) {
+    mCandidate = Candidate {.mSince = now};
+  }
+  mCandidate->mSum.x += gaze->x;
+  mCandidate->mSum.y += gaze->y;
+  ++mCandidate->mCount;
+
+  if (now - mCandidate->mSince >= mParameters.mDwell) {
+    mFixation = mCandidate->Mean();
+  }
+  return mFixation;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,70 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <optional>
+
+namespace HandTrackedCockpitClicking {
+
+namespace Config {
+struct Snapshot;
+}
+
+/** Stabilizes a gaze direction by only following fixations.
+ *
+ * Eyes never hold perfectly still, and constantly flick between nearby
+ * points; following the raw gaze makes for an unusable pointer. Instead,
+ * samples within `mRadius` of each other are grouped into a candidate
+ * fixation, and once the gaze has dwelt on it for `mDwell`, the pointer moves
+ * to its average. Glances elsewhere that are shorter than `mDwell` don't move
+ * the pointer at all.
+ *
+ * Directions are rotations around the x and y axis, as in
+ * `InputState::mDirection`.
+ */
+class GazeDwellFilter final {
+ public:
+  // Nanoseconds since an arbitrary epoch
+  using Time = std::chrono::nanoseconds;
+
+  struct Parameters {
+    // In radians
+    float mRadius {};
+    std::chrono::milliseconds mDwell {};
+
+    static Parameters FromConfig();
+    static Parameters FromConfig(const Config::Snapshot&);
+  };
+
+  GazeDwellFilter() = delete;
+  GazeDwellFilter(const Parameters&);
+
+  /* Returns the current fixation, if any.
+   *
+   * `gaze` should be `std::nullopt` if the gaze isn't currently valid, e.g.
+   * while blinking; the previous fixation is kept.
+   */
+  std::optional<XrVector2f> Update(
+    Time now,
+    const std::optional<XrVector2f>& gaze);
+  void Reset();
+
+ private:
+  Parameters mParameters;
+
+  struct Candidate {
+    Time mSince {};
+    XrVector2f mSum {};
+    uint32_t mCount {};
+
+    XrVector2f Mean() const;
+  };
+  std::optional<Candidate> mCandidate;
+  std::optional<XrVector2f> mFixation;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,109 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "HandTrackingGates.h"
+
+#include <directxtk/SimpleMath.h>
+
+#include <cmath>
+
+using namespace DirectX::SimpleMath;
+
+namespace HandTrackedCockpitClicking {
+
+HandTrackingGates::Parameters HandTrackingGates::Parameters::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+HandTrackingGates::Parameters HandTrackingGates::Parameters::FromConfig(
+  const Config::Snapshot& config) {
+  return {
+    .mWakeHFOV = config.HandTrackingWakeHFOV,
+    .mWakeVFOV = config.HandTrackingWakeVFOV,
+    .mActionHFOV = config.HandTrackingActionHFOV,
+    .mActionVFOV = config.HandTrackingActionVFOV,
+    .mHibernateCutoff = config.HandTrackingHibernateGestureEnabled
+      ? config.HandTrackingHibernateCutoff
+      : 0.0f,
+    .mOrientation = config.HandTrackingOrientation,
+  };
+}
+
+HandTrackingGates::HandTrackingGates(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+std::tuple<XrPosef, XrVector2f> HandTrackingGates::RaycastPose(
+  const FrameInfo& frameInfo,
+  const XrPosef& pose) {
+  const auto& p = (pose * frameInfo.mLocalInView).position;
+  const auto rx = std::atan2f(p.y, -p.z);
+  const auto ry = std::atan2f(p.x, -p.z);
+
+  const auto o = Quaternion::CreateFromAxisAngle(Vector3::UnitX, rx)
+    * Quaternion::CreateFromAxisAngle(Vector3::UnitY, -ry);
+  const XrPosef retView = {
+    {o.x, o.y, o.z, o.w},
+    pose.position,
+  };
+
+  return {
+    {
+      (retView * frameInfo.mViewInLocal).orientation,
+      pose.position,
+    },
+    {rx, ry},
+  };
+}
+
+HandWakeStateMachine::Input HandTrackingGates::GetWakeInput(
+  const FrameInfo& frameInfo,
+  const HandObservation& observation) const {
+  using Tracking = HandWakeStateMachine::Tracking;
+  if (observation.mTracking != Tracking::Tracked) {
+    return {.mTracking = observation.mTracking};
+  }
+
+  const auto rotation = std::get<1>(RaycastPose(frameInfo, observation.mPose));
+  const auto arx = std::abs(rotation.x);
+  const auto ary = std::abs(rotation.y);
+
+  const auto& p = mParameters;
+  return {
+    .mTracking = Tracking::Tracked,
+    .mInWakeFOV = arx <= (p.mWakeVFOV / 2) && ary <= (p.mWakeHFOV / 2),
+    .mInActionFOV = arx <= (p.mActionVFOV / 2) && ary <= (p.mActionHFOV / 2),
+    .mInHibernateGesture = p.mHibernateCutoff > 0.001
+      && rotation.x >= p.mHibernateCutoff
+      && observation.mPose.position.y > frameInfo.mViewInLocal.position.y,
+    .mRawActions = observation.mRawActions,
+  };
+}
+
+InputState HandTrackingGates::GetInputState(
+  XrHandEXT hand,
+  const FrameInfo& frameInfo,
+  const HandObservation& observation,
+  const ActionState& actions) const {
+  const auto [raycastPose, rotation]
+    = RaycastPose(frameInfo, observation.mPose);
+
+  InputState state {hand};
+  state.mPositionUpdatedAt = observation.mPositionUpdatedAt;
+  state.mActions = actions;
+  state.mDirection = {rotation};
+  switch (mParameters.mOrientation) {
+    case HandTrackingOrientation::Raw:
+      state.mPose = observation.mPose;
+      break;
+    case HandTrackingOrientation::RayCast:
+      state.mPose = raycastPose;
+      break;
+    case HandTrackingOrientation::RayCastWithReprojection:
+      // reproject from direction
+      state.mPose = {};
+      break;
+  }
+  return state;
+}
+
+}// namespace HandTrackedCockpitClicking
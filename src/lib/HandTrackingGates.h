@@ -0,0 +1,82 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <tuple>
+
+#include "Config.h"
+#include "FrameInfo.h"
+#include "HandWakeStateMachine.h"
+#include "InputState.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** What hand tracking saw for one hand in one frame.
+ *
+ * This is everything needed to repeat the per-frame decisions, so it's also
+ * what's recorded in session captures.
+ */
+struct HandObservation {
+  HandWakeStateMachine::Tracking mTracking {
+    HandWakeStateMachine::Tracking::Unavailable};
+  XrTime mPositionUpdatedAt {};
+  // In LOCAL space; only meaningful if tracked
+  XrPosef mPose {XR_POSEF_IDENTITY};
+  ActionState mRawActions {};
+  // When `mRawActions` were first seen, including any predicted pinch onset
+  // or sampled changes between frames
+  XrTime mRawActionsSince {};
+  // Between the thumb and index finger tips, in meters; negative if either
+  // isn't tracked
+  float mPinchDistance {-1.0f};
+};
+
+/** Per-frame decisions about a tracked hand.
+ *
+ * Maps an observation to the wake state machine's input - whether the hand
+ * is in the wake or action FOV, or making the hibernate gesture - then maps
+ * the machine's output back to the hand's `InputState`.
+ *
+ * This doesn't call the OpenXR runtime, so the same code is used by the API
+ * layer and by offline replay.
+ */
+class HandTrackingGates final {
+ public:
+  struct Parameters {
+    // Full angles, in radians
+    float mWakeHFOV {};
+    float mWakeVFOV {};
+    float mActionHFOV {};
+    float mActionVFOV {};
+    // Radians above the view; zero to disable the hibernate gesture
+    float mHibernateCutoff {};
+    HandTrackingOrientation mOrientation {HandTrackingOrientation::RayCast};
+
+    static Parameters FromConfig();
+    static Parameters FromConfig(const Config::Snapshot&);
+  };
+
+  HandTrackingGates() = delete;
+  explicit HandTrackingGates(const Parameters&);
+
+  HandWakeStateMachine::Input GetWakeInput(
+    const FrameInfo&,
+    const HandObservation&) const;
+
+  // The state of a tracked hand while it's active
+  InputState GetInputState(
+    XrHandEXT,
+    const FrameInfo&,
+    const HandObservation&,
+    const ActionState& actions) const;
+
+  // A pose from the view through `pose`, and its direction
+  static std::tuple<XrPosef, XrVector2f> RaycastPose(
+    const FrameInfo&,
+    const XrPosef& pose);
+
+ private:
+  Parameters mParameters;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,307 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "HandWakeStateMachine.h"
+
+#include "Config.h"
+
+namespace HandTrackedCockpitClicking {
+
+// Evaluated in order; the first matching transition for the current tracking
+// state is applied, even if it doesn't change the state, so that its timer
+// changes take effect.
+const std::array<HandWakeStateMachine::Transition, 4>
+  HandWakeStateMachine::Transitions {{
+    // Losing an awake hand for too long puts it to sleep, and abandons any
+    // gestures in progress
+    {
+      .mTracking = Tracking::Untracked,
+      .mFrom = State::Awake,
+      .mCondition = Condition::KeepAliveExpired,
+      .mTo = State::Sleeping,
+      .mClear = Bit(Timer::WakeConditions) | Bit(Timer::HibernateGesture),
+    },
+    // Any action immediately wakes the hand and keeps it awake, and cancels
+    // the hibernate gesture
+    {
+      .mTracking = Tracking::Tracked,
+      .mCondition = Condition::ActionsActive,
+      .mTo = State::Awake,
+      .mRestart = Bit(Timer::KeepAlive),
+      .mClear = Bit(Timer::HibernateGesture),
+    },
+    {
+      .mTracking = Tracking::Tracked,
+      .mCondition = Condition::WakeTimerElapsed,
+      .mTo = State::Awake,
+    },
+    {
+      .mTracking = Tracking::Tracked,
+      .mCondition = Condition::KeepAliveExpired,
+      .mTo = State::Sleeping,
+    },
+  }};
+
+HandWakeStateMachine::Timings HandWakeStateMachine::Timings::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+HandWakeStateMachine::Timings HandWakeStateMachine::Timings::FromConfig(
+  const Config::Snapshot& config) {
+  using std::chrono::milliseconds;
+  return {
+    .mWake = milliseconds(config.HandTrackingWakeMilliseconds),
+    .mSleep = milliseconds(config.HandTrackingSleepMilliseconds),
+    .mGesture = milliseconds(config.HandTrackingGestureMilliseconds),
+    .mHibernateGesture
+    = milliseconds(config.HandTrackingHibernateMilliseconds),
+    .mHibernateInterval
+    = milliseconds(config.HandTrackingHibernateIntervalMilliseconds),
+  };
+}
+
+HandWakeStateMachine::HandWakeStateMachine(const Timings& timings)
+  : mTimings(timings) {
+}
+
+void HandWakeStateMachine::SetTimings(const Timings& timings) {
+  mTimings = timings;
+}
+
+HandWakeStateMachine::Output
+HandWakeStateMachine::Step(Hand which, Time now, const Input& input) {
+  auto& hand = Get(which);
+  const auto previousState = hand.mState;
+
+  Output out {};
+
+  switch (input.mTracking) {
+    case Tracking::Unavailable:
+      hand.mActions = {};
+      return out;
+    case Tracking::Untracked:
+      hand.mActions = {};
+      hand.mInActionFOV = false;
+      ApplyTransitions(&hand, input.mTracking, now);
+      break;
+    case Tracking::Tracked:
+      if (input.mInWakeFOV) {
+        Start(&hand, Timer::WakeConditions, now);
+      } else {
+        Clear(&hand, Timer::WakeConditions);
+      }
+      hand.mInActionFOV = input.mInActionFOV;
+      if (input.mInActionFOV) {
+        Restart(&hand, Timer::KeepAlive, now);
+      }
+      FilterActions(&hand, input, now);
+
+      if (
+        input.mInHibernateGesture && mTimings.mHibernateInterval.count()
+        && (now - mLastHibernationChangeAt) >= mTimings.mHibernateInterval) {
+        Start(&hand, Timer::HibernateGesture, now);
+      } else {
+        Clear(&hand, Timer::HibernateGesture);
+      }
+
+      ApplyTransitions(&hand, input.mTracking, now);
+      break;
+  }
+
+  if (hand.mState != previousState) {
+    out.mHandEvent
+      = (hand.mState == State::Sleeping) ? Event::Sleep : Event::Wake;
+  }
+
+  if (input.mTracking == Tracking::Tracked) {
+    out.mHibernationEvent = UpdateHibernation(&hand, now);
+  }
+
+  out.mActive = (hand.mState == State::Awake) && !mHibernating;
+  if (!out.mActive) {
+    hand.mActions = {};
+  }
+  out.mActions = hand.mActions;
+  return out;
+}
+
+void HandWakeStateMachine::KeepAlive(Hand which, Time now) {
+  Restart(&Get(which), Timer::KeepAlive, now);
+}
+
+bool HandWakeStateMachine::ObserveRawActions(
+  Hand which,
+  const ActionState& actions,
+  Time at) {
+  return ObserveRawActions(&Get(which), actions, at);
+}
+
+bool HandWakeStateMachine::ObserveRawActions(
+  HandState* hand,
+  const ActionState& actions,
+  Time at) {
+  if (actions == hand->mRawActions) {
+    return false;
+  }
+  hand->mRawActions = actions;
+  Restart(hand, Timer::RawActions, at);
+  return true;
+}
+
+HandWakeStateMachine::State HandWakeStateMachine::GetState(Hand which) const {
+  return Get(which).mState;
+}
+
+HandWakeStateMachine::Time HandWakeStateMachine::GetRawActionsSince(
+  Hand which) const {
+  return Get(which).mTimers.at(static_cast<std::size_t>(Timer::RawActions));
+}
+
+bool HandWakeStateMachine::IsHibernating() const {
+  return mHibernating;
+}
+
+bool HandWakeStateMachine::IsIdle(Hand which) const {
+  const auto& hand = Get(which);
+  // Whether asleep or hibernating, the hibernate gesture needs every frame,
+  // or its timing is quantized to the idle poll interval
+  if (IsSet(hand, Timer::HibernateGesture)) {
+    return false;
+  }
+  // Likewise for pinches: a hand in the action FOV can pinch to wake without
+  // ever being in the wake FOV, and a raw action may be about to complete its
+  // debounce. Only hands that aren't in use are throttled.
+  if (hand.mInActionFOV || hand.mRawActions.Any()) {
+    return false;
+  }
+  if (mHibernating) {
+    return true;
+  }
+  return hand.mState == State::Sleeping
+    && !IsSet(hand, Timer::WakeConditions);
+}
+
+HandWakeStateMachine::HandState& HandWakeStateMachine::Get(Hand which) {
+  return mHands.at(static_cast<std::size_t>(which));
+}
+
+const HandWakeStateMachine::HandState& HandWakeStateMachine::Get(
+  Hand which) const {
+  return mHands.at(static_cast<std::size_t>(which));
+}
+
+bool HandWakeStateMachine::Evaluate(
+  const HandState& hand,
+  Condition condition,
+  Time now) const {
+  switch (condition) {
+    case Condition::ActionsActive:
+      return hand.mActions.Any();
+    case Condition::WakeTimerElapsed:
+      return Elapsed(hand, Timer::WakeConditions, now, mTimings.mWake);
+    case Condition::KeepAliveExpired:
+      return Elapsed(hand, Timer::KeepAlive, now, mTimings.mSleep);
+  }
+  return false;
+}
+
+void HandWakeStateMachine::ApplyTransitions(
+  HandState* hand,
+  Tracking tracking,
+  Time now) {
+  for (const auto& transition: Transitions) {
+    if (transition.mTracking != tracking) {
+      continue;
+    }
+    if (transition.mFrom && *transition.mFrom != hand->mState) {
+      continue;
+    }
+    if (!Evaluate(*hand, transition.mCondition, now)) {
+      continue;
+    }
+
+    for (std::size_t i = 0; i < TimerCount; ++i) {
+      const auto timer = static_cast<Timer>(i);
+      if (transition.mRestart & Bit(timer)) {
+        Restart(hand, timer, now);
+      }
+      if (transition.mClear & Bit(timer)) {
+        Clear(hand, timer);
+      }
+    }
+    hand->mState = transition.mTo;
+    return;
+  }
+}
+
+void HandWakeStateMachine::FilterActions(
+  HandState* hand,
+  const Input& input,
+  Time now) {
+  if (ObserveRawActions(hand, input.mRawActions, now)) {
+    return;
+  }
+  if (!Elapsed(*hand, Timer::RawActions, now, mTimings.mGesture)) {
+    return;
+  }
+
+  const auto& raw = input.mRawActions;
+  auto& actions = hand->mActions;
+  // Clicks can only start inside the action FOV, but can continue outside it,
+  // e.g. for drags
+  actions.mPrimary = raw.mPrimary && (actions.mPrimary || input.mInActionFOV);
+  actions.mSecondary
+    = raw.mSecondary && (actions.mSecondary || input.mInActionFOV);
+
+  if (input.mInActionFOV || (raw.mValueChange == actions.mValueChange)) {
+    actions.mValueChange = raw.mValueChange;
+  } else {
+    actions.mValueChange = ActionState::ValueChange::None;
+  }
+}
+
+std::optional<HandWakeStateMachine::Event>
+HandWakeStateMachine::UpdateHibernation(HandState* hand, Time now) {
+  if (!mTimings.mHibernateGesture.count()) {
+    return {};
+  }
+  if (!Elapsed(
+        *hand, Timer::HibernateGesture, now, mTimings.mHibernateGesture)) {
+    return {};
+  }
+
+  Clear(hand, Timer::HibernateGesture);
+  mLastHibernationChangeAt = now;
+  mHibernating = !mHibernating;
+  return mHibernating ? Event::HibernateSleep : Event::HibernateWake;
+}
+
+bool HandWakeStateMachine::IsSet(const HandState& hand, Timer timer) {
+  return hand.mTimers.at(static_cast<std::size_t>(timer)) != Time::zero();
+}
+
+bool HandWakeStateMachine::Elapsed(
+  const HandState& hand,
+  Timer timer,
+  Time now,
+  std::chrono::milliseconds duration) {
+  if (!IsSet(hand, timer)) {
+    return false;
+  }
+  return (now - hand.mTimers.at(static_cast<std::size_t>(timer))) >= duration;
+}
+
+void HandWakeStateMachine::Start(HandState* hand, Timer timer, Time now) {
+  if (!IsSet(*hand, timer)) {
+    Restart(hand, timer, now);
+  }
+}
+
+void HandWakeStateMachine::Restart(HandState* hand, Timer timer, Time now) {
+  hand->mTimers.at(static_cast<std::size_t>(timer)) = now;
+}
+
+void HandWakeStateMachine::Clear(HandState* hand, Timer timer) {
+  hand->mTimers.at(static_cast<std::size_t>(timer)) = {};
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,178 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <optional>
+
+#include "ActionState.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace Config {
+struct Snapshot;
+}
+
+/** Decides when tracked hands are awake, asleep, or hibernating, and
+ * debounces their actions.
+ *
+ * This has no OpenXR dependency: callers reduce each frame to an `Input` of
+ * booleans plus a timestamp, so traces can be replayed through it directly.
+ *
+ * Each hand is either `Awake` or `Sleeping`; hibernation is shared between
+ * both hands. Changes are driven by a fixed transition table, evaluated
+ * against a small set of per-hand timers.
+ */
+class HandWakeStateMachine final {
+ public:
+  // Nanoseconds since an arbitrary epoch; zero means 'never'
+  using Time = std::chrono::nanoseconds;
+
+  enum class Hand {
+    Left,
+    Right,
+  };
+
+  enum class State {
+    Awake,
+    Sleeping,
+  };
+
+  enum class Tracking {
+    // No usable data this frame; clears actions, but otherwise ignored
+    Unavailable,
+    // The runtime says the hand isn't visible
+    Untracked,
+    Tracked,
+  };
+
+  enum class Event {
+    Wake,
+    Sleep,
+    HibernateWake,
+    HibernateSleep,
+  };
+
+  struct Timings {
+    // How long wake conditions must hold before waking
+    std::chrono::milliseconds mWake {};
+    // How long without keep-alives before sleeping
+    std::chrono::milliseconds mSleep {};
+    // How long raw actions must be stable before they're used
+    std::chrono::milliseconds mGesture {};
+    // How long the hibernate gesture must be held; zero to disable
+    std::chrono::milliseconds mHibernateGesture {};
+    // Minimum time between hibernation changes; zero to disable
+    std::chrono::milliseconds mHibernateInterval {};
+
+    static Timings FromConfig();
+    static Timings FromConfig(const Config::Snapshot&);
+  };
+
+  struct Input {
+    Tracking mTracking {Tracking::Unavailable};
+    bool mInWakeFOV {false};
+    bool mInActionFOV {false};
+    bool mInHibernateGesture {false};
+    ActionState mRawActions {};
+  };
+
+  struct Output {
+    // False if the hand is sleeping or hibernating
+    bool mActive {false};
+    ActionState mActions {};
+
+    std::optional<Event> mHandEvent;
+    std::optional<Event> mHibernationEvent;
+  };
+
+  HandWakeStateMachine() = delete;
+  HandWakeStateMachine(const Timings&);
+
+  void SetTimings(const Timings&);
+
+  Output Step(Hand, Time now, const Input&);
+
+  // Extend the time before the hand falls asleep
+  void KeepAlive(Hand, Time now);
+  /* Record raw actions seen between steps.
+   *
+   * Returns true if they differ from the previous raw actions, in which case
+   * the debounce period restarts from `at`.
+   */
+  bool ObserveRawActions(Hand, const ActionState&, Time at);
+
+  State GetState(Hand) const;
+  // When the current raw actions were first seen; zero if never
+  Time GetRawActionsSince(Hand) const;
+  bool IsHibernating() const;
+  // True if nothing is likely to change until the hand moves into position to
+  // wake, or to toggle hibernation
+  bool IsIdle(Hand) const;
+
+ private:
+  enum class Timer {
+    WakeConditions,
+    KeepAlive,
+    HibernateGesture,
+    RawActions,
+  };
+  static constexpr std::size_t TimerCount = 4;
+
+  enum class Condition {
+    ActionsActive,
+    WakeTimerElapsed,
+    KeepAliveExpired,
+  };
+
+  using TimerMask = uint8_t;
+  static constexpr TimerMask Bit(Timer timer) {
+    return 1 << static_cast<std::size_t>(timer);
+  }
+
+  struct Transition {
+    Tracking mTracking;
+    std::optional<State> mFrom;
+    Condition mCondition;
+    State mTo;
+    TimerMask mRestart {};
+    TimerMask mClear {};
+  };
+  static const std::array<Transition, 4> Transitions;
+
+  struct HandState {
+    State mState {State::Sleeping};
+    std::array<Time, TimerCount> mTimers {};
+    ActionState mRawActions {};
+    ActionState mActions {};
+    // As of the last step where it was tracked or untracked
+    bool mInActionFOV {false};
+  };
+
+  Timings mTimings;
+  std::array<HandState, 2> mHands {};
+
+  bool mHibernating {false};
+  Time mLastHibernationChangeAt {};
+
+  HandState& Get(Hand);
+  const HandState& Get(Hand) const;
+
+  bool Evaluate(const HandState&, Condition, Time now) const;
+  void ApplyTransitions(HandState*, Tracking, Time now);
+  void FilterActions(HandState*, const Input&, Time now);
+  std::optional<Event> UpdateHibernation(HandState*, Time now);
+
+  static bool ObserveRawActions(HandState*, const ActionState&, Time at);
+
+  static bool IsSet(const HandState&, Timer);
+  static bool
+  Elapsed(const HandState&, Timer, Time now, std::chrono::milliseconds);
+  static void Start(HandState*, Timer, Time now);
+  static void Restart(HandState*, Timer, Time now);
+  static void Clear(HandState*, Timer);
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,188 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cinttypes>
+#include <mutex>
+
+namespace HandTrackedCockpitClicking {
+
+/** Fixed-capacity map from an OpenXR handle to state, for per-call dispatch.
+ *
+ * `Find()` is lock-free and allocation-free, so it's cheap enough to use for
+ * every intercepted call; `Insert()` and `Erase()` are serialized with a
+ * mutex, as they're only used when handles are created or destroyed.
+ *
+ * Values are not owned. As with OpenXR itself, a handle must not be destroyed
+ * while another thread is still using it, so a value must outlive any
+ * `Find()` that could return it.
+ */
+template <class THandle, class T, std::size_t Capacity>
+class HandleMap final {
+  static_assert(
+    (Capacity & (Capacity - 1)) == 0,
+    "Capacity must be a power of two");
+  static_assert(sizeof(THandle) == sizeof(uint64_t));
+
+ public:
+  T* Find(THandle handle) const noexcept {
+    const auto key = ToKey(handle);
+    const auto hash = Hash(key);
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      const auto& slot = mSlots[(hash + i) % Capacity];
+      const auto slotKey = slot.mKey.load(std::memory_order_acquire);
+      if (slotKey == Empty) {
+        return nullptr;
+      }
+      if (slotKey != key) {
+        continue;
+      }
+      const auto value = slot.mValue.load(std::memory_order_acquire);
+      // If the slot was erased and reused since we read the key, the value
+      // is for a different handle
+      if (slot.mKey.load(std::memory_order_acquire) != key) {
+        return nullptr;
+      }
+      return value;
+    }
+    return nullptr;
+  }
+
+  // Returns false if the handle is already present, or the map is full
+  bool Insert(THandle handle, T* value) {
+    const auto key = ToKey(handle);
+    if (key == Empty || key == Tombstone || !value) {
+      return false;
+    }
+
+    std::unique_lock lock(mMutex);
+    const auto hash = Hash(key);
+    Slot* target {nullptr};
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      auto& slot = mSlots[(hash + i) % Capacity];
+      const auto slotKey = slot.mKey.load(std::memory_order_relaxed);
+      if (slotKey == key) {
+        return false;
+      }
+      if (slotKey == Tombstone && !target) {
+        target = &slot;
+        continue;
+      }
+      if (slotKey == Empty) {
+        if (!target) {
+          target = &slot;
+        }
+        break;
+      }
+    }
+    if (!target) {
+      return false;
+    }
+    target->mValue.store(value, std::memory_order_release);
+    target->mKey.store(key, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the removed value, or nullptr if the handle wasn't present
+  T* Erase(THandle handle) {
+    const auto key = ToKey(handle);
+    std::unique_lock lock(mMutex);
+    const auto hash = Hash(key);
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      const auto index = (hash + i) % Capacity;
+      const auto slotKey = mSlots[index].mKey.load(std::memory_order_relaxed);
+      if (slotKey == Empty) {
+        return nullptr;
+      }
+      if (slotKey == key) {
+        return EraseSlot(index);
+      }
+    }
+    return nullptr;
+  }
+
+  // Erases every handle whose value matches `pred`
+  template <class F>
+  void EraseIf(F&& pred) {
+    std::unique_lock lock(mMutex);
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      const auto& slot = mSlots[i];
+      const auto slotKey = slot.mKey.load(std::memory_order_relaxed);
+      if (slotKey == Empty || slotKey == Tombstone) {
+        continue;
+      }
+      if (pred(slot.mValue.load(std::memory_order_relaxed))) {
+        EraseSlot(i);
+      }
+    }
+  }
+
+  // Lock-free; entries inserted or erased concurrently may or may not be seen
+  template <class F>
+  void ForEach(F&& f) const {
+    for (const auto& slot: mSlots) {
+      const auto slotKey = slot.mKey.load(std::memory_order_acquire);
+      if (slotKey == Empty || slotKey == Tombstone) {
+        continue;
+      }
+      const auto value = slot.mValue.load(std::memory_order_acquire);
+      if (value) {
+        f(std::bit_cast<THandle>(slotKey), value);
+      }
+    }
+  }
+
+ private:
+  // XR_NULL_HANDLE is never a valid handle, so can mark unused slots
+  static constexpr uint64_t Empty {0};
+  // Erased slots; lookups must keep probing past these
+  static constexpr uint64_t Tombstone {~uint64_t {0}};
+
+  struct Slot {
+    std::atomic<uint64_t> mKey {Empty};
+    std::atomic<T*> mValue {nullptr};
+  };
+
+  static uint64_t ToKey(THandle handle) noexcept {
+    return std::bit_cast<uint64_t>(handle);
+  }
+
+  // Handles are often pointers or counters, so mix the bits before using
+  // them as an index (splitmix64 finalizer)
+  static std::size_t Hash(uint64_t key) noexcept {
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<std::size_t>(key ^ (key >> 31));
+  }
+
+  T* EraseSlot(std::size_t index) {
+    auto& slot = mSlots[index];
+    const auto value = slot.mValue.load(std::memory_order_relaxed);
+    slot.mValue.store(nullptr, std::memory_order_release);
+    slot.mKey.store(Tombstone, std::memory_order_release);
+
+    // If the next slot is empty, lookups never need to probe past this one,
+    // so it and any tombstones before it can be emptied; otherwise churn
+    // would gradually make every lookup a full scan
+    const auto next = (index + 1) % Capacity;
+    if (mSlots[next].mKey.load(std::memory_order_relaxed) != Empty) {
+      return value;
+    }
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      auto& it = mSlots[(index + Capacity - i) % Capacity];
+      if (it.mKey.load(std::memory_order_relaxed) != Tombstone) {
+        break;
+      }
+      it.mKey.store(Empty, std::memory_order_release);
+    }
+    return value;
+  }
+
+  std::array<Slot, Capacity> mSlots {};
+  std::mutex mMutex;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,192 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "HotspotIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "DebugPrint.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+constexpr uint32_t LeafSize = 8;
+// The tree is balanced and indexed with uint32_t, so this is plenty
+constexpr std::size_t MaxDepth = 64;
+
+// Angle between the ray and `point`, or nullopt if the point is at the origin
+std::optional<float> AngleTo(
+  const HotspotIndex::Vector3& origin,
+  const HotspotIndex::Vector3& direction,
+  const HotspotIndex::Vector3& point) {
+  const auto offset = point - origin;
+  const auto distance = offset.Length();
+  if (distance < 1e-6f) {
+    return std::nullopt;
+  }
+  return std::acos(
+    std::clamp(offset.Dot(direction) / distance, -1.0f, 1.0f));
+}
+}// namespace
+
+HotspotIndex::HotspotIndex(std::vector<Vector3> hotspots)
+  : mHotspots(std::move(hotspots)) {
+  if (mHotspots.empty()) {
+    return;
+  }
+  mNodes.reserve((2 * mHotspots.size()) / LeafSize + 1);
+  this->Build(0, static_cast<uint32_t>(mHotspots.size()));
+}
+
+std::optional<HotspotIndex> HotspotIndex::Load(
+  const std::filesystem::path& path) {
+  std::ifstream f(path);
+  if (!f) {
+    DebugPrint(L"Failed to open hotspot file `{}`", path.wstring());
+    return std::nullopt;
+  }
+
+  std::vector<Vector3> hotspots;
+  std::string line;
+  std::size_t lineNumber = 0;
+  while (std::getline(f, line)) {
+    ++lineNumber;
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    std::istringstream ss(line);
+    Vector3 point;
+    if (!(ss >> point.x >> point.y >> point.z)) {
+      DebugPrint(
+        L"Ignoring invalid line {} in hotspot file `{}`",
+        lineNumber,
+        path.wstring());
+      continue;
+    }
+    hotspots.push_back(point);
+  }
+
+  DebugPrint(
+    L"Loaded {} hotspots from `{}`", hotspots.size(), path.wstring());
+  return HotspotIndex {std::move(hotspots)};
+}
+
+std::size_t HotspotIndex::size() const {
+  return mHotspots.size();
+}
+
+uint32_t HotspotIndex::Build(uint32_t begin, uint32_t end) {
+  const auto index = static_cast<uint32_t>(mNodes.size());
+  mNodes.push_back({});
+
+  const auto first = mHotspots.begin() + begin;
+  const auto last = mHotspots.begin() + end;
+
+  Vector3 min {first->x, first->y, first->z};
+  Vector3 max = min;
+  for (auto it = first; it != last; ++it) {
+    min = Vector3::Min(min, *it);
+    max = Vector3::Max(max, *it);
+  }
+  const auto center = (min + max) / 2;
+  float radius {};
+  for (auto it = first; it != last; ++it) {
+    radius = std::max(radius, Vector3::Distance(center, *it));
+  }
+
+  Node node {
+    .mCenter = center,
+    .mRadius = radius,
+    .mBegin = begin,
+    .mEnd = end,
+  };
+
+  if (end - begin > LeafSize) {
+    // Split at the median of the longest axis
+    const auto extent = max - min;
+    float Vector3::* axis = &Vector3::x;
+    if (extent.y > extent.x && extent.y >= extent.z) {
+      axis = &Vector3::y;
+    } else if (extent.z > extent.x && extent.z > extent.y) {
+      axis = &Vector3::z;
+    }
+    const auto mid = begin + ((end - begin) / 2);
+    std::nth_element(
+      first,
+      mHotspots.begin() + mid,
+      last,
+      [axis](const Vector3& a, const Vector3& b) {
+        return a.*axis < b.*axis;
+      });
+    node.mLeft = this->Build(begin, mid);
+    node.mRight = this->Build(mid, end);
+  }
+
+  mNodes.at(index) = node;
+  return index;
+}
+
+std::optional<HotspotIndex::Hit> HotspotIndex::FindNearest(
+  const Vector3& origin,
+  const Vector3& direction,
+  float maxAngle) const {
+  if (mNodes.empty()) {
+    return std::nullopt;
+  }
+
+  std::optional<Hit> best;
+  auto bestAngle = maxAngle;
+
+  // Smallest possible angle between the ray and any point in the node
+  const auto minAngle = [&](const Node& node) {
+    const auto distance = Vector3::Distance(origin, node.mCenter);
+    if (distance <= node.mRadius) {
+      return 0.0f;
+    }
+    // No angle if the origin is (almost) at the center, even if the node is
+    // smaller than that, e.g. a single zero-radius hotspot; never skip it
+    const auto toCenter = AngleTo(origin, direction, node.mCenter);
+    if (!toCenter) {
+      return 0.0f;
+    }
+    return *toCenter - std::asin(node.mRadius / distance);
+  };
+
+  std::array<uint32_t, MaxDepth> stack {0};
+  std::size_t depth = 1;
+  while (depth > 0) {
+    const auto& node = mNodes[stack[--depth]];
+    if (minAngle(node) > bestAngle) {
+      continue;
+    }
+
+    if (!node.mLeft) {
+      for (auto i = node.mBegin; i < node.mEnd; ++i) {
+        const auto angle = AngleTo(origin, direction, mHotspots[i]);
+        if (angle && *angle <= bestAngle) {
+          bestAngle = *angle;
+          best = Hit {mHotspots[i], *angle};
+        }
+      }
+      continue;
+    }
+
+    // Push the further child first, so the closer one is searched first and
+    // tightens `bestAngle` sooner
+    auto closer = node.mLeft;
+    auto further = node.mRight;
+    if (minAngle(mNodes[further]) < minAngle(mNodes[closer])) {
+      std::swap(closer, further);
+    }
+    stack[depth++] = further;
+    stack[depth++] = closer;
+  }
+
+  return best;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,65 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <directxtk/SimpleMath.h>
+
+#include <cinttypes>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace HandTrackedCockpitClicking {
+
+/** A set of points that pointer rays can snap to.
+ *
+ * Points are stored in a bounding volume hierarchy of spheres, so a query
+ * only needs to look at the few points near the ray, rather than all of them.
+ */
+class HotspotIndex final {
+ public:
+  using Vector3 = DirectX::SimpleMath::Vector3;
+
+  HotspotIndex() = delete;
+  HotspotIndex(std::vector<Vector3> hotspots);
+
+  /* Load whitespace-separated `x y z` lines, in meters in LOCAL space.
+   *
+   * Blank lines, and lines starting with `#`, are ignored.
+   */
+  static std::optional<HotspotIndex> Load(const std::filesystem::path&);
+
+  struct Hit {
+    Vector3 mPosition;
+    // Angle between the ray and the hotspot, in radians
+    float mAngle;
+  };
+
+  // Find the hotspot closest to the ray, by angle, within `maxAngle` radians.
+  // `direction` must be normalized.
+  std::optional<Hit> FindNearest(
+    const Vector3& origin,
+    const Vector3& direction,
+    float maxAngle) const;
+
+  std::size_t size() const;
+
+ private:
+  struct Node {
+    Vector3 mCenter {};
+    float mRadius {};
+    // Range in mHotspots, if this is a leaf
+    uint32_t mBegin {};
+    uint32_t mEnd {};
+    // Zero for leaves; the root is never a child
+    uint32_t mLeft {};
+    uint32_t mRight {};
+  };
+
+  std::vector<Vector3> mHotspots;
+  std::vector<Node> mNodes;
+
+  uint32_t Build(uint32_t begin, uint32_t end);
+};
+
+}// namespace HandTrackedCockpitClicking
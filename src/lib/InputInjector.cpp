@@ -0,0 +1,42 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "InputInjector.h"
+
+#include <utility>
+
+#include "Clock.h"
+
+namespace HandTrackedCockpitClicking {
+
+void SendInputInjector::Inject(std::span<const INPUT> events) {
+  if (events.empty()) {
+    return;
+  }
+  // SendInput() takes a non-const pointer, but doesn't modify the events
+  SendInput(
+    static_cast<UINT>(events.size()),
+    const_cast<INPUT*>(events.data()),
+    sizeof(INPUT));
+}
+
+RecordingInputInjector::RecordingInputInjector(
+  const std::shared_ptr<const Clock>& clock)
+  : mClock(clock) {
+}
+
+void RecordingInputInjector::Inject(std::span<const INPUT> events) {
+  const auto now = mClock->Now();
+  std::unique_lock lock(mMutex);
+  const auto batch = mBatchCount++;
+  for (const auto& event: events) {
+    mEvents.push_back({now, batch, event});
+  }
+}
+
+std::vector<RecordingInputInjector::Event>
+RecordingInputInjector::TakeEvents() {
+  std::unique_lock lock(mMutex);
+  return std::exchange(mEvents, {});
+}
+
+}// namespace HandTrackedCockpitClicking
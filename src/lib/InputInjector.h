@@ -0,0 +1,60 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <Windows.h>
+#include <openxr/openxr.h>
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace HandTrackedCockpitClicking {
+
+class Clock;
+
+// Where VirtualTouchScreenSink sends mouse events
+class InputInjector {
+ public:
+  virtual ~InputInjector() = default;
+
+  // `events` are sent as a single batch, in order
+  virtual void Inject(std::span<const INPUT> events) = 0;
+};
+
+// Sends events to the system with `SendInput()`
+class SendInputInjector final : public InputInjector {
+ public:
+  void Inject(std::span<const INPUT> events) override;
+};
+
+/** Keeps events instead of sending them.
+ *
+ * Useful for checking what would have been sent, and when; with a
+ * `VirtualClock`, the times are deterministic.
+ */
+class RecordingInputInjector final : public InputInjector {
+ public:
+  struct Event {
+    XrTime mTime {};
+    // Events with the same batch number were sent together
+    std::size_t mBatch {};
+    INPUT mInput {};
+  };
+
+  explicit RecordingInputInjector(const std::shared_ptr<const Clock>&);
+
+  void Inject(std::span<const INPUT> events) override;
+
+  // Returns and clears the recorded events
+  std::vector<Event> TakeEvents();
+
+ private:
+  std::shared_ptr<const Clock> mClock;
+  std::mutex mMutex;
+  std::vector<Event> mEvents;
+  std::size_t mBatchCount {};
+};
+
+}// namespace HandTrackedCockpitClicking
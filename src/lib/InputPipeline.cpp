@@ -0,0 +1,67 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "InputPipeline.h"
+
+#include "DebugPrint.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+const InputPipeline::Hands EmptyHands {
+  InputState {XR_HAND_LEFT_EXT},
+  InputState {XR_HAND_RIGHT_EXT},
+};
+}
+
+InputPipeline::~InputPipeline() {
+  for (const auto& timing: mTimings) {
+    if (!timing.mCount) {
+      continue;
+    }
+    DebugPrint(
+      "Input pipeline stage '{}': {} frames, average {}",
+      timing.mName,
+      timing.mCount,
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        timing.mTotal / timing.mCount));
+  }
+}
+
+void InputPipeline::AddStage(std::unique_ptr<Stage> stage) {
+  DebugPrint("Adding input pipeline stage '{}'", stage->GetName());
+  mTimings.push_back({.mName = stage->GetName()});
+  mStages.push_back(std::move(stage));
+  mBuffers.resize(mStages.size() + 1, EmptyHands);
+}
+
+void InputPipeline::Run(const FrameInfo& frameInfo) {
+  using clock = std::chrono::steady_clock;
+
+  for (std::size_t i = 0; i < mStages.size(); ++i) {
+    auto& hands = mBuffers[i + 1];
+    hands = mBuffers[i];
+
+    const auto start = clock::now();
+    mStages[i]->Process(frameInfo, &hands);
+    const auto elapsed = clock::now() - start;
+
+    auto& timing = mTimings[i];
+    timing.mLast = elapsed;
+    timing.mTotal += elapsed;
+    ++timing.mCount;
+  }
+}
+
+std::size_t InputPipeline::GetStageCount() const {
+  return mStages.size();
+}
+
+const InputPipeline::Hands& InputPipeline::GetOutput(std::size_t index) const {
+  return mBuffers.at(index + 1);
+}
+
+std::span<const InputPipeline::StageTiming> InputPipeline::GetTimings() const {
+  return mTimings;
+}
+
+}// namespace HandTrackedCockpitClicking
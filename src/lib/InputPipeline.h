@@ -0,0 +1,65 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "FrameInfo.h"
+#include "InputState.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** A fixed sequence of stages that turn inputs into outputs each frame.
+ *
+ * Sources fill in the hands, filters modify them, and sinks consume them;
+ * they're all just stages, run in the order they were added.
+ *
+ * The pipeline is built once per session with only the stages the current
+ * configuration needs, so disabled features cost nothing per frame.
+ */
+class InputPipeline final {
+ public:
+  // Left, right
+  using Hands = std::array<InputState, 2>;
+
+  class Stage {
+   public:
+    virtual ~Stage() = default;
+    virtual std::string_view GetName() const = 0;
+    // `hands` starts as a copy of the previous stage's output
+    virtual void Process(const FrameInfo&, Hands* hands) = 0;
+  };
+
+  struct StageTiming {
+    std::string_view mName;
+    std::chrono::nanoseconds mLast {};
+    std::chrono::nanoseconds mTotal {};
+    uint64_t mCount {};
+  };
+
+  InputPipeline() = default;
+  ~InputPipeline();
+
+  void AddStage(std::unique_ptr<Stage>);
+
+  void Run(const FrameInfo&);
+
+  std::size_t GetStageCount() const;
+
+  // Output of stage `index`, as of the most recent `Run()`
+  const Hands& GetOutput(std::size_t index) const;
+  std::span<const StageTiming> GetTimings() const;
+
+ private:
+  std::vector<std::unique_ptr<Stage>> mStages;
+  // mBuffers[0] is the empty input; mBuffers[i + 1] is stage i's output
+  std::vector<Hands> mBuffers;
+  std::vector<StageTiming> mTimings;
+};
+
+}// namespace HandTrackedCockpitClicking
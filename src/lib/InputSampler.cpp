@@ -0,0 +1,83 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "InputSampler.h"
+
+#include <wil/resource.h>
+
+#include <algorithm>
+
+#include "Clock.h"
+#include "DebugPrint.h"
+#include "InputSource.h"
+
+namespace HandTrackedCockpitClicking {
+
+InputSampler::InputSampler(
+  const std::shared_ptr<const Clock>& clock,
+  uint16_t sampleRateHz,
+  std::vector<InputSource*> sources)
+  : mClock(clock),
+    mInterval(
+      std::chrono::nanoseconds(std::chrono::seconds(1))
+      / std::clamp<uint16_t>(sampleRateHz, 1, 2000)),
+    mSources(std::move(sources)) {
+  DebugPrint(
+    "Starting input sampler at {}Hz for {} sources",
+    std::chrono::seconds(1) / mInterval,
+    mSources.size());
+  for (auto source: mSources) {
+    source->SetSampling(true);
+  }
+  mThread = std::jthread {std::bind_front(&InputSampler::Run, this)};
+}
+
+InputSampler::~InputSampler() {
+  mThread.request_stop();
+  mThread.join();
+  for (auto source: mSources) {
+    source->SetSampling(false);
+  }
+  DebugPrint("Stopped input sampler");
+}
+
+void InputSampler::Run(std::stop_token stopToken) {
+  SetThreadDescription(GetCurrentThread(), L"HTCC Input Sampler");
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+  // Regular timers have ~15ms resolution, which is worse than most games'
+  // frame intervals
+  wil::unique_handle timer {CreateWaitableTimerExW(
+    nullptr,
+    nullptr,
+    CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+    TIMER_ALL_ACCESS)};
+  if (!timer) {
+    DebugPrint(
+      "Failed to create high-resolution timer for input sampler: {:#x}",
+      GetLastError());
+    return;
+  }
+
+  // In 100ns units; negative means relative
+  const LARGE_INTEGER dueTime {
+    .QuadPart = -std::max<LONGLONG>(1, mInterval.count() / 100),
+  };
+
+  while (!stopToken.stop_requested()) {
+    if (!SetWaitableTimer(timer.get(), &dueTime, 0, nullptr, nullptr, FALSE)) {
+      DebugPrint("Failed to arm input sampler timer: {:#x}", GetLastError());
+      return;
+    }
+    WaitForSingleObject(timer.get(), INFINITE);
+    if (stopToken.stop_requested()) {
+      return;
+    }
+
+    const auto now = mClock->Now();
+    for (auto source: mSources) {
+      source->Sample(now);
+    }
+  }
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,41 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace HandTrackedCockpitClicking {
+
+class Clock;
+class InputSource;
+
+/** Polls input sources at a fixed rate, independently of the game's frame
+ * rate.
+ *
+ * Without this, inputs are only read once per `xrWaitFrame()`, so button and
+ * pinch edges are quantized to the frame interval.
+ */
+class InputSampler final {
+ public:
+  InputSampler(
+    const std::shared_ptr<const Clock>& clock,
+    uint16_t sampleRateHz,
+    std::vector<InputSource*> sources);
+  ~InputSampler();
+
+ private:
+  std::shared_ptr<const Clock> mClock;
+  std::chrono::nanoseconds mInterval {};
+  std::vector<InputSource*> mSources;
+
+  std::jthread mThread;
+
+  void Run(std::stop_token);
+};
+
+}// namespace HandTrackedCockpitClicking
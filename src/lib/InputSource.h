@@ -11,5 +11,21 @@ class InputSource {
  public:
   virtual std::tuple<InputState, InputState>
   Update(PointerMode pointerMode, const FrameInfo& info) = 0;
+
+  /** Called from the `InputSampler` thread, if enabled.
+   *
+   * Sources that support this should queue the raw input, then consume the
+   * queue in `Update()`.
+   */
+  virtual void Sample(XrTime now) {
+  }
+
+  /** Called by the `InputSampler` before its first `Sample()`, and after its
+   * thread has stopped.
+   *
+   * While this is false, `Update()` must read the input itself.
+   */
+  virtual void SetSampling(bool sampling) {
+  }
 };
 }// namespace HandTrackedCockpitClicking
@@ -3,29 +3,12 @@
 #pragma once
 #include <optional>
 
+#include "ActionState.h"
 #include "PointerMode.h"
 #include "openxr.h"
 
 namespace HandTrackedCockpitClicking {
 
-struct ActionState {
-  bool mPrimary {false};// 'left click'
-  bool mSecondary {false};// 'right click'
-
-  enum class ValueChange {
-    None,
-    Decrease,// scroll wheel up
-    Increase,// scroll wheel down
-  };
-  ValueChange mValueChange {ValueChange::None};
-
-  constexpr bool Any() const {
-    return mPrimary || mSecondary || (mValueChange != ValueChange::None);
-  }
-
-  constexpr auto operator<=>(const ActionState&) const noexcept = default;
-};
-
 struct InputState {
   XrHandEXT mHand;
   XrTime mPositionUpdatedAt {};
@@ -0,0 +1,21 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "LocateSpaces.h"
+
+namespace HandTrackedCockpitClicking {
+
+LocateSpacesScratch& LocateSpacesScratch::Get(std::size_t spaceCount) {
+  thread_local LocateSpacesScratch sScratch;
+  auto& it = sScratch;
+  // Never shrinks, so once the largest batch has been seen, this doesn't
+  // allocate
+  if (it.mSpaces.size() < spaceCount) {
+    it.mSpaces.resize(spaceCount);
+    it.mLocations.resize(spaceCount);
+    it.mVelocities.resize(spaceCount);
+    it.mOverridden.resize(spaceCount);
+  }
+  return it;
+}
+
+}// namespace HandTrackedCockpitClicking
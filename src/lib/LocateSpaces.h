@@ -0,0 +1,162 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <cinttypes>
+#include <vector>
+
+namespace HandTrackedCockpitClicking {
+
+/** Per-thread buffers for `LocateSpaces()`.
+ *
+ * These grow to fit the largest batch seen on each thread, then are reused,
+ * so locating spaces doesn't allocate every frame.
+ */
+struct LocateSpacesScratch {
+  std::vector<XrSpace> mSpaces;
+  std::vector<XrSpaceLocationData> mLocations;
+  std::vector<XrSpaceVelocityData> mVelocities;
+  std::vector<uint8_t> mOverridden;
+
+  static LocateSpacesScratch& Get(std::size_t spaceCount);
+};
+
+/** Implements xrLocateSpaces when we provide the poses of some spaces.
+ *
+ * - `isOverridden(space)` returns true for spaces we locate ourselves
+ * - `locate(space, anchorLocation)` returns the `XrSpaceLocationData` for one
+ *   of those spaces, given where `anchor` is
+ * - `next(info, locations)` is the next layer or runtime's xrLocateSpaces or
+ *   xrLocateSpacesKHR
+ *
+ * The other spaces are passed to `next` in a single batch, with `anchor`
+ * added to the start, so each call makes at most one call to the runtime.
+ * XrSpaceVelocities is supported; velocities for overridden spaces are not
+ * valid.
+ */
+template <class TIsOverridden, class TLocate, class TNext>
+XrResult LocateSpaces(
+  const XrSpacesLocateInfo* info,
+  XrSpaceLocations* locations,
+  XrSpace anchor,
+  TIsOverridden&& isOverridden,
+  TLocate&& locate,
+  TNext&& next) {
+  const auto count = info->spaceCount;
+  if (count == 0 || locations->locationCount != count) {
+    // Let the runtime handle validation
+    return next(info, locations);
+  }
+
+  auto& scratch = LocateSpacesScratch::Get(count + 1);
+  std::size_t overriddenCount {};
+  for (uint32_t i = 0; i < count; ++i) {
+    const bool overridden = isOverridden(info->spaces[i]);
+    scratch.mOverridden[i] = overridden;
+    overriddenCount += overridden;
+  }
+  if (overriddenCount == 0) {
+    return next(info, locations);
+  }
+
+  XrSpaceVelocities* velocities {nullptr};
+  bool haveUnknownNext = false;
+  for (auto it = reinterpret_cast<XrBaseOutStructure*>(locations->next); it;
+       it = it->next) {
+    if (it->type == XR_TYPE_SPACE_VELOCITIES && !velocities) {
+      velocities = reinterpret_cast<XrSpaceVelocities*>(it);
+    } else {
+      haveUnknownNext = true;
+    }
+  }
+  if (velocities && velocities->velocityCount != count) {
+    return next(info, locations);
+  }
+
+  if (haveUnknownNext) {
+    // We can't resize arrays in structs we don't know about, so pass the
+    // whole batch through, then locate the anchor separately and replace
+    // our spaces
+    const auto result = next(info, locations);
+    if (XR_FAILED(result)) {
+      return result;
+    }
+    XrSpaceLocationData anchorLocation {};
+    XrSpacesLocateInfo anchorInfo {*info};
+    anchorInfo.next = nullptr;
+    anchorInfo.spaceCount = 1;
+    anchorInfo.spaces = &anchor;
+    XrSpaceLocations anchorLocations {
+      .type = XR_TYPE_SPACE_LOCATIONS,
+      .locationCount = 1,
+      .locations = &anchorLocation,
+    };
+    const auto anchorResult = next(&anchorInfo, &anchorLocations);
+    if (XR_FAILED(anchorResult)) {
+      return anchorResult;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      if (scratch.mOverridden[i]) {
+        locations->locations[i] = locate(info->spaces[i], anchorLocation);
+        // The runtime's velocities are for the space we replaced
+        if (velocities) {
+          velocities->velocities[i] = {};
+        }
+      }
+    }
+    return result;
+  }
+
+  // Compact the batch: the anchor, then the spaces the runtime handles
+  const auto forwardedCount
+    = static_cast<uint32_t>(count - overriddenCount + 1);
+  scratch.mSpaces[0] = anchor;
+  for (uint32_t i = 0, j = 1; i < count; ++i) {
+    if (!scratch.mOverridden[i]) {
+      scratch.mSpaces[j++] = info->spaces[i];
+    }
+  }
+
+  XrSpacesLocateInfo forwardedInfo {*info};
+  forwardedInfo.spaceCount = forwardedCount;
+  forwardedInfo.spaces = scratch.mSpaces.data();
+
+  XrSpaceVelocities forwardedVelocities {XR_TYPE_SPACE_VELOCITIES};
+  if (velocities) {
+    forwardedVelocities.velocityCount = forwardedCount;
+    forwardedVelocities.velocities = scratch.mVelocities.data();
+  }
+  XrSpaceLocations forwardedLocations {
+    .type = locations->type,
+    .next = velocities ? &forwardedVelocities : nullptr,
+    .locationCount = forwardedCount,
+    .locations = scratch.mLocations.data(),
+  };
+
+  const auto result = next(&forwardedInfo, &forwardedLocations);
+  if (XR_FAILED(result)) {
+    return result;
+  }
+
+  // Scatter the results back to where the app expects them
+  const auto& anchorLocation = scratch.mLocations[0];
+  for (uint32_t i = 0, j = 1; i < count; ++i) {
+    if (scratch.mOverridden[i]) {
+      locations->locations[i] = locate(info->spaces[i], anchorLocation);
+      if (velocities) {
+        velocities->velocities[i] = {};
+      }
+      continue;
+    }
+    locations->locations[i] = scratch.mLocations[j];
+    if (velocities) {
+      velocities->velocities[i] = scratch.mVelocities[j];
+    }
+    ++j;
+  }
+  return result;
+}
+
+}// namespace HandTrackedCockpitClicking
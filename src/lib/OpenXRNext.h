@@ -15,6 +15,9 @@
   IT(xrDestroySession) \
   IT(xrBeginSession) \
   IT(xrLocateSpace) \
+  IT_EXT(XR_VERSION_1_1, xrLocateSpaces) \
+  IT_EXT(XR_KHR_locate_spaces, xrLocateSpacesKHR) \
+  IT(xrDestroySpace) \
   IT(xrWaitFrame) \
   IT(xrSuggestInteractionProfileBindings) \
   IT(xrAttachSessionActionSets) \
@@ -31,13 +34,19 @@
   IT(xrEnumerateApiLayerProperties) \
   IT(xrEnumerateInstanceExtensionProperties) \
   IT(xrDestroyInstance)
+// Not handled by the APILayer, but intercepted by the loader to track which
+// instance and session own the handles they create
+#define TRACKED_OPENXR_FUNCS \
+  IT(xrCreateReferenceSpace) \
+  IT(xrCreateActionSet) \
+  IT(xrDestroyActionSet)
 #define NEXT_OPENXR_FUNCS \
   INTERCEPTED_OPENXR_FUNCS \
   SPECIAL_INTERCEPTED_OPENXR_FUNCS \
-  IT(xrCreateReferenceSpace) \
-  IT(xrDestroySpace) \
+  TRACKED_OPENXR_FUNCS \
   IT(xrLocateViews) \
   IT(xrPathToString) \
+  IT(xrStringToPath) \
   IT(xrGetInstanceProperties) \
   IT_EXT( \
     XR_KHR_win32_convert_performance_counter_time, \
@@ -48,17 +57,18 @@
   IT_EXT(XR_EXT_hand_tracking, xrDestroyHandTrackerEXT) \
   IT_EXT(XR_EXT_hand_tracking, xrLocateHandJointsEXT)
 
-template <class T>
-struct XRFuncName;
+// Keyed by name rather than by function pointer type, as aliases such as
+// xrLocateSpaces and xrLocateSpacesKHR have the same type
+namespace XRFuncName {
 #define IT_EXT(ext, func) IT(func)
 #define IT(func) \
-  template <> \
-  struct XRFuncName<PFN_##func> { \
+  struct func { \
     static constexpr auto value = #func; \
   };
 NEXT_OPENXR_FUNCS
 #undef IT_EXT
 #undef IT
+}// namespace XRFuncName
 
 namespace HandTrackedCockpitClicking {
 
@@ -110,7 +120,7 @@ class OpenXRNext final {
 
 #define IT_EXT(ext, func) IT(func)
 #define IT(func) \
-  Fun<PFN_##func, XRFuncName<PFN_##func>> func; \
+  Fun<PFN_##func, ::XRFuncName::func> func; \
   template <class... Args> \
   [[nodiscard]] \
   bool check_##func(Args&&... args) { \
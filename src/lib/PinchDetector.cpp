@@ -0,0 +1,127 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "PinchDetector.h"
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+
+#include "Config.h"
+
+using namespace DirectX;
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+constexpr std::array FingerTips {
+  XR_HAND_JOINT_INDEX_TIP_EXT,
+  XR_HAND_JOINT_MIDDLE_TIP_EXT,
+  XR_HAND_JOINT_RING_TIP_EXT,
+  XR_HAND_JOINT_LITTLE_TIP_EXT,
+};
+
+constexpr std::array<XrHandTrackingAimFlagsFB, 4> FingerPinchBits {
+  XR_HAND_TRACKING_AIM_INDEX_PINCHING_BIT_FB,
+  XR_HAND_TRACKING_AIM_MIDDLE_PINCHING_BIT_FB,
+  XR_HAND_TRACKING_AIM_RING_PINCHING_BIT_FB,
+  XR_HAND_TRACKING_AIM_LITTLE_PINCHING_BIT_FB,
+};
+
+bool IsPositionValid(const XrHandJointLocationEXT& joint) {
+  return (joint.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT);
+}
+
+XMVECTOR LoadLanes(const std::array<float, 4>& lanes) {
+  return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(lanes.data()));
+}
+
+}// namespace
+
+PinchDetector::Thresholds PinchDetector::Thresholds::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+PinchDetector::Thresholds PinchDetector::Thresholds::FromConfig(
+  const Config::Snapshot& config) {
+  return {
+    .mPinchDistance = {
+      config.HandTrackingPinchIndexDistance,
+      config.HandTrackingPinchMiddleDistance,
+      config.HandTrackingPinchRingDistance,
+      config.HandTrackingPinchLittleDistance,
+    },
+    .mReleaseRatio = config.HandTrackingPinchReleaseRatio,
+  };
+}
+
+PinchDetector::PinchDetector(const Thresholds& thresholds) {
+  // A release ratio below 1 would let a pinch end before it started
+  const auto releaseRatio = std::max(thresholds.mReleaseRatio, 1.0f);
+  for (std::size_t i = 0; i < FingerTips.size(); ++i) {
+    const auto pinch = thresholds.mPinchDistance.at(i);
+    const auto release = pinch * releaseRatio;
+    mPinchDistanceSq.at(i) = pinch * pinch;
+    mReleaseDistanceSq.at(i) = release * release;
+  }
+}
+
+void PinchDetector::Reset() {
+  mPinching = {};
+}
+
+XrHandTrackingAimFlagsFB PinchDetector::Update(
+  std::span<const XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT> joints) {
+  const auto& thumb = joints[XR_HAND_JOINT_THUMB_TIP_EXT];
+  if (!IsPositionValid(thumb)) {
+    this->Reset();
+    return {};
+  }
+
+  // Structure-of-arrays: lane i is finger i
+  std::array<float, 4> xs, ys, zs;
+  uint32_t valid {};
+  for (std::size_t i = 0; i < FingerTips.size(); ++i) {
+    const auto& tip = joints[FingerTips[i]];
+    xs[i] = tip.pose.position.x;
+    ys[i] = tip.pose.position.y;
+    zs[i] = tip.pose.position.z;
+    if (IsPositionValid(tip)) {
+      valid |= (1 << i);
+    }
+  }
+
+  const auto dx
+    = XMVectorSubtract(LoadLanes(xs), XMVectorReplicate(thumb.pose.position.x));
+  const auto dy
+    = XMVectorSubtract(LoadLanes(ys), XMVectorReplicate(thumb.pose.position.y));
+  const auto dz
+    = XMVectorSubtract(LoadLanes(zs), XMVectorReplicate(thumb.pose.position.z));
+  const auto distanceSq = XMVectorMultiplyAdd(
+    dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+
+  // Fingers that are already pinching use the (larger) release threshold
+  const auto wasPinching = XMVectorSelectControl(
+    (mPinching >> 0) & 1,
+    (mPinching >> 1) & 1,
+    (mPinching >> 2) & 1,
+    (mPinching >> 3) & 1);
+  const auto threshold = XMVectorSelect(
+    LoadLanes(mPinchDistanceSq), LoadLanes(mReleaseDistanceSq), wasPinching);
+
+  XMUINT4 lanes;
+  XMStoreUInt4(&lanes, XMVectorLess(distanceSq, threshold));
+
+  mPinching = valid
+    & ((lanes.x ? 1 : 0) | (lanes.y ? 2 : 0) | (lanes.z ? 4 : 0)
+       | (lanes.w ? 8 : 0));
+
+  XrHandTrackingAimFlagsFB ret {};
+  for (std::size_t i = 0; i < FingerPinchBits.size(); ++i) {
+    if (mPinching & (1 << i)) {
+      ret |= FingerPinchBits[i];
+    }
+  }
+  return ret;
+}
+
+}// namespace HandTrackedCockpitClicking
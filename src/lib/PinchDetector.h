@@ -0,0 +1,56 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <array>
+#include <cinttypes>
+#include <span>
+
+namespace HandTrackedCockpitClicking {
+
+namespace Config {
+struct Snapshot;
+}
+
+/** Detects thumb-to-finger pinches from hand joint positions.
+ *
+ * This is a fallback for runtimes that don't support
+ * `XR_FB_hand_tracking_aim`; the result uses the same pinch bits as
+ * `XrHandTrackingAimStateFB::status`, so the rest of the pipeline doesn't need
+ * to care where it came from.
+ *
+ * All four fingers are tested at once with SIMD. Each finger has its own
+ * threshold, and releasing requires the tips to move further apart than
+ * pinching did, so pinches don't flicker at the boundary.
+ */
+class PinchDetector final {
+ public:
+  struct Thresholds {
+    // Index, middle, ring, little; in meters
+    std::array<float, 4> mPinchDistance {};
+    // A pinch ends when the distance exceeds mPinchDistance * mReleaseRatio
+    float mReleaseRatio {1.0f};
+
+    static Thresholds FromConfig();
+    static Thresholds FromConfig(const Config::Snapshot&);
+  };
+
+  PinchDetector() = delete;
+  PinchDetector(const Thresholds&);
+
+  XrHandTrackingAimFlagsFB Update(
+    std::span<const XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT> joints);
+  void Reset();
+
+ private:
+  // Squared distances, to avoid square roots
+  std::array<float, 4> mPinchDistanceSq {};
+  std::array<float, 4> mReleaseDistanceSq {};
+
+  // Bit i is set if finger i is currently pinching
+  uint32_t mPinching {};
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,107 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "PinchOnsetPredictor.h"
+
+#include <algorithm>
+
+#include "Config.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+// If we've missed this many frames, the previous sample tells us nothing
+// about the current velocity
+constexpr std::chrono::milliseconds MaxSampleInterval {100};
+}// namespace
+
+PinchOnsetPredictor::Parameters PinchOnsetPredictor::Parameters::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+PinchOnsetPredictor::Parameters PinchOnsetPredictor::Parameters::FromConfig(
+  const Config::Snapshot& config) {
+  return {
+    .mMaxLead = std::chrono::milliseconds(
+      config.HandTrackingPinchPredictionMilliseconds),
+    .mMinClosingSpeed = config.HandTrackingPinchPredictionSpeed,
+    .mMaxDistance = config.HandTrackingPinchIndexDistance * 4,
+  };
+}
+
+PinchOnsetPredictor::PinchOnsetPredictor(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+void PinchOnsetPredictor::Reset() {
+  mPrevious = {};
+  mClosingSince = {};
+}
+
+PinchOnsetPredictor::Result PinchOnsetPredictor::Observe(
+  Time now,
+  float distance) {
+  if (mParameters.mMaxLead == std::chrono::milliseconds::zero()) {
+    return Result::None;
+  }
+
+  const auto previous = mPrevious;
+  mPrevious = {now, distance};
+
+  // If the runtime hasn't reported a pinch by now, it either isn't going to,
+  // or it's going to be too late for the prediction to be used
+  if (mClosingSince && (now - *mClosingSince) > mParameters.mMaxLead) {
+    mClosingSince = {};
+    return Result::Cancelled;
+  }
+
+  if (!previous) {
+    return Result::None;
+  }
+  const auto interval = now - previous->mTime;
+  if (interval <= Time::zero() || interval > MaxSampleInterval) {
+    mClosingSince = {};
+    return Result::None;
+  }
+
+  const auto seconds = std::chrono::duration<float>(interval).count();
+  const auto closingSpeed = (previous->mDistance - distance) / seconds;
+
+  if (distance > mParameters.mMaxDistance) {
+    mClosingSince = {};
+    return Result::None;
+  }
+
+  if (closingSpeed >= mParameters.mMinClosingSpeed) {
+    if (mClosingSince) {
+      return Result::None;
+    }
+    mClosingSince = previous->mTime;
+    return Result::Predicted;
+  }
+
+  // Holding still once the tips are touching is expected, but moving apart
+  // means the pinch didn't happen
+  if (mClosingSince && closingSpeed <= -mParameters.mMinClosingSpeed) {
+    mClosingSince = {};
+    return Result::Cancelled;
+  }
+
+  return Result::None;
+}
+
+std::optional<PinchOnsetPredictor::Time> PinchOnsetPredictor::TakeOnset(
+  Time pinchSeenAt) {
+  if (!mClosingSince) {
+    return std::nullopt;
+  }
+  const auto closingSince = *mClosingSince;
+  mClosingSince = {};
+  // Clamping a stale prediction would still shorten the debounce period for
+  // a pinch that it doesn't belong to
+  if (closingSince < pinchSeenAt - mParameters.mMaxLead) {
+    return std::nullopt;
+  }
+  return std::min(closingSince, pinchSeenAt);
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,76 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+
+namespace HandTrackedCockpitClicking {
+
+namespace Config {
+struct Snapshot;
+}
+
+/** Estimates when a thumb-index pinch actually started.
+ *
+ * Watches the distance between the thumb and index finger tips; if they're
+ * closing quickly enough, the start of that movement is remembered as a
+ * candidate onset. When the runtime later reports the pinch, the caller can
+ * start the debounce period from the onset instead, so the click isn't
+ * delayed by the full debounce time. If the fingers open again before the
+ * runtime reports a pinch, the prediction is cancelled and has no effect.
+ */
+class PinchOnsetPredictor final {
+ public:
+  // Nanoseconds since an arbitrary epoch
+  using Time = std::chrono::nanoseconds;
+
+  struct Parameters {
+    // Zero disables prediction
+    std::chrono::milliseconds mMaxLead {};
+    // Minimum closing speed, in meters per second
+    float mMinClosingSpeed {};
+    // Ignore movement while the tips are further apart than this, in meters
+    float mMaxDistance {};
+
+    static Parameters FromConfig();
+    static Parameters FromConfig(const Config::Snapshot&);
+  };
+
+  enum class Result {
+    None,
+    Predicted,
+    Cancelled,
+  };
+
+  PinchOnsetPredictor() = delete;
+  PinchOnsetPredictor(const Parameters&);
+
+  /* Returns `Cancelled` if the fingers open again, or if the prediction is
+   * older than `mMaxLead` without a pinch being reported.
+   */
+  Result Observe(Time now, float distance);
+  void Reset();
+
+  /* When the pinch seen at `pinchSeenAt` is predicted to have started.
+   *
+   * `std::nullopt` if there is no prediction, or if it started more than
+   * `mMaxLead` before `pinchSeenAt`. The prediction is consumed either way,
+   * so releasing the pinch isn't treated as a cancellation.
+   */
+  std::optional<Time> TakeOnset(Time pinchSeenAt);
+
+ private:
+  Parameters mParameters;
+
+  struct Sample {
+    Time mTime {};
+    float mDistance {};
+  };
+  std::optional<Sample> mPrevious;
+
+  std::optional<Time> mClosingSince;
+};
+
+}// namespace HandTrackedCockpitClicking
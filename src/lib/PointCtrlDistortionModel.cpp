@@ -0,0 +1,337 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "PointCtrlDistortionModel.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <numbers>
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+
+constexpr auto Degrees = std::numbers::pi_v<float> / 180;
+// Different distances on the axes and diagonals, so that the cubic terms
+// aren't just multiples of the linear terms
+constexpr float AxisTarget = 20 * Degrees;
+constexpr float DiagonalTarget = 15 * Degrees;
+
+// { up, right }, as in InputState::mDirection
+constexpr std::array<XrVector2f, 9> Targets {{
+  {0, 0},
+  {0, AxisTarget},
+  {0, -AxisTarget},
+  {AxisTarget, 0},
+  {-AxisTarget, 0},
+  {DiagonalTarget, DiagonalTarget},
+  {DiagonalTarget, -DiagonalTarget},
+  {-DiagonalTarget, DiagonalTarget},
+  {-DiagonalTarget, -DiagonalTarget},
+}};
+
+// Fills as many terms as `terms` has space for
+template <class T>
+void GetTerms(T u, T v, std::span<T> terms) {
+  const std::array<T, 8> all {
+    1,
+    u,
+    v,
+    u * v,
+    u * u,
+    v * v,
+    u * u * u,
+    v * v * v,
+  };
+  std::copy_n(all.begin(), terms.size(), terms.begin());
+}
+
+/* Solves `a * x = b` for both columns of `b` by Gaussian elimination with
+ * partial pivoting; `a` is row-major, and both are overwritten, with `b`
+ * containing the solution.
+ *
+ * Returns false if `a` is singular, or too close to it for the solution to
+ * be meaningful.
+ */
+bool Solve(
+  size_t n,
+  std::span<double> a,
+  std::span<std::array<double, 2>> b) {
+  double largest {};
+  for (size_t i = 0; i < n; ++i) {
+    largest = std::max(largest, std::abs(a[(i * n) + i]));
+  }
+  const auto epsilon = largest * 1e-10;
+
+  for (size_t col = 0; col < n; ++col) {
+    size_t pivot = col;
+    for (size_t row = col + 1; row < n; ++row) {
+      if (std::abs(a[(row * n) + col]) > std::abs(a[(pivot * n) + col])) {
+        pivot = row;
+      }
+    }
+    if (!(std::abs(a[(pivot * n) + col]) > epsilon)) {
+      return false;
+    }
+    if (pivot != col) {
+      const auto pivotRow = a.begin() + (pivot * n);
+      std::swap_ranges(pivotRow, pivotRow + n, a.begin() + (col * n));
+      std::swap(b[pivot], b[col]);
+    }
+
+    for (size_t row = col + 1; row < n; ++row) {
+      const auto factor = a[(row * n) + col] / a[(col * n) + col];
+      for (size_t k = col; k < n; ++k) {
+        a[(row * n) + k] -= factor * a[(col * n) + k];
+      }
+      b[row][0] -= factor * b[col][0];
+      b[row][1] -= factor * b[col][1];
+    }
+  }
+
+  for (size_t row = n; row-- > 0;) {
+    for (size_t k = row + 1; k < n; ++k) {
+      b[row][0] -= a[(row * n) + k] * b[k][0];
+      b[row][1] -= a[(row * n) + k] * b[k][1];
+    }
+    b[row][0] /= a[(row * n) + row];
+    b[row][1] /= a[(row * n) + row];
+  }
+  return true;
+}
+
+}// namespace
+
+std::span<const XrVector2f> PointCtrlDistortionModel::GetTargets(
+  size_t count) {
+  if (count != 5 && count != 9) {
+    return {};
+  }
+  return {Targets.data(), count};
+}
+
+std::optional<PointCtrlDistortionModel> PointCtrlDistortionModel::Fit(
+  std::span<const Sample> samples) {
+  if (samples.size() >= 9) {
+    if (auto ret = Fit(samples, CubicTermCount)) {
+      return ret;
+    }
+  }
+  return Fit(samples, AffineTermCount);
+}
+
+std::optional<PointCtrlDistortionModel> PointCtrlDistortionModel::Fit(
+  std::span<const Sample> samples,
+  size_t termCount) {
+  if (samples.size() < termCount) {
+    return std::nullopt;
+  }
+
+  PointCtrlDistortionModel ret;
+  ret.mTermCount = termCount;
+
+  for (const auto& sample: samples) {
+    ret.mOrigin.x += sample.mRaw.x;
+    ret.mOrigin.y += sample.mRaw.y;
+  }
+  ret.mOrigin.x /= samples.size();
+  ret.mOrigin.y /= samples.size();
+
+  double spread {};
+  for (const auto& sample: samples) {
+    spread += std::pow(sample.mRaw.x - ret.mOrigin.x, 2)
+      + std::pow(sample.mRaw.y - ret.mOrigin.y, 2);
+  }
+  ret.mScale = static_cast<float>(std::sqrt(spread / samples.size()));
+  if (!(ret.mScale > 0)) {
+    return std::nullopt;
+  }
+
+  ret.mMin = {std::numeric_limits<float>::max(),
+              std::numeric_limits<float>::max()};
+  ret.mMax = {std::numeric_limits<float>::lowest(),
+              std::numeric_limits<float>::lowest()};
+  for (const auto& sample: samples) {
+    const auto u = (sample.mRaw.x - ret.mOrigin.x) / ret.mScale;
+    const auto v = (sample.mRaw.y - ret.mOrigin.y) / ret.mScale;
+    ret.mMin = {std::min(ret.mMin.x, u), std::min(ret.mMin.y, v)};
+    ret.mMax = {std::max(ret.mMax.x, u), std::max(ret.mMax.y, v)};
+  }
+
+  // Normal equations: (AᵀA)x = Aᵀb
+  std::vector<double> ata(termCount * termCount);
+  std::vector<std::array<double, 2>> atb(termCount);
+  std::array<double, CubicTermCount> terms {};
+  const std::span row {terms.data(), termCount};
+  for (const auto& sample: samples) {
+    GetTerms<double>(
+      (sample.mRaw.x - ret.mOrigin.x) / ret.mScale,
+      (sample.mRaw.y - ret.mOrigin.y) / ret.mScale,
+      row);
+    for (size_t i = 0; i < termCount; ++i) {
+      for (size_t j = 0; j < termCount; ++j) {
+        ata[(i * termCount) + j] += row[i] * row[j];
+      }
+      atb[i][0] += row[i] * sample.mDirection.x;
+      atb[i][1] += row[i] * sample.mDirection.y;
+    }
+  }
+
+  if (!Solve(termCount, ata, atb)) {
+    return std::nullopt;
+  }
+
+  ret.mCoefficients.resize(termCount * 2);
+  for (size_t i = 0; i < termCount; ++i) {
+    ret.mCoefficients[i] = static_cast<float>(atb[i][0]);
+    ret.mCoefficients[termCount + i] = static_cast<float>(atb[i][1]);
+  }
+  return ret;
+}
+
+std::optional<PointCtrlDistortionModel> PointCtrlDistortionModel::Parse(
+  std::string_view text) {
+  std::vector<float> values;
+  auto first = text.data();
+  const auto last = text.data() + text.size();
+  while (first != last) {
+    if (*first == ' ') {
+      ++first;
+      continue;
+    }
+    float value {};
+    const auto [end, error] = std::from_chars(first, last, value);
+    if (error != std::errc {} || !std::isfinite(value)) {
+      return std::nullopt;
+    }
+    values.push_back(value);
+    first = end;
+  }
+
+  // Term count, origin x and y, scale, then the min and max covered
+  constexpr size_t HeaderSize = 8;
+  if (values.size() < HeaderSize) {
+    return std::nullopt;
+  }
+
+  PointCtrlDistortionModel ret;
+  ret.mTermCount = static_cast<size_t>(values[0]);
+  if (
+    static_cast<float>(ret.mTermCount) != values[0]
+    || (ret.mTermCount != AffineTermCount
+        && ret.mTermCount != CubicTermCount)
+    || values.size() != HeaderSize + (ret.mTermCount * 2)) {
+    return std::nullopt;
+  }
+  ret.mOrigin = {values[1], values[2]};
+  ret.mScale = values[3];
+  ret.mMin = {values[4], values[5]};
+  ret.mMax = {values[6], values[7]};
+  if (
+    !(ret.mScale > 0) || ret.mMin.x > ret.mMax.x || ret.mMin.y > ret.mMax.y) {
+    return std::nullopt;
+  }
+  ret.mCoefficients.assign(values.begin() + HeaderSize, values.end());
+  return ret;
+}
+
+std::string PointCtrlDistortionModel::Serialize() const {
+  auto ret = std::format(
+    "{} {} {} {} {} {} {} {}",
+    mTermCount,
+    mOrigin.x,
+    mOrigin.y,
+    mScale,
+    mMin.x,
+    mMin.y,
+    mMax.x,
+    mMax.y);
+  for (const auto it: mCoefficients) {
+    ret += std::format(" {}", it);
+  }
+  return ret;
+}
+
+XrVector2f PointCtrlDistortionModel::Evaluate(const XrVector2f& raw) const {
+  const auto u = (raw.x - mOrigin.x) / mScale;
+  const auto v = (raw.y - mOrigin.y) / mScale;
+  const auto cu = std::clamp(u, mMin.x, mMax.x);
+  const auto cv = std::clamp(v, mMin.y, mMax.y);
+
+  std::array<float, CubicTermCount> terms {};
+  const std::span row {terms.data(), mTermCount};
+  GetTerms<float>(cu, cv, row);
+
+  XrVector2f ret {};
+  for (size_t i = 0; i < mTermCount; ++i) {
+    ret.x += row[i] * mCoefficients[i];
+    ret.y += row[i] * mCoefficients[mTermCount + i];
+  }
+
+  // Linear terms are [1] and [2]
+  const auto du = u - cu;
+  const auto dv = v - cv;
+  const auto* y = &mCoefficients[mTermCount];
+  ret.x += (du * mCoefficients[1]) + (dv * mCoefficients[2]);
+  ret.y += (du * y[1]) + (dv * y[2]);
+  return ret;
+}
+
+float PointCtrlDistortionModel::GetRMSError(
+  std::span<const Sample> samples) const {
+  if (samples.empty()) {
+    return 0;
+  }
+  double sum {};
+  for (const auto& sample: samples) {
+    const auto fitted = Evaluate(sample.mRaw);
+    sum += std::pow(fitted.x - sample.mDirection.x, 2)
+      + std::pow(fitted.y - sample.mDirection.y, 2);
+  }
+  return static_cast<float>(std::sqrt(sum / samples.size()));
+}
+
+PointCtrlLookupTable::PointCtrlLookupTable(
+  const PointCtrlDistortionModel& model,
+  size_t resolution)
+  : mResolution(std::max<size_t>(resolution, 1)),
+    mCellSize(65536.0f / mResolution) {
+  const auto stride = mResolution + 1;
+  mPoints.resize(stride * stride);
+  for (size_t y = 0; y < stride; ++y) {
+    for (size_t x = 0; x < stride; ++x) {
+      mPoints[(y * stride) + x]
+        = model.Evaluate({x * mCellSize, y * mCellSize});
+    }
+  }
+}
+
+XrVector2f PointCtrlLookupTable::Evaluate(uint16_t x, uint16_t y) const {
+  const auto fx = x / mCellSize;
+  const auto fy = y / mCellSize;
+  const auto col = std::min(static_cast<size_t>(fx), mResolution - 1);
+  const auto row = std::min(static_cast<size_t>(fy), mResolution - 1);
+  const auto tx = fx - col;
+  const auto ty = fy - row;
+
+  const auto stride = mResolution + 1;
+  const auto& p00 = mPoints[(row * stride) + col];
+  const auto& p01 = mPoints[(row * stride) + col + 1];
+  const auto& p10 = mPoints[((row + 1) * stride) + col];
+  const auto& p11 = mPoints[((row + 1) * stride) + col + 1];
+
+  const auto lerp = [tx, ty](float a, float b, float c, float d) {
+    const auto top = std::lerp(a, b, tx);
+    const auto bottom = std::lerp(c, d, tx);
+    return std::lerp(top, bottom, ty);
+  };
+  return {
+    lerp(p00.x, p01.x, p10.x, p11.x),
+    lerp(p00.y, p01.y, p10.y, p11.y),
+  };
+}
+
+}// namespace HandTrackedCockpitClicking
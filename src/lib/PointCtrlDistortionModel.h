@@ -0,0 +1,114 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <cinttypes>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HandTrackedCockpitClicking {
+
+/** Maps raw PointCtrl sensor positions to pointer directions.
+ *
+ * The sensor is close to linear near its center, but not toward the edges of
+ * its range; a single center point and a fixed number of radians per unit
+ * puts the pointer visibly off target there.
+ *
+ * Instead, the calibration tool averages several samples for each of a set
+ * of known targets, and `Fit()` finds the polynomial in the raw position that
+ * best matches them by least squares:
+ *
+ * - with 9 or more samples, each axis is
+ *   `a + bu + cv + duv + eu^2 + fv^2 + gu^3 + hv^3`
+ * - with fewer, or if the samples don't constrain the cubic terms, it's
+ *   affine: `a + bu + cv`
+ *
+ * `u` and `v` are the raw position, centered and scaled by the samples'
+ * centroid and spread, to keep the equations well-conditioned.
+ *
+ * Outside of the area covered by the samples, the polynomial is evaluated at
+ * the nearest covered point, and extended with just the linear terms; cubic
+ * terms are fine for the edge of the range the user reached for, but would
+ * quickly run away beyond it.
+ *
+ * This only depends on the standard library and OpenXR types, so fits can be
+ * tested anywhere with synthetic samples.
+ *
+ * Directions are rotations around the x and y axis, as in
+ * `InputState::mDirection`.
+ */
+class PointCtrlDistortionModel final {
+ public:
+  struct Sample {
+    // The average raw (x, y) position for a target
+    XrVector2f mRaw {};
+    XrVector2f mDirection {};
+  };
+
+  /** Calibration targets: the center, then points around it.
+   *
+   * `count` must be 5 (the center and 4 axis-aligned points) or 9 (those,
+   * plus 4 diagonals, which are needed for the cubic model).
+   */
+  static std::span<const XrVector2f> GetTargets(size_t count);
+
+  // nullopt if the samples don't determine even an affine model
+  static std::optional<PointCtrlDistortionModel> Fit(
+    std::span<const Sample>);
+
+  // The reverse of `Serialize()`; nullopt if invalid
+  static std::optional<PointCtrlDistortionModel> Parse(std::string_view);
+  std::string Serialize() const;
+
+  XrVector2f Evaluate(const XrVector2f& raw) const;
+
+  // Root mean square angular error of the model for the given samples
+  float GetRMSError(std::span<const Sample>) const;
+
+ private:
+  static constexpr size_t AffineTermCount = 3;
+  static constexpr size_t CubicTermCount = 8;
+
+  XrVector2f mOrigin {};
+  float mScale {1.0f};
+  // The area covered by the samples, in scaled coordinates
+  XrVector2f mMin {};
+  XrVector2f mMax {};
+  // `mTermCount` coefficients for direction.x, then for direction.y
+  std::vector<float> mCoefficients;
+  size_t mTermCount {};
+
+  static std::optional<PointCtrlDistortionModel>
+  Fit(std::span<const Sample>, size_t termCount);
+};
+
+/** A precomputed grid of `PointCtrlDistortionModel` evaluations.
+ *
+ * This covers the full range of the sensor, and is bilinearly interpolated,
+ * so the cost per frame doesn't depend on the model.
+ */
+class PointCtrlLookupTable final {
+ public:
+  // Number of cells along each axis
+  static constexpr size_t DefaultResolution = 64;
+
+  PointCtrlLookupTable() = delete;
+  explicit PointCtrlLookupTable(
+    const PointCtrlDistortionModel&,
+    size_t resolution = DefaultResolution);
+
+  XrVector2f Evaluate(uint16_t x, uint16_t y) const;
+
+ private:
+  size_t mResolution {};
+  float mCellSize {};
+  // (mResolution + 1)^2 grid points, row-major with y as the row
+  std::vector<XrVector2f> mPoints;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,139 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "PointCtrlDriftEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Config.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+// How far we trust the initial guess of 'no drift', as a variance; about as
+// much as a few seconds of movement
+constexpr float InitialCovariance = 0.1f;
+// Without movement along an axis, forgetting lets the covariance grow
+// without limit, and the next sample would be trusted far too much
+constexpr float MaxCovarianceTrace = 2 * InitialCovariance;
+}// namespace
+
+PointCtrlDriftEstimator::Parameters
+PointCtrlDriftEstimator::Parameters::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+PointCtrlDriftEstimator::Parameters
+PointCtrlDriftEstimator::Parameters::FromConfig(
+  const Config::Snapshot& config) {
+  return {
+    .mWindow = std::chrono::duration<float>(config.FusionDriftWindowSeconds),
+    .mCorrectionRate = config.FusionDriftCorrectionRate,
+  };
+}
+
+PointCtrlDriftEstimator::PointCtrlDriftEstimator(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+void PointCtrlDriftEstimator::SetParameters(const Parameters& parameters) {
+  mParameters = parameters;
+}
+
+PointCtrlDriftEstimator::Axis::Axis() {
+  mCovariance = {InitialCovariance, 0, 0, InitialCovariance};
+}
+
+void PointCtrlDriftEstimator::Axis::Update(
+  float x,
+  float y,
+  float weight,
+  float forgetting) {
+  auto& p = mCovariance;
+  // P * phi, where phi = (x, 1)
+  const float px[2] {(p[0] * x) + p[1], (p[2] * x) + p[3]};
+  const auto denominator = (forgetting / weight) + (x * px[0]) + px[1];
+  const float gain[2] {px[0] / denominator, px[1] / denominator};
+
+  const auto error = y - ((mScale * x) + mOffset);
+  mScale += gain[0] * error;
+  mOffset += gain[1] * error;
+
+  // P = (P - gain * phi' * P) / forgetting; phi' * P is px', as P is symmetric
+  p = {
+    (p[0] - (gain[0] * px[0])) / forgetting,
+    (p[1] - (gain[0] * px[1])) / forgetting,
+    (p[2] - (gain[1] * px[0])) / forgetting,
+    (p[3] - (gain[1] * px[1])) / forgetting,
+  };
+
+  const auto trace = p[0] + p[3];
+  if (trace > MaxCovarianceTrace) {
+    const auto scale = MaxCovarianceTrace / trace;
+    for (auto& it: p) {
+      it *= scale;
+    }
+  }
+}
+
+void PointCtrlDriftEstimator::Update(
+  Time now,
+  const XrVector2f& pointCtrl,
+  const XrVector2f& handTracking,
+  float weight) {
+  if (!(weight > 0)) {
+    return;
+  }
+  // The first sample after a gap only sets the time, so a gap doesn't count
+  // as time spent forgetting or correcting
+  const std::chrono::duration<float> dt
+    = mLastUpdate ? (now - *mLastUpdate) : Time {};
+  mLastUpdate = now;
+  if (dt.count() <= 0) {
+    return;
+  }
+
+  const auto forgetting = (mParameters.mWindow.count() > 0)
+    ? std::exp(-dt / mParameters.mWindow)
+    : 1.0f;
+  mAxes[0].Update(pointCtrl.x, handTracking.x, weight, forgetting);
+  mAxes[1].Update(pointCtrl.y, handTracking.y, weight, forgetting);
+
+  const auto target = this->GetEstimate();
+  const auto alpha
+    = std::min(1.0f, mParameters.mCorrectionRate * dt.count()) * weight;
+  auto& c = mCorrection;
+  c.mScale.x += (target.mScale.x - c.mScale.x) * alpha;
+  c.mScale.y += (target.mScale.y - c.mScale.y) * alpha;
+  c.mOffset.x += (target.mOffset.x - c.mOffset.x) * alpha;
+  c.mOffset.y += (target.mOffset.y - c.mOffset.y) * alpha;
+}
+
+void PointCtrlDriftEstimator::Pause() {
+  mLastUpdate = {};
+}
+
+XrVector2f PointCtrlDriftEstimator::Apply(const XrVector2f& pointCtrl) const {
+  return {
+    (pointCtrl.x * mCorrection.mScale.x) + mCorrection.mOffset.x,
+    (pointCtrl.y * mCorrection.mScale.y) + mCorrection.mOffset.y,
+  };
+}
+
+PointCtrlDriftEstimator::Correction PointCtrlDriftEstimator::GetCorrection()
+  const {
+  return mCorrection;
+}
+
+PointCtrlDriftEstimator::Correction PointCtrlDriftEstimator::GetEstimate()
+  const {
+  return {
+    .mScale = {
+      std::clamp(mAxes[0].mScale, MinScale, MaxScale),
+      std::clamp(mAxes[1].mScale, MinScale, MaxScale),
+    },
+    .mOffset = {mAxes[0].mOffset, mAxes[1].mOffset},
+  };
+}
+
+}// namespace HandTrackedCockpitClicking
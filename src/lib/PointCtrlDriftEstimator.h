@@ -0,0 +1,101 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <array>
+#include <chrono>
+#include <optional>
+
+namespace HandTrackedCockpitClicking::Config {
+struct Snapshot;
+}
+
+namespace HandTrackedCockpitClicking {
+
+/** Estimates how far PointCtrl has drifted from its calibration.
+ *
+ * When the headset shifts on the head, PointCtrl's center moves, and its
+ * scale can change slightly; until now, the only fix was to re-run the
+ * calibration program.
+ *
+ * While both sources are available, this fits
+ * `handTracking = scale * pointCtrl + offset` for each axis by recursive
+ * least squares: each sample updates a 2x2 covariance, so the cost per frame
+ * is constant. Older samples are forgotten exponentially over `mWindow`.
+ *
+ * Hand tracking is much noisier than PointCtrl, so the correction that's
+ * applied only moves toward the estimate at `mCorrectionRate`; the scale is
+ * also limited to `[MinScale, MaxScale]`.
+ *
+ * Directions are rotations around the x and y axis, as in
+ * `InputState::mDirection`.
+ */
+class PointCtrlDriftEstimator final {
+ public:
+  // Nanoseconds since an arbitrary epoch
+  using Time = std::chrono::nanoseconds;
+
+  static constexpr float MinScale = 0.5f;
+  static constexpr float MaxScale = 2.0f;
+
+  struct Parameters {
+    std::chrono::duration<float> mWindow {};
+    // Per second
+    float mCorrectionRate {};
+
+    static Parameters FromConfig();
+    static Parameters FromConfig(const Config::Snapshot&);
+  };
+
+  struct Correction {
+    XrVector2f mScale {1.0f, 1.0f};
+    XrVector2f mOffset {};
+  };
+
+  PointCtrlDriftEstimator() = delete;
+  explicit PointCtrlDriftEstimator(const Parameters&);
+
+  // Keeps the current estimate
+  void SetParameters(const Parameters&);
+
+  /* Adds a sample where both sources have a direction.
+   *
+   * `weight` is how much to trust this sample, from 0 to 1; for example, how
+   * fresh both directions are.
+   */
+  void Update(
+    Time now,
+    const XrVector2f& pointCtrl,
+    const XrVector2f& handTracking,
+    float weight);
+  // Call when either source goes away, so that the gap isn't counted as time
+  // spent correcting
+  void Pause();
+
+  XrVector2f Apply(const XrVector2f& pointCtrl) const;
+
+  // The correction currently being applied
+  Correction GetCorrection() const;
+  // What the correction is moving toward
+  Correction GetEstimate() const;
+
+ private:
+  // y = mScale * x + mOffset, with the covariance of (mScale, mOffset)
+  struct Axis {
+    float mScale {1.0f};
+    float mOffset {};
+    std::array<float, 4> mCovariance {};
+
+    Axis();
+    void Update(float x, float y, float weight, float forgetting);
+  };
+
+  Parameters mParameters;
+  std::array<Axis, 2> mAxes {};
+  Correction mCorrection {};
+  std::optional<Time> mLastUpdate;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -4,6 +4,7 @@
 
 #include <directxtk/SimpleMath.h>
 
+#include <algorithm>
 #include <numbers>
 
 #include "CheckHResult.hpp"
@@ -17,14 +18,15 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 using namespace DirectX::SimpleMath;
 
 static constexpr auto PressedBit = 1 << 7;
-#define FCUB(x) Config::PointCtrlFCUButton##x
+#define FCUB(x) mConfig->PointCtrlFCUButton##x
 #define HAS_BUTTON(idx) ((buttons[idx] & PressedBit) == PressedBit)
 #define HAND_FCUB(hand, x) (hand == XR_HAND_LEFT_EXT ? FCUB(L##x) : FCUB(R##x))
 
 namespace HandTrackedCockpitClicking {
 
-static bool IsPointerSource() {
-  return Config::PointerSource == PointerSource::PointCtrl
+static bool IsPointerSource(const Config::Snapshot& config) {
+  return config.PointerSource == PointerSource::PointCtrl
+    || config.PointerSource == PointerSource::Fusion
     || Environment::IsPointCtrlCalibration;
 }
 
@@ -32,24 +34,33 @@ PointCtrlSource::PointCtrlSource() : PointCtrlSource(NULL) {
 }
 
 PointCtrlSource::PointCtrlSource(HANDLE eventNotification)
-  : mEventHandle(eventNotification) {
+  : PointCtrlSource(
+      std::make_shared<const Config::Snapshot>(Config::Current()),
+      eventNotification) {
+}
+
+PointCtrlSource::PointCtrlSource(
+  std::shared_ptr<const Config::Snapshot> config,
+  HANDLE eventNotification)
+  : mConfig(std::move(config)), mEventHandle(eventNotification) {
   DebugPrint(
     "Initializing PointCtrlSource with calibration ({}, {}) delta ({}, {})",
-    Config::PointCtrlCenterX,
-    Config::PointCtrlCenterY,
-    Config::PointCtrlRadiansPerUnitX,
-    Config::PointCtrlRadiansPerUnitY);
+    mConfig->PointCtrlCenterX,
+    mConfig->PointCtrlCenterY,
+    mConfig->PointCtrlRadiansPerUnitX,
+    mConfig->PointCtrlRadiansPerUnitY);
+  LoadCalibrationModel();
   DebugPrint(
     "PointerSource: {}; ActionSource: {}",
-    IsPointerSource(),
-    Config::PointCtrlFCUMapping != PointCtrlFCUMapping::Disabled);
+    IsPointerSource(*mConfig),
+    mConfig->PointCtrlFCUMapping != PointCtrlFCUMapping::Disabled);
   CheckHResult(DirectInput8Create(
     reinterpret_cast<HINSTANCE>(&__ImageBase),
     DIRECTINPUT_VERSION,
     IID_IDirectInput8W,
     mDI.put_void(),
     nullptr));
-  ConnectDevice();
+  ConnectDevice(*mConfig);
   if (!IsConnected()) {
     ConnectDeviceAsync();
   }
@@ -63,32 +74,79 @@ PointCtrlSource::~PointCtrlSource() {
   }
 }
 
-void PointCtrlSource::ConnectDevice() {
-  if (mDevice) {
+void PointCtrlSource::ReloadConfig(
+  std::shared_ptr<const Config::Snapshot> config) {
+  mConfig = std::move(config);
+  if (mConfig->PointCtrlCalibrationModel != mCalibrationModel) {
+    LoadCalibrationModel();
+  }
+}
+
+void PointCtrlSource::LoadCalibrationModel() {
+  mCalibrationModel = mConfig->PointCtrlCalibrationModel;
+  mLookupTable = {};
+  if (mCalibrationModel.empty()) {
+    return;
+  }
+
+  const auto model = PointCtrlDistortionModel::Parse(mCalibrationModel);
+  if (!model) {
+    DebugPrint(
+      "Ignoring invalid PointCtrlCalibrationModel '{}'", mCalibrationModel);
+    return;
+  }
+  DebugPrint("Using PointCtrl calibration model '{}'", mCalibrationModel);
+  mLookupTable.emplace(*model);
+}
+
+wil::com_ptr<IDirectInputDevice8W> PointCtrlSource::GetDevice() const {
+  std::unique_lock lock(mDeviceMutex);
+  return mDevice;
+}
+
+void PointCtrlSource::SetDevice(wil::com_ptr<IDirectInputDevice8W> device) {
+  std::unique_lock lock(mDeviceMutex);
+  mDevice = std::move(device);
+}
+
+void PointCtrlSource::ReleaseDevice(
+  const wil::com_ptr<IDirectInputDevice8W>& device) {
+  std::unique_lock lock(mDeviceMutex);
+  if (mDevice == device) {
+    mDevice = {nullptr};
+  }
+}
+
+void PointCtrlSource::ConnectDevice(const Config::Snapshot& config) {
+  if (GetDevice()) {
     return;
   }
 
   // If we're not going to do anything with it, don't fetch the data.
   if (
-    (!IsPointerSource())
-    && Config::PointCtrlFCUMapping == PointCtrlFCUMapping::Disabled) {
+    (!IsPointerSource(config))
+    && config.PointCtrlFCUMapping == PointCtrlFCUMapping::Disabled) {
     return;
   }
 
+  EnumDevicesContext context {this, &config};
   CheckHResult(mDI->EnumDevices(
     DI8DEVCLASS_GAMECTRL,
     &PointCtrlSource::EnumDevicesCallbackStatic,
-    this,
+    &context,
     DIEDFL_ATTACHEDONLY));
 }
 
 BOOL PointCtrlSource::EnumDevicesCallbackStatic(
   LPCDIDEVICEINSTANCE lpddi,
   LPVOID pvRef) {
-  return reinterpret_cast<PointCtrlSource*>(pvRef)->EnumDevicesCallback(lpddi);
+  const auto context = reinterpret_cast<EnumDevicesContext*>(pvRef);
+  return context->mSource->EnumDevicesCallback(*context->mConfig, lpddi);
 }
 
-BOOL PointCtrlSource::EnumDevicesCallback(LPCDIDEVICEINSTANCE lpddi) {
+BOOL PointCtrlSource::EnumDevicesCallback(
+  const Config::Snapshot& config,
+  LPCDIDEVICEINSTANCE lpddi) {
   wil::com_ptr<IDirectInputDevice8W> dev;
   CheckHResult(mDI->CreateDevice(lpddi->guidInstance, dev.put(), nullptr));
 
@@ -103,7 +161,7 @@ BOOL PointCtrlSource::EnumDevicesCallback(LPCDIDEVICEINSTANCE lpddi) {
   const auto vid = LOWORD(buf.dwData);
   const auto pid = HIWORD(buf.dwData);
 
-  if (vid != Config::PointCtrlVID || pid != Config::PointCtrlPID) {
+  if (vid != config.PointCtrlVID || pid != config.PointCtrlPID) {
     return DIENUM_CONTINUE;
   }
 
@@ -115,7 +173,7 @@ BOOL PointCtrlSource::EnumDevicesCallback(LPCDIDEVICEINSTANCE lpddi) {
 
   CheckHResult(dev->SetDataFormat(&c_dfDIJoystick2));
   CheckHResult(dev->Acquire());
-  mDevice = std::move(dev);
+  SetDevice(std::move(dev));
   return DIENUM_STOP;
 }
 
@@ -124,18 +182,20 @@ void PointCtrlSource::ConnectDeviceAsync() {
     return;
   }
 
-  mConnectDeviceThread = std::jthread {[this](std::stop_token tok) {
+  // mConfig may be replaced by the frame thread, so keep the one we started
+  // with
+  const auto config = mConfig;
+  mConnectDeviceThread = std::jthread {[this, config](std::stop_token tok) {
     DebugPrint("Starting PointCTRL hotplug thread");
-    auto lastCheck = std::chrono::steady_clock::now();
-    while (!tok.stop_requested()) {
+    // Check once a second, but wake up more often so that we can be stopped
+    constexpr auto ChecksEvery = 10;
+    for (uint32_t i = 1; !tok.stop_requested(); ++i) {
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      const auto now = std::chrono::steady_clock::now();
-      if (now - lastCheck < std::chrono::seconds(1)) {
+      if (i % ChecksEvery) {
         continue;
       }
-      lastCheck = now;
-      ConnectDevice();
-      if (mDevice) {
+      ConnectDevice(*config);
+      if (GetDevice()) {
         mConnectDeviceThread->detach();
         mConnectDeviceThread = {};
         DebugPrint("Terminating PointCTRL hotplug thread");
@@ -150,33 +210,97 @@ std::tuple<InputState, InputState> PointCtrlSource::Update(
   const FrameInfo& frameInfo) {
   const auto now = frameInfo.mNow;
 
-  if (!mDevice) {
-    if (Config::PointCtrlSupportHotplug) {
+  const auto device = GetDevice();
+  if (!device) {
+    if (mConfig->PointCtrlSupportHotplug) {
       ConnectDeviceAsync();
     }
     return {{XR_HAND_LEFT_EXT}, {XR_HAND_RIGHT_EXT}};
   }
 
-  const auto polled = mDevice->Poll();
+  if (mIsSampling) {
+    return UpdateSampled();
+  }
+  // Anything left over from a sampler that has since stopped is stale
+  mSamples.Drain([](const DeviceSample&) {});
+
+  const auto polled = device->Poll();
   if (polled != DI_OK && polled != DI_NOEFFECT) {
-    mDevice = {nullptr};
+    ReleaseDevice(device);
     return {{XR_HAND_LEFT_EXT}, {XR_HAND_RIGHT_EXT}};
   }
 
   DIJOYSTATE2 joystate;
-  if (mDevice->GetDeviceState(sizeof(joystate), &joystate) != DI_OK) {
+  if (device->GetDeviceState(sizeof(joystate), &joystate) != DI_OK) {
     return {{XR_HAND_LEFT_EXT}, {XR_HAND_RIGHT_EXT}};
   }
-  const auto& buttons = joystate.rgbButtons;
+  return UpdateFromDevice(now, joystate.lX, joystate.lY, joystate.rgbButtons);
+}
+
+void PointCtrlSource::Sample(XrTime now) {
+  const auto device = GetDevice();
+  if (!device) {
+    return;
+  }
+
+  const auto polled = device->Poll();
+  if (polled != DI_OK && polled != DI_NOEFFECT) {
+    // If the hotplug thread has already replaced it, leave the new one alone
+    ReleaseDevice(device);
+    return;
+  }
+
+  DIJOYSTATE2 joystate;
+  if (device->GetDeviceState(sizeof(joystate), &joystate) != DI_OK) {
+    return;
+  }
+
+  DeviceSample sample {now, joystate.lX, joystate.lY};
+  std::ranges::copy(joystate.rgbButtons, sample.mButtons);
+  mSamples.Push(sample);
+}
+
+void PointCtrlSource::SetSampling(bool sampling) {
+  mIsSampling = sampling;
+}
 
+std::tuple<InputState, InputState> PointCtrlSource::UpdateSampled() {
+  // Run every sample through the state machines so that we see every edge,
+  // and latch presses so that a click that started and finished between two
+  // frames is still reported for one frame.
+  bool primary[2] {};
+  bool secondary[2] {};
+  mSamples.Drain([&](const DeviceSample& sample) {
+    mLastSampledState = UpdateFromDevice(
+      sample.mTime, sample.mX, sample.mY, sample.mButtons);
+    const auto& [left, right] = mLastSampledState;
+    primary[0] |= left.mActions.mPrimary;
+    secondary[0] |= left.mActions.mSecondary;
+    primary[1] |= right.mActions.mPrimary;
+    secondary[1] |= right.mActions.mSecondary;
+  });
+
+  auto [left, right] = mLastSampledState;
+  left.mActions.mPrimary |= primary[0];
+  left.mActions.mSecondary |= secondary[0];
+  right.mActions.mPrimary |= primary[1];
+  right.mActions.mSecondary |= secondary[1];
+  return {left, right};
+}
+
+std::tuple<InputState, InputState> PointCtrlSource::UpdateFromDevice(
+  XrTime now,
+  LONG x,
+  LONG y,
+  const RawButtons& buttons) {
   auto& mX = mRaw.mX;
   auto& mY = mRaw.mY;
 
-  if (mX != joystate.lX || mY != joystate.lY) {
+  if (mX != x || mY != y) {
     mLastMovedAt = now;
     mRaw = {};
-    mX = joystate.lX;
-    mY = joystate.lY;
+    mX = x;
+    mY = y;
   }
 
   for (auto hand: {&mLeftHand, &mRightHand}) {
@@ -185,7 +309,7 @@ std::tuple<InputState, InputState> PointCtrlSource::Update(
     const auto b3 = HAS_BUTTON(HAND_FCUB(hand->mHand, 3));
     const auto haveButton = b1 || b2 || b3;
 
-    if (IsPointerSource()) {
+    if (IsPointerSource(*mConfig)) {
       UpdateWakeState(haveButton, now, hand);
 
       if (hand->mWakeState == WakeState::Waking) {
@@ -201,7 +325,7 @@ std::tuple<InputState, InputState> PointCtrlSource::Update(
     hand->mState.mDirection = {};
     hand->mState.mPositionUpdatedAt = mLastMovedAt;
 
-    switch (Config::PointCtrlFCUMapping) {
+    switch (mConfig->PointCtrlFCUMapping) {
       case PointCtrlFCUMapping::Classic:
         MapActionsClassic(hand, now, buttons);
         break;
@@ -225,12 +349,14 @@ std::tuple<InputState, InputState> PointCtrlSource::Update(
   const auto interval = std::chrono::nanoseconds(now - mLastMovedAt);
 
   if (interval < std::chrono::milliseconds(100)) {
-    const XrVector2f direction {
-      (static_cast<float>(mY) - Config::PointCtrlCenterY)
-        * -Config::PointCtrlRadiansPerUnitY,
-      (static_cast<float>(mX) - Config::PointCtrlCenterX)
-        * Config::PointCtrlRadiansPerUnitX,
-    };
+    const XrVector2f direction = mLookupTable
+      ? mLookupTable->Evaluate(mX, mY)
+      : XrVector2f {
+          (static_cast<float>(mY) - mConfig->PointCtrlCenterY)
+            * -mConfig->PointCtrlRadiansPerUnitY,
+          (static_cast<float>(mX) - mConfig->PointCtrlCenterX)
+            * mConfig->PointCtrlRadiansPerUnitX,
+        };
     mLeftHand.mState.mDirection = direction;
     mRightHand.mState.mDirection = direction;
   }
@@ -247,7 +373,7 @@ void PointCtrlSource::UpdateWakeState(bool hasButtons, XrTime now, Hand* hand) {
   if (state == WakeState::Default && hasButtons) {
     if (
       interval
-      > std::chrono::milliseconds(Config::PointCtrlSleepMilliseconds)) {
+      > std::chrono::milliseconds(mConfig->PointCtrlSleepMilliseconds)) {
       state = WakeState::Waking;
     }
     hand->mInteractionAt = now;
@@ -273,7 +399,7 @@ XrTime PointCtrlSource::GetLastMovedAt() const {
 }
 
 bool PointCtrlSource::IsConnected() const {
-  return static_cast<bool>(mDevice);
+  return static_cast<bool>(GetDevice());
 }
 
 ///// start button mappings /////
@@ -317,11 +443,11 @@ void PointCtrlSource::MapActionsDedicatedScrollButtons(
   const auto isLeftHand = hand->mHand == XR_HAND_LEFT_EXT;
 
   const auto scrollUp = HAS_BUTTON(
-    isLeftHand ? Config::GameControllerLWheelUpButton
-               : Config::GameControllerRWheelUpButton);
+    isLeftHand ? mConfig->GameControllerLWheelUpButton
+               : mConfig->GameControllerRWheelUpButton);
   const auto scrollDown = HAS_BUTTON(
-    isLeftHand ? Config::GameControllerLWheelDownButton
-               : Config::GameControllerRWheelDownButton);
+    isLeftHand ? mConfig->GameControllerLWheelDownButton
+               : mConfig->GameControllerRWheelDownButton);
   if (scrollUp && !scrollDown) {
     state.mValueChange = ActionState::ValueChange::Decrease;
   } else if (scrollDown && !scrollUp) {
@@ -347,7 +473,7 @@ void PointCtrlSource::MapActionsModal(
     case LockState::Unlocked:
       if (
         b1 && b2
-        && Config::PointCtrlFCUMapping
+        && mConfig->PointCtrlFCUMapping
           == PointCtrlFCUMapping::ModalWithLeftLock) {
         hand->mScrollMode = LockState::MaybeLockingWithLeftHold;
         hand->mModeSwitchStart = now;
@@ -360,7 +486,7 @@ void PointCtrlSource::MapActionsModal(
       if (!b2) {
         if (
           interval > std::chrono::milliseconds(
-            Config::ShortPressLongPressMilliseconds)) {
+            mConfig->ShortPressLongPressMilliseconds)) {
           hand->mScrollMode = LockState::LockingWithLeftHoldAfterRelease;
         } else {
           hand->mScrollMode = LockState::Unlocked;
@@ -375,7 +501,7 @@ void PointCtrlSource::MapActionsModal(
       if (!b3) {
         if (
           interval > std::chrono::milliseconds(
-            Config::ShortPressLongPressMilliseconds)) {
+            mConfig->ShortPressLongPressMilliseconds)) {
           hand->mScrollMode = LockState::LockedWithoutLeftHold;
         } else {
           hand->mScrollMode = LockState::Unlocked;
@@ -426,7 +552,8 @@ void PointCtrlSource::MapActionsModal(
       break;
   }
 
-  if (state.mValueChange != previousValueChange && Config::VerboseDebug >= 1) {
+  if (
+    state.mValueChange != previousValueChange && mConfig->VerboseDebug >= 1) {
     DebugPrint(
       "Scroll mode change: {} -> {}",
       static_cast<uint8_t>(previousValueChange),
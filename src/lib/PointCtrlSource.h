@@ -6,11 +6,17 @@
 #include <openxr/openxr.h>
 #include <wil/com.h>
 
+#include <atomic>
 #include <cinttypes>
+#include <memory>
+#include <mutex>
 #include <thread>
 
+#include "Config.h"
 #include "InputSource.h"
 #include "OpenXRNext.h"
+#include "PointCtrlDistortionModel.h"
+#include "SampleRing.h"
 
 namespace HandTrackedCockpitClicking {
 
@@ -18,13 +24,22 @@ namespace HandTrackedCockpitClicking {
 // firmware.
 class PointCtrlSource final : public InputSource {
  public:
+  // Use the given config instead of the globals
+  PointCtrlSource(
+    std::shared_ptr<const Config::Snapshot>,
+    HANDLE eventNotification);
   explicit PointCtrlSource(HANDLE eventNotification);
   PointCtrlSource();
   ~PointCtrlSource();
 
+  // Call on the frame thread
+  void ReloadConfig(std::shared_ptr<const Config::Snapshot>);
+
   bool IsConnected() const;
   std::tuple<InputState, InputState> Update(PointerMode, const FrameInfo&)
     override;
+  void Sample(XrTime now) override;
+  void SetSampling(bool sampling) override;
 
   // Just used for calibration
   struct RawValues {
@@ -51,14 +66,21 @@ class PointCtrlSource final : public InputSource {
   XrTime GetLastMovedAt() const;
 
  private:
+  // Only used on the frame thread; the hotplug thread has its own reference
+  std::shared_ptr<const Config::Snapshot> mConfig;
+
   std::optional<std::jthread> mConnectDeviceThread;
-  void ConnectDevice();
+  void ConnectDevice(const Config::Snapshot&);
   void ConnectDeviceAsync();
 
+  struct EnumDevicesContext {
+    PointCtrlSource* mSource {nullptr};
+    const Config::Snapshot* mConfig {nullptr};
+  };
   static BOOL EnumDevicesCallbackStatic(
     LPCDIDEVICEINSTANCE lpddi,
     LPVOID pvRef);
-  BOOL EnumDevicesCallback(LPCDIDEVICEINSTANCE lpddi);
+  BOOL EnumDevicesCallback(const Config::Snapshot&, LPCDIDEVICEINSTANCE lpddi);
 
   enum class LockState {
     Unlocked,
@@ -89,17 +111,52 @@ class PointCtrlSource final : public InputSource {
   Hand mRightHand {XR_HAND_RIGHT_EXT, {XR_HAND_RIGHT_EXT}};
 
   wil::com_ptr<IDirectInput8W> mDI;
+
+  // Used by the frame, sampler, and hotplug threads; each takes its own
+  // reference with `GetDevice()`, so the device can't be released while
+  // another thread is polling it
+  mutable std::mutex mDeviceMutex;
   wil::com_ptr<IDirectInputDevice8W> mDevice;
+  wil::com_ptr<IDirectInputDevice8W> GetDevice() const;
+  void SetDevice(wil::com_ptr<IDirectInputDevice8W>);
+  // Releases `device` if it's still the current device
+  void ReleaseDevice(const wil::com_ptr<IDirectInputDevice8W>& device);
+
   HANDLE mEventHandle {};
 
   RawValues mRaw {};
   XrTime mLastMovedAt {};
 
+  // If set, used instead of the center and radians per unit
+  std::optional<PointCtrlLookupTable> mLookupTable;
+  // The `PointCtrlCalibrationModel` setting `mLookupTable` was built from
+  std::string mCalibrationModel;
+  void LoadCalibrationModel();
+
   void UpdatePose(const FrameInfo&, InputState* hand);
   void UpdateWakeState(bool hasButtons, XrTime now, Hand* hand);
 
   using RawButtons = decltype(DIJOYSTATE2::rgbButtons);
 
+  struct DeviceSample {
+    XrTime mTime {};
+    LONG mX {};
+    LONG mY {};
+    RawButtons mButtons {};
+  };
+  // Written by the sampler thread, if enabled
+  SampleRing<DeviceSample, 64> mSamples;
+  // Set by the sampler; while false, `Update()` polls the device itself
+  std::atomic_bool mIsSampling {false};
+  std::tuple<InputState, InputState> mLastSampledState {
+    InputState {XR_HAND_LEFT_EXT},
+    InputState {XR_HAND_RIGHT_EXT},
+  };
+
+  std::tuple<InputState, InputState> UpdateSampled();
+  std::tuple<InputState, InputState>
+  UpdateFromDevice(XrTime now, LONG x, LONG y, const RawButtons&);
+
   void MapActionsClassic(Hand*, XrTime now, const RawButtons&);
   void MapActionsModal(Hand*, XrTime now, const RawButtons&);
   void MapActionsDedicatedScrollButtons(Hand*, XrTime now, const RawButtons&);
@@ -0,0 +1,55 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+
+namespace HandTrackedCockpitClicking {
+
+/** Fixed-capacity single-producer, single-consumer queue.
+ *
+ * Used to move samples from a background thread to the frame thread without
+ * locks or allocations. If the consumer falls behind, new samples are dropped
+ * until it catches up.
+ */
+template <class T, std::size_t Capacity>
+class SampleRing final {
+  static_assert(
+    (Capacity & (Capacity - 1)) == 0,
+    "Capacity must be a power of two");
+
+ public:
+  // Producer only
+  bool Push(const T& value) noexcept {
+    const auto head = mHead.load(std::memory_order_relaxed);
+    const auto tail = mTail.load(std::memory_order_acquire);
+    if (head - tail >= Capacity) {
+      return false;
+    }
+    mBuffer[head % Capacity] = value;
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only; calls `f` for each queued sample, oldest first
+  template <class F>
+  std::size_t Drain(F&& f) {
+    const auto head = mHead.load(std::memory_order_acquire);
+    auto tail = mTail.load(std::memory_order_relaxed);
+    const auto count = head - tail;
+    for (; tail != head; ++tail) {
+      f(mBuffer[tail % Capacity]);
+    }
+    mTail.store(tail, std::memory_order_release);
+    return count;
+  }
+
+ private:
+  std::array<T, Capacity> mBuffer {};
+  alignas(64) std::atomic<uint64_t> mHead {0};
+  alignas(64) std::atomic<uint64_t> mTail {0};
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,62 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "SessionCapture.h"
+
+#include "DebugPrint.h"
+
+namespace HandTrackedCockpitClicking::SessionCapture {
+
+PointCtrlObservation::PointCtrlObservation(const InputState& state)
+  : mValid(state.mDirection.has_value()),
+    mDirection(state.mDirection.value_or(XrVector2f {})),
+    mPositionUpdatedAt(state.mPositionUpdatedAt) {
+}
+
+Writer::Writer(const std::filesystem::path& path)
+  : mFile(path, std::ios::binary | std::ios::trunc) {
+  if (!mFile) {
+    DebugPrint(L"Failed to open capture file '{}'", path.wstring());
+    return;
+  }
+  const Header header {};
+  mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  DebugPrint(L"Capturing hand tracking to '{}'", path.wstring());
+}
+
+bool Writer::IsOpen() const {
+  return mFile.is_open() && mFile.good();
+}
+
+void Writer::Write(const Frame& frame) {
+  if (!mFile) {
+    return;
+  }
+  mFile.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+}
+
+std::optional<std::vector<Frame>> Load(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    DebugPrint(L"Failed to open capture file '{}'", path.wstring());
+    return std::nullopt;
+  }
+
+  Header header {};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (
+    file.gcount() != sizeof(header) || header.mMagic != Magic
+    || header.mVersion != Version || header.mFrameSize != sizeof(Frame)) {
+    DebugPrint(L"'{}' is not a compatible capture file", path.wstring());
+    return std::nullopt;
+  }
+
+  std::vector<Frame> frames;
+  Frame frame {};
+  // A truncated final frame is expected if the game crashed or was killed
+  while (file.read(reinterpret_cast<char*>(&frame), sizeof(frame))) {
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+}// namespace HandTrackedCockpitClicking::SessionCapture
@@ -0,0 +1,68 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "FrameInfo.h"
+#include "HandTrackingGates.h"
+#include "InputState.h"
+
+/** A binary recording of hand tracking observations, one frame at a time.
+ *
+ * Frames are written as-is after a small header, so a capture can only be
+ * read by a build with the same layout; the header's version and frame size
+ * are checked when loading.
+ */
+namespace HandTrackedCockpitClicking::SessionCapture {
+
+constexpr uint32_t Magic = 0x50414348;// 'HCAP'
+constexpr uint32_t Version = 3;
+
+// PointCtrl's direction before fusion; only recorded with the Fusion source
+struct PointCtrlObservation {
+  bool mValid {false};
+  XrVector2f mDirection {};
+  XrTime mPositionUpdatedAt {};
+
+  PointCtrlObservation() = default;
+  explicit PointCtrlObservation(const InputState&);
+};
+
+struct Frame {
+  FrameInfo mFrameInfo;
+  // Left, right
+  std::array<HandObservation, 2> mHands;
+  std::array<PointCtrlObservation, 2> mPointCtrl;
+};
+static_assert(std::is_trivially_copyable_v<Frame>);
+
+struct Header {
+  uint32_t mMagic {Magic};
+  uint32_t mVersion {Version};
+  uint32_t mFrameSize {sizeof(Frame)};
+  uint32_t mReserved {};
+};
+
+class Writer final {
+ public:
+  Writer() = delete;
+  explicit Writer(const std::filesystem::path&);
+
+  bool IsOpen() const;
+  void Write(const Frame&);
+
+ private:
+  std::ofstream mFile;
+};
+
+// Returns nullopt if the file can't be read, or isn't a compatible capture
+std::optional<std::vector<Frame>> Load(const std::filesystem::path&);
+
+}// namespace HandTrackedCockpitClicking::SessionCapture
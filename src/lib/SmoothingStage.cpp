@@ -0,0 +1,154 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "SmoothingStage.h"
+
+#include <directxtk/SimpleMath.h>
+
+#include <cmath>
+
+#include "Config.h"
+
+using namespace DirectX::SimpleMath;
+
+namespace HandTrackedCockpitClicking {
+
+std::optional<XrPosef> ProjectDirection(
+  const FrameInfo& frameInfo,
+  const InputState& hand,
+  float distance) {
+  if (hand.mPose) {
+    return hand.mPose;
+  }
+
+  if (!hand.mDirection) {
+    return {};
+  }
+
+  const auto rx = hand.mDirection->x;
+  const auto ry = hand.mDirection->y;
+
+  const auto pointDirection
+    = Quaternion::CreateFromAxisAngle(Vector3::UnitX, rx)
+    * Quaternion::CreateFromAxisAngle(Vector3::UnitY, -ry);
+
+  const auto p = Vector3::Transform({0.0f, 0.0f, -distance}, pointDirection);
+  const auto o = pointDirection;
+
+  const XrPosef viewPose {
+    .orientation = {o.x, o.y, o.z, o.w},
+    .position = {p.x, p.y, p.z},
+  };
+
+  const auto worldPose = viewPose * frameInfo.mViewInLocal;
+  return worldPose;
+}
+
+SmoothingStage::Parameters SmoothingStage::Parameters::FromConfig() {
+  return FromConfig(Config::Current());
+}
+
+SmoothingStage::Parameters SmoothingStage::Parameters::FromConfig(
+  const Config::Snapshot& config) {
+  return {
+    .mFactor = config.SmoothingFactor,
+    .mProjectionDistance = config.ProjectionDistance,
+  };
+}
+
+SmoothingStage::SmoothingStage(const Parameters& parameters)
+  : mParameters(parameters) {
+}
+
+std::string_view SmoothingStage::GetName() const {
+  return "Smoothing";
+}
+
+void SmoothingStage::Process(
+  const FrameInfo& frameInfo,
+  InputPipeline::Hands* hands) {
+  for (std::size_t i = 0; i < hands->size(); ++i) {
+    auto& hand = (*hands)[i];
+    const Snapshot snapshot {frameInfo, hand};
+    hand = SmoothHand(snapshot, mPreviousFrame[i]);
+    mPreviousFrame[i] = snapshot;
+  }
+}
+
+InputState SmoothingStage::SmoothHand(
+  const Snapshot& currentFrame,
+  const std::optional<Snapshot>& maybePreviousFrame) const {
+  const auto& currentInput = currentFrame.mInputState;
+  if (currentInput.mPointerMode == PointerMode::None) {
+    return currentInput;
+  }
+
+  if (mParameters.mFactor > 0.99f) {
+    return currentInput;
+  }
+
+  if (!maybePreviousFrame) {
+    return currentInput;
+  }
+  const auto& previousFrame = *maybePreviousFrame;
+  const auto& previousInput = previousFrame.mInputState;
+
+  if (currentInput.mPointerMode != previousInput.mPointerMode) {
+    return currentInput;
+  }
+
+  switch (currentInput.mPointerMode) {
+    case PointerMode::None:
+      // TODO (C++23): std::unreachable()
+      __assume(false);
+    case PointerMode::Direction: {
+      if (!(currentInput.mDirection && previousInput.mDirection)) {
+        return currentInput;
+      }
+
+      const auto distance = mParameters.mProjectionDistance;
+      const auto currentPose
+        = ProjectDirection(currentFrame.mFrameInfo, currentInput, distance);
+      const auto previousPose
+        = ProjectDirection(previousFrame.mFrameInfo, previousInput, distance);
+      if (!(currentPose && previousPose)) {
+        return currentInput;
+      }
+
+      const auto p = (SmoothPose(*currentPose, *previousPose)
+                      * currentFrame.mFrameInfo.mLocalInView)
+                       .position;
+      const auto rx = std::atan2f(p.y, -p.z);
+      const auto ry = std::atan2f(p.x, -p.z);
+      auto ret = currentInput;
+      ret.mDirection = {rx, ry};
+      return ret;
+    }
+    case PointerMode::Pose: {
+      if (!(currentInput.mPose && previousInput.mPose)) {
+        return currentInput;
+      }
+
+      auto ret = currentInput;
+      ret.mPose = SmoothPose(*currentInput.mPose, *previousInput.mPose);
+      return ret;
+    }
+    default:
+      __assume(false);
+  }
+}
+
+XrPosef SmoothingStage::SmoothPose(
+  const XrPosef& currentPose,
+  const XrPosef& previousPose) const {
+  const auto ao = XrQuatToSM(previousPose.orientation);
+  const auto bo = XrQuatToSM(currentPose.orientation);
+  const auto ap = XrVecToSM(previousPose.position);
+  const auto bp = XrVecToSM(currentPose.position);
+
+  return {
+    SMQuatToXr(Quaternion::Slerp(ao, bo, mParameters.mFactor)),
+    SMVecToXr(Vector3::Lerp(ap, bp, mParameters.mFactor)),
+  };
+}
+
+}// namespace HandTrackedCockpitClicking
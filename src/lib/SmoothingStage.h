@@ -0,0 +1,56 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <optional>
+
+#include "InputPipeline.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace Config {
+struct Snapshot;
+}
+
+// The pose `distance` meters along the hand's direction, unless the hand
+// already has a pose
+std::optional<XrPosef> ProjectDirection(
+  const FrameInfo&,
+  const InputState& hand,
+  float distance);
+
+// Blends each hand's pointer with the previous frame's
+class SmoothingStage final : public InputPipeline::Stage {
+ public:
+  struct Parameters {
+    // 1.0 for no smoothing
+    float mFactor {1.0f};
+    float mProjectionDistance {};
+
+    static Parameters FromConfig();
+    static Parameters FromConfig(const Config::Snapshot&);
+  };
+
+  SmoothingStage() = delete;
+  explicit SmoothingStage(const Parameters&);
+
+  std::string_view GetName() const override;
+  void Process(const FrameInfo&, InputPipeline::Hands*) override;
+
+ private:
+  struct Snapshot {
+    FrameInfo mFrameInfo {};
+    InputState mInputState {};
+  };
+
+  Parameters mParameters;
+  std::array<std::optional<Snapshot>, 2> mPreviousFrame;
+
+  InputState SmoothHand(
+    const Snapshot& currentFrame,
+    const std::optional<Snapshot>& previousFrame) const;
+  XrPosef SmoothPose(const XrPosef& current, const XrPosef& previous) const;
+};
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,238 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+/** Per-frame pipeline state, shared with external tools.
+ *
+ * The API layer writes one `FrameRecord` per frame into a fixed-size ring in
+ * shared memory; readers copy records out without ever blocking the writer.
+ * Each slot is a seqlock: the writer makes the sequence odd while writing, so
+ * readers can detect and retry torn reads.
+ *
+ * The seqlock only works with a single writer, so writers must claim the
+ * buffer with `TryAcquireWriter()` first.
+ *
+ * This header only uses the standard library, so readers aren't tied to
+ * Windows.
+ */
+namespace HandTrackedCockpitClicking::Telemetry {
+
+constexpr uint32_t Magic = 0x43435448;// "HTCC"
+constexpr uint32_t Version = 2;
+// About 2.8 seconds at 90Hz
+constexpr std::size_t Capacity = 256;
+constexpr std::size_t MaxStages = 16;
+
+// Name of the shared memory on Windows
+constexpr std::wstring_view SharedMemoryName {L"Local\\HTCCTelemetry"};
+
+struct HandRecord {
+  enum Flags : uint8_t {
+    HavePose = 1 << 0,
+    HaveDirection = 1 << 1,
+    Primary = 1 << 2,
+    Secondary = 1 << 3,
+    // Only set for OpenXR hand tracking; the runtime may be tracking a
+    // hand while it's asleep, in which case there's no pose
+    Awake = 1 << 4,
+    Tracked = 1 << 5,
+  };
+  uint8_t mFlags {};
+  // -1 for decrease, 1 for increase
+  int8_t mValueChange {};
+  uint8_t mPointerMode {};
+  uint8_t mReserved {};
+
+  int64_t mPositionUpdatedAt {};
+  // LOCAL space
+  std::array<float, 3> mPosition {};
+  std::array<float, 4> mOrientation {};
+  // Radians; see `InputState::mDirection`
+  std::array<float, 2> mDirection {};
+};
+
+struct StageRecord {
+  // Null-terminated unless full
+  std::array<char, 24> mName {};
+  uint32_t mNanoseconds {};
+};
+
+struct FrameRecord {
+  uint64_t mFrame {};
+  int64_t mNow {};
+  int64_t mPredictedDisplayTime {};
+  uint8_t mHibernating {};
+  uint8_t mStageCount {};
+  std::array<uint8_t, 6> mReserved {};
+
+  // Left, right; output of the last source stage, before any filters
+  std::array<HandRecord, 2> mRaw {};
+  // Left, right; what the sinks were given
+  std::array<HandRecord, 2> mFinal {};
+  std::array<StageRecord, MaxStages> mStages {};
+};
+static_assert(std::is_trivially_copyable_v<FrameRecord>);
+
+struct Slot {
+  std::atomic<uint64_t> mSequence;
+  FrameRecord mRecord;
+};
+
+struct Header {
+  uint32_t mMagic;
+  uint32_t mVersion;
+  uint32_t mCapacity;
+  uint32_t mRecordSize;
+  // The frame number the next record will have
+  std::atomic<uint64_t> mNextFrame;
+  // Zero if there's no writer; see `MakeWriterID()`
+  std::atomic<uint64_t> mWriter;
+};
+
+struct Buffer {
+  Header mHeader;
+  std::array<Slot, Capacity> mSlots;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::is_standard_layout_v<Buffer>);
+
+// Buffer must be zero-initialized, e.g. fresh shared memory
+inline void Initialize(Buffer* buffer) {
+  auto& header = buffer->mHeader;
+  header.mVersion = Version;
+  header.mCapacity = Capacity;
+  header.mRecordSize = sizeof(FrameRecord);
+  std::atomic_thread_fence(std::memory_order_release);
+  header.mMagic = Magic;
+}
+
+/* Identifies a writer; the high 32 bits are its process ID.
+ *
+ * `instance` distinguishes writers in the same process, and must not be 0.
+ */
+constexpr uint64_t MakeWriterID(uint32_t processID, uint32_t instance) {
+  return (static_cast<uint64_t>(processID) << 32) | instance;
+}
+
+constexpr uint32_t GetWriterProcessID(uint64_t writer) {
+  return static_cast<uint32_t>(writer >> 32);
+}
+
+// Zero if there's no writer
+inline uint64_t GetWriter(const Buffer* buffer) {
+  return buffer->mHeader.mWriter.load(std::memory_order_acquire);
+}
+
+/* Claim the buffer for `writer`, if there's no other writer.
+ *
+ * If the current writer went away without calling `ReleaseWriter()` - e.g.
+ * its process crashed - pass its ID as `stale` to take over from it.
+ */
+inline bool
+TryAcquireWriter(Buffer* buffer, uint64_t writer, uint64_t stale = 0) {
+  return buffer->mHeader.mWriter.compare_exchange_strong(
+    stale, writer, std::memory_order_acq_rel);
+}
+
+inline void ReleaseWriter(Buffer* buffer, uint64_t writer) {
+  buffer->mHeader.mWriter.compare_exchange_strong(
+    writer, 0, std::memory_order_acq_rel);
+}
+
+// Only call while holding `TryAcquireWriter()`; sets `record.mFrame`
+inline void Write(Buffer* buffer, FrameRecord record) {
+  auto& header = buffer->mHeader;
+  const auto frame = header.mNextFrame.load(std::memory_order_relaxed);
+  record.mFrame = frame;
+
+  auto& slot = buffer->mSlots[frame % Capacity];
+  const auto sequence = slot.mSequence.load(std::memory_order_relaxed);
+  slot.mSequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.mRecord, &record, sizeof(record));
+  slot.mSequence.store(sequence + 2, std::memory_order_release);
+
+  header.mNextFrame.store(frame + 1, std::memory_order_release);
+}
+
+class Reader final {
+ public:
+  Reader() = delete;
+  explicit Reader(const Buffer* buffer) : mBuffer(buffer) {
+  }
+
+  // False if the writer uses a different layout
+  bool IsCompatible() const {
+    const auto& header = mBuffer->mHeader;
+    return header.mMagic == Magic && header.mVersion == Version
+      && header.mCapacity == Capacity
+      && header.mRecordSize == sizeof(FrameRecord);
+  }
+
+  uint64_t GetNextFrame() const {
+    return mBuffer->mHeader.mNextFrame.load(std::memory_order_acquire);
+  }
+
+  // Empty if `frame` hasn't been written yet, or has been overwritten
+  std::optional<FrameRecord> Read(uint64_t frame) const {
+    const auto next = this->GetNextFrame();
+    if (frame >= next || next - frame > Capacity) {
+      return {};
+    }
+
+    const auto& slot = mBuffer->mSlots[frame % Capacity];
+    // Bounded; if we keep losing the race, the slot is being overwritten
+    for (int attempt = 0; attempt < 4; ++attempt) {
+      const auto before = slot.mSequence.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      FrameRecord record;
+      std::memcpy(&record, &slot.mRecord, sizeof(record));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.mSequence.load(std::memory_order_relaxed) != before) {
+        continue;
+      }
+      if (record.mFrame != frame) {
+        return {};
+      }
+      return record;
+    }
+    return {};
+  }
+
+  /* Call `f` with each record from `*cursor` onwards, oldest first.
+   *
+   * Records that were overwritten before they could be read are skipped;
+   * `*cursor` is advanced past everything that was visited.
+   */
+  template <class F>
+  std::size_t ReadSince(uint64_t* cursor, F&& f) const {
+    const auto next = this->GetNextFrame();
+    // Also handles the writer restarting
+    if (*cursor > next || next - *cursor > Capacity) {
+      *cursor = (next > Capacity) ? (next - Capacity) : 0;
+    }
+    std::size_t count = 0;
+    for (; *cursor < next; ++*cursor) {
+      if (const auto record = this->Read(*cursor)) {
+        f(*record);
+        ++count;
+      }
+    }
+    return count;
+  }
+
+ private:
+  const Buffer* mBuffer {nullptr};
+};
+
+}// namespace HandTrackedCockpitClicking::Telemetry
@@ -0,0 +1,168 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "TelemetryStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+using Flags = Telemetry::HandRecord::Flags;
+
+bool IsTracked(const Telemetry::HandRecord& hand) {
+  constexpr auto mask = Flags::Tracked | Flags::HavePose | Flags::HaveDirection;
+  return hand.mFlags & mask;
+}
+
+float ToMilliseconds(int64_t nanoseconds) {
+  return static_cast<float>(nanoseconds) / 1'000'000;
+}
+}// namespace
+
+float TelemetryStats::DirectionSums::StandardDeviation() const {
+  if (mCount < 2) {
+    return 0;
+  }
+  double variance = 0;
+  for (std::size_t i = 0; i < 2; ++i) {
+    const auto mean = mSum[i] / mCount;
+    variance += std::max(0.0, (mSumOfSquares[i] / mCount) - (mean * mean));
+  }
+  return static_cast<float>(std::sqrt(variance));
+}
+
+void TelemetryStats::Reset() {
+  *this = {};
+}
+
+void TelemetryStats::UpdateStageNames(const Telemetry::FrameRecord& record) {
+  const auto count = std::min<std::size_t>(
+    record.mStageCount, Telemetry::MaxStages);
+  const auto changed = (count != mStageNames.size())
+    || !std::ranges::equal(
+      mStageNames,
+      std::span {record.mStages.data(), count},
+      {},
+      {},
+      [](const Telemetry::StageRecord& stage) {
+        return std::string_view {
+          stage.mName.data(),
+          strnlen(stage.mName.data(), stage.mName.size())};
+      });
+  if (!changed) {
+    return;
+  }
+
+  // The pipeline was rebuilt, so older buckets aren't comparable
+  this->Reset();
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& name = record.mStages[i].mName;
+    mStageNames.emplace_back(name.data(), strnlen(name.data(), name.size()));
+  }
+}
+
+void TelemetryStats::Add(const Telemetry::FrameRecord& record) {
+  this->UpdateStageNames(record);
+
+  const auto now = record.mNow;
+  const auto bucketDuration
+    = std::chrono::nanoseconds(BucketDuration).count();
+  if (mCurrent.mFrameCount && now - mCurrent.mStart >= bucketDuration) {
+    this->FinishBucket();
+  }
+  if (!mCurrent.mFrameCount) {
+    mCurrent.mStart = now;
+  }
+  ++mCurrent.mFrameCount;
+
+  for (std::size_t i = 0; i < 2; ++i) {
+    auto& hand = mHands[i];
+    const auto& raw = record.mRaw[i];
+    const auto& output = record.mFinal[i];
+
+    const auto tracked = IsTracked(raw);
+    if (tracked && !hand.mTracked) {
+      hand.mTrackedSince = now;
+    } else if (hand.mTracked && !tracked) {
+      ++mCurrent.mTrackingLosses;
+    }
+    hand.mTracked = tracked;
+
+    const bool awake = raw.mFlags & Flags::Awake;
+    if (awake && !hand.mAwake && tracked) {
+      mCurrent.mWakeLatency = std::max(
+        mCurrent.mWakeLatency, ToMilliseconds(now - hand.mTrackedSince));
+    }
+    hand.mAwake = awake;
+
+    const bool rawPrimary = raw.mFlags & Flags::Primary;
+    if (rawPrimary && !hand.mRawPrimary) {
+      hand.mRawPrimarySince = now;
+    }
+    hand.mRawPrimary = rawPrimary;
+
+    const bool finalPrimary = output.mFlags & Flags::Primary;
+    if (finalPrimary && !hand.mFinalPrimary && rawPrimary) {
+      mCurrent.mClickLatency = std::max(
+        mCurrent.mClickLatency, ToMilliseconds(now - hand.mRawPrimarySince));
+    }
+    hand.mFinalPrimary = finalPrimary;
+
+    if (output.mFlags & Flags::HaveDirection) {
+      auto& sums = mCurrent.mDirections[i];
+      ++sums.mCount;
+      for (std::size_t axis = 0; axis < 2; ++axis) {
+        const double value = output.mDirection[axis];
+        sums.mSum[axis] += value;
+        sums.mSumOfSquares[axis] += value * value;
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < mStageNames.size(); ++i) {
+    mCurrent.mStageNanoseconds[i] += record.mStages[i].mNanoseconds;
+  }
+}
+
+void TelemetryStats::FinishBucket() {
+  const auto frames = mCurrent.mFrameCount;
+  const std::chrono::duration<float> duration = BucketDuration;
+
+  Bucket bucket {
+    .mFrameCount = frames,
+    .mJitter = std::max(
+      mCurrent.mDirections[0].StandardDeviation(),
+      mCurrent.mDirections[1].StandardDeviation()),
+    .mTrackingLossRate = mCurrent.mTrackingLosses / duration.count(),
+    .mWakeLatency = mCurrent.mWakeLatency,
+    .mClickLatency = mCurrent.mClickLatency,
+  };
+  for (std::size_t i = 0; i < mStageNames.size(); ++i) {
+    bucket.mStageMicroseconds[i]
+      = static_cast<float>(mCurrent.mStageNanoseconds[i]) / (frames * 1000);
+  }
+
+  mBuckets[mNextBucket] = bucket;
+  mNextBucket = (mNextBucket + 1) % BucketCount;
+  mBucketsUsed = std::min(mBucketsUsed + 1, BucketCount);
+  mCurrent = {};
+}
+
+std::vector<TelemetryStats::Bucket> TelemetryStats::GetBuckets() const {
+  std::vector<Bucket> ret;
+  ret.reserve(mBucketsUsed);
+  const auto first = (mNextBucket + BucketCount - mBucketsUsed) % BucketCount;
+  for (std::size_t i = 0; i < mBucketsUsed; ++i) {
+    ret.push_back(mBuckets[(first + i) % BucketCount]);
+  }
+  return ret;
+}
+
+std::span<const std::string> TelemetryStats::GetStageNames() const {
+  return mStageNames;
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,92 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Telemetry.h"
+
+namespace HandTrackedCockpitClicking {
+
+/** Summarizes telemetry records into fixed-length time buckets for display.
+ *
+ * Records arrive at the headset's frame rate, which is far more than a UI
+ * needs; each record is folded into the current bucket in constant time, and
+ * only completed buckets are kept.
+ */
+class TelemetryStats final {
+ public:
+  static constexpr std::chrono::milliseconds BucketDuration {250};
+  // 30 seconds
+  static constexpr std::size_t BucketCount = 120;
+
+  struct Bucket {
+    uint32_t mFrameCount {};
+    // Standard deviation of the pointer direction, in radians; the larger of
+    // the two hands
+    float mJitter {};
+    // Times per second a hand stopped being tracked
+    float mTrackingLossRate {};
+    // From a hand being tracked to it waking, in milliseconds; zero if no
+    // hand woke in this bucket
+    float mWakeLatency {};
+    // From a source reporting a click to the sinks receiving it, in
+    // milliseconds; zero if there were no clicks in this bucket
+    float mClickLatency {};
+    // Average CPU time per frame for each of `GetStageNames()`
+    std::array<float, Telemetry::MaxStages> mStageMicroseconds {};
+  };
+
+  void Add(const Telemetry::FrameRecord&);
+  void Reset();
+
+  // Completed buckets, oldest first
+  std::vector<Bucket> GetBuckets() const;
+  std::span<const std::string> GetStageNames() const;
+
+ private:
+  struct HandState {
+    bool mTracked {false};
+    bool mAwake {false};
+    int64_t mTrackedSince {};
+    bool mRawPrimary {false};
+    int64_t mRawPrimarySince {};
+    bool mFinalPrimary {false};
+  };
+
+  struct DirectionSums {
+    uint32_t mCount {};
+    std::array<double, 2> mSum {};
+    std::array<double, 2> mSumOfSquares {};
+
+    float StandardDeviation() const;
+  };
+
+  struct Accumulator {
+    int64_t mStart {};
+    uint32_t mFrameCount {};
+    uint32_t mTrackingLosses {};
+    float mWakeLatency {};
+    float mClickLatency {};
+    std::array<DirectionSums, 2> mDirections {};
+    std::array<uint64_t, Telemetry::MaxStages> mStageNanoseconds {};
+  };
+
+  std::array<HandState, 2> mHands {};
+  std::vector<std::string> mStageNames;
+  Accumulator mCurrent {};
+
+  std::array<Bucket, BucketCount> mBuckets {};
+  std::size_t mNextBucket {};
+  std::size_t mBucketsUsed {};
+
+  void UpdateStageNames(const Telemetry::FrameRecord&);
+  void FinishBucket();
+};
+
+}// namespace HandTrackedCockpitClicking
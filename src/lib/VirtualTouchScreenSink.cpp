@@ -10,24 +10,56 @@
 namespace HandTrackedCockpitClicking {
 
 VirtualTouchScreenSink::VirtualTouchScreenSink(
+  std::shared_ptr<const Config::Snapshot> config,
   std::optional<Calibration> calibration,
-  DWORD targetProcessID)
-  : mCalibration(calibration), mTargetProcessID(targetProcessID) {
+  DWORD targetProcessID,
+  std::unique_ptr<InputInjector> injector)
+  : VirtualTouchScreenSink(
+      std::move(config),
+      calibration,
+      std::make_unique<WindowTracker>(targetProcessID),
+      std::move(injector)) {
+}
+
+VirtualTouchScreenSink::VirtualTouchScreenSink(
+  std::shared_ptr<const Config::Snapshot> config,
+  std::optional<Calibration> calibration,
+  const WindowTracker::Window& window,
+  std::unique_ptr<InputInjector> injector)
+  : VirtualTouchScreenSink(
+      std::move(config),
+      calibration,
+      std::make_unique<WindowTracker>(window),
+      std::move(injector)) {
+}
+
+VirtualTouchScreenSink::VirtualTouchScreenSink(
+  std::shared_ptr<const Config::Snapshot> config,
+  std::optional<Calibration> calibration,
+  std::unique_ptr<WindowTracker> windowTracker,
+  std::unique_ptr<InputInjector> injector)
+  : mConfig(std::move(config)),
+    mCalibration(calibration),
+    mWindowTracker(std::move(windowTracker)),
+    mInjector(std::move(injector)) {
+  if (!mInjector) {
+    mInjector = std::make_unique<SendInputInjector>();
+  }
   DebugPrint(
     "Initialized virtual touch screen - PointerSink: {}; ActionSink: {}",
-    IsPointerSink(),
-    IsActionSink());
-
-  UpdateMainWindow();
+    IsPointerSink(*mConfig),
+    IsActionSink(*mConfig));
 }
 
 VirtualTouchScreenSink::VirtualTouchScreenSink(
+  std::shared_ptr<const Config::Snapshot> config,
   const std::shared_ptr<OpenXRNext>& oxr,
   XrSession session,
   XrViewConfigurationType viewConfigurationType,
   XrTime nextDisplayTime,
   XrSpace viewSpace)
   : VirtualTouchScreenSink(
+      std::move(config),
       CalibrationFromOpenXR(
         oxr,
         session,
@@ -37,6 +69,10 @@ VirtualTouchScreenSink::VirtualTouchScreenSink(
       GetCurrentProcessId()) {
 }
 
+VirtualTouchScreenSink::~VirtualTouchScreenSink() {
+  this->ReleaseButtons();
+}
+
 std::optional<VirtualTouchScreenSink::Calibration>
 VirtualTouchScreenSink::CalibrationFromOpenXR(
   const std::shared_ptr<OpenXRNext>& oxr,
@@ -140,8 +176,9 @@ VirtualTouchScreenSink::CalibrationFromOpenXRView(const XrView& view) {
 }
 
 std::optional<VirtualTouchScreenSink::Calibration>
-VirtualTouchScreenSink::CalibrationFromConfig() {
-  if (!Config::HaveSavedFOV) {
+VirtualTouchScreenSink::CalibrationFromConfig(
+  const Config::Snapshot& config) {
+  if (!config.HaveSavedFOV) {
     return {};
   }
 
@@ -149,106 +186,42 @@ VirtualTouchScreenSink::CalibrationFromConfig() {
     .type = XR_TYPE_VIEW,
     .pose = XR_POSEF_IDENTITY,
     .fov = XrFovf {
-      .angleLeft = Config::LeftEyeFOVLeft,
-      .angleRight = Config::LeftEyeFOVRight,
-      .angleUp = Config::LeftEyeFOVUp,
-      .angleDown = Config::LeftEyeFOVDown,
+      .angleLeft = config.LeftEyeFOVLeft,
+      .angleRight = config.LeftEyeFOVRight,
+      .angleUp = config.LeftEyeFOVUp,
+      .angleDown = config.LeftEyeFOVDown,
   },
   };
   return CalibrationFromOpenXRView(view);
 }
 
-void VirtualTouchScreenSink::UpdateMainWindow() {
-  mConsoleWindow = GetConsoleWindow();
-  EnumWindows(
-    &VirtualTouchScreenSink::EnumWindowCallback,
-    reinterpret_cast<LPARAM>(this));
-  mLastWindowCheck = std::chrono::steady_clock::now();
-}
-
-BOOL CALLBACK
-VirtualTouchScreenSink::EnumWindowCallback(HWND hwnd, LPARAM lparam) {
-  auto self = reinterpret_cast<VirtualTouchScreenSink*>(lparam);
-
-  if (hwnd == self->mConsoleWindow) {
-    return TRUE;
-  }
-
-  if (hwnd == self->mWindow) {
-    return FALSE;
-  }
-
-  DWORD processID {};
-  GetWindowThreadProcessId(hwnd, &processID);
-  if (processID != self->mTargetProcessID) {
-    return TRUE;
-  }
-
-  // Has a parent window
-  if (GetWindow(hwnd, GW_OWNER) != (HWND)0) {
-    return TRUE;
-  }
-
-  self->mWindow = hwnd;
-
-  RECT rect {};
-  // ... this is annoyingly enough in client coordinates
-  GetClientRect(hwnd, &rect);
-  ClientToScreen(hwnd, reinterpret_cast<LPPOINT>(&rect.left));
-  ClientToScreen(hwnd, reinterpret_cast<LPPOINT>(&rect.right));
-
-  self->mWindowRect = rect;
-  self->mWindowSize = {
-    static_cast<float>(rect.right - rect.left),
-    static_cast<float>(rect.bottom - rect.top),
-  };
-  DebugPrint(
-    "Found game window; mapping hand-tracking within headset FOV to "
-    "on-screen "
-    "rect ({}, {}) -> ({}, {})",
-    rect.left,
-    rect.top,
-    rect.right,
-    rect.bottom);
-
-  auto monitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTOPRIMARY);
-  MONITORINFO monitorInfo {sizeof(MONITORINFO)};
-  GetMonitorInfo(monitor, &monitorInfo);
-
-  rect = monitorInfo.rcMonitor;
-  self->mScreenSize = {
-    static_cast<float>(rect.right - rect.left),
-    static_cast<float>(rect.bottom - rect.top),
-  };
-
-  return FALSE;
-}
-
 template <class Actual, class Wanted>
 static constexpr bool HasFlags(Actual actual, Wanted wanted) {
   return (actual & wanted) == wanted;
 }
 
-bool VirtualTouchScreenSink::IsPointerSink() {
-  return Config::PointerSink == PointerSink::VirtualTouchScreen;
+bool VirtualTouchScreenSink::IsPointerSink(const Config::Snapshot& config) {
+  return config.PointerSink == PointerSink::VirtualTouchScreen;
 }
 
-static bool IsActionSink(ActionSink actionSink) {
+static bool IsActionSink(
+  const Config::Snapshot& config,
+  ActionSink actionSink) {
   return (actionSink == ActionSink::VirtualTouchScreen)
     || ((actionSink == ActionSink::MatchPointerSink)
-        && VirtualTouchScreenSink::IsPointerSink());
+        && VirtualTouchScreenSink::IsPointerSink(config));
 }
 
-static bool IsClickActionSink() {
-  return IsActionSink(Config::ClickActionSink);
+static bool IsClickActionSink(const Config::Snapshot& config) {
+  return IsActionSink(config, config.ClickActionSink);
 }
 
-static bool IsScrollActionSink() {
-  return IsActionSink(Config::ScrollActionSink);
+static bool IsScrollActionSink(const Config::Snapshot& config) {
+  return IsActionSink(config, config.ScrollActionSink);
 }
 
-bool VirtualTouchScreenSink::IsActionSink() {
-  return IsClickActionSink() || IsScrollActionSink();
+bool VirtualTouchScreenSink::IsActionSink(const Config::Snapshot& config) {
+  return IsClickActionSink(config) || IsScrollActionSink(config);
 }
 
 bool VirtualTouchScreenSink::RotationToCartesian(
@@ -273,45 +246,87 @@ bool VirtualTouchScreenSink::RotationToCartesian(
 }
 
 void VirtualTouchScreenSink::Update(
+  const FrameInfo& frameInfo,
   const InputState& left,
   const InputState& right) {
+  const Time now {frameInfo.mNow};
   if (right.mActions.Any()) {
-    Update(right);
+    Update(now, right);
     return;
   }
   if (left.mActions.Any()) {
-    Update(left);
+    Update(now, left);
     return;
   }
 
   if (left.mDirection && !right.mDirection) {
-    Update(left);
+    Update(now, left);
     return;
   }
 
   if (right.mDirection && !left.mDirection) {
-    Update(right);
+    Update(now, right);
     return;
   }
 }
 
-void VirtualTouchScreenSink::Update(const InputState& hand) {
-  std::vector<INPUT> events;
+void VirtualTouchScreenSink::ReloadConfig(
+  std::shared_ptr<const Config::Snapshot> config) {
+  mConfig = std::move(config);
+  if (!IsClickActionSink(*mConfig)) {
+    this->ReleaseButtons();
+  }
+}
+
+void VirtualTouchScreenSink::PushEvent(const INPUT& event) {
+  mEvents.at(mEventCount++) = event;
+}
+
+void VirtualTouchScreenSink::ReleaseButtons() {
+  // Otherwise, they stay down until the user next clicks
+  mEventCount = MoveEventIndex + 1;
+  if (mLeftClick) {
+    mLeftClick = false;
+    PushEvent({.type = INPUT_MOUSE, .mi = {.dwFlags = MOUSEEVENTF_LEFTUP}});
+  }
+  if (mRightClick) {
+    mRightClick = false;
+    PushEvent({.type = INPUT_MOUSE, .mi = {.dwFlags = MOUSEEVENTF_RIGHTUP}});
+  }
+  const auto count = mEventCount - (MoveEventIndex + 1);
+  if (count > 0) {
+    mInjector->Inject({&mEvents[MoveEventIndex + 1], count});
+  }
+}
+
+void VirtualTouchScreenSink::Update(Time now, const InputState& hand) {
+  // Leave space for the move; we don't know if we need it until we've seen
+  // the other events
+  mEventCount = MoveEventIndex + 1;
+  bool haveMove = false;
+  bool moveChanged = false;
 
-  const auto now = std::chrono::steady_clock::now();
   const auto& rotation = hand.mDirection;
+  const auto window = mWindowTracker->Get();
   XrVector2f xy {};
   if (
-    IsPointerSink() && mCalibration && rotation
+    IsPointerSink(*mConfig) && mCalibration && rotation && window
     && RotationToCartesian(*rotation, &xy)) {
-    if (now - mLastWindowCheck > std::chrono::seconds(1)) {
-      UpdateMainWindow();
-    }
-
-    const auto x = ((xy.x * mWindowSize.x) + mWindowRect.left) / mScreenSize.x;
-    const auto y = ((xy.y * mWindowSize.y) + mWindowRect.top) / mScreenSize.y;
-
-    if (Config::VerboseDebug >= 3) {
+    const auto& windowRect = window->mClientRect;
+    const auto& screenRect = window->mMonitorRect;
+    const XrVector2f windowSize {
+      static_cast<float>(windowRect.right - windowRect.left),
+      static_cast<float>(windowRect.bottom - windowRect.top),
+    };
+    const XrVector2f screenSize {
+      static_cast<float>(screenRect.right - screenRect.left),
+      static_cast<float>(screenRect.bottom - screenRect.top),
+    };
+
+    const auto x = ((xy.x * windowSize.x) + windowRect.left) / screenSize.x;
+    const auto y = ((xy.y * windowSize.y) + windowRect.top) / screenSize.y;
+
+    if (mConfig->VerboseDebug >= 3) {
       DebugPrint(
         "Raw: ({:.02f}, {:0.2f}); adjusted for window: ({:.02f}, {:.02f})",
         xy.x,
@@ -320,21 +335,41 @@ void VirtualTouchScreenSink::Update(const InputState& hand) {
         y);
     }
 
-    events.push_back({
+    const POINT pixel {
+      std::lround(x * screenSize.x),
+      std::lround(y * screenSize.y),
+    };
+    haveMove = true;
+    moveChanged = !mLastMove
+      || (pixel.x != mLastMove->x || pixel.y != mLastMove->y);
+    if (moveChanged && mConfig->VirtualTouchScreenMaxUpdateHz) {
+      const auto interval = Time(std::chrono::seconds(1))
+        / mConfig->VirtualTouchScreenMaxUpdateHz;
+      if (now - mLastMoveAt < interval) {
+        // Don't update mLastMove, so the latest position is sent next time
+        moveChanged = false;
+      }
+    }
+    if (moveChanged) {
+      mLastMove = pixel;
+      mLastMoveAt = now;
+    }
+
+    mEvents[MoveEventIndex] = {
       .type = INPUT_MOUSE,
       .mi = {
         .dx = std::lround(x * 65535),
         .dy = std::lround(y * 65535),
         .dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE,
       },
-    });
+    };
   }
 
-  if (IsClickActionSink()) {
+  if (IsClickActionSink(*mConfig)) {
     const auto leftClick = hand.mActions.mPrimary;
     if (leftClick != mLeftClick) {
       mLeftClick = leftClick;
-      events.push_back(
+      PushEvent(
         {.type = INPUT_MOUSE,
          .mi = {
            .dwFlags = static_cast<DWORD>(
@@ -345,7 +380,7 @@ void VirtualTouchScreenSink::Update(const InputState& hand) {
     const auto rightClick = hand.mActions.mSecondary;
     if (rightClick != mRightClick) {
       mRightClick = rightClick;
-      events.push_back(
+      PushEvent(
         {.type = INPUT_MOUSE,
          .mi = {
            .dwFlags = static_cast<DWORD>(
@@ -354,7 +389,7 @@ void VirtualTouchScreenSink::Update(const InputState& hand) {
     }
   }
 
-  if (IsScrollActionSink()) {
+  if (IsScrollActionSink(*mConfig)) {
     using ValueChange = ActionState::ValueChange;
     bool isFirstScrollEvent = false;
     bool hadScrollEvent = false;
@@ -370,7 +405,7 @@ void VirtualTouchScreenSink::Update(const InputState& hand) {
       hand.mActions.mValueChange == ValueChange::Decrease
       && now >= mNextScrollEvent) {
       hadScrollEvent = true;
-      events.push_back({
+      PushEvent({
       .type = INPUT_MOUSE,
       .mi = {
         .mouseData = static_cast<DWORD>(-WHEEL_DELTA),
@@ -383,7 +418,7 @@ void VirtualTouchScreenSink::Update(const InputState& hand) {
       hand.mActions.mValueChange == ValueChange::Increase
       && now >= mNextScrollEvent) {
       hadScrollEvent = true;
-      events.push_back({
+      PushEvent({
       .type = INPUT_MOUSE,
       .mi = {
         .mouseData = static_cast<DWORD>(WHEEL_DELTA),
@@ -395,16 +430,22 @@ void VirtualTouchScreenSink::Update(const InputState& hand) {
     if (hadScrollEvent) {
       if (isFirstScrollEvent) {
         mNextScrollEvent = now
-          + std::chrono::milliseconds(Config::ScrollWheelDelayMilliseconds);
+          + std::chrono::milliseconds(mConfig->ScrollWheelDelayMilliseconds);
       } else {
-        mNextScrollEvent
-          += std::chrono::milliseconds(Config::ScrollWheelIntervalMilliseconds);
+        mNextScrollEvent += std::chrono::milliseconds(
+          mConfig->ScrollWheelIntervalMilliseconds);
       }
     }
   }
 
-  if (!events.empty()) {
-    SendInput(events.size(), events.data(), sizeof(INPUT));
+  // Always move with clicks and scrolls, even if the position hasn't changed,
+  // in case something else moved the cursor
+  const auto haveActions = mEventCount > MoveEventIndex + 1;
+  const auto sendMove = haveMove && (moveChanged || haveActions);
+  const auto first = sendMove ? MoveEventIndex : MoveEventIndex + 1;
+  const auto count = mEventCount - first;
+  if (count > 0) {
+    mInjector->Inject({&mEvents[first], count});
   }
 }
 
@@ -4,11 +4,16 @@
 
 #include <openxr/openxr.h>
 
+#include <array>
 #include <chrono>
+#include <memory>
 
 #include "Config.h"
+#include "FrameInfo.h"
+#include "InputInjector.h"
 #include "InputState.h"
 #include "OpenXRNext.h"
+#include "WindowTracker.h"
 
 namespace HandTrackedCockpitClicking {
 
@@ -19,18 +24,38 @@ class VirtualTouchScreenSink final {
     XrVector2f mWindowInputFovOrigin0To1 {};
   };
 
-  VirtualTouchScreenSink(std::optional<Calibration>, DWORD targetProcessID);
+  // Defaults to a SendInputInjector if `injector` is null
   VirtualTouchScreenSink(
+    std::shared_ptr<const Config::Snapshot>,
+    std::optional<Calibration>,
+    DWORD targetProcessID,
+    std::unique_ptr<InputInjector> injector = nullptr);
+  // Maps to a fixed window instead of finding one; for tests
+  VirtualTouchScreenSink(
+    std::shared_ptr<const Config::Snapshot>,
+    std::optional<Calibration>,
+    const WindowTracker::Window&,
+    std::unique_ptr<InputInjector>);
+  VirtualTouchScreenSink(
+    std::shared_ptr<const Config::Snapshot>,
     const std::shared_ptr<OpenXRNext>& oxr,
     XrSession session,
     XrViewConfigurationType viewConfigurationType,
     XrTime nextDisplayTime,
     XrSpace viewSpace);
+  // Releases any held buttons
+  ~VirtualTouchScreenSink();
 
-  void Update(const InputState& leftHand, const InputState& rightHand);
+  // Held buttons are released if the new config doesn't send clicks
+  void ReloadConfig(std::shared_ptr<const Config::Snapshot>);
 
-  static bool IsActionSink();
-  static bool IsPointerSink();
+  void Update(
+    const FrameInfo&,
+    const InputState& leftHand,
+    const InputState& rightHand);
+
+  static bool IsActionSink(const Config::Snapshot&);
+  static bool IsPointerSink(const Config::Snapshot&);
 
   VirtualTouchScreenSink() = delete;
 
@@ -42,30 +67,44 @@ class VirtualTouchScreenSink final {
     XrSpace viewSpace);
 
   static Calibration CalibrationFromOpenXRView(const XrView& view);
-  static std::optional<Calibration> CalibrationFromConfig();
+  static std::optional<Calibration> CalibrationFromConfig(
+    const Config::Snapshot&);
 
  private:
-  void Update(const InputState& hand);
-  bool RotationToCartesian(const XrVector2f& rotation, XrVector2f* cartesian);
-  void UpdateMainWindow();
-  static BOOL CALLBACK EnumWindowCallback(HWND hwnd, LPARAM lparam);
+  // Same epoch as XrTime, but with chrono arithmetic
+  using Time = std::chrono::nanoseconds;
 
-  DWORD mTargetProcessID;
-  HWND mWindow {};
-  HWND mConsoleWindow {};
-  XrVector2f mWindowSize {};
-  RECT mWindowRect {};
-  XrVector2f mScreenSize;
+  VirtualTouchScreenSink(
+    std::shared_ptr<const Config::Snapshot>,
+    std::optional<Calibration>,
+    std::unique_ptr<WindowTracker>,
+    std::unique_ptr<InputInjector>);
+
+  void Update(Time now, const InputState& hand);
+  void PushEvent(const INPUT&);
+  void ReleaseButtons();
+  bool RotationToCartesian(const XrVector2f& rotation, XrVector2f* cartesian);
 
+  std::shared_ptr<const Config::Snapshot> mConfig;
   std::optional<Calibration> mCalibration {};
+  std::unique_ptr<WindowTracker> mWindowTracker;
+  std::unique_ptr<InputInjector> mInjector;
 
   bool mLeftClick {false};
   bool mRightClick {false};
   ActionState::ValueChange mScrollDirection = ActionState::ValueChange::None;
 
-  std::chrono::steady_clock::time_point mLastWindowCheck {};
+  Time mNextScrollEvent {};
+
+  // Move, left button, right button, wheel; the move is always first, so that
+  // clicks land at the new position
+  static constexpr std::size_t MoveEventIndex = 0;
+  std::array<INPUT, 4> mEvents {};
+  std::size_t mEventCount {};
 
-  std::chrono::steady_clock::time_point mNextScrollEvent {};
+  // In screen pixels; moves within the same pixel are skipped
+  std::optional<POINT> mLastMove;
+  Time mLastMoveAt {};
 };
 
 }// namespace HandTrackedCockpitClicking
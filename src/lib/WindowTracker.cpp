@@ -0,0 +1,197 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#include "WindowTracker.h"
+
+#include <array>
+#include <functional>
+
+#include "DebugPrint.h"
+
+namespace HandTrackedCockpitClicking {
+
+namespace {
+// WinEvent callbacks don't have a context pointer, but out-of-context hooks
+// are called on the thread that set them
+thread_local WindowTracker* tTracker {nullptr};
+}// namespace
+
+WindowTracker::WindowTracker(DWORD processID)
+  : mProcessID(processID), mConsoleWindow(GetConsoleWindow()) {
+  mThread = std::jthread {std::bind_front(&WindowTracker::Run, this)};
+}
+
+WindowTracker::WindowTracker(const Window& window)
+  : mWindow(std::make_shared<const Window>(window)) {
+}
+
+WindowTracker::~WindowTracker() {
+  if (!mThread.joinable()) {
+    return;
+  }
+  mThread.request_stop();
+  // Wait until the thread has a message queue to post to
+  mThreadID.wait(0);
+  PostThreadMessageW(mThreadID.load(), WM_QUIT, 0, 0);
+  mThread.join();
+}
+
+std::shared_ptr<const WindowTracker::Window> WindowTracker::Get() const {
+  return mWindow.load(std::memory_order_acquire);
+}
+
+void WindowTracker::Run(std::stop_token stopToken) {
+  SetThreadDescription(GetCurrentThread(), L"HTCC Window Tracker");
+  tTracker = this;
+
+  // Make sure we have a message queue before anyone posts to it
+  MSG msg {};
+  PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+  mThreadID.store(GetCurrentThreadId());
+  mThreadID.notify_all();
+
+  const auto hook = [this](DWORD first, DWORD last) {
+    return SetWinEventHook(
+      first,
+      last,
+      nullptr,
+      &WindowTracker::WinEventCallback,
+      mProcessID,
+      0,
+      WINEVENT_OUTOFCONTEXT);
+  };
+  const std::array hooks {
+    hook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND),
+    // EVENT_OBJECT_DESTROY and EVENT_OBJECT_SHOW
+    hook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_SHOW),
+    hook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE),
+  };
+
+  this->FindMainWindow();
+
+  while (!stopToken.stop_requested()) {
+    if (GetMessageW(&msg, nullptr, 0, 0) <= 0) {
+      break;
+    }
+    DispatchMessageW(&msg);
+  }
+
+  for (const auto it: hooks) {
+    if (it) {
+      UnhookWinEvent(it);
+    }
+  }
+  tTracker = nullptr;
+}
+
+bool WindowTracker::IsMainWindow(HWND hwnd) const {
+  if (hwnd == mConsoleWindow) {
+    return false;
+  }
+
+  // Top-level windows only
+  if (GetAncestor(hwnd, GA_ROOT) != hwnd) {
+    return false;
+  }
+
+  DWORD processID {};
+  GetWindowThreadProcessId(hwnd, &processID);
+  if (processID != mProcessID) {
+    return false;
+  }
+
+  // Has a parent window
+  if (GetWindow(hwnd, GW_OWNER) != (HWND)0) {
+    return false;
+  }
+
+  return true;
+}
+
+void WindowTracker::FindMainWindow() {
+  EnumWindows(
+    &WindowTracker::EnumWindowCallback, reinterpret_cast<LPARAM>(this));
+}
+
+BOOL CALLBACK WindowTracker::EnumWindowCallback(HWND hwnd, LPARAM lparam) {
+  auto self = reinterpret_cast<WindowTracker*>(lparam);
+  if (!self->IsMainWindow(hwnd)) {
+    return TRUE;
+  }
+  self->Publish(hwnd);
+  return FALSE;
+}
+
+void WindowTracker::Publish(HWND hwnd) {
+  Window window {hwnd};
+
+  // ... this is annoyingly enough in client coordinates
+  auto& rect = window.mClientRect;
+  GetClientRect(hwnd, &rect);
+  ClientToScreen(hwnd, reinterpret_cast<LPPOINT>(&rect.left));
+  ClientToScreen(hwnd, reinterpret_cast<LPPOINT>(&rect.right));
+
+  auto monitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTOPRIMARY);
+  MONITORINFO monitorInfo {sizeof(MONITORINFO)};
+  GetMonitorInfo(monitor, &monitorInfo);
+  window.mMonitorRect = monitorInfo.rcMonitor;
+
+  if (hwnd != mCurrentWindow) {
+    mCurrentWindow = hwnd;
+    DebugPrint(
+      "Found game window; mapping hand-tracking within headset FOV to "
+      "on-screen rect ({}, {}) -> ({}, {})",
+      rect.left,
+      rect.top,
+      rect.right,
+      rect.bottom);
+  }
+
+  mWindow.store(
+    std::make_shared<const Window>(window), std::memory_order_release);
+}
+
+void WindowTracker::OnWinEvent(DWORD event, HWND hwnd, LONG idObject) {
+  if (idObject != OBJID_WINDOW || !hwnd) {
+    return;
+  }
+
+  switch (event) {
+    case EVENT_OBJECT_LOCATIONCHANGE:
+      if (hwnd == mCurrentWindow) {
+        this->Publish(hwnd);
+      }
+      return;
+    case EVENT_OBJECT_DESTROY:
+      if (hwnd == mCurrentWindow) {
+        mCurrentWindow = {};
+        mWindow.store(nullptr, std::memory_order_release);
+        this->FindMainWindow();
+      }
+      return;
+    case EVENT_OBJECT_SHOW:
+      if (!mCurrentWindow && IsMainWindow(hwnd)) {
+        this->Publish(hwnd);
+      }
+      return;
+    case EVENT_SYSTEM_FOREGROUND:
+      if (IsMainWindow(hwnd)) {
+        this->Publish(hwnd);
+      }
+      return;
+  }
+}
+
+void CALLBACK WindowTracker::WinEventCallback(
+  HWINEVENTHOOK,
+  DWORD event,
+  HWND hwnd,
+  LONG idObject,
+  LONG,
+  DWORD,
+  DWORD) {
+  if (tTracker) {
+    tTracker->OnWinEvent(event, hwnd, idObject);
+  }
+}
+
+}// namespace HandTrackedCockpitClicking
@@ -0,0 +1,72 @@
+// Copyright (c) 2025-present Frederick Emmott
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace HandTrackedCockpitClicking {
+
+/** Tracks a process's main window on a background thread.
+ *
+ * Finding the window needs `EnumWindows()`, which visits every top-level
+ * window on the desktop; instead of polling, this finds it once, then uses
+ * WinEvent hooks to notice when it moves, resizes, or is replaced.
+ *
+ * The latest state is published atomically, so `Get()` is cheap enough for
+ * the frame thread.
+ *
+ * For tests, it can instead always return a fixed window, without starting a
+ * thread.
+ */
+class WindowTracker final {
+ public:
+  struct Window {
+    HWND mWindow {};
+    // In screen coordinates
+    RECT mClientRect {};
+    // The monitor containing the window
+    RECT mMonitorRect {};
+  };
+
+  WindowTracker() = delete;
+  explicit WindowTracker(DWORD processID);
+  explicit WindowTracker(const Window&);
+  ~WindowTracker();
+
+  // nullptr if the window hasn't been found yet
+  std::shared_ptr<const Window> Get() const;
+
+ private:
+  DWORD mProcessID {};
+  HWND mConsoleWindow {};
+
+  std::atomic<std::shared_ptr<const Window>> mWindow;
+
+  // Only touched by mThread
+  HWND mCurrentWindow {};
+
+  std::atomic<DWORD> mThreadID {};
+  std::jthread mThread;
+
+  void Run(std::stop_token);
+  void FindMainWindow();
+  bool IsMainWindow(HWND) const;
+  void Publish(HWND);
+  void OnWinEvent(DWORD event, HWND, LONG idObject);
+
+  static BOOL CALLBACK EnumWindowCallback(HWND hwnd, LPARAM lparam);
+  static void CALLBACK WinEventCallback(
+    HWINEVENTHOOK hook,
+    DWORD event,
+    HWND hwnd,
+    LONG idObject,
+    LONG idChild,
+    DWORD eventThread,
+    DWORD eventTime);
+};
+
+}// namespace HandTrackedCockpitClicking